@@ -43,6 +43,7 @@
 #include "Time.hpp"
 #include "Activity.hpp"
 #include "os/MutexLock.hpp"
+#include "os/oro_arch.h"
 #include "os/traces.h"
 #include "Logger.hpp"
 #include "rtt-fwd.hpp"
@@ -56,19 +57,19 @@ namespace RTT
 
     Activity::Activity(RunnableInterface* _r, const std::string& name )
         : ActivityInterface(_r), os::Thread(ORO_SCHED_OTHER, RTT::os::LowestPriority, 0.0, 0, name ),
-          update_period(0.0), mtimeout(false), mstopRequested(false), mwaitpolicy(ORO_WAIT_ABS)
+          update_period(0.0), mtimeout(false), mstopRequested(false), mwaiting(false), mwaitpolicy(ORO_WAIT_ABS)
     {
     }
 
     Activity::Activity(int priority, RunnableInterface* r, const std::string& name )
         : ActivityInterface(r), os::Thread(ORO_SCHED_RT, priority, 0.0, 0, name ),
-          update_period(0.0), mtimeout(false), mstopRequested(false), mwaitpolicy(ORO_WAIT_ABS)
+          update_period(0.0), mtimeout(false), mstopRequested(false), mwaiting(false), mwaitpolicy(ORO_WAIT_ABS)
     {
     }
 
     Activity::Activity(int priority, Seconds period, RunnableInterface* r, const std::string& name )
         : ActivityInterface(r), os::Thread(ORO_SCHED_RT, priority, period, 0, name ),
-          update_period(period), mtimeout(false), mstopRequested(false), mwaitpolicy(ORO_WAIT_ABS)
+          update_period(period), mtimeout(false), mstopRequested(false), mwaiting(false), mwaitpolicy(ORO_WAIT_ABS)
     {
         // We pass the requested period to the constructor to not confuse users with log messages.
         // Then we clear it immediately again in order to force the Thread implementation to
@@ -78,13 +79,13 @@ namespace RTT
 
      Activity::Activity(int scheduler, int priority, RunnableInterface* r, const std::string& name )
          : ActivityInterface(r), os::Thread(scheduler, priority, 0.0, 0, name ),
-           update_period(0.0), mtimeout(false), mstopRequested(false), mwaitpolicy(ORO_WAIT_ABS)
+           update_period(0.0), mtimeout(false), mstopRequested(false), mwaiting(false), mwaitpolicy(ORO_WAIT_ABS)
      {
      }
 
      Activity::Activity(int scheduler, int priority, Seconds period, RunnableInterface* r, const std::string& name )
          : ActivityInterface(r), os::Thread(scheduler, priority, period, 0, name ),
-           update_period(period), mtimeout(false), mstopRequested(false), mwaitpolicy(ORO_WAIT_ABS)
+           update_period(period), mtimeout(false), mstopRequested(false), mwaiting(false), mwaitpolicy(ORO_WAIT_ABS)
      {
          // We pass the requested period to the constructor to not confuse users with log messages.
          // Then we clear it immediately again in order to force the Thread implementation to
@@ -94,7 +95,7 @@ namespace RTT
 
      Activity::Activity(int scheduler, int priority, Seconds period, unsigned cpu_affinity, RunnableInterface* r, const std::string& name )
      : ActivityInterface(r), os::Thread(scheduler, priority, period, cpu_affinity, name ),
-       update_period(period), mtimeout(false), mstopRequested(false), mwaitpolicy(ORO_WAIT_ABS)
+       update_period(period), mtimeout(false), mstopRequested(false), mwaiting(false), mwaitpolicy(ORO_WAIT_ABS)
      {
          // We pass the requested period to the constructor to not confuse users with log messages.
          // Then we clear it immediately again in order to force the Thread implementation to
@@ -149,8 +150,7 @@ namespace RTT
         if ( ! Thread::isActive() )
             return false;
         //a trigger is always allowed when active
-        msg_cond.broadcast();
-        Thread::start();
+        mwakeup.signal();
         return true;
     }
 
@@ -165,13 +165,14 @@ namespace RTT
             return false;
         }
         mtimeout = true;
-        msg_cond.broadcast();
-        Thread::start();
+        mwakeup.signal();
         return true;
     }
 
     void Activity::loop() {
         nsecs wakeup = 0;
+        // the wakeup time of the period which is being executed, if any.
+        nsecs period_start = 0;
         int overruns = 0;
         while ( true ) {
             // since update_period may be changed at any time, we need to recheck it each time:
@@ -185,12 +186,30 @@ namespace RTT
                 wakeup = 0;
             }
 
+            mwaiting = false;
+            // stop() sets mstopRequested before it checks mwaiting, so either
+            // it sees that we are executing and breaks the loop, or we see it.
+            oro_mb();
+            if (mstopRequested) {
+                mstopRequested = false;
+                return;
+            }
             // periodic: we flag mtimeout below; non-periodic: we flag mtimeout in timeout()
             if (mtimeout) {
                 // was a timeout() call, or internally generated after wakeup
                 mtimeout = false;
+                nsecs step_start = 0;
+                if ( period_start != 0 ) {
+                    // record the timing of a periodic wakeup, like os::Thread does.
+                    step_start = os::TimeService::Instance()->getNSecs();
+                    mstatistics.latency.record( step_start - period_start );
+                }
                 this->step();
                 this->work(base::RunnableInterface::TimeOut);
+                if ( period_start != 0 ) {
+                    mstatistics.duration.record( os::TimeService::Instance()->getNSecs() - step_start );
+                    period_start = 0;
+                }
             } else {
                 // was a trigger() call
                 if ( update_period > 0 ) {
@@ -205,30 +224,36 @@ namespace RTT
                         this->work(base::RunnableInterface::Trigger);
                     }
                 }
-                // if a timeout() was done during work(), we will re-enter
-                // loop() due to the Thread::start().
+                // if a timeout() was done during work(), mwakeup is set
+                // and we execute again.
+            }
+            mwaiting = true;
+            if (mstopRequested) {
+                mstopRequested = false;
+                return;
             }
             // next, sleep/wait
-            os::MutexLock lock(msg_lock);
             if ( wakeup == 0 ) {
-                // non periodic, default behavior:
-                return;
+                // non periodic: wait for the next trigger(), timeout() or stop().
+                mwakeup.wait();
             } else {
                 // If periodic, sleep until wakeup time or a message comes in.
                 // when wakeup time passed, wait_until will return false and we recalculate wakeup + update_period
-                bool time_elapsed = ! msg_cond.wait_until(msg_lock,wakeup);
+                bool time_elapsed = ! mwakeup.wait_until(wakeup);
 
                 if (time_elapsed) {
                     nsecs now = os::TimeService::Instance()->getNSecs();
 
                     // calculate next wakeup point
                     nsecs nsperiod = Seconds_to_nsecs(update_period);
+                    period_start = wakeup;
                     wakeup = wakeup + nsperiod;
 
                     // detect overruns
                     if ( wakeup < now )
                     {
                         ++overruns;
+                        mstatistics.overruns.inc();
                         if (overruns == maxOverRun)
                             break; // break while(true)
                     }
@@ -244,7 +269,7 @@ namespace RTT
                 }
             }
             if (mstopRequested) {
-                mstopRequested = false; // guarded by Mutex lock
+                mstopRequested = false;
                 return;
             }
         }
@@ -273,7 +298,14 @@ namespace RTT
 
 
     bool Activity::start() {
+        // loop() executes until stop(), so a start() when active is a trigger().
+        if ( Thread::isActive() ) {
+            mwakeup.signal();
+            return true;
+        }
         mstopRequested = false;
+        // forget the triggers since the last stop().
+        mwakeup.trywait();
         return Thread::start();
     }
 
@@ -284,23 +316,34 @@ namespace RTT
 
         running = false;
 
-        // first of all, exit loop() if possible:
-        {
-            os::MutexLock lock(msg_lock); // protects stopRequested
-            mstopRequested = true;
-            msg_cond.broadcast();
-        }
-
+        bool broken = false;
         if (update_period == 0)
         {
-            if ( inloop ) {
+            // a subclass may override loop(), which is then not waiting.
+            if ( inloop && !mwaiting ) {
                 if ( !this->breakLoop() ) {
                     log(Warning) << "Failed to stop thread " << this->getName() << ": breakLoop() returned false."<<endlog();
                     running = true;
                     return false;
                 }
                 // breakLoop was ok, wait for loop() to return.
+                broken = true;
             }
+        }
+
+        // exit loop() after the current step:
+        mstopRequested = true;
+        oro_mb();
+        // loop() may have been woken up since mwaiting was checked, and
+        // started executing before it could see mstopRequested.
+        if ( update_period == 0 && !broken && inloop && !mwaiting ) {
+            if ( !this->breakLoop() )
+                log(Warning) << "Thread " << this->getName() << " woke up while being stopped and breakLoop() returned false: waiting for loop() to return."<<endlog();
+        }
+        mwakeup.signal();
+
+        if (update_period == 0)
+        {
             MutexTimedLock lock(breaker, getStopTimeout());
             if ( !lock.isSuccessful() ) {
                 log(Error) << "Failed to stop thread " << this->getName() << ": breakLoop() returned true, but loop() function did not return after "<<getStopTimeout() << " second(s)."<<endlog();
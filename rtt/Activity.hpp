@@ -45,6 +45,7 @@
 #include "os/Thread.hpp"
 #include "os/Mutex.hpp"
 #include "os/Condition.hpp"
+#include "os/Wakeup.hpp"
 
 namespace RTT
 {
@@ -60,6 +61,10 @@ namespace RTT
      * When provided one, it will execute a base::RunnableInterface object, or the equivalent methods in
      * it's own interface when none is given.
      *
+     * The thread waits for trigger(), timeout() and stop() on an os::Wakeup
+     * flag, such that triggering an Activity which is executing or which was
+     * triggered already does not enter the kernel.
+     *
      * @ingroup CoreLibActivities
      */
     class RTT_API Activity
@@ -215,8 +220,16 @@ namespace RTT
          */
         virtual void finalize();
     protected:
+        /**
+         * No longer used by Activity, which waits on mwakeup instead.
+         * Kept for subclasses which use them.
+         */
         os::Mutex msg_lock;
         os::Condition msg_cond;
+        /**
+         * Set by trigger(), timeout() and stop() to wake up loop().
+         */
+        os::Wakeup mwakeup;
         /**
          * The period at which the Activity steps().
          */
@@ -226,7 +239,11 @@ namespace RTT
          * When set to true, a next cycle will be a TimeOut cycle.
          */
         bool mtimeout;
-        bool mstopRequested;
+        volatile bool mstopRequested;
+        /**
+         * True while loop() waits for mwakeup.
+         */
+        volatile bool mwaiting;
         int mwaitpolicy;
     };
 
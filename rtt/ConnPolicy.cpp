@@ -64,6 +64,8 @@ namespace RTT
         , buffer_policy(PerConnection)
         , max_threads(0)
         , mandatory(true)
+        , shared_samples(false)
+        , seqlock(SEQLOCK_AUTO)
         , transport(0)
         , data_size(0)
     {}
@@ -115,6 +117,8 @@ namespace RTT
         , buffer_policy(Default().buffer_policy)
         , max_threads(Default().max_threads)
         , mandatory(Default().mandatory)
+        , shared_samples(Default().shared_samples)
+        , seqlock(Default().seqlock)
         , transport(Default().transport)
         , data_size(Default().data_size)
     {}
@@ -128,6 +132,8 @@ namespace RTT
         , buffer_policy(Default().buffer_policy)
         , max_threads(Default().max_threads)
         , mandatory(Default().mandatory)
+        , shared_samples(Default().shared_samples)
+        , seqlock(Default().seqlock)
         , transport(Default().transport)
         , data_size(Default().data_size)
     {}
@@ -141,6 +147,8 @@ namespace RTT
         , buffer_policy(Default().buffer_policy)
         , max_threads(Default().max_threads)
         , mandatory(Default().mandatory)
+        , shared_samples(Default().shared_samples)
+        , seqlock(Default().seqlock)
         , transport(Default().transport)
         , data_size(Default().data_size)
     {}
@@ -180,6 +188,12 @@ namespace RTT
         os << type;
         if (!cp.name_id.empty()) os << " (name_id=" << cp.name_id << ")";
         if (cp.max_threads > 0) os << " (max_threads=" << cp.max_threads << ")";
+        if (cp.shared_samples) os << " (shared_samples)";
+        // the sequence lock only applies to lock-free data objects, print it unless it is the default.
+        if (cp.type == ConnPolicy::DATA && cp.lock_policy == ConnPolicy::LOCK_FREE) {
+            if (cp.seqlock == ConnPolicy::SEQLOCK_NEVER) os << " (no seqlock)";
+            if (cp.seqlock == ConnPolicy::SEQLOCK_ALWAYS) os << " (seqlock)";
+        }
 
         return os;
     }
@@ -85,6 +85,13 @@ namespace RTT {
      *       call fail if the new sample cannot be successfully written. Default connections
      *       are not mandatory.
      *
+     *  <li> if a lock-free data connection uses a sequence lock. By default, it does
+     *       for small trivially copyable types, which need no deep copy.
+     *
+     *  <li> if samples are shared between connections. When an output port writes
+     *       to several connections that share samples, the sample is copied only
+     *       once and all connections store a reference to the same immutable copy.
+     *
      *  <li> the transport type. Can be used to force a certain kind of transports.
      *       The number is a RTT transport id. When the transport type is zero,
      *       local in-process communication is used, unless one of the ports is
@@ -119,6 +126,10 @@ namespace RTT {
         static const bool PUSH = false;
         static const bool PULL = true;
 
+        static const int SEQLOCK_NEVER  = 0;
+        static const int SEQLOCK_AUTO   = 1;
+        static const int SEQLOCK_ALWAYS = 2;
+
         /**
          * Returns the process-wide default ConnPolicy that serves as a template for new ConnPolicy instances.
          *
@@ -231,6 +242,26 @@ namespace RTT {
          */
         bool   mandatory;
 
+        /**
+         * Whether the connection stores references to samples which are shared with the other
+         * connections of the same output port, instead of a copy per connection.
+         * The output port copies a written sample once into a real-time pool and every
+         * connection that has this flag set receives a reference to that copy.
+         * Only applies to local PerConnection connections and is ignored otherwise.
+         * By default, samples are not shared.
+         */
+        bool   shared_samples;
+
+        /**
+         * Whether a LOCK_FREE DATA connection stores its sample in a base::DataObjectSeqLock
+         * instead of a base::DataObjectLockFree. The sequence lock keeps two copies of the sample
+         * for any number of readers, but can only be used for trivially copyable types.
+         * SEQLOCK_AUTO uses it for trivially copyable types of at most ORONUM_DATAOBJECT_SEQLOCK_MAX_SIZE
+         * bytes, SEQLOCK_ALWAYS for all trivially copyable types and SEQLOCK_NEVER never.
+         * The default is SEQLOCK_AUTO.
+         */
+        int    seqlock;
+
         /**
          * The prefered transport used. 0 is local (in process), a higher number
          * is used for inter-process or networked communication transports.
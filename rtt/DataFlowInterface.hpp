@@ -113,6 +113,9 @@ namespace RTT
          * callback function in order to schedule an updateHook() nevertheless
          * in the same cycle. If callback is not provided, updateHook() will be
          * executed by default.
+         * @note Samples which arrive before the callback was executed do not
+         * cause additional calls, so the callback must read all new data of
+         * the port, or the rest of a buffer stays unread until the next sample arrives.
          */
         base::InputPortInterface& addEventPort(const std::string& name, base::InputPortInterface& port, SlotFunction callback = SlotFunction() ) {
             if ( !chkPtr("addEventPort", name, &port) ) return port;
@@ -132,6 +135,9 @@ namespace RTT
          * callback function in order to schedule an updateHook() nevertheless
          * in the same cycle. If callback is not provided, updateHook() will be
          * executed by default.
+         * @note Samples which arrive before the callback was executed do not
+         * cause additional calls, so the callback must read all new data of
+         * the port, or the rest of a buffer stays unread until the next sample arrives.
          * @return \a port
          */
         base::InputPortInterface& addEventPort(base::InputPortInterface& port, SlotFunction callback = SlotFunction() );
@@ -42,7 +42,12 @@
 #include "base/TaskCore.hpp"
 #include "rtt-fwd.hpp"
 #include "os/MutexLock.hpp"
+#include "os/oro_arch.h"
+#include "os/CAS.hpp"
 #include "internal/MWSRQueue.hpp"
+#include "internal/TsPool.hpp"
+#include "internal/PortCallback.hpp"
+#include "os/TimeService.hpp"
 #include "TaskContext.hpp"
 #include "internal/CatchConfig.hpp"
 #include "extras/SlaveActivity.hpp"
@@ -66,12 +71,68 @@ namespace RTT
     using namespace detail;
     using namespace boost;
 
+    const int ExecutionEngine::PriorityLevels;
+
+    /**
+     * A MWSRQueue of pointers to T which can remember when each
+     * item was enqueued. The time stamps are kept in a lock-free
+     * pool of the same size as the queue.
+     */
+    template<class T>
+    class ExecutionEngine::StampedQueue
+    {
+        struct Item {
+            Item() : item(0), stamp(0) {}
+            T* item;
+            nsecs stamp;
+        };
+        TsPool<Item> pool;
+        MWSRQueue<Item*> queue;
+    public:
+        StampedQueue(int size) : pool(size), queue(size) {}
+
+        /**
+         * Enqueues \a t and time stamps it if \a stamp is true.
+         */
+        bool enqueue(T* t, bool stamp) {
+            Item* i = pool.allocate();
+            if ( !i )
+                return false;
+            i->item = t;
+            i->stamp = stamp ? os::TimeService::Instance()->getNSecs() : 0;
+            if ( !queue.enqueue(i) ) {
+                pool.deallocate(i);
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Dequeues the oldest item and returns in \a waited how long
+         * it has been queued, or zero if it was not time stamped.
+         */
+        bool dequeue(T*& t, nsecs& waited) {
+            Item* i = 0;
+            if ( !queue.dequeue(i) )
+                return false;
+            t = i->item;
+            waited = i->stamp ? os::TimeService::Instance()->getNSecs() - i->stamp : 0;
+            pool.deallocate(i);
+            return true;
+        }
+
+        bool isEmpty() const { return queue.isEmpty(); }
+    };
+
     ExecutionEngine::ExecutionEngine( TaskCore* owner )
         : taskc(owner),
-          mqueue(new MWSRQueue<DisposableInterface*>(ORONUM_EE_MQUEUE_SIZE) ),
-          port_queue(new MWSRQueue<PortInterface*>(ORONUM_EE_MQUEUE_SIZE) ),
-          f_queue( new MWSRQueue<ExecutableInterface*>(ORONUM_EE_MQUEUE_SIZE) )
+          f_queue( new MWSRQueue<ExecutableInterface*>(ORONUM_EE_MQUEUE_SIZE) ),
+          budget_items(0), budget_time(0), mtiming(false)
     {
+        for (int p = 0; p != PriorityLevels; ++p) {
+            mqueue[p] = new StampedQueue<DisposableInterface>(ORONUM_EE_MQUEUE_SIZE);
+            port_queue[p] = new StampedQueue<internal::PortCallback>(ORONUM_EE_MQUEUE_SIZE);
+        }
     }
 
     ExecutionEngine::~ExecutionEngine()
@@ -83,12 +144,16 @@ namespace RTT
             foo->unloaded();
 
         DisposableInterface* dis;
-        while ( mqueue->dequeue( dis ) )
-            dis->dispose();
+        nsecs waited;
+        for (int p = 0; p != PriorityLevels; ++p)
+            while ( mqueue[p]->dequeue( dis, waited ) )
+                dis->dispose();
 
         delete f_queue;
-        delete port_queue;
-        delete mqueue;
+        for (int p = 0; p != PriorityLevels; ++p) {
+            delete port_queue[p];
+            delete mqueue[p];
+        }
     }
 
     TaskCore* ExecutionEngine::getParent() {
@@ -105,15 +170,7 @@ namespace RTT
             assert(foo);
             if ( foo->execute() == false ){
                 foo->unloaded();
-                {
-                    // There's no need to hold the lock while
-                    // processing the queue. But we must hold the
-                    // lock once between foo->execute() and the
-                    // broadcast to avoid the race condition in
-                    // waitForMessagesInternal().
-                    MutexLock locker( msg_lock );
-                }
-                msg_cond.broadcast(); // required for waitForFunctions() (3rd party thread)
+                notifyWaiters(); // required for waitForFunctions() (3rd party thread)
             } else {
                 f_queue->enqueue( foo );
             }
@@ -201,81 +258,231 @@ namespace RTT
 
     bool ExecutionEngine::hasWork()
     {
-        return !mqueue->isEmpty();
+        for (int p = 0; p != PriorityLevels; ++p)
+            if ( !mqueue[p]->isEmpty() )
+                return true;
+        return false;
+    }
+
+    bool ExecutionEngine::budgetExhausted(unsigned int count, nsecs start) const
+    {
+        if ( budget_items != 0 && count >= budget_items )
+            return true;
+        if ( budget_time != 0 && os::TimeService::Instance()->getNSecs() - start >= budget_time )
+            return true;
+        return false;
     }
 
     void ExecutionEngine::processMessages()
+    {
+        unsigned int count = 0;
+        for (int p = 0; p != PriorityLevels; ++p)
+            processMessages(p, false, count, 0);
+    }
+
+    bool ExecutionEngine::processMessages(int priority, bool budgeted, unsigned int& count, nsecs start)
     {
         // Fast bail-out :
-        if ( mqueue->isEmpty() )
-            return;
+        if ( mqueue[priority]->isEmpty() )
+            return true;
         // execute all commands from the AtomicQueue.
         // msg_lock may not be held when entering this function !
+        bool result = true;
         DisposableInterface* com(0);
+        nsecs waited;
+        MessageStatistics& stats = mstats[priority];
         {
-            while ( mqueue->dequeue(com) ) {
+            while ( mqueue[priority]->dequeue(com, waited) ) {
                 assert( com );
+                ++stats.processed;
+                stats.total_wait += waited;
+                if ( waited > stats.max_wait )
+                    stats.max_wait = waited;
                 com->executeAndDispose();
+                if ( budgeted && budgetExhausted(++count, start) ) {
+                    result = false;
+                    break;
+                }
             }
-            // there's no need to hold the lock during
-            // emptying the queue. But we must hold the
-            // lock once between excuteAndDispose and the
-            // broadcast to avoid the race condition in
-            // waitForMessages().
-            // This allows us to recurse into processMessages.
-            MutexLock locker( msg_lock );
         }
         if ( com )
-            msg_cond.broadcast(); // required for waitForMessages() (3rd party thread)
+            notifyWaiters(); // required for waitForMessages() (3rd party thread)
+        return result;
     }
 
     void ExecutionEngine::processPortCallbacks()
+    {
+        unsigned int count = 0;
+        for (int p = 0; p != PriorityLevels; ++p)
+            processPortCallbacks(p, false, count, 0);
+    }
+
+    bool ExecutionEngine::processPortCallbacks(int priority, bool budgeted, unsigned int& count, nsecs start)
     {
         // Fast bail-out :
-        if (port_queue->isEmpty())
-            return;
+        if (port_queue[priority]->isEmpty())
+            return true;
 
         TaskContext* tc = dynamic_cast<TaskContext*>(taskc);
         if (tc) {
-            PortInterface* port(0);
+            internal::PortCallback* entry(0);
+            nsecs waited;
+            MessageStatistics& stats = mstats[priority];
             {
-                while ( port_queue->dequeue(port) ) {
-                    assert( port );
-                    tc->dataOnPortCallback(port);
+                while ( port_queue[priority]->dequeue(entry, waited) ) {
+                    assert( entry );
+                    ++stats.processed;
+                    stats.total_wait += waited;
+                    if ( waited > stats.max_wait )
+                        stats.max_wait = waited;
+                    // data which arrives from here on queues the port again.
+                    // This must be a full barrier, such that the callback
+                    // reads all data which did not queue the port.
+                    os::CAS(&entry->queued, 1, 0);
+                    // the port may have been removed since it was queued.
+                    PortInterface* port = entry->port;
+                    if ( port )
+                        tc->dataOnPortCallback(port);
+                    if ( budgeted && budgetExhausted(++count, start) )
+                        return false;
                 }
             }
         }
+        return true;
+    }
+
+    bool ExecutionEngine::processQueues()
+    {
+        nsecs start = budget_time ? os::TimeService::Instance()->getNSecs() : 0;
+        unsigned int count = 0;
+        int p = 0;
+        for (; p != PriorityLevels; ++p) {
+            if ( !processMessages(p, true, count, start) || !processPortCallbacks(p, true, count, start) )
+                break;
+        }
+        // count the classes which have items left and carry them over to the next cycle.
+        bool left = false;
+        for (; p < PriorityLevels; ++p) {
+            if ( !mqueue[p]->isEmpty() || !port_queue[p]->isEmpty() ) {
+                ++mstats[p].deferred;
+                left = true;
+            }
+        }
+        if ( left && this->getActivity() )
+            this->getActivity()->trigger();
+        return !left;
     }
 
     bool ExecutionEngine::process( DisposableInterface* c )
+    {
+        return queueMessage( c, NormalPriority );
+    }
+
+    bool ExecutionEngine::process( DisposableInterface* c, MessagePriority priority )
+    {
+        // such that subclasses which override process(c) still see these.
+        if ( priority == NormalPriority )
+            return this->process( c );
+        return queueMessage( c, priority );
+    }
+
+    bool ExecutionEngine::queueMessage( DisposableInterface* c, MessagePriority priority )
     {
         // We only reject running functions when we're in the FatalError state.
         if (taskc && taskc->mTaskState == TaskCore::FatalError )
             return false;
 
         if ( c && this->getActivity() ) {
-            bool result = mqueue->enqueue( c );
+            bool result = mqueue[priority]->enqueue( c, mtiming );
             this->getActivity()->trigger();
-            msg_cond.broadcast(); // required for waitAndProcessMessages() (EE thread)
+            notifyWaiters(); // required for waitAndProcessMessages() (EE thread)
             return result;
         }
         return false;
     }
 
     bool ExecutionEngine::process( PortInterface* port )
+    {
+        return queuePortCallback( port, NormalPriority );
+    }
+
+    bool ExecutionEngine::process( PortInterface* port, MessagePriority priority )
+    {
+        if ( priority == NormalPriority )
+            return this->process( port );
+        return queuePortCallback( port, priority );
+    }
+
+    bool ExecutionEngine::queuePortCallback( PortInterface* port, MessagePriority priority )
     {
         // We only reject running port callbacks when we're in the FatalError state.
         if (taskc && taskc->mTaskState == TaskCore::FatalError )
             return false;
 
-        if ( port && this->getActivity() ) {
-            bool result = port_queue->enqueue( port );
+        // only the event ports of a TaskContext have a callback entry.
+        internal::PortCallback* entry = port ? port->mcallback : 0;
+        if ( entry && this->getActivity() ) {
+            // the queued callback of the port will also see this data.
+            if ( !os::CAS(&entry->queued, 0, 1) ) {
+                mcoalesced[priority].inc();
+                return true;
+            }
+            bool result = port_queue[priority]->enqueue( entry, mtiming );
+            if ( !result )
+                oro_atomic_set(&entry->queued, 0);
             this->getActivity()->trigger();
             return result;
         }
         return false;
     }
 
+    void ExecutionEngine::setProcessingBudget(unsigned int max_items, Seconds max_time)
+    {
+        budget_items = max_items;
+        budget_time = max_time > 0.0 ? Seconds_to_nsecs(max_time) : 0;
+    }
+
+    void ExecutionEngine::setMessageTiming(bool on)
+    {
+        mtiming = on;
+    }
+
+    ExecutionEngine::MessageStatistics ExecutionEngine::getMessageStatistics(MessagePriority priority) const
+    {
+        MessageStatistics stats = mstats[priority];
+        stats.coalesced = mcoalesced[priority].read();
+        return stats;
+    }
+
+    void ExecutionEngine::resetMessageStatistics()
+    {
+        for (int p = 0; p != PriorityLevels; ++p) {
+            mstats[p] = MessageStatistics();
+            mcoalesced[p].set(0);
+        }
+    }
+
+    void ExecutionEngine::notifyWaiters()
+    {
+        // a waiter counts itself before it checks its predicate, so
+        // either it sees our change or we see it waiting.
+        oro_mb();
+        if ( msg_waiters.read() == 0 )
+            return;
+        // the thread of this engine waits on msg_wakeup, other threads on msg_cond.
+        msg_wakeup.signal();
+        {
+            // There's no need to hold the lock while
+            // processing the queue. But we must hold the
+            // lock once between the change and the
+            // broadcast to avoid the race condition in
+            // waitForMessages().
+            // This allows us to recurse into processMessages.
+            MutexLock locker( msg_lock );
+        }
+        msg_cond.broadcast();
+    }
+
     void ExecutionEngine::waitForMessages(const boost::function<bool(void)>& pred)
     {
         if (isSelf())
@@ -293,11 +500,16 @@ namespace RTT
     {
         if ( pred() )
             return;
-        // only to be called from the thread not executing step().
-        os::MutexLock lock(msg_lock);
-        while (!pred()) { // the mutex guards that processMessages can not run between !pred and the wait().
-            msg_cond.wait(msg_lock); // now processMessages may run.
+        msg_waiters.inc();
+        oro_mb();
+        {
+            // only to be called from the thread not executing step().
+            os::MutexLock lock(msg_lock);
+            while (!pred()) { // the mutex guards that processMessages can not run between !pred and the wait().
+                msg_cond.wait(msg_lock); // now processMessages may run.
+            }
         }
+        msg_waiters.dec();
     }
 
 
@@ -307,20 +519,17 @@ namespace RTT
         if ( pred() )
             return;
 
+        msg_waiters.inc();
+        oro_mb();
         while ( true ) {
-            // may not be called while holding the msg_lock !!!
             this->processMessages();
-            {
-                // only to be called from the thread executing step().
-                // We must lock because the cond variable will unlock msg_lock.
-                os::MutexLock lock(msg_lock);
-                if (!pred()) {
-                    msg_cond.wait(msg_lock); // now processMessages may run.
-                } else {
-                    return; // do not process messages when pred() == true;
-                }
-            }
+            if ( pred() )
+                break; // do not process messages when pred() == true;
+            // only to be called from the thread executing step(), which is
+            // the only thread that waits on msg_wakeup.
+            msg_wakeup.wait();
         }
+        msg_waiters.dec();
     }
 
     void ExecutionEngine::step() {
@@ -347,12 +556,10 @@ namespace RTT
         }
         if (reason == RunnableInterface::Trigger) {
             /* Callback step */
-            processMessages();
-            processPortCallbacks();
+            processQueues();
         } else if (reason == RunnableInterface::TimeOut || reason == RunnableInterface::IOReady) {
             /* Update step */
-            processMessages();
-            processPortCallbacks();
+            processQueues();
             processFunctions();
             processHooks();
         }
@@ -42,11 +42,15 @@
 #include "os/Mutex.hpp"
 #include "os/MutexLock.hpp"
 #include "os/Condition.hpp"
+#include "os/Wakeup.hpp"
+#include "os/Time.hpp"
+#include "os/Atomic.hpp"
 #include "base/RunnableInterface.hpp"
 #include "base/ActivityInterface.hpp"
 #include "base/DisposableInterface.hpp"
 #include "base/ExecutableInterface.hpp"
 #include "internal/List.hpp"
+#include "MessagePriority.hpp"
 #include <vector>
 #include <boost/function.hpp>
 
@@ -93,11 +97,38 @@ namespace RTT
         base::TaskCore* getTaskCore() const { return taskc; }
 
         /**
-         * Queue and execute (process) a given message. The message is
-         * executed in step() or loop() directly after all other
-         * queued ActionInterface objects. The constructor parameter
-         * \a queue_size limits how many messages can be queued in
-         * between step()s or loop().
+         * The number of MessagePriority classes served by this engine.
+         */
+        static const int PriorityLevels = LowPriority + 1;
+
+        /**
+         * Counters of the messages and port callbacks that were processed
+         * in one priority class. The wait times are measured from the
+         * moment the item was accepted by process() until it was executed,
+         * and only while setMessageTiming() is on.
+         */
+        struct MessageStatistics {
+            MessageStatistics() : processed(0), deferred(0), coalesced(0), max_wait(0), total_wait(0) {}
+            /** The number of items executed. */
+            unsigned long processed;
+            /** The number of cycles that ended with items of this class still queued. */
+            unsigned long deferred;
+            /** The number of port signals merged into a port callback that was already queued. */
+            unsigned long coalesced;
+            /** The longest wait time seen, in nanoseconds. */
+            nsecs max_wait;
+            /** The sum of all wait times, in nanoseconds. */
+            nsecs total_wait;
+        };
+
+        /**
+         * Queue and execute (process) a given message with NormalPriority.
+         * The message is executed in step() or loop() after all messages
+         * and port callbacks of a higher priority and after the messages
+         * of the same priority that were queued before it.
+         * The queue of each priority class is limited in size, so only
+         * a limited number of messages can be queued in between step()s
+         * or loop().
          *
          * @return true if the message got accepted, false otherwise.
          * @return false if the engine does not accept messages.
@@ -105,14 +136,70 @@ namespace RTT
         virtual bool process(base::DisposableInterface* c);
 
         /**
-         * Queue and execute (process) a given port callback. The port callback is
-         * executed in step() or loop() directly after the queued messages.
+         * Queue and execute (process) a given message in the
+         * given priority class. Messages of NormalPriority are
+         * passed on to process(base::DisposableInterface*).
          *
-         * @return true if the port callback got accepted, false otherwise.
-         * @return false if the engine does not accept messages.
+         * @param priority The priority class of this message.
+         * @return true if the message got accepted, false otherwise.
+         */
+        virtual bool process(base::DisposableInterface* c, MessagePriority priority);
+
+        /**
+         * Queue and execute (process) a given port callback with NormalPriority.
+         * The port callback is executed in step() or loop() directly after the
+         * queued messages of the same priority class. A port is queued only once:
+         * when it is signalled again before its callback was executed, both signals
+         * are served by one callback, which must read all new data of the port.
+         *
+         * @return true if the port callback got accepted or was queued already, false otherwise.
+         * @return false if the engine does not accept messages, or if \a port is
+         * not an event port of a TaskContext.
          */
         virtual bool process(base::PortInterface* port);
 
+        /**
+         * Queue and execute (process) a given port callback in the
+         * given priority class. Port callbacks of NormalPriority are
+         * passed on to process(base::PortInterface*).
+         *
+         * @param priority The priority class of this port callback.
+         * @return true if the port callback got accepted or was queued already, false otherwise.
+         */
+        virtual bool process(base::PortInterface* port, MessagePriority priority);
+
+        /**
+         * Limit the number of messages and port callbacks that are processed
+         * in one cycle of this engine. Items left in the queues when the budget
+         * is exhausted are processed in the next cycle, for which this engine
+         * triggers its activity. At least one item is processed in each cycle.
+         * By default, the budget is unlimited.
+         *
+         * @param max_items The maximum number of items per cycle, or zero for no limit.
+         * @param max_time The maximum time to spend on the queues per cycle,
+         * or zero for no limit.
+         */
+        void setProcessingBudget(unsigned int max_items, Seconds max_time = 0.0);
+
+        /**
+         * Measure how long messages and port callbacks wait in the queues,
+         * which fills in max_wait and total_wait of the MessageStatistics.
+         * This reads the clock twice for each item, so it is off by default.
+         */
+        void setMessageTiming(bool on);
+
+        /**
+         * Returns the counters of a priority class.
+         * @note These counters are updated by the thread of this engine,
+         * except for the coalesced port signals, and are read without synchronisation.
+         */
+        MessageStatistics getMessageStatistics(MessagePriority priority) const;
+
+        /**
+         * Resets the counters of all priority classes.
+         */
+        void resetMessageStatistics();
+
         /**
          * Run a given function in step() or loop(). The function may only
          * be destroyed after the
@@ -209,25 +296,100 @@ namespace RTT
         base::TaskCore*     taskc;
 
         /**
-         * Our Message queue
+         * A queue which time stamps the items it accepts.
+         */
+        template<class T>
+        class StampedQueue;
+
+        /**
+         * Our Message queues, one per priority class.
          */
-        internal::MWSRQueue<base::DisposableInterface*>* mqueue;
+        StampedQueue<base::DisposableInterface>* mqueue[PriorityLevels];
 
         /**
-         * The port callback queue
+         * The port callback queues, one per priority class. They hold the
+         * callback entries of the ports, which outlive a removed port.
          */
-        internal::MWSRQueue<base::PortInterface*>* port_queue;
+        StampedQueue<internal::PortCallback>* port_queue[PriorityLevels];
 
         /**
          * Stores all functions we're executing.
          */
         internal::MWSRQueue<base::ExecutableInterface*>* f_queue;
 
+        /**
+         * The threads other than the thread of this engine wait on msg_cond
+         * in waitForMessages(). There may be several, which os::Wakeup does
+         * not support.
+         */
         os::Mutex msg_lock;
         os::Condition msg_cond;
 
+        /**
+         * The thread of this engine waits on msg_wakeup in
+         * waitAndProcessMessages(), without taking msg_lock.
+         */
+        os::Wakeup msg_wakeup;
+
+        /**
+         * The number of threads in waitForMessages(). msg_wakeup and
+         * msg_cond are only signalled when it is not zero.
+         */
+        os::AtomicInt msg_waiters;
+
+        /**
+         * Wakes up the threads in waitForMessages(), if any.
+         */
+        void notifyWaiters();
+
+        /**
+         * The processing budget per cycle, zero means unlimited.
+         */
+        unsigned int budget_items;
+        nsecs budget_time;
+
+        /**
+         * True if the queued items are time stamped.
+         */
+        bool mtiming;
+
+        MessageStatistics mstats[PriorityLevels];
+        /**
+         * The coalesced port signals per priority class, counted by the writer threads.
+         */
+        os::AtomicInt mcoalesced[PriorityLevels];
+
+        /**
+         * Processes all queued messages, from high to low priority,
+         * regardless of the processing budget.
+         */
         void processMessages();
+        /**
+         * Processes all queued port callbacks, from high to low priority,
+         * regardless of the processing budget.
+         */
         void processPortCallbacks();
+        /**
+         * Processes the messages and port callbacks of each priority
+         * class in turn, within the processing budget.
+         * @return false if items were left in the queues.
+         */
+        bool processQueues();
+        /**
+         * Processes the messages or port callbacks of one priority class.
+         * When \a budgeted, stops as soon as the budget of the cycle which
+         * started at \a start is exhausted. \a count is increased with
+         * the number of items processed.
+         * @return false if the budget got exhausted.
+         */
+        bool processMessages(int priority, bool budgeted, unsigned int& count, nsecs start);
+        bool processPortCallbacks(int priority, bool budgeted, unsigned int& count, nsecs start);
+        /**
+         * Queues a message or port callback in the queue of \a priority.
+         */
+        bool queueMessage(base::DisposableInterface* c, MessagePriority priority);
+        bool queuePortCallback(base::PortInterface* port, MessagePriority priority);
+        bool budgetExhausted(unsigned int count, nsecs start) const;
         void processFunctions();
         void processHooks();
 
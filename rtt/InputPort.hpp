@@ -42,6 +42,7 @@
 #include "base/InputPortInterface.hpp"
 #include "internal/Channels.hpp"
 #include "internal/InputPortSource.hpp"
+#include "LoanedSample.hpp"
 #include "Service.hpp"
 #include "OperationCaller.hpp"
 
@@ -149,6 +150,39 @@ namespace RTT
             return getEndpoint()->getReadEndpoint()->read(sample, copy_old_data);
         }
 
+        /** Reads a sample from the connection without copying it.
+         * \a sample will refer to the sample in the connection's data storage
+         * until it is reset or used for the next read.
+         *
+         * Only lock-free connections support loans. Other connections loan
+         * a copy of the sample, which they own. Buffered connections
+         * consume the loaned sample, such that it will not be returned as
+         * RTT::OldData afterwards.
+         *
+         * @return RTT::NewData or RTT::OldData if \a sample is valid, RTT::NoData otherwise.
+         */
+        FlowStatus read(ConstLoanedSample<T>& sample)
+        {
+            sample.reset();
+            return getEndpoint()->getReadEndpoint()->readLoan(sample.sample, sample.owner);
+        }
+
+        /** Reads all new samples that are available on this port at once.
+         * \a samples is cleared and filled with the samples of all connections,
+         * oldest first per connection. Data connections contribute at most
+         * their last sample.
+         *
+         * Buffered samples read this way are consumed, such that read() will
+         * not return them as RTT::OldData afterwards.
+         *
+         * @return RTT::NewData if at least one sample was read, RTT::NoData otherwise.
+         */
+        FlowStatus readAll(std::vector<T>& samples)
+        {
+            samples.clear();
+            return getEndpoint()->getReadEndpoint()->readAll(samples);
+        }
+
         /** Read all new samples that are available on this port, and returns
          * the last one.
          *
@@ -0,0 +1,119 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef ORO_LOANED_SAMPLE_HPP
+#define ORO_LOANED_SAMPLE_HPP
+
+#include "rtt-fwd.hpp"
+#include "base/ChannelElement.hpp"
+
+namespace RTT
+{
+    /**
+     * A handle to a sample which is borrowed from the data storage of a connection
+     * by OutputPort::loan(). The writer fills the sample in-place and publishes
+     * it with OutputPort::write(LoanedSample<T>&), which avoids copying the sample
+     * into the connection buffer.
+     *
+     * If the handle is destroyed or reset() before it was written, the sample
+     * is handed back to the connection without being published.
+     * A LoanedSample can not be copied.
+     * @ingroup Ports
+     */
+    template<typename T>
+    class LoanedSample
+    {
+        friend class OutputPort<T>;
+        typename base::ChannelElement<T>::shared_ptr owner;
+        T* sample;
+
+        LoanedSample(LoanedSample const& orig);
+        LoanedSample& operator=(LoanedSample const& orig);
+    public:
+        LoanedSample() : owner(), sample(0) {}
+        ~LoanedSample() { reset(); }
+
+        /** True if this handle refers to a borrowed sample */
+        bool valid() const { return sample != 0; }
+
+        T& operator*() const { return *sample; }
+        T* operator->() const { return sample; }
+        T* get() const { return sample; }
+
+        /** Hands back the borrowed sample without publishing it. */
+        void reset()
+        {
+            if (sample)
+                owner->discard(sample);
+            sample = 0;
+            owner = typename base::ChannelElement<T>::shared_ptr();
+        }
+    };
+
+    /**
+     * A read-only handle to a sample in the data storage of a connection, as
+     * returned by InputPort::read(ConstLoanedSample<T>&). The sample is not
+     * copied out of the connection and writers will not modify it as long as
+     * the handle refers to it. The sample is handed back when the handle is
+     * destroyed, reset() or used for the next read.
+     *
+     * A ConstLoanedSample can not be copied.
+     * @ingroup Ports
+     */
+    template<typename T>
+    class ConstLoanedSample
+    {
+        friend class InputPort<T>;
+        typename base::ChannelElement<T>::shared_ptr owner;
+        T* sample;
+
+        ConstLoanedSample(ConstLoanedSample const& orig);
+        ConstLoanedSample& operator=(ConstLoanedSample const& orig);
+    public:
+        ConstLoanedSample() : owner(), sample(0) {}
+        ~ConstLoanedSample() { reset(); }
+
+        /** True if this handle refers to a sample */
+        bool valid() const { return sample != 0; }
+
+        T const& operator*() const { return *sample; }
+        T const* operator->() const { return sample; }
+        T const* get() const { return sample; }
+
+        /** Hands back the sample to the connection. */
+        void reset()
+        {
+            if (sample)
+                owner->release(sample);
+            sample = 0;
+            owner = typename base::ChannelElement<T>::shared_ptr();
+        }
+    };
+}
+
+#endif
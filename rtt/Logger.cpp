@@ -41,9 +41,17 @@
 #include "os/MutexLock.hpp"
 #include "os/Mutex.hpp"
 #include "os/TimeService.hpp"
+#include "os/Thread.hpp"
+#include "os/Atomic.hpp"
+#include "os/CAS.hpp"
+#include "os/ThreadLocal.hpp"
+#include "base/BufferLockFreeSPSC.hpp"
 
 #include "Logger.hpp"
 #include <iomanip>
+#include <streambuf>
+#include <vector>
+#include <cstring>
 
 #ifdef OROSEM_PRINTF_LOGGING
 #  include <stdio.h>
@@ -112,6 +120,30 @@ namespace RTT
         return value;
     }
 
+#endif
+
+/**
+ * Default number of log lines each thread can have pending in asynchronous
+ * mode, see Logger::allowAsync(). One more than this is a power of two,
+ * which is the number of slots of the ring.
+ */
+#ifndef ORONUM_LOGGING_ASYNC_RECORDS
+# define ORONUM_LOGGING_ASYNC_RECORDS 31
+#endif
+
+/**
+ * Maximum length of an asynchronous log line. Longer lines are truncated.
+ */
+#ifndef ORONUM_LOGGING_ASYNC_LINESIZE
+# define ORONUM_LOGGING_ASYNC_LINESIZE 256
+#endif
+
+/**
+ * Default number of threads that can log asynchronously at the same time,
+ * see Logger::allowAsync(). Other threads log synchronously.
+ */
+#ifndef ORONUM_LOGGING_ASYNC_THREADS
+# define ORONUM_LOGGING_ASYNC_THREADS 16
 #endif
 
     Logger& Logger::log() {
@@ -147,7 +179,8 @@ namespace RTT
               timestamp(0),
               started(false), showtime(true), allowRT(false),
               mlogStdOut(true), mlogFile(true),
-              moduleptr("Logger")
+              moduleptr("Logger"),
+              async(0), flusher(0)
         {
 #if defined(OROSEM_FILE_LOGGING) && !defined(OROSEM_LOG4CPP_LOGGING) && defined(OROSEM_PRINTF_LOGGING)
             logfile = fopen(logfile_name ? logfile_name : "orocos.log","w");
@@ -160,14 +193,21 @@ namespace RTT
             return true;
         }
 
-        bool maylogStdOut() const {
-            if ( inloglevel <= outloglevel && outloglevel != Never && inloglevel != Never && mlogStdOut)
+        ~D()
+        {
+            delete flusher;
+            for (std::vector<ThreadLog*>::iterator it = threadlogs.begin(); it != threadlogs.end(); ++it)
+                delete *it;
+        }
+
+        bool maylogStdOut(LogLevel ll) const {
+            if ( ll <= outloglevel && outloglevel != Never && ll != Never && mlogStdOut)
                 return true;
             return false;
         }
 
-        bool maylogFile() const {
-            if ( (inloglevel <= Info || inloglevel <= outloglevel)  && mlogFile)
+        bool maylogFile(LogLevel ll) const {
+            if ( (ll <= Info || ll <= outloglevel)  && mlogFile)
                 return true;
             return false;
         }
@@ -180,11 +220,17 @@ namespace RTT
         void logit(std::ostream& (*pf)(std::ostream&))
         {
             // only on Logger::nl or Logger::endl, a time+log-line is written.
+            if ( async.read() ) {
+                if ( ThreadLog* tl = threadLog() ) {
+                    logAsync(tl);
+                    return;
+                }
+            }
             os::MutexLock lock( inpguard );
             std:: string res = showTime() +" " + showLevel(inloglevel) + showModule() + " ";
 
             // do not log if not wanted.
-            if ( maylogStdOut() ) {
+            if ( maylogStdOut(inloglevel) ) {
 #ifndef OROSEM_PRINTF_LOGGING
                 *stdoutput << res << logline.str() << pf;
 #else
@@ -193,7 +239,7 @@ namespace RTT
                 logline.str("");   // clear stringstream.
             }
 
-            if ( maylogFile() ) {
+            if ( maylogFile(inloglevel) ) {
 #ifdef OROSEM_FILE_LOGGING
 #if     defined(OROSEM_LOG4CPP_LOGGING)
                 category.log(level2Priority(inloglevel), fileline.str());
@@ -212,6 +258,199 @@ namespace RTT
             }
         }
 
+        /**
+         * A log line as it is handed from a logging thread to the flusher.
+         */
+        struct AsyncRecord
+        {
+            TimeService::ticks stamp;
+            LogLevel level;
+            char module[64];
+            char text[ORONUM_LOGGING_ASYNC_LINESIZE];
+        };
+
+        /**
+         * A stream buffer on a fixed array. Output that does not fit
+         * sets the badbit of the stream, which truncates the line.
+         */
+        struct LineBuf : public std::streambuf
+        {
+            LineBuf() { reset(); }
+            void reset() { setp(line, line + sizeof(line) - 1); }
+            const char* str() { *pptr() = '\0'; return line; }
+            char line[ORONUM_LOGGING_ASYNC_LINESIZE];
+        };
+
+        /**
+         * The asynchronous logging state of one thread. Only the owning
+         * thread writes to it, only the flusher reads the ring.
+         */
+        struct ThreadLog
+        {
+            ThreadLog(unsigned int lines)
+                : ring(lines, base::BufferBase::Options().max_threads(1)), line(&buf), level(Info)
+            {
+                setModule("Logger");
+                oro_atomic_set(&state, Free);
+            }
+
+            void setModule(const char* name)
+            {
+                strncpy(module, name, sizeof(module) - 1);
+                module[sizeof(module) - 1] = '\0';
+            }
+
+            base::BufferLockFreeSPSC<AsyncRecord> ring;
+            LineBuf buf;
+            std::ostream line;
+            LogLevel level;
+            char module[sizeof(AsyncRecord().module)];
+            os::AtomicInt dropped;
+            /**
+             * Free, Owned by a thread, or Released by a thread that exited.
+             */
+            oro_atomic_t state;
+        };
+
+        static const int Free = 0, Owned = 1, Released = 2;
+
+        /**
+         * The low priority thread which periodically drains all rings.
+         */
+        struct Flusher : public os::Thread
+        {
+            Flusher(D* owner)
+                : os::Thread(ORO_SCHED_OTHER, os::LowestPriority, 0.05, 0, "LoggerFlusher"),
+                  owner(owner)
+            {}
+
+            virtual void step() { owner->drain(); }
+
+            D* owner;
+        };
+
+        /**
+         * Returns the ThreadLog of the calling thread. The first call of
+         * each thread claims a free one, without locking or allocating.
+         * Returns null if all are in use, then the thread logs synchronously.
+         */
+        ThreadLog* threadLog()
+        {
+            if ( void* current = threadlog.get() )
+                return static_cast<ThreadLog*>(current);
+            for (std::vector<ThreadLog*>::iterator it = threadlogs.begin(); it != threadlogs.end(); ++it) {
+                ThreadLog* tl = *it;
+                if ( oro_atomic_read(&tl->state) == Free && os::CAS(&tl->state, Free, Owned) ) {
+                    threadlog.set(tl);
+                    return tl;
+                }
+            }
+            return 0;
+        }
+
+        /**
+         * Called when a thread with a ThreadLog exits. The flusher reuses
+         * the ThreadLog once it wrote out its pending lines.
+         */
+        static void releaseThreadLog(void* arg)
+        {
+            ThreadLog* tl = static_cast<ThreadLog*>(arg);
+            os::CAS(&tl->state, Owned, Released);
+        }
+
+        /**
+         * Hands the line of the calling thread to the flusher.
+         */
+        void logAsync(ThreadLog* tl)
+        {
+            if ( maylogStdOut(tl->level) || maylogFile(tl->level) ) {
+                AsyncRecord* rec = tl->ring.Loan();
+                if ( rec ) {
+                    rec->stamp = TimeService::Instance()->getTicks();
+                    rec->level = tl->level;
+                    strcpy( rec->module, tl->module );
+                    strcpy( rec->text, tl->buf.str() );
+                    tl->ring.Commit( rec );
+                } else
+                    tl->dropped.inc();
+            }
+            tl->buf.reset();
+            tl->line.clear();
+        }
+
+        /**
+         * Writes one asynchronous log line to all outputs.
+         */
+        void emit(LogLevel ll, TimeService::ticks stamp, const char* module, const char* text)
+        {
+            os::MutexLock lock( inpguard );
+            std::string res = showTime(stamp) + " " + showLevel(ll) + "[" + module + "] ";
+
+            if ( maylogStdOut(ll) ) {
+#ifndef OROSEM_PRINTF_LOGGING
+                *stdoutput << res << text << '\n';
+#else
+                printf("%s%s\n", res.c_str(), text );
+#endif
+            }
+
+            if ( maylogFile(ll) ) {
+#ifdef OROSEM_FILE_LOGGING
+#if     defined(OROSEM_LOG4CPP_LOGGING)
+                category.log(level2Priority(ll), text);
+#elif   !defined(OROSEM_PRINTF_LOGGING)
+                logfile << res << text << '\n';
+#else
+                fprintf( logfile, "%s%s\n", res.c_str(), text );
+#endif
+#ifdef OROSEM_REMOTE_LOGGING
+                remotestring.Push(res + text);
+#endif
+#endif
+            }
+        }
+
+        /**
+         * Writes out the pending lines of all threads and reports
+         * the lines that were dropped in the mean time. Only called by
+         * the flusher, or when no flusher runs.
+         */
+        void drain()
+        {
+            for (std::vector<ThreadLog*>::iterator it = threadlogs.begin(); it != threadlogs.end(); ++it) {
+                ThreadLog* tl = *it;
+                // the lines of an exited thread were all committed before it released tl.
+                bool released = oro_atomic_read(&tl->state) == Released;
+                AsyncRecord* rec;
+                while ( (rec = tl->ring.PopWithoutRelease()) ) {
+                    emit( rec->level, rec->stamp, rec->module, rec->text );
+                    tl->ring.Release( rec );
+                }
+                int lost = tl->dropped.read();
+                if ( lost ) {
+                    tl->dropped.sub( lost );
+                    droppedRecords.add( lost );
+                    std::stringstream msg;
+                    msg << "Dropped " << lost << " log lines of a thread in module '" << tl->module
+                        << "' because its asynchronous log buffer was full.";
+                    emit( Warning, TimeService::Instance()->getTicks(), "Logger", msg.str().c_str() );
+                }
+                if ( released ) {
+                    tl->level = Info;
+                    tl->setModule("Logger");
+                    os::CAS(&tl->state, Released, Free);
+                }
+            }
+
+            os::MutexLock outlock( inpguard );
+#ifndef OROSEM_PRINTF_LOGGING
+            stdoutput->flush();
+#if     defined(OROSEM_FILE_LOGGING) && !defined(OROSEM_LOG4CPP_LOGGING)
+            logfile.flush();
+#endif
+#endif
+        }
+
 #ifndef OROSEM_PRINTF_LOGGING
         std::ostream* stdoutput;
 #endif
@@ -267,6 +506,17 @@ namespace RTT
             return time.str();
         }
 
+        /**
+         * As showTime(), but for a line logged at \a stamp.
+         */
+        std::string showTime(TimeService::ticks stamp) const
+        {
+            std::stringstream time;
+            if ( showtime )
+                time <<fixed<< showpoint << setprecision(3) << Seconds(TimeService::ticks2nsecs(stamp - timestamp))/NSECS_IN_SECS;
+            return time.str();
+        }
+
         /**
          * Convert a loglevel to a string representation.
          */
@@ -320,6 +570,27 @@ namespace RTT
         std::string moduleptr;
 
         os::Mutex inpguard;
+
+        /**
+         * Asynchronous logging is in effect. Read by all logging threads.
+         */
+        os::AtomicInt async;
+
+        Flusher* flusher;
+
+        /**
+         * The ThreadLogs that threads claim when they log asynchronously.
+         * They are allocated when asynchronous logging is enabled the first
+         * time and live as long as this object.
+         */
+        std::vector<ThreadLog*> threadlogs;
+
+        /**
+         * The ThreadLog claimed by each thread, which is released when it exits.
+         */
+        os::ThreadLocal<&D::releaseThreadLog> threadlog;
+
+        os::AtomicInt droppedRecords;
     };
 
     Logger::Logger(std::ostream& str)
@@ -339,11 +610,23 @@ namespace RTT
     }
 
     bool Logger::mayLogFile() const {
-        return d->maylogFile();
+        return d->maylogFile(d->inloglevel);
     }
 
     bool Logger::mayLogStdOut() const {
-        return d->maylogStdOut();
+        return d->maylogStdOut(d->inloglevel);
+    }
+
+    std::ostream* Logger::asyncline() {
+        if ( !d->async.read() )
+            return 0;
+        D::ThreadLog* tl = d->threadLog();
+        if ( !tl )
+            return 0;
+        // drop the fragments of lines that will not be logged.
+        if ( !d->maylogStdOut(tl->level) && !d->maylogFile(tl->level) )
+            tl->line.setstate( std::ios_base::badbit );
+        return &tl->line;
     }
 
     void Logger::mayLogStdOut(bool tf) {
@@ -364,6 +647,42 @@ namespace RTT
         d->allowRT = false;
     }
 
+    void Logger::allowAsync(unsigned int lines, unsigned int threads) {
+        if ( d->async.read() )
+            return;
+        *this << Logger::Info << "Enabling asynchronous logging." << Logger::endl;
+        if ( lines == 0 )
+            lines = ORONUM_LOGGING_ASYNC_RECORDS;
+        if ( threads == 0 )
+            threads = ORONUM_LOGGING_ASYNC_THREADS;
+        if ( d->threadlogs.empty() )
+            for (unsigned int i = 0; i != threads; ++i)
+                d->threadlogs.push_back( new D::ThreadLog(lines) );
+        d->flusher = new D::Flusher(d);
+        d->flusher->start();
+        d->async.set(1);
+    }
+
+    void Logger::disallowAsync() {
+        if ( !d->async.read() )
+            return;
+        d->async.set(0);
+        d->flusher->stop();
+        delete d->flusher;
+        d->flusher = 0;
+        // write out what was logged in the mean time.
+        d->drain();
+        *this << Logger::Info << "Disabled asynchronous logging." << Logger::endl;
+    }
+
+    bool Logger::isAsync() const {
+        return d->async.read() != 0;
+    }
+
+    unsigned int Logger::getDroppedRecords() const {
+        return d->droppedRecords.read();
+    }
+
     TimeService::ticks Logger::getReferenceTime()const
     {
         return d->timestamp;
@@ -415,6 +734,12 @@ namespace RTT
     {
         if ( !d->maylog() )
             return *this;
+        if ( d->async.read() ) {
+            if ( D::ThreadLog* tl = d->threadLog() ) {
+                tl->setModule( modname.c_str() );
+                return *this;
+            }
+        }
         os::MutexLock lock( d->inpguard );
         d->moduleptr = modname.c_str();
         return *this;
@@ -424,6 +749,12 @@ namespace RTT
     {
         if ( !d->maylog() )
             return *this;
+        if ( d->async.read() ) {
+            if ( D::ThreadLog* tl = d->threadLog() ) {
+                tl->setModule( oldmod.c_str() );
+                return *this;
+            }
+        }
         os::MutexLock lock( d->inpguard );
         d->moduleptr = oldmod.c_str();
         return *this;
@@ -432,6 +763,10 @@ namespace RTT
     std::string Logger::getLogModule() const {
         if ( !d->maylog() )
             return "";
+        if ( d->async.read() ) {
+            if ( D::ThreadLog* tl = d->threadLog() )
+                return tl->module;
+        }
         os::MutexLock lock( d->inpguard );
         std::string ret = d->moduleptr.c_str();
         return ret;
@@ -494,6 +829,7 @@ namespace RTT
     void Logger::shutdown() {
         if (!d->started)
             return;
+        this->disallowAsync();
         *this<<Logger::Info<<"Orocos Logging Deactivated." << Logger::endl;
         this->logflush();
         d->started = false;
@@ -525,13 +861,18 @@ namespace RTT
         if ( !d->maylog() )
             return *this;
 
+        if ( std::ostream* line = asyncline() ) {
+            *line << t;
+            return *this;
+        }
+
         os::MutexLock lock( d->inpguard );
-        if ( d->maylogStdOut() )
+        if ( d->maylogStdOut(d->inloglevel) )
             d->logline << t;
 
 #if defined(OROSEM_FILE_LOGGING) || defined(OROSEM_REMOTE_LOGGING)
         // log Info or better to log file, even if not started.
-        if ( d->maylogFile() )
+        if ( d->maylogFile(d->inloglevel) )
             d->fileline << t;
 #endif
         return *this;
@@ -544,6 +885,12 @@ namespace RTT
     Logger& Logger::operator<<(LogLevel ll) {
         if ( !d->maylog() )
             return *this;
+        if ( d->async.read() ) {
+            if ( D::ThreadLog* tl = d->threadLog() ) {
+                tl->level = ll;
+                return *this;
+            }
+        }
         d->inloglevel = ll;
         return *this;
     }
@@ -558,12 +905,14 @@ namespace RTT
             this->lognl();
         else if ( pf == Logger::flush )
             this->logflush();
+        else if ( std::ostream* line = asyncline() )
+            *line << pf;
         else {
             os::MutexLock lock( d->inpguard );
-            if ( d->maylogStdOut() )
+            if ( d->maylogStdOut(d->inloglevel) )
                 d->logline << pf; // normal std operator in stream.
 #if defined(OROSEM_FILE_LOGGING) || defined(OROSEM_REMOTE_LOGGING)
-            if ( d->maylogFile() )
+            if ( d->maylogFile(d->inloglevel) )
                 d->fileline << pf;
 #endif
         }
@@ -571,18 +920,19 @@ namespace RTT
     }
 
     void Logger::logflush() {
-        if (!d->maylog())
+        // the flusher thread flushes in asynchronous mode.
+        if (!d->maylog() || d->async.read())
             return;
         {
             // just flush all buffers, do not produce a new logline
             os::MutexLock lock( d->inpguard );
-            if ( d->maylogStdOut() ) {
+            if ( d->maylogStdOut(d->inloglevel) ) {
 #ifndef OROSEM_PRINTF_LOGGING
                 d->stdoutput->flush();
 #endif
             }
 #if defined(OROSEM_FILE_LOGGING)
-            if ( d->maylogFile() ) {
+            if ( d->maylogFile(d->inloglevel) ) {
 #ifndef OROSEM_PRINTF_LOGGING
                 d->logfile.flush();
 #endif
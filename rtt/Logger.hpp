@@ -90,6 +90,8 @@ namespace RTT
      * is 6 or lower, these messages will not appear and do no harm to real-time performance.
      * You need to call @verbatim Logger::log().allowRealTime(); @endverbatim once in your program
      * to confirm this choice. AGAIN: THIS WILL BREAK REAL-TIME PERFORMANCE.
+     * Unless you also call @verbatim Logger::log().allowAsync(); @endverbatim
+     * which moves all output to a low priority flusher thread.
      * @ingroup CoreLib
      */
     class RTT_API Logger
@@ -130,6 +132,48 @@ namespace RTT
          */
         void disallowRealTime();
 
+        /**
+         * Switch to asynchronous logging. From then on, each thread formats its
+         * messages in a private, fixed size line buffer and hands each finished
+         * line to its own lock-free ring buffer. A low priority flusher thread
+         * drains these rings to the console, the log file and the remote log
+         * buffer. Writing a message never blocks and never waits on another
+         * thread, which makes logging from real-time threads feasible.
+         * Lines longer than the line buffer are truncated and lines that do
+         * not fit in a full ring are dropped and counted, see getDroppedRecords().
+         *
+         * The rings are allocated by the first call, with the sizes given to it,
+         * and are kept until the Logger is destroyed. A thread claims one with
+         * the first message it logs and hands it back when it exits.
+         * The LogLevel and the module (see In) are kept per thread in this mode.
+         *
+         * @param lines The number of lines each thread can have pending, or zero
+         * for ORONUM_LOGGING_ASYNC_RECORDS (31). Each line takes
+         * ORONUM_LOGGING_ASYNC_LINESIZE (256) bytes plus about 80 bytes, and
+         * the ring rounds the number up such that one more is a power of two.
+         * @param threads The number of threads that can log asynchronously
+         * at the same time, or zero for ORONUM_LOGGING_ASYNC_THREADS (16).
+         * Other threads log synchronously.
+         */
+        void allowAsync(unsigned int lines = 0, unsigned int threads = 0);
+
+        /**
+         * Stop the flusher thread, write out all pending asynchronous log
+         * lines and return to synchronous logging.
+         */
+        void disallowAsync();
+
+        /**
+         * Returns true if allowAsync() is in effect.
+         */
+        bool isAsync() const;
+
+        /**
+         * Returns the number of log lines that were dropped since
+         * the first allowAsync() because a thread's ring buffer was full.
+         */
+        unsigned int getDroppedRecords() const;
+
         /**
          * Toggles the flag if the logger may log to the
          * standard output stream.
@@ -329,6 +373,12 @@ namespace RTT
         bool mayLogStdOut() const;
         bool mayLogFile() const;
 
+        /**
+         * Returns the line buffer of the calling thread if
+         * asynchronous logging is in effect, null otherwise.
+         */
+        std::ostream* asyncline();
+
         Logger(std::ostream& str=std::cerr);
         ~Logger();
 
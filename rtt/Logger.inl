@@ -55,6 +55,11 @@ namespace RTT
         if ( !mayLog() )
             return *this;
 
+        if ( std::ostream* line = asyncline() ) {
+            *line << t;
+            return *this;
+        }
+
         os::MutexLock lock( inpguard );
         if ( this->mayLogStdOut() )
             logline << t;
@@ -95,6 +100,20 @@ namespace RTT
     inline void Logger::disallowRealTime() {
     }
 
+    inline void Logger::allowAsync(unsigned int, unsigned int) {
+    }
+
+    inline void Logger::disallowAsync() {
+    }
+
+    inline bool Logger::isAsync() const {
+        return false;
+    }
+
+    inline unsigned int Logger::getDroppedRecords() const {
+        return 0;
+    }
+
     inline std::ostream&
     Logger::nl(std::ostream& __os)
     {
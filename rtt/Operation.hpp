@@ -136,6 +136,16 @@ namespace RTT
          */
         Operation<Signature>& arg(const std::string& name, const std::string& description) { marg(name, description); return *this; }
 
+        /**
+         * Set the priority class of the messages with which this operation
+         * is executed in its owner's ExecutionEngine when it is sent or
+         * called with OwnThread semantics. Defaults to NormalPriority.
+         * The priority is kept when calls() sets another function.
+         * @param p The priority class of this operation.
+         * @return A reference to this object.
+         */
+        Operation<Signature>& priority(MessagePriority p) { impl->setPriority(p); return *this; }
+
         /**
          * Indicate that this operation calls a given function.
          * This will replace any previously registered function present in this operation.
@@ -147,7 +157,9 @@ namespace RTT
         Operation& calls(boost::function<Signature> func, ExecutionThread et = ClientThread, ExecutionEngine* ownerEngine = NULL ) {
             // creates a Local OperationCaller
             ExecutionEngine* null_caller = 0;
+            MessagePriority p = impl ? impl->getPriority() : NormalPriority;
             impl = boost::make_shared<internal::LocalOperationCaller<Signature> >(func, ownerEngine ? ownerEngine : this->mowner, null_caller, et);
+            impl->setPriority(p);
 #ifdef ORO_SIGNALLING_OPERATIONS
             if (signal)
                 impl->setSignal(signal);
@@ -168,7 +180,9 @@ namespace RTT
         Operation& calls(Function func, Object o, ExecutionThread et = ClientThread, ExecutionEngine* ownerEngine = NULL ) {
             // creates a Local OperationCaller or sets function
             ExecutionEngine* null_caller = 0;
+            MessagePriority p = impl ? impl->getPriority() : NormalPriority;
             impl = boost::make_shared<internal::LocalOperationCaller<Signature> >(func, o, ownerEngine ? ownerEngine : this->mowner, null_caller, et);
+            impl->setPriority(p);
 #ifdef ORO_SIGNALLING_OPERATIONS
             if (signal)
                 impl->setSignal(signal);
@@ -370,6 +370,26 @@ namespace RTT
                 this->impl->setCaller(caller);
         }
 
+        /**
+         * Limits the number of send() invocations of this OperationCaller
+         * which can be pending at the same time to \a n, and pre-allocates
+         * their storage such that send() does not allocate memory.
+         * When all \a n invocations are in use, send() returns a SendHandle
+         * which is not ready() and of which collect() returns SendFailure.
+         * An invocation is available again once its SendHandle is destroyed
+         * and it has been executed.
+         * Setting \a n to zero restores the default, where the storage of each
+         * send() is allocated from the real-time allocator.
+         *
+         * The limit applies to the current implementation. It must be set
+         * again after this OperationCaller is assigned or set up again.
+         * @return false if the implementation is not local.
+         * @nrt
+         */
+        bool setMaxConcurrentSends(unsigned int n) {
+            return this->impl && this->impl->setMaxConcurrentSends(n);
+        }
+
         void disconnect()
         {
             this->impl.reset();
@@ -44,6 +44,7 @@
 #include "internal/DataObjectDataSource.hpp"
 #include "internal/Channels.hpp"
 #include "internal/ConnFactory.hpp"
+#include "LoanedSample.hpp"
 #include "Service.hpp"
 #include "OperationCaller.hpp"
 
@@ -262,6 +263,100 @@ namespace RTT
             return result;
         }
 
+        /**
+         * Writes a batch of samples to all receivers (if any), oldest first.
+         * Buffered connections store the whole batch at once and wake up the
+         * reader only once. Data connections only keep the last sample.
+         * @param samples The new samples to send out.
+         */
+        WriteStatus write(const std::vector<T>& samples)
+        {
+            if (samples.empty())
+                return connected() ? WriteSuccess : NotConnected;
+
+            if (keeps_last_written_value || keeps_next_written_value)
+            {
+                keeps_next_written_value = false;
+                has_initial_sample = true;
+                this->sample->Set(samples.back());
+            }
+            has_last_written_value = keeps_last_written_value;
+
+            WriteStatus result = NotConnected;
+            if (connected()) {
+                traceWrite();
+                result = getEndpoint()->getWriteEndpoint()->writeAll(samples);
+                if (result == NotConnected) {
+                    log(Error) << "A channel of port " << getName() << " has been invalidated during write(), it will be removed" << endlog();
+                }
+            }
+
+            return result;
+        }
+
+        /**
+         * Writes the samples in the range [\a first, \a last) as one batch.
+         * The samples are copied into a temporary std::vector first, use
+         * write(const std::vector<T>&) in real-time code.
+         * @see write(const std::vector<T>&)
+         */
+        template<typename InputIterator>
+        WriteStatus write(InputIterator first, InputIterator last)
+        {
+            return write(std::vector<T>(first, last));
+        }
+
+        /**
+         * Borrows a sample from the data storage of the connection, such that
+         * the next sample can be filled in-place and written with
+         * write(LoanedSample<T>&) without being copied into the connection.
+         *
+         * Loans are only possible if this port has exactly one lock-free
+         * connection or a shared output buffer. Otherwise, this function
+         * returns false and the sample should be written with write(const T&).
+         * @param sample The handle which will refer to the borrowed sample.
+         * @return true if \a sample refers to a borrowed sample.
+         */
+        bool loan(LoanedSample<T>& sample)
+        {
+            sample.reset();
+            if (!connected())
+                return false;
+            sample.sample = getEndpoint()->getWriteEndpoint()->loan(sample.owner);
+            return sample.sample != 0;
+        }
+
+        /**
+         * Writes a sample borrowed with loan() to the receivers.
+         * The sample is owned by the connection again after this call
+         * and \a sample is reset. If this port keeps its last written value,
+         * the sample is still copied once into the port.
+         * @param sample The borrowed sample to send out.
+         */
+        WriteStatus write(LoanedSample<T>& sample)
+        {
+            if (!sample.valid())
+                return WriteFailure;
+
+            if (keeps_last_written_value || keeps_next_written_value)
+            {
+                keeps_next_written_value = false;
+                has_initial_sample = true;
+                this->sample->Set(*sample);
+            }
+            has_last_written_value = keeps_last_written_value;
+
+            traceWrite();
+            WriteStatus result = getEndpoint()->getWriteEndpoint()->commit(sample.sample, sample.owner.get());
+            if (result == NotConnected) {
+                log(Error) << "A channel of port " << getName() << " has been invalidated during write(), it will be removed" << endlog();
+            }
+
+            // discards the sample if it did not reach its connection
+            sample.reset();
+            return result;
+        }
+
         WriteStatus write(base::DataSourceBase::shared_ptr source)
         {
             typename internal::AssignableDataSource<T>::shared_ptr ds =
@@ -50,6 +50,7 @@
 #include "internal/DataSource.hpp"
 #include "internal/mystd.hpp"
 #include "internal/MWSRQueue.hpp"
+#include "internal/PortCallback.hpp"
 #include "OperationCaller.hpp"
 
 #include "rtt-config.h"
@@ -144,6 +145,10 @@ namespace RTT
             }
             // Do not call this->disconnect() !!!
             // Ports are probably already destructed by user code.
+
+            // the engine no longer runs, so no entry is in use.
+            for (PortCallbacks::iterator it = port_callbacks.begin(); it != port_callbacks.end(); ++it)
+                delete *it;
         }
 
     bool TaskContext::connectPorts( TaskContext* peer )
@@ -437,7 +442,7 @@ namespace RTT
     void TaskContext::dataOnPort(PortInterface* port)
     {
         if ( this->dataOnPortHook(port) ) {
-            this->engine()->process(port);
+            this->engine()->process(port, port->getPriority());
         }
     }
 
@@ -446,22 +451,35 @@ namespace RTT
     }
 
     void TaskContext::dataOnPortCallback(PortInterface* port) {
-        UserCallbacks::iterator it = user_callbacks.find(port);
-        if (it != user_callbacks.end() )
-            it->second(port); // fire the user callback
+        if ( port->mcallback && port->mcallback->callback )
+            port->mcallback->callback(port); // fire the user callback
     }
 
     void TaskContext::setDataOnPortCallback(InputPortInterface* port, TaskContext::SlotFunction callback) {
-        // user_callbacks will only be emitted from updateHook().
+        // user callbacks will only be emitted from updateHook().
         MutexLock lock(mportlock);
-        user_callbacks[port] = callback;
+        if ( !port->mcallback ) {
+            // reuse the entry of a removed port, which may still be queued.
+            PortCallbacks::iterator it = port_callbacks.begin();
+            while ( it != port_callbacks.end() && (*it)->port )
+                ++it;
+            if ( it == port_callbacks.end() ) {
+                port_callbacks.push_back( new internal::PortCallback() );
+                it = port_callbacks.end() - 1;
+            }
+            (*it)->port = port;
+            port->mcallback = *it;
+        }
+        port->mcallback->callback = callback;
     }
 
     void TaskContext::removeDataOnPortCallback(PortInterface* port) {
         MutexLock lock(mportlock);
-        UserCallbacks::iterator it = user_callbacks.find(port);
-        if (it != user_callbacks.end() ) {
-            user_callbacks.erase(it);
-        }
+        if ( !port->mcallback )
+            return;
+        // the engine skips the entry if it is still queued.
+        port->mcallback->port = 0;
+        port->mcallback->callback.clear();
+        port->mcallback = 0;
     }
 }
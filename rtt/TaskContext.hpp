@@ -50,6 +50,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace RTT
 {
@@ -310,6 +311,9 @@ namespace RTT
 
         /**
          * Use this method to load a service known to RTT into this component.
+         * The \a connectionStatistics and \a threadStatistics services are
+         * built into RTT and registered in the PluginLoader, they are only
+         * created when loaded with this method.
          * @param service_name The name with which the service is registered by in the PluginLoader.
          * @return true if the service was present already or could be loaded.
          */
@@ -533,6 +537,9 @@ namespace RTT
          * @param callback (Optional) provide a function which will be called asynchronously
          * when new data arrives on this port. You can add more functions by using the port
          * directly using base::PortInterface::getNewDataOnPort().
+         * @note Samples which arrive before the callback was executed do not
+         * cause additional calls, so the callback must read all new data of
+         * the port, or the rest of a buffer stays unread until the next sample arrives.
          */
         base::InputPortInterface& addEventPort(const std::string& name, base::InputPortInterface& port, SlotFunction callback = SlotFunction() ) {
             port.setName(name);
@@ -546,6 +553,9 @@ namespace RTT
          * @param callback (Optional) provide a function which will be called asynchronously
          * when new data arrives on this port. You can add more functions by using the port
          * directly using base::PortInterface::getNewDataOnPort().
+         * @note Samples which arrive before the callback was executed do not
+         * cause additional calls, so the callback must read all new data of
+         * the port, or the rest of a buffer stays unread until the next sample arrives.
          */
         base::InputPortInterface& addEventPort(base::InputPortInterface& port, SlotFunction callback = SlotFunction() ) {
             return ports()->addEventPort(port,callback);
@@ -608,8 +618,10 @@ namespace RTT
 
         /**
          * This method implements port callbacks. It will be called
-         * once per sample received on the port and is executed
-         * in the component's thread.
+         * after one or more samples were received on the port and is executed
+         * in the component's thread. Samples which arrive before the
+         * callback is executed do not cause additional calls, so it
+         * should read all new data of the port.
          *
          * The default implementation invokes the user callback
          * if one was given in the addEventPort() call. It can be
@@ -649,8 +661,6 @@ namespace RTT
         void setup();
 
         friend class DataFlowInterface;
-        typedef std::map<base::PortInterface*, SlotFunction > UserCallbacks;
-        UserCallbacks user_callbacks;
 
         /**
          * This callback is called each time data arrived on an
@@ -684,6 +694,14 @@ namespace RTT
         ServiceRequester::shared_ptr tcrequests;
         os::Mutex mportlock;
 
+        typedef std::vector<internal::PortCallback*> PortCallbacks;
+        /**
+         * The callback entries of the event ports, which the ExecutionEngine
+         * queues. Entries of removed ports are reused, and only deleted with
+         * this object, since the engine may still have them queued.
+         */
+        PortCallbacks port_callbacks;
+
         // non copyable
         TaskContext( TaskContext& );
 
@@ -229,6 +229,16 @@ namespace RTT
          */
         virtual os::ThreadInterface* thread() = 0;
 
+        /**
+         * Returns the timing statistics of the thread which runs this
+         * activity. These are shared by all activities that thread runs.
+         * @return null if that thread does not record statistics.
+         */
+        os::ThreadStatistics* getThreadStatistics() {
+            os::ThreadInterface* t = thread();
+            return t ? t->getStatistics() : 0;
+        }
+
         /**
          * Returns a pointer to the RunnableInterface instance
          */
@@ -100,7 +100,7 @@ namespace RTT
 
         /**
          * Releases the pointer
-         * @param item pointer aquired using PopWithoutRelease()
+         * @param item pointer aquired using PopWithoutRelease() or Loan()
          **/
         virtual void Release(value_t *item) = 0;
 	
@@ -122,6 +122,32 @@ namespace RTT
          */
         virtual size_type Push( const std::vector<value_t>& items ) = 0;
 
+        /**
+         * Returns a pointer to a free element of the buffer, such that
+         * a sample can be constructed in-place instead of being copied
+         * by Push(). The contents of the element are unspecified (it holds
+         * the data sample or a previously written value).
+         *
+         * Note the pointer needs to be handed back to the buffer by calling
+         * either Commit() or Release() on the buffer.
+         *
+         * @return a pointer to a free element or Zero if the buffer is full
+         * or if this buffer implementation does not support loans.
+         * @cts
+         * @rt
+         */
+        virtual value_t* Loan() { return 0; }
+
+        /**
+         * Appends an element previously obtained by Loan() to the buffer.
+         * The buffer owns \a item again after this call, even if it returns false.
+         * @param item pointer aquired using Loan()
+         * @return false if the buffer is full and the item has been dropped.
+         * @cts
+         * @rt
+         */
+        virtual bool Commit(value_t *item) { return false; }
+
         /**
          * Initializes this buffer with a data sample, such that for
          * dynamical allocated types T, the buffer can reserve place
@@ -42,6 +42,7 @@
 #include "../os/Atomic.hpp"
 #include "../os/CAS.hpp"
 #include "BufferInterface.hpp"
+#include "SampleSlot.hpp"
 #include "../internal/AtomicMWSRQueue.hpp"
 #include "../internal/AtomicMWMRQueue.hpp"
 #include "../internal/TsPool.hpp"
@@ -181,7 +182,7 @@ namespace RTT
         {
             Item* item;
             while ( bufs->dequeue(item) )
-                mpool->deallocate( item );
+                deallocate( item );
         }
 
         virtual size_type dropped() const
@@ -191,34 +192,35 @@ namespace RTT
         
         bool Push( param_t item)
         {
-            if (!mcircular && ( capacity() == (size_type)bufs->size() )) {
+            // the sample is committed right away, so the oldest one may be dropped for it.
+            Item* mitem = allocate( /* evict = */ mcircular );
+            if ( mitem == 0 ) {
                 droppedSamples.inc();
                 return false;
-                // we will recover below in case of circular
-            }
-            Item* mitem = mpool->allocate();
-            if ( mitem == 0 ) { // queue full ( rare but possible in race with PopWithoutRelease )
-                if (!mcircular) {
-                    droppedSamples.inc();
-                    return false;
-                }
-                else {
-                    if (bufs->dequeue( mitem ) == false ) {
-                        droppedSamples.inc();
-                        return false; // assert(false) ???
-                    }
-                    // we keep mitem to write item to next
-                }
             }
 
             // copy over.
             *mitem = item;
+            return Commit( mitem );
+        }
+
+        /**
+         * A circular buffer only drops its oldest sample when the loaned
+         * one is committed, so a discarded loan does not lose a sample.
+         */
+        value_t* Loan()
+        {
+            return allocate( /* evict = */ false );
+        }
+
+        bool Commit(value_t *mitem)
+        {
             if (bufs->enqueue( mitem ) == false ) {
                 //got memory, but buffer is full
                 //this can happen, as the memory pool is
                 //bigger than the buffer
                 if (!mcircular) {
-                    mpool->deallocate( mitem );
+                    deallocate( mitem );
                     droppedSamples.inc();
                     return false;
                 } else {
@@ -226,7 +228,7 @@ namespace RTT
                     Item* itmp = 0;
                     do {
                         if ( bufs->dequeue( itmp ) ) {
-                            mpool->deallocate( itmp );
+                            deallocate( itmp );
                             droppedSamples.inc();
                         } else {
                             // Both operations, enqueue() and dequeue() failed on the buffer:
@@ -264,7 +266,7 @@ namespace RTT
             if (bufs->dequeue( ipop ) == false )
                 return NoData;
             item = *ipop;
-            if (mpool->deallocate( ipop ) == false )
+            if (deallocate( ipop ) == false )
                 assert(false);
             return NewData;
         }
@@ -275,7 +277,7 @@ namespace RTT
             items.clear();
             while( bufs->dequeue(ipop) ) {
                 items.push_back( *ipop );
-                if (mpool->deallocate(ipop) == false)
+                if (deallocate(ipop) == false)
                     assert(false);
             }
             return items.size();
@@ -291,9 +293,46 @@ namespace RTT
 
         void Release(value_t *item)
         {
-            if (mpool->deallocate( item ) == false )
+            if (deallocate( item ) == false )
                 assert(false);
         }
+
+    private:
+        /**
+         * Returns an element that was read to the pool.
+         */
+        bool deallocate(Item* item)
+        {
+            SampleSlot<T>::release( *item );
+            return mpool->deallocate( item );
+        }
+
+        /**
+         * Allocates an element from the pool. When the pool is exhausted and
+         * \a evict is true, the oldest sample in the buffer is taken instead.
+         */
+        Item* allocate(bool evict)
+        {
+            if (!mcircular && ( capacity() == (size_type)bufs->size() )) {
+                return 0;
+                // we will recover below in case of circular
+            }
+            Item* mitem = mpool->allocate();
+            if ( mitem == 0 ) { // queue full ( rare but possible in race with PopWithoutRelease )
+                if (!evict) {
+                    return 0;
+                }
+                else {
+                    if (bufs->dequeue( mitem ) == false ) {
+                        return 0; // assert(false) ???
+                    }
+                    SampleSlot<T>::release( *mitem );
+                    droppedSamples.inc();
+                    // we keep mitem to write item to next
+                }
+            }
+            return mitem;
+        }
     };
 }}
 
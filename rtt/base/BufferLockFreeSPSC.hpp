@@ -0,0 +1,329 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef ORO_BUFFER_LOCK_FREE_SPSC_HPP
+#define ORO_BUFFER_LOCK_FREE_SPSC_HPP
+
+#include "../os/oro_arch.h"
+#include "../os/Atomic.hpp"
+#include "BufferInterface.hpp"
+#include "SampleSlot.hpp"
+#include <vector>
+#include <algorithm>
+
+namespace RTT
+{ namespace base {
+
+    /**
+     * A wait-free buffer implementation to read and write data of type \a T
+     * in a FIFO way, for exactly one writer thread and one reader thread.
+     *
+     * The elements are stored in-place in a ring of slots, so Push() and Pop()
+     * only touch the slot and advance a single index. The writer and the reader
+     * indices live on separate cache lines, and each side caches the last value
+     * it has seen of the other side's index, such that the two threads only share
+     * a cache line when the buffer runs full or empty.
+     *
+     * The ring holds \a bufsize + \a max_threads slots (rounded up to a power of two),
+     * such that the reader can hold elements obtained with PopWithoutRelease() while
+     * the writer keeps on filling the buffer up to its capacity.
+     *
+     * This buffer does not support the circular option, Push() fails if the buffer
+     * is full.
+     *
+     * @param T The value type to be stored in the Buffer.
+     * @see BufferLockFree for the multi-writer and circular variant.
+     * @ingroup PortBuffers
+     */
+    template<class T>
+    class BufferLockFreeSPSC
+        : public BufferInterface<T>
+    {
+    public:
+        typedef typename BufferBase::Options Options;
+        typedef typename BufferInterface<T>::reference_t reference_t;
+        typedef typename BufferInterface<T>::param_t param_t;
+        typedef typename BufferInterface<T>::size_type size_type;
+        typedef T value_t;
+
+    private:
+        enum { CacheLineSize = 64 };
+
+        const unsigned int mcapacity;
+        const unsigned int mmask;
+        value_t* const mslots;
+        value_t mdata_sample;
+        bool initialized;
+
+        char pad_writer[CacheLineSize];
+        /// Index of the slot the writer fills next. Written by the writer only.
+        oro_atomic_t mhead;
+        /// Last seen values of mread and mtail. Writer side only.
+        unsigned int mcached_read, mcached_tail;
+        RTT::os::AtomicInt droppedSamples;
+
+        char pad_reader[CacheLineSize];
+        /// Index of the slot the reader pops next. Written by the reader only.
+        oro_atomic_t mread;
+        /// Index of the oldest slot not yet released by the reader. Written by the reader only.
+        oro_atomic_t mtail;
+        /// Last seen value of mhead. Reader side only.
+        unsigned int mcached_head;
+        /// Slots between mtail and mread that have been released out of order. Reader side only.
+        std::vector<char> mreleased;
+
+        char pad_end[CacheLineSize];
+
+        static unsigned int load(const oro_atomic_t& index)
+        {
+            return (unsigned int) oro_atomic_read(&index);
+        }
+
+        void init()
+        {
+            ORO_ATOMIC_SETUP(&mhead, 0);
+            ORO_ATOMIC_SETUP(&mread, 0);
+            ORO_ATOMIC_SETUP(&mtail, 0);
+            mcached_read = mcached_tail = mcached_head = 0;
+        }
+
+    public:
+        /**
+         * Returns the number of slots of a buffer which can store \a bufsize elements.
+         */
+        static unsigned int slotCount(unsigned int bufsize, const Options &options)
+        {
+            unsigned int n = 1;
+            while (n < bufsize + options.max_threads())
+                n <<= 1;
+            return n;
+        }
+
+        /**
+         * Create an uninitialized single-writer single-reader buffer which can store \a bufsize elements.
+         * @param bufsize the capacity of the buffer.
+         */
+        BufferLockFreeSPSC( unsigned int bufsize, const Options &options = Options() )
+            : mcapacity(bufsize), mmask(slotCount(bufsize, options) - 1)
+            , mslots(new value_t[mmask + 1]), mdata_sample(), initialized(false)
+            , droppedSamples(0), mreleased(mmask + 1, 0)
+        {
+            init();
+        }
+
+        /**
+         * Create a single-writer single-reader buffer which can store \a bufsize elements.
+         * @param bufsize the capacity of the buffer.
+         * @param initial_value A data sample with which each preallocated data element is initialized.
+         */
+        BufferLockFreeSPSC( unsigned int bufsize, param_t initial_value, const Options &options = Options() )
+            : mcapacity(bufsize), mmask(slotCount(bufsize, options) - 1)
+            , mslots(new value_t[mmask + 1]), mdata_sample(), initialized(false)
+            , droppedSamples(0), mreleased(mmask + 1, 0)
+        {
+            init();
+            data_sample( initial_value );
+        }
+
+        ~BufferLockFreeSPSC() {
+            ORO_ATOMIC_CLEANUP(&mhead);
+            ORO_ATOMIC_CLEANUP(&mread);
+            ORO_ATOMIC_CLEANUP(&mtail);
+            delete[] mslots;
+        }
+
+        virtual bool data_sample( param_t sample, bool reset = true )
+        {
+            if (!initialized || reset) {
+                mdata_sample = sample;
+                std::fill(mslots, mslots + mmask + 1, sample);
+                initialized = true;
+            }
+            return true;
+        }
+
+        virtual value_t data_sample() const
+        {
+            return mdata_sample;
+        }
+
+        size_type capacity() const
+        {
+            return mcapacity;
+        }
+
+        size_type size() const
+        {
+            return load(mhead) - load(mread);
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        bool full() const
+        {
+            return size() >= capacity();
+        }
+
+        /**
+         * Pops and releases all elements. Must be called by the reader.
+         */
+        void clear()
+        {
+            value_t* item;
+            while ( (item = PopWithoutRelease()) )
+                Release(item);
+        }
+
+        virtual size_type dropped() const
+        {
+            return droppedSamples.read();
+        }
+
+        bool Push( param_t item )
+        {
+            value_t* mitem = Loan();
+            if ( mitem == 0 ) {
+                droppedSamples.inc();
+                return false;
+            }
+            *mitem = item;
+            return Commit( mitem );
+        }
+
+        size_type Push(const std::vector<value_t>& items)
+        {
+            size_type written = 0;
+            typename std::vector<value_t>::const_iterator it;
+            for( it = items.begin(); it != items.end(); ++it) {
+                value_t* mitem = Loan();
+                if ( mitem == 0 )
+                    break;
+                *mitem = *it;
+                Commit( mitem );
+                written++;
+            }
+            droppedSamples.add(items.size() - written);
+            return written;
+        }
+
+        value_t* Loan()
+        {
+            unsigned int head = load(mhead);
+            if (head - mcached_read >= mcapacity) {
+                mcached_read = load(mread);
+                if (head - mcached_read >= mcapacity)
+                    return 0;
+            }
+            // the slot may still be held by the reader after a PopWithoutRelease()
+            if (head - mcached_tail > mmask) {
+                mcached_tail = load(mtail);
+                if (head - mcached_tail > mmask)
+                    return 0;
+            }
+            return &mslots[head & mmask];
+        }
+
+        bool Commit(value_t *item)
+        {
+            unsigned int head = load(mhead);
+            if (item != &mslots[head & mmask])
+                return false;
+            // full barrier: the contents of the slot are visible before the new head.
+            oro_atomic_inc(&mhead);
+            return true;
+        }
+
+        FlowStatus Pop( reference_t item )
+        {
+            value_t* ipop = PopWithoutRelease();
+            if (ipop == 0)
+                return NoData;
+            item = *ipop;
+            Release(ipop);
+            return NewData;
+        }
+
+        size_type Pop(std::vector<value_t>& items )
+        {
+            value_t* ipop;
+            items.clear();
+            while( (ipop = PopWithoutRelease()) ) {
+                items.push_back( *ipop );
+                Release(ipop);
+            }
+            return items.size();
+        }
+
+        value_t* PopWithoutRelease()
+        {
+            unsigned int read = load(mread);
+            if (read == mcached_head) {
+                mcached_head = load(mhead);
+                if (read == mcached_head)
+                    return 0;
+            }
+            value_t* ipop = &mslots[read & mmask];
+            // full barrier: the slot is only read after the head has been seen.
+            oro_atomic_inc(&mread);
+            return ipop;
+        }
+
+        /**
+         * Releases an element obtained by PopWithoutRelease() (reader side)
+         * or discards an element obtained by Loan() without committing it
+         * (writer side). Elements can be released in any order.
+         */
+        void Release(value_t *item)
+        {
+            if (item < mslots || item > mslots + mmask)
+                return;
+            unsigned int index = item - mslots;
+            unsigned int tail = load(mtail);
+            unsigned int read = load(mread);
+            // Only the slots in [tail, read) are held by the reader. Any other slot
+            // is an uncommitted loan of the writer, which needs no action.
+            if (((index - tail) & mmask) >= read - tail)
+                return;
+            SampleSlot<T>::release(*item);
+            mreleased[index] = 1;
+            unsigned int released = 0;
+            while (tail + released != read && mreleased[(tail + released) & mmask]) {
+                mreleased[(tail + released) & mmask] = 0;
+                ++released;
+            }
+            // full barrier: the reader is done with the slots before the writer may reuse them.
+            if (released)
+                oro_atomic_add(&mtail, released);
+        }
+    };
+}}
+
+#endif
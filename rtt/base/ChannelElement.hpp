@@ -45,8 +45,11 @@
 #include "../ConnPolicy.hpp"
 #include "../FlowStatus.hpp"
 #include "../os/MutexLock.hpp"
+#include "../internal/SharedSample.hpp"
 
 #include <boost/bind.hpp>
+#include <vector>
+#include <algorithm>
 
 namespace RTT { namespace base {
 
@@ -123,6 +126,120 @@ namespace RTT { namespace base {
             else
                 return NoData;
         }
+
+        /** Writes a batch of samples on this connection, in order.
+         * Elements that store data override this method such that the whole
+         * batch is stored at once and the reader is signalled only once.
+         * By default, the samples are written one by one with write().
+         *
+         * @returns NotConnected if the channel has been invalidated, WriteFailure
+         * if at least one sample could not be written and WriteSuccess otherwise.
+         */
+        virtual WriteStatus writeAll(const std::vector<value_t>& samples)
+        {
+            WriteStatus result = WriteSuccess;
+            for(typename std::vector<value_t>::const_iterator it = samples.begin(); it != samples.end(); ++it)
+            {
+                WriteStatus fs = this->write(*it);
+                if (fs == NotConnected) return NotConnected;
+                if (result < fs) result = fs;
+            }
+            return result;
+        }
+
+        /** Reads all new samples available on this connection and appends them,
+         * oldest first, to \a samples. Elements that store data override this
+         * method such that the samples are taken from the storage at once.
+         * By default, read() is called until it returns no more new data.
+         *
+         * @returns NewData if at least one sample was appended, NoData otherwise.
+         */
+        virtual FlowStatus readAll(std::vector<value_t>& samples)
+        {
+            FlowStatus result = NoData;
+            value_t sample = value_t();
+            while (this->read(sample, false) == NewData)
+            {
+                samples.push_back(sample);
+                result = NewData;
+            }
+            return result;
+        }
+
+        /** Borrows a sample from the data storage of this connection, such that
+         * the writer can fill it in-place instead of having it copied by write().
+         * By default, the channel element forwards the call to its output.
+         *
+         * @param owner is set to the channel element that owns the returned sample.
+         * @returns a pointer to the borrowed sample or Zero if the connection does
+         * not support loans. A non-Zero sample must be handed back by
+         * calling commit() on this element or discard() on \a owner.
+         */
+        virtual value_t* loan(shared_ptr& owner)
+        {
+            typename ChannelElement<T>::shared_ptr output = getOutput();
+            if (output)
+                return output->loan(owner);
+            return 0;
+        }
+
+        /** Writes a sample obtained by loan() on this connection.
+         * When the element \a owner takes the sample back, it sets \a sample to
+         * Zero. If \a sample is not Zero after this call, the sample did not
+         * reach its owner and must be discarded by the caller.
+         *
+         * @returns the same as write()
+         */
+        virtual WriteStatus commit(value_t*& sample, ChannelElement<T>* owner)
+        {
+            typename ChannelElement<T>::shared_ptr output = getOutput();
+            if (output)
+                return output->commit(sample, owner);
+            return NotConnected;
+        }
+
+        /** Hands back a sample obtained by loan() without writing it.
+         * This must be called on the owner returned by loan().
+         */
+        virtual void discard(value_t* sample)
+        {
+        }
+
+        /** Reads a sample from the connection without copying it. If a sample
+         * is available, \a sample points to it until it is handed back
+         * by calling release() on \a owner. Writers will not modify it in the
+         * mean time.
+         *
+         * @returns NewData or OldData if \a sample is valid, NoData otherwise. Buffered
+         * connections consume the loaned sample and never return OldData.
+         */
+        virtual FlowStatus readLoan(value_t*& sample, shared_ptr& owner)
+        {
+            typename ChannelElement<T>::shared_ptr input = this->getInput();
+            if (input)
+                return input->readLoan(sample, owner);
+            else
+                return NoData;
+        }
+
+        /** Hands back a sample obtained by readLoan().
+         * This must be called on the owner returned by readLoan().
+         */
+        virtual void release(value_t* sample)
+        {
+        }
+
+        /** Writes a sample that is shared with other connections.
+         * Elements that store samples by reference override this method
+         * to keep a reference to \a sample instead of a copy.
+         * By default, the sample is copied with write().
+         *
+         * @returns the same as write()
+         */
+        virtual WriteStatus writeShared(const internal::SharedSample<T>& sample)
+        {
+            return this->write(*sample);
+        }
     };
 
     /** A typed version of MultipleInputsChannelElementBase.
@@ -137,7 +254,7 @@ namespace RTT { namespace base {
         typedef typename ChannelElement<T>::reference_t reference_t;
 
         MultipleInputsChannelElement()
-            : last()
+            : last(0)
         {}
 
         /**
@@ -145,8 +262,10 @@ namespace RTT { namespace base {
          */
         virtual value_t data_sample()
         {
-            RTT::os::SharedMutexLock lock(inputs_lock);
-            typename ChannelElement<T>::shared_ptr input = currentInput();
+            RTT::os::Epoch::Guard guard;
+            const Inputs &snapshot = inputs.get();
+            if (snapshot.empty()) return value_t();
+            typename ChannelElement<T>::shared_ptr input = snapshot[currentInput(snapshot)]->template narrow<T>();
             if (input) {
                 return input->data_sample();
             }
@@ -161,18 +280,54 @@ namespace RTT { namespace base {
         virtual FlowStatus read(reference_t sample, bool copy_old_data = true)
         {
             FlowStatus result = NoData;
-            RTT::os::SharedMutexLock lock(inputs_lock);
+            RTT::os::Epoch::Guard guard;
 
             // read and iterate if necessary.
             select_reader_channel( boost::bind( &MultipleInputsChannelElement<T>::do_read, this, boost::ref(sample), boost::ref(result), _1, _2), copy_old_data );
             return result;
         }
 
+        /** Reads a sample from the connection without copying it.
+         * Old data is only returned for the currently selected input.
+         */
+        virtual FlowStatus readLoan(value_t*& sample, typename ChannelElement<T>::shared_ptr& owner)
+        {
+            FlowStatus result = NoData;
+            sample = 0;
+            RTT::os::Epoch::Guard guard;
+
+            select_reader_channel( boost::bind( &MultipleInputsChannelElement<T>::do_read_loan, this, boost::ref(sample), boost::ref(owner), boost::ref(result), _1, _2), true );
+            return result;
+        }
+
+        /** Reads all new samples of all inputs.
+         * The samples of one input are kept in order, but the inputs are not merged in time.
+         */
+        virtual FlowStatus readAll(std::vector<value_t>& samples)
+        {
+            FlowStatus result = NoData;
+            RTT::os::Epoch::Guard guard;
+            const Inputs &snapshot = inputs.get();
+            for(std::size_t index = 0; index < snapshot.size(); ++index)
+            {
+                typename ChannelElement<T>::shared_ptr input = snapshot[index]->template narrow<T>();
+                if (input->readAll(samples) == NewData) {
+                    result = NewData;
+                    last = index;
+                }
+            }
+            return result;
+        }
+
     private:
-        typename ChannelElement<T>::shared_ptr currentInput() {
-            typename ChannelElement<T>::shared_ptr last = this->last;
-            if ( !last && !inputs.empty() ) last = inputs.front()->template narrow<T>();
-            return last;
+        /**
+         * Returns the index of the currently selected input in a non-empty
+         * \a snapshot of the inputs list.
+         */
+        std::size_t currentInput(const Inputs &snapshot) const {
+            std::size_t index = last;
+            // last may refer to a list that has been replaced in the meantime
+            return (index < snapshot.size()) ? index : 0;
         }
 
         bool do_read(reference_t sample, FlowStatus& result, bool copy_old_data, typename ChannelElement<T>::shared_ptr& input)
@@ -192,59 +347,105 @@ namespace RTT { namespace base {
             return false;
         }
 
+        bool do_read_loan(value_t*& sample, typename ChannelElement<T>::shared_ptr& owner, FlowStatus& result, bool copy_old_data, typename ChannelElement<T>::shared_ptr& input)
+        {
+            assert( result != NewData );
+            if ( input ) {
+                value_t* tsample = 0;
+                typename ChannelElement<T>::shared_ptr towner;
+                FlowStatus tresult = input->readLoan(tsample, towner);
+                if (tresult == NewData) {
+                    // give back the old data sample of the current input, if any
+                    if (sample)
+                        owner->release(sample);
+                    sample = tsample;
+                    owner = towner;
+                    result = tresult;
+                    return true;
+                }
+                // only keeps OldData of the current input
+                if (tsample) {
+                    if (copy_old_data && !sample) {
+                        sample = tsample;
+                        owner = towner;
+                        result = tresult;
+                    } else {
+                        towner->release(tsample);
+                    }
+                }
+            }
+            return false;
+        }
+
         /**
          * Selects a connection as the current channel
          * if pred(connection) is true. It will first check
          * the current channel ( getCurrentChannel() ), if that
-         * does not satisfy pred, iterate over \b all connections.
+         * does not satisfy pred, only the connections that signalled
+         * new data are checked, in the order of their signals. All
+         * connections are only iterated after the inputs list changed.
          * If none satisfy pred, the current channel remains unchanged.
+         * Must be called inside an os::Epoch::Guard.
          * @param pred
          */
         template<typename Pred>
         void select_reader_channel(Pred pred, bool copy_old_data) {
-            typename ChannelElement<T>::shared_ptr new_input =
-                find_if(pred, copy_old_data);
-
-            if (new_input)
-            {
-                // We don't clear the current channel (to get it to NoData state), because there is a race
-                // between find_if and this line. We have to accept (in other parts of the code) that eventually,
-                // all channels return 'OldData'.
-                last = new_input.get();
-            }
-        }
-
-        template<typename Pred>
-        typename ChannelElement<T>::shared_ptr find_if(Pred pred, bool copy_old_data) {
-            typename ChannelElement<T>::shared_ptr current = currentInput();
+            const Inputs &snapshot = inputs.get();
+            if (snapshot.empty()) return;
 
             // We only copy OldData in the initial read of the current channel.
             // if it has no new data, the search over the other channels starts,
             // but no old data is needed.
-            if ( current )
-                if ( pred( copy_old_data, current ) )
-                    return current;
+            std::size_t current = currentInput(snapshot);
+            typename ChannelElement<T>::shared_ptr input = snapshot[current]->template narrow<T>();
+            if ( pred( copy_old_data, input ) )
+                return;
+
+            if (!takeRescan()) {
+                int ready;
+                while ( (ready = nextReadyInput(snapshot)) >= 0 ) {
+                    std::size_t index = static_cast<std::size_t>(ready);
+                    if (index == current) continue;
+                    input = snapshot[index]->template narrow<T>();
+                    if ( pred(false, input) == true) {
+                        last = index;
+                        return;
+                    }
+                }
+                return;
+            }
 
-            for (Inputs::iterator it = inputs.begin(); it != inputs.end(); ++it) {
-                if (*it == current) continue;
-                typename ChannelElement<T>::shared_ptr input = (*it)->narrow<T>();
+            for (std::size_t index = 0; index < snapshot.size(); ++index) {
+                if (index == current) continue;
+                input = snapshot[index]->template narrow<T>();
                 assert(input);
-                if ( pred(false, input) == true)
-                    return input;
+                if ( pred(false, input) == true) {
+                    // We don't clear the current channel (to get it to NoData state), because there is a race
+                    // between the search and this line. We have to accept (in other parts of the code) that eventually,
+                    // all channels return 'OldData'.
+                    last = index;
+                    return;
+                }
             }
-
-            return typename ChannelElement<T>::shared_ptr();
         }
 
     protected:
         virtual void removeInput(ChannelElementBase::shared_ptr const& input)
         {
-            if (last == input) last = 0;
+            // keep the selection on the same input if it is not the removed one
+            const Inputs &current = inputs.get();
+            Inputs::const_iterator found = std::find(current.begin(), current.end(), input);
+            if (found != current.end()) {
+                std::size_t index = found - current.begin();
+                if (last == index) last = 0;
+                else if (last > index) --last;
+            }
             MultipleInputsChannelElementBase::removeInput(input);
         }
 
     private:
-        ChannelElement<T> *last;
+        /** The index of the currently selected input in the inputs list. */
+        std::size_t last;
     };
 
     /** A typed version of MultipleOutputsChannelElementBase.
@@ -258,22 +459,35 @@ namespace RTT { namespace base {
         typedef typename ChannelElement<T>::param_t param_t;
         typedef typename ChannelElement<T>::reference_t reference_t;
 
+        MultipleOutputsChannelElement()
+            : sample_pool(0), shared_outputs(0), shared_capacity(0)
+        {}
+
+        ~MultipleOutputsChannelElement()
+        {
+            if (sample_pool) intrusive_ptr_release(sample_pool);
+        }
+
         virtual WriteStatus data_sample(param_t sample, bool reset = true)
         {
             WriteStatus result = WriteSuccess;
             bool at_least_one_output_is_disconnected = false;
             bool at_least_one_output_is_connected = false;
 
+            internal::SharedSamplePool<T>* pool = sample_pool;
+            if (pool) pool->data_sample(sample);
+
             {
-                RTT::os::SharedMutexLock lock(outputs_lock);
-                if (outputs.empty()) return WriteSuccess;
-                for(Outputs::iterator it = outputs.begin(); it != outputs.end(); ++it)
+                RTT::os::Epoch::Guard guard;
+                const Outputs &snapshot = outputs.get();
+                if (snapshot.empty()) return WriteSuccess;
+                for(Outputs::const_iterator it = snapshot.begin(); it != snapshot.end(); ++it)
                 {
                     typename ChannelElement<T>::shared_ptr output = it->channel->narrow<T>();
                     WriteStatus fs = output->data_sample(sample, reset);
                     if (result < fs) result = fs;
                     if (fs == NotConnected) {
-                        it->disconnected = true;
+                        it->disconnected.set(1);
                         at_least_one_output_is_disconnected = true;
                     } else {
                         at_least_one_output_is_connected = true;
@@ -301,15 +515,59 @@ namespace RTT { namespace base {
             bool at_least_one_output_is_connected = false;
 
             {
-                RTT::os::SharedMutexLock lock(outputs_lock);
-                if (outputs.empty()) return NotConnected;
-                for(Outputs::iterator it = outputs.begin(); it != outputs.end(); ++it)
+                RTT::os::Epoch::Guard guard;
+                const Outputs &snapshot = outputs.get();
+                if (snapshot.empty()) return NotConnected;
+
+                // Copy the sample once for all outputs that store shared samples.
+                // If the pool is exhausted, every output gets its own copy.
+                internal::SharedSample<T> shared;
+                internal::SharedSamplePool<T>* pool = sample_pool;
+                if (pool && shared_outputs != 0) shared = pool->allocate(sample);
+
+                for(Outputs::const_iterator it = snapshot.begin(); it != snapshot.end(); ++it)
+                {
+                    typename ChannelElement<T>::shared_ptr output = it->channel->narrow<T>();
+                    WriteStatus fs = shared.empty() ? output->write(sample) : output->writeShared(shared);
+                    if (it->mandatory && (result < fs)) result = fs;
+                    if (fs == NotConnected) {
+                        it->disconnected.set(1);
+                        at_least_one_output_is_disconnected = true;
+                    } else {
+                        at_least_one_output_is_connected = true;
+                    }
+                }
+            }
+
+            if (at_least_one_output_is_disconnected) {
+                removeDisconnectedOutputs();
+                if (!at_least_one_output_is_connected) result = NotConnected;
+            }
+
+            return result;
+        }
+
+        /** Writes a batch of samples to all connected channels.
+         *
+         * @returns the same as write()
+         */
+        virtual WriteStatus writeAll(const std::vector<value_t>& samples)
+        {
+            WriteStatus result = WriteSuccess;
+            bool at_least_one_output_is_disconnected = false;
+            bool at_least_one_output_is_connected = false;
+
+            {
+                RTT::os::Epoch::Guard guard;
+                const Outputs &snapshot = outputs.get();
+                if (snapshot.empty()) return NotConnected;
+                for(Outputs::const_iterator it = snapshot.begin(); it != snapshot.end(); ++it)
                 {
                     typename ChannelElement<T>::shared_ptr output = it->channel->narrow<T>();
-                    WriteStatus fs = output->write(sample);
+                    WriteStatus fs = output->writeAll(samples);
                     if (it->mandatory && (result < fs)) result = fs;
                     if (fs == NotConnected) {
-                        it->disconnected = true;
+                        it->disconnected.set(1);
                         at_least_one_output_is_disconnected = true;
                     } else {
                         at_least_one_output_is_connected = true;
@@ -324,6 +582,96 @@ namespace RTT { namespace base {
 
             return result;
         }
+
+        /** Borrows a sample from the single connected output channel.
+         * A loan is not possible if the sample would have to be copied to
+         * more than one channel anyway.
+         */
+        virtual value_t* loan(typename ChannelElement<T>::shared_ptr& owner)
+        {
+            RTT::os::Epoch::Guard guard;
+            const Outputs &snapshot = outputs.get();
+            if (snapshot.size() != 1) return 0;
+            typename ChannelElement<T>::shared_ptr output = snapshot.front().channel->narrow<T>();
+            return output->loan(owner);
+        }
+
+        /** Writes a sample obtained by loan() to the single connected output channel.
+         */
+        virtual WriteStatus commit(value_t*& sample, ChannelElement<T>* owner)
+        {
+            WriteStatus result = WriteFailure;
+            bool disconnected = false;
+
+            {
+                RTT::os::Epoch::Guard guard;
+                const Outputs &snapshot = outputs.get();
+                if (snapshot.empty()) return NotConnected;
+                if (snapshot.size() != 1) return WriteFailure;
+                typename ChannelElement<T>::shared_ptr output = snapshot.front().channel->narrow<T>();
+                result = output->commit(sample, owner);
+                if (result == NotConnected) {
+                    snapshot.front().disconnected.set(1);
+                    disconnected = true;
+                } else if (!snapshot.front().mandatory) {
+                    result = WriteSuccess;
+                }
+            }
+
+            if (disconnected) {
+                removeDisconnectedOutputs();
+            }
+
+            return result;
+        }
+
+    protected:
+        /**
+         * Overridden implementation of MultipleOutputsChannelElementBase::addOutput()
+         * which sizes the pool of shared samples for outputs that store them.
+         */
+        virtual bool addOutput(ChannelElementBase::shared_ptr const& output, bool mandatory = true)
+        {
+            if (!MultipleOutputsChannelElementBase::addOutput(output, mandatory)) return false;
+            const ConnPolicy *policy = output->getConnPolicy();
+            if (storesSharedSamples(policy)) {
+                RTT::os::MutexLock lock(outputs_lock);
+                if (!sample_pool) {
+                    internal::SharedSamplePool<T>* pool = new internal::SharedSamplePool<T>();
+                    intrusive_ptr_add_ref(pool);
+                    oro_mb();
+                    sample_pool = pool;
+                }
+                // each output may hold other samples than the others, plus the one being written
+                shared_capacity += internal::SharedSamplePool<T>::capacityFor(*policy);
+                sample_pool->reserve(shared_capacity + 1);
+                ++shared_outputs;
+            }
+            return true;
+        }
+
+        virtual void removeOutput(ChannelElementBase::shared_ptr const& output)
+        {
+            const ConnPolicy *policy = output->getConnPolicy();
+            if (storesSharedSamples(policy) && shared_outputs > 0) {
+                shared_capacity -= internal::SharedSamplePool<T>::capacityFor(*policy);
+                --shared_outputs;
+            }
+            MultipleOutputsChannelElementBase::removeOutput(output);
+        }
+
+    private:
+        static bool storesSharedSamples(const ConnPolicy *policy)
+        {
+            return policy && policy->shared_samples && policy->buffer_policy == PerConnection;
+        }
+
+        /** The pool of samples shared by the outputs, created by the first output that stores shared samples. */
+        internal::SharedSamplePool<T>* volatile sample_pool;
+        /** The number of outputs that store shared samples, guarded by outputs_lock. */
+        unsigned int shared_outputs;
+        /** The number of samples the outputs that store shared samples may hold together, guarded by outputs_lock. */
+        unsigned int shared_capacity;
     };
 
     /** A typed version of MultipleInputsMultipleOutputsChannelElementBase.
@@ -42,6 +42,7 @@
 #include "../os/oro_arch.h"
 #include <utility>
 #include <boost/intrusive_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/call_traits.hpp>
 
 #include "../rtt-fwd.hpp"
@@ -49,9 +50,13 @@
 #include "../internal/rtt-internal-fwd.hpp"
 #include "../BufferPolicy.hpp"
 #include "../os/Mutex.hpp"
+#include "../os/Epoch.hpp"
+#include "../os/Atomic.hpp"
+#include "../os/oro_arch.h"
+#include "../internal/AtomicMWMRQueue.hpp"
 
-#include <list>
 #include <map>
+#include <vector>
 
 namespace RTT { namespace base {
 
@@ -79,6 +84,17 @@ namespace RTT { namespace base {
         mutable RTT::os::SharedMutex input_lock;
         mutable RTT::os::SharedMutex output_lock;
 
+        /**
+         * The statistics of the samples stored in this element, or null if they
+         * are not collected. Updated by the read and write functions of elements
+         * which store data.
+         */
+        ChannelStatistics* statistics;
+
+    private:
+        boost::shared_ptr<ChannelStatistics> statistics_owner;
+        mutable RTT::os::Mutex statistics_lock;
+
     protected:
         /** Increases the reference count */
         void ref();
@@ -235,6 +251,19 @@ namespace RTT { namespace base {
          */
         virtual const ConnPolicy* getConnPolicy() const;
 
+        /**
+         * Starts collecting statistics about the samples which pass through this
+         * element. Only elements which store data (buffers and data objects) support this.
+         * @return true if this element collects statistics.
+         */
+        virtual bool enableStatistics();
+
+        /**
+         * Returns the statistics collected by this element.
+         * @return null if enableStatistics() was not called or is not supported.
+         */
+        virtual boost::shared_ptr<ChannelStatistics> getStatistics() const;
+
         RTT_DEPRECATED void setOutput(const ChannelElementBase::shared_ptr &output)
         {
             assert(false && "ChannelElementBase::setOutput() is deprecated! You should use ChannelElementBase::connectTo() instead.");
@@ -316,6 +345,13 @@ namespace RTT { namespace base {
          */
         virtual void removeInput(shared_ptr const& input);
 
+        /**
+         * Creates the statistics of this element for enableStatistics().
+         * @return null if this element does not support statistics, which is
+         * the default.
+         */
+        virtual ChannelStatistics* createStatistics() const;
+
     private:
         /**
          * Deprecated, argument-less variant of \ref inputReady(shared_ptr).
@@ -332,11 +368,70 @@ namespace RTT { namespace base {
     {
     public:
         typedef boost::intrusive_ptr<MultipleInputsChannelElementBase> shared_ptr;
-        typedef std::list<ChannelElementBase::shared_ptr> Inputs;
+        typedef std::vector<ChannelElementBase::shared_ptr> Inputs;
+
+        /**
+         * The set of inputs that signalled this element since they were
+         * last visited by a reader. Each input is queued at most once, in
+         * the order in which the signals arrived, such that a reader only
+         * visits the inputs that have pending data. A set is built for one
+         * version of the inputs list and replaced together with it.
+         */
+        class RTT_API ReadySet
+        {
+        public:
+            explicit ReadySet(const Inputs &inputs = Inputs());
+            ~ReadySet();
+
+            /**
+             * Queues \a input unless it is queued already.
+             * @return false if \a input is not in the list this set was built from
+             * or if it could not be queued.
+             */
+            bool mark(ChannelElementBase *input) const;
+
+            /**
+             * Removes the oldest queued input from the set.
+             * @return its index in \a inputs, or -1 if no input in \a inputs is queued.
+             */
+            int next(const Inputs &inputs) const;
+
+        private:
+            struct Entry {
+                ChannelElementBase *input;
+                std::size_t index;
+                mutable oro_atomic_t queued;
+            };
+
+            ReadySet(const ReadySet &);
+            ReadySet &operator=(const ReadySet &);
+            static std::size_t hash(const ChannelElementBase *input);
+
+            /** Open addressing hash table of the inputs, its size is a power of two. */
+            std::vector<Entry> table;
+            std::size_t mask;
+            internal::AtomicMWMRQueue<const Entry *> *queue;
+        };
 
     protected:
-        Inputs inputs;
-        mutable RTT::os::SharedMutex inputs_lock;
+        /**
+         * The list of inputs is never modified in place. Writers hold
+         * inputs_lock and publish a modified copy, readers traverse the
+         * current list inside an os::Epoch::Guard without taking a lock.
+         */
+        os::EpochPointer<Inputs> inputs;
+        mutable RTT::os::Mutex inputs_lock;
+
+        /**
+         * The inputs that signalled new data, published together with \ref inputs.
+         */
+        os::EpochPointer<ReadySet> ready;
+
+        /**
+         * Set when signals may have been lost because the inputs list was
+         * replaced. The next reader then visits all inputs once.
+         */
+        oro_atomic_t rescan;
 
     public:
         MultipleInputsChannelElementBase();
@@ -372,6 +467,18 @@ namespace RTT { namespace base {
         bool signalFrom(ChannelElementBase *caller);
 
     protected:
+        /**
+         * Returns the index of the next input in \a snapshot that signalled new data,
+         * or -1 if there is none. Must be called inside an os::Epoch::Guard.
+         */
+        int nextReadyInput(const Inputs &snapshot);
+
+        /**
+         * Returns true once after signals may have been lost, in which case
+         * the caller must visit all inputs instead of only the ready ones.
+         */
+        bool takeRescan();
+
         /**
          * Sets the new input channel element of this element or adds a channel to the inputs list.
          * @param input the previous element in chain.
@@ -398,13 +505,22 @@ namespace RTT { namespace base {
             bool operator==(ChannelElementBase::shared_ptr const& channel) const;
             ChannelElementBase::shared_ptr channel;
             bool mandatory;
-            bool disconnected;
+            /**
+             * Set by readers of the list after a failed write, see removeDisconnectedOutputs().
+             * It is atomic since many readers may share the same list.
+             */
+            mutable os::AtomicInt disconnected;
         };
-        typedef std::list<Output> Outputs;
+        typedef std::vector<Output> Outputs;
 
     protected:
-        Outputs outputs;
-        mutable RTT::os::SharedMutex outputs_lock;
+        /**
+         * The list of outputs is never modified in place. Writers hold
+         * outputs_lock and publish a modified copy, readers traverse the
+         * current list inside an os::Epoch::Guard without taking a lock.
+         */
+        os::EpochPointer<Outputs> outputs;
+        mutable RTT::os::Mutex outputs_lock;
 
     public:
         MultipleOutputsChannelElementBase();
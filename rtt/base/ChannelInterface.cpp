@@ -39,12 +39,17 @@
 #include "../internal/Channels.hpp"
 #include "../os/Atomic.hpp"
 #include "../os/MutexLock.hpp"
+#include "../os/CAS.hpp"
+#include "ChannelStatistics.hpp"
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <iterator>
 
 using namespace RTT;
 using namespace RTT::detail;
 
 ChannelElementBase::ChannelElementBase()
+    : statistics(0)
 {
     ORO_ATOMIC_SETUP(&refcount,0);
 }
@@ -224,47 +229,148 @@ std::string ChannelElementBase::getLocalURI() const {
     return std::string(boost::lexical_cast<std::string>(this));
 }
 
+bool ChannelElementBase::enableStatistics()
+{
+    RTT::os::MutexLock lock(statistics_lock);
+    if (!statistics_owner) {
+        statistics_owner.reset( createStatistics() );
+        // publish only after the statistics were fully constructed.
+        os::CAS(&statistics, (ChannelStatistics*) 0, statistics_owner.get());
+    }
+    return statistics != 0;
+}
+
+boost::shared_ptr<ChannelStatistics> ChannelElementBase::getStatistics() const
+{
+    RTT::os::MutexLock lock(statistics_lock);
+    return statistics_owner;
+}
+
+ChannelStatistics* ChannelElementBase::createStatistics() const
+{
+    return 0;
+}
+
 std::string ChannelElementBase::getElementName() const {
     return std::string("ChannelElementBase");
 }
 
+MultipleInputsChannelElementBase::ReadySet::ReadySet(const Inputs &inputs)
+    : mask(0)
+    , queue(new internal::AtomicMWMRQueue<const Entry *>(inputs.size() + 1))
+{
+    // keep the table at most half full
+    std::size_t size = 1;
+    while (size < 2 * inputs.size()) size <<= 1;
+    Entry empty;
+    empty.input = 0;
+    empty.index = 0;
+    ORO_ATOMIC_SETUP(&empty.queued, 0);
+    table.assign(size, empty);
+    mask = size - 1;
+
+    for (std::size_t index = 0; index < inputs.size(); ++index) {
+        std::size_t slot = hash(inputs[index].get()) & mask;
+        while (table[slot].input) slot = (slot + 1) & mask;
+        table[slot].input = inputs[index].get();
+        table[slot].index = index;
+    }
+}
+
+MultipleInputsChannelElementBase::ReadySet::~ReadySet()
+{
+    delete queue;
+}
+
+std::size_t MultipleInputsChannelElementBase::ReadySet::hash(const ChannelElementBase *input)
+{
+    // Fibonacci hashing of the pointer, without the alignment bits
+    return ((reinterpret_cast<std::size_t>(input) >> 4) * 2654435761u);
+}
+
+bool MultipleInputsChannelElementBase::ReadySet::mark(ChannelElementBase *input) const
+{
+    std::size_t slot = hash(input) & mask;
+    while (table[slot].input != input) {
+        if (!table[slot].input) return false;
+        slot = (slot + 1) & mask;
+    }
+
+    const Entry &entry = table[slot];
+    if (!os::CAS(&entry.queued, 0, 1)) return true; // still queued
+    if (!queue->enqueue(&entry)) {
+        oro_atomic_set(&entry.queued, 0);
+        return false;
+    }
+    return true;
+}
+
+int MultipleInputsChannelElementBase::ReadySet::next(const Inputs &inputs) const
+{
+    const Entry *entry = 0;
+    while (queue->dequeue(entry)) {
+        // clear the flag before the input is read, such that a signal for data
+        // that arrives after the read queues the input again
+        os::CAS(&entry->queued, 1, 0);
+        // entries of a set built for another version of the list are skipped
+        if (entry->index < inputs.size() && inputs[entry->index].get() == entry->input)
+            return static_cast<int>(entry->index);
+    }
+    return -1;
+}
+
 MultipleInputsChannelElementBase::MultipleInputsChannelElementBase()
-{}
+{
+    ORO_ATOMIC_SETUP(&rescan, 0);
+}
 
 bool MultipleInputsChannelElementBase::addInput(ChannelElementBase::shared_ptr const& input)
 {
     if (!input) return false;
     RTT::os::MutexLock lock(inputs_lock);
-    assert(std::find(inputs.begin(), inputs.end(), input) == inputs.end());
-    if (std::find(inputs.begin(), inputs.end(), input) != inputs.end()) return false;
-    inputs.push_back(input);
+    const Inputs &current = inputs.get();
+    assert(std::find(current.begin(), current.end(), input) == current.end());
+    if (std::find(current.begin(), current.end(), input) != current.end()) return false;
+    Inputs *next = new Inputs(current);
+    next->push_back(input);
+    inputs.publish(next);
+    ready.publish(new ReadySet(*next));
+    oro_atomic_set(&rescan, 1);
     return true;
 }
 
 void MultipleInputsChannelElementBase::removeInput(ChannelElementBase::shared_ptr const& input)
 {
-    inputs.remove(input);
+    const Inputs &current = inputs.get();
+    Inputs *next = new Inputs();
+    next->reserve(current.size());
+    std::remove_copy(current.begin(), current.end(), std::back_inserter(*next), input);
+    inputs.publish(next);
+    ready.publish(new ReadySet(*next));
+    oro_atomic_set(&rescan, 1);
 }
 
 bool MultipleInputsChannelElementBase::connected()
 {
-    RTT::os::SharedMutexLock lock(inputs_lock);
-    return inputs.size() > 0;
+    RTT::os::Epoch::Guard guard;
+    return !inputs.get().empty();
 }
 
 bool MultipleInputsChannelElementBase::inputReady(ChannelElementBase::shared_ptr const&)
 {
-    RTT::os::SharedMutexLock lock(inputs_lock);
-    for (Inputs::const_iterator it = inputs.begin(); it != inputs.end(); ++it) {
+    RTT::os::Epoch::Guard guard;
+    const Inputs &current = inputs.get();
+    for (Inputs::const_iterator it = current.begin(); it != current.end(); ++it) {
         if (!(*it)->inputReady(this)) return false;
     }
-    return !inputs.empty();
+    return !current.empty();
 }
 
 void MultipleInputsChannelElementBase::clear()
 {
-    RTT::os::SharedMutexLock lock(inputs_lock);
-    for (Inputs::const_iterator it = inputs.begin(); it != inputs.end(); ++it) {
+    RTT::os::Epoch::Guard guard;
+    const Inputs &current = inputs.get();
+    for (Inputs::const_iterator it = current.begin(); it != current.end(); ++it) {
         (*it)->clear();
     }
 }
@@ -276,8 +382,9 @@ bool MultipleInputsChannelElementBase::disconnect(ChannelElementBase::shared_ptr
         {
             // Remove the channel from the inputs list
             RTT::os::MutexLock lock(inputs_lock);
-            Inputs::iterator found = std::find(inputs.begin(), inputs.end(), channel);
-            if (found == inputs.end()) {
+            const Inputs &current = inputs.get();
+            Inputs::const_iterator found = std::find(current.begin(), current.end(), channel);
+            if (found == current.end()) {
                 return false;
             }
             ChannelElementBase::shared_ptr input = *found;
@@ -288,8 +395,8 @@ bool MultipleInputsChannelElementBase::disconnect(ChannelElementBase::shared_ptr
                 }
             }
 
-            removeInput(input.get()); // invalidates input
-            was_last = inputs.empty();
+            removeInput(input.get()); // invalidates current
+            was_last = inputs.get().empty();
         }
 
         // If the removed input was the last channel and forward is true, disconnect output side, too.
@@ -302,29 +409,44 @@ bool MultipleInputsChannelElementBase::disconnect(ChannelElementBase::shared_ptr
     } else if (!forward) {
         // Disconnect and remove all inputs
         RTT::os::MutexLock lock(inputs_lock);
-        for (Inputs::iterator it = inputs.begin(); it != inputs.end(); ) {
-            const ChannelElementBase::shared_ptr &input = *it++;
-            input->disconnect(this, false);
-            removeInput(input.get()); // invalidates input
+        Inputs current = inputs.get(); // a copy, as removeInput() replaces the list
+        for (Inputs::const_iterator it = current.begin(); it != current.end(); ++it) {
+            (*it)->disconnect(this, false);
+            removeInput(*it);
         }
-        assert(inputs.empty());
+        assert(inputs.get().empty());
     }
 
     return ChannelElementBase::disconnect(channel, forward);
 }
 
-bool MultipleInputsChannelElementBase::signalFrom(ChannelElementBase *)
+bool MultipleInputsChannelElementBase::signalFrom(ChannelElementBase *caller)
 {
+    {
+        RTT::os::Epoch::Guard guard;
+        if (!ready.get().mark(caller)) oro_atomic_set(&rescan, 1);
+    }
     return signal();
 }
 
+int MultipleInputsChannelElementBase::nextReadyInput(const Inputs &snapshot)
+{
+    return ready.get().next(snapshot);
+}
+
+bool MultipleInputsChannelElementBase::takeRescan()
+{
+    if (!oro_atomic_read(&rescan)) return false;
+    return os::CAS(&rescan, 1, 0);
+}
+
 MultipleOutputsChannelElementBase::MultipleOutputsChannelElementBase()
 {}
 
 MultipleOutputsChannelElementBase::Output::Output(ChannelElementBase::shared_ptr const &channel, bool mandatory)
     : channel(channel)
     , mandatory(mandatory)
-    , disconnected(false)
+    , disconnected(0)
 {}
 
 bool MultipleOutputsChannelElementBase::Output::operator==(ChannelElementBase::shared_ptr const& channel) const
@@ -336,39 +458,50 @@ bool MultipleOutputsChannelElementBase::addOutput(ChannelElementBase::shared_ptr
 {
     if (!output) return false;
     RTT::os::MutexLock lock(outputs_lock);
-    // assert(std::find(outputs.begin(), outputs.end(), output) == outputs.end());
-    if (std::find(outputs.begin(), outputs.end(), output) != outputs.end()) return false;
-    outputs.push_back(Output(output, mandatory));
+    const Outputs &current = outputs.get();
+    // assert(std::find(current.begin(), current.end(), output) == current.end());
+    if (std::find(current.begin(), current.end(), output) != current.end()) return false;
+    Outputs *next = new Outputs(current);
+    next->push_back(Output(output, mandatory));
+    outputs.publish(next);
     return true;
 }
 
 void MultipleOutputsChannelElementBase::removeOutput(ChannelElementBase::shared_ptr const& output)
 {
-    outputs.remove_if(boost::bind(&Output::operator==, _1, output));
+    const Outputs &current = outputs.get();
+    Outputs *next = new Outputs();
+    next->reserve(current.size());
+    std::remove_copy_if(current.begin(), current.end(), std::back_inserter(*next), boost::bind(&Output::operator==, _1, output));
+    outputs.publish(next);
 }
 
 bool MultipleOutputsChannelElementBase::connected()
 {
-    RTT::os::SharedMutexLock lock(outputs_lock);
-    return outputs.size() > 0;
+    RTT::os::Epoch::Guard guard;
+    return !outputs.get().empty();
 }
 
 bool MultipleOutputsChannelElementBase::signal()
 {
-    RTT::os::SharedMutexLock lock(outputs_lock);
-    for (Outputs::const_iterator output = outputs.begin(); output != outputs.end(); ++output) {
-        output->channel->signalFrom(this);
+    {
+        RTT::os::Epoch::Guard guard;
+        const Outputs &current = outputs.get();
+        for (Outputs::const_iterator output = current.begin(); output != current.end(); ++output) {
+            output->channel->signalFrom(this);
+        }
     }
     return ChannelElementBase::signal();
 }
 
 bool MultipleOutputsChannelElementBase::channelReady(ChannelElementBase::shared_ptr const&, ConnPolicy const& policy, internal::ConnID *conn_id)
 {
-    RTT::os::SharedMutexLock lock(outputs_lock);
-    for (Outputs::const_iterator it = outputs.begin(); it != outputs.end(); ++it) {
+    RTT::os::Epoch::Guard guard;
+    const Outputs &current = outputs.get();
+    for (Outputs::const_iterator it = current.begin(); it != current.end(); ++it) {
         if (!it->channel->channelReady(this, policy, conn_id)) return false;
     }
-    return !outputs.empty();
+    return !current.empty();
 }
 
 bool MultipleOutputsChannelElementBase::disconnect(ChannelElementBase::shared_ptr const& channel, bool forward)
@@ -378,20 +511,21 @@ bool MultipleOutputsChannelElementBase::disconnect(ChannelElementBase::shared_pt
         bool was_last = false;
         {
             RTT::os::MutexLock lock(outputs_lock);
-            Outputs::iterator found = std::find(outputs.begin(), outputs.end(), channel);
-            if (found == outputs.end()) {
+            const Outputs &current = outputs.get();
+            Outputs::const_iterator found = std::find(current.begin(), current.end(), channel);
+            if (found == current.end()) {
                 return false;
             }
-            const Output &output = *found;
+            ChannelElementBase::shared_ptr output = found->channel;
 
             if (forward) {
-                if (!output.channel->disconnect(this, forward)) {
+                if (!output->disconnect(this, forward)) {
                     return false;
                 }
             }
 
-            removeOutput(output.channel.get()); // invalidates output
-            was_last = outputs.empty();
+            removeOutput(output); // invalidates current
+            was_last = outputs.get().empty();
         }
 
         // If the removed output was the last channel, disconnect input side, too.
@@ -405,12 +539,13 @@ bool MultipleOutputsChannelElementBase::disconnect(ChannelElementBase::shared_pt
     if (forward) {
         // Disconnect and remove all outputs
         RTT::os::MutexLock lock(outputs_lock);
-        for (Outputs::iterator it = outputs.begin(); it != outputs.end(); ) {
-            const Output &output = *it++;
-            output.channel->disconnect(this, true);
-            removeOutput(output.channel.get()); // invalidates output
+        // a copy, as removeOutput() replaces the list.
+        Outputs current = outputs.get();
+        for (Outputs::const_iterator it = current.begin(); it != current.end(); ++it) {
+            it->channel->disconnect(this, true);
+            removeOutput(it->channel);
         }
-        assert(outputs.empty());
+        assert(outputs.get().empty());
     }
 
     return ChannelElementBase::disconnect(channel, forward);
@@ -419,11 +554,13 @@ bool MultipleOutputsChannelElementBase::disconnect(ChannelElementBase::shared_pt
 void MultipleOutputsChannelElementBase::removeDisconnectedOutputs()
 {
     RTT::os::MutexLock lock(outputs_lock);
-    for (Outputs::iterator it = outputs.begin(); it != outputs.end(); ) {
-        const Output &output = *it++;
-        if (output.disconnected) {
-            output.channel->disconnect(this, true);
-            removeOutput(output.channel.get()); // invalidates output
+    // a copy, as removeOutput() replaces the list. A mark set on a list that
+    // got replaced meanwhile is lost, the next failed write sets it again.
+    Outputs current = outputs.get();
+    for (Outputs::const_iterator it = current.begin(); it != current.end(); ++it) {
+        if (it->disconnected.read()) {
+            it->channel->disconnect(this, true);
+            removeOutput(it->channel);
         }
     }
 }
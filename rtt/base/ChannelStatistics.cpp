@@ -0,0 +1,144 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "ChannelStatistics.hpp"
+#include "BufferLockFree.hpp"
+#include "BufferLocked.hpp"
+#include "BufferUnSync.hpp"
+#include "../ConnPolicy.hpp"
+
+using namespace RTT;
+using namespace RTT::base;
+
+const unsigned int ChannelStatistics::LatencyBins;
+
+ChannelStatistics::ChannelStatistics(const ConnPolicy& policy)
+    : stamps(0)
+{
+    // A data object keeps the last sample, which behaves like a
+    // circular buffer of size one.
+    BufferBase::Options options(policy);
+    unsigned int size = policy.size;
+    if (policy.type == ConnPolicy::DATA) {
+        options.circular(true);
+        size = 1;
+    }
+    switch (policy.lock_policy)
+    {
+#ifndef OROBLD_OS_NO_ASM
+    case ConnPolicy::LOCK_FREE:
+        stamps = new BufferLockFree<os::TimeService::nsecs>(size, 0, options);
+        break;
+#else
+    case ConnPolicy::LOCK_FREE:
+#endif
+    case ConnPolicy::LOCKED:
+        stamps = new BufferLocked<os::TimeService::nsecs>(size, 0, options);
+        break;
+    case ConnPolicy::UNSYNC:
+    default:
+        stamps = new BufferUnSync<os::TimeService::nsecs>(size, 0, options);
+        break;
+    }
+    mcircular = options.circular();
+}
+
+ChannelStatistics::~ChannelStatistics()
+{
+    delete stamps;
+}
+
+void ChannelStatistics::writing(unsigned int samples)
+{
+    os::TimeService::nsecs now = os::TimeService::Instance()->getNSecs();
+    BufferBase::size_type before = stamps->dropped();
+    for (unsigned int i = 0; i != samples; ++i)
+        stamps->Push(now);
+    if (mcircular)
+        overwrites.add(stamps->dropped() - before);
+}
+
+void ChannelStatistics::written(unsigned int samples)
+{
+    writes.add(samples);
+}
+
+void ChannelStatistics::dropped(unsigned int samples)
+{
+    drops.add(samples);
+}
+
+void ChannelStatistics::read(FlowStatus status, unsigned int samples)
+{
+    reads.inc();
+    if (status == OldData)
+        olddata.inc();
+    if (status != NewData)
+        return;
+    newdata.inc();
+
+    os::TimeService::nsecs now = os::TimeService::Instance()->getNSecs();
+    os::TimeService::nsecs stamp;
+    for (unsigned int i = 0; i != samples && stamps->Pop(stamp); ++i) {
+        // bin i counts latencies below 2^i us.
+        os::TimeService::nsecs us = (now - stamp) / 1000;
+        unsigned int bin = 0;
+        while (us > 0 && bin != LatencyBins - 1) {
+            us >>= 1;
+            ++bin;
+        }
+        latency[bin].inc();
+    }
+}
+
+void ChannelStatistics::cleared()
+{
+    stamps->clear();
+}
+
+void ChannelStatistics::reset()
+{
+    writes.set(0);
+    overwrites.set(0);
+    drops.set(0);
+    reads.set(0);
+    newdata.set(0);
+    olddata.set(0);
+    for (unsigned int i = 0; i != LatencyBins; ++i)
+        latency[i].set(0);
+}
+
+std::vector<int> ChannelStatistics::getLatencyHistogram() const
+{
+    std::vector<int> result(LatencyBins);
+    for (unsigned int i = 0; i != LatencyBins; ++i)
+        result[i] = latency[i].read();
+    return result;
+}
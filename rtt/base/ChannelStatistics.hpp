@@ -0,0 +1,156 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_CHANNEL_STATISTICS_HPP
+#define ORO_CHANNEL_STATISTICS_HPP
+
+#include "../rtt-config.h"
+#include "../FlowStatus.hpp"
+#include "../os/Atomic.hpp"
+#include "../os/TimeService.hpp"
+#include "../rtt-fwd.hpp"
+#include "rtt-base-fwd.hpp"
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+namespace RTT
+{ namespace base {
+
+    /**
+     * Counts the samples written to and read from a connection element
+     * which stores data, and how long the samples waited in it.
+     * Collected only after ChannelElementBase::enableStatistics().
+     *
+     * All update functions are lock-free and do not allocate memory,
+     * such that they can be called from the real-time writer and reader
+     * of the connection. The latencies are approximate when several
+     * threads write or read the same connection.
+     * @ingroup PortBuffers
+     */
+    class RTT_API ChannelStatistics
+    {
+    public:
+        typedef boost::shared_ptr<ChannelStatistics> shared_ptr;
+
+        /**
+         * The number of bins of the latency histogram. Bin \a i counts the
+         * samples which waited less than 2^i microseconds, the last bin
+         * counts all others.
+         */
+        static const unsigned int LatencyBins = 16;
+
+        /**
+         * Creates the statistics of a connection element that was built
+         * with \a policy, which determines how many samples are time stamped.
+         */
+        ChannelStatistics(const ConnPolicy& policy);
+
+        ~ChannelStatistics();
+
+        /**
+         * Time stamps \a samples samples that are about to be stored in the
+         * connection. Call it before the samples are published, such that
+         * a reader which gets them also finds their time stamps. If this
+         * pushed out samples which were not read yet, they are counted as
+         * overwrites.
+         */
+        void writing(unsigned int samples = 1);
+
+        /**
+         * Counts \a samples samples that were stored in the connection.
+         */
+        void written(unsigned int samples = 1);
+
+        /**
+         * Counts \a samples samples that could not be stored in the connection.
+         */
+        void dropped(unsigned int samples = 1);
+
+        /**
+         * Counts a read which returned \a status. For NewData, the
+         * waiting time of the \a samples consumed samples is added to
+         * the latency histogram.
+         */
+        void read(FlowStatus status, unsigned int samples = 1);
+
+        /**
+         * Forgets the time stamps of the stored samples, after the
+         * connection was cleared.
+         */
+        void cleared();
+
+        /**
+         * Sets all counters and the latency histogram to zero.
+         */
+        void reset();
+
+        /** The number of samples stored in the connection. */
+        int getWrites() const { return writes.read(); }
+        /** The number of stored samples which were overwritten before they were read. */
+        int getOverwrites() const { return overwrites.read(); }
+        /** The number of samples which could not be stored (WriteFailure). */
+        int getDrops() const { return drops.read(); }
+        /** The number of reads, including those that returned NoData. */
+        int getReads() const { return reads.read(); }
+        /** The number of reads which returned NewData. */
+        int getNewData() const { return newdata.read(); }
+        /** The number of reads which returned OldData. */
+        int getOldData() const { return olddata.read(); }
+
+        /**
+         * Returns the latency histogram, which has LatencyBins elements.
+         */
+        std::vector<int> getLatencyHistogram() const;
+
+    private:
+        ChannelStatistics(const ChannelStatistics&);
+        ChannelStatistics& operator=(const ChannelStatistics&);
+
+        os::AtomicInt writes;
+        os::AtomicInt overwrites;
+        os::AtomicInt drops;
+        os::AtomicInt reads;
+        os::AtomicInt newdata;
+        os::AtomicInt olddata;
+        os::AtomicInt latency[LatencyBins];
+
+        /**
+         * The time stamps of the stored samples, which mirror the
+         * size and overwrite policy of the connection's storage.
+         */
+        BufferInterface<os::TimeService::nsecs>* stamps;
+
+        /**
+         * True if writing to a full connection overwrites the oldest sample.
+         */
+        bool mcircular;
+    };
+}}
+
+#endif
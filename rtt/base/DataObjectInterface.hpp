@@ -100,6 +100,45 @@ namespace RTT
          */
         virtual bool Set( param_t push ) = 0;
 
+        /**
+         * Returns a pointer to the storage element the next Set() would
+         * write to, such that a sample can be constructed in-place.
+         * The pointer must be handed back with Commit() or Discard().
+         *
+         * @return a pointer to the storage element or Zero if another writer
+         * holds it or if this data object does not support loans.
+         */
+        virtual value_t* Loan() { return 0; }
+
+        /**
+         * Publishes an element obtained by Loan() as the new value of this data object.
+         *
+         * @param item pointer aquired using Loan()
+         * @return false if the element could not be published (too many readers).
+         */
+        virtual bool Commit( value_t* item ) { return false; }
+
+        /**
+         * Hands back an element obtained by Loan() without publishing it.
+         */
+        virtual void Discard( value_t* item ) {}
+
+        /**
+         * Returns a pointer to the current value of this data object which stays
+         * valid until it is handed back with Release(). Writers will not touch it
+         * in the mean time.
+         *
+         * @param item is set to the current value, or Zero if NoData is returned.
+         * @return NewData if the value has not been read before, OldData otherwise.
+         */
+        virtual FlowStatus GetWithoutRelease( value_t*& item ) { item = 0; return NoData; }
+
+        /**
+         * Releases the pointer
+         * @param item pointer aquired using GetWithoutRelease()
+         */
+        virtual void Release( value_t* item ) {}
+
         /**
          * Provides a data sample to initialize this data object.
          * As such enough storage
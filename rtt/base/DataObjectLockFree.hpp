@@ -41,9 +41,12 @@
 
 #include "../os/oro_arch.h"
 #include "DataObjectInterface.hpp"
+#include "SampleSlot.hpp"
 #include "../Logger.hpp"
 #include "../types/Types.hpp"
 #include "../internal/DataSourceTypeInfo.hpp"
+#include <cassert>
+#include <cstddef>
 
 namespace RTT
 { namespace base {
@@ -200,28 +203,8 @@ namespace RTT
                 return NoData;
             }
 
-            PtrType reading;
-            // loop to combine Read/Modify of counter
-            // This avoids a race condition where read_ptr
-            // could become write_ptr ( then we would read corrupted data).
-            do {
-                reading = read_ptr;            // copy buffer location
-                oro_atomic_inc(&reading->read_counter); // lock buffer, no more writes
-                // XXX smp_mb
-                if ( reading != read_ptr )     // if read_ptr changed,
-                    oro_atomic_dec(&reading->read_counter); // better to start over.
-                else
-                    break;
-            } while ( true );
-            // from here on we are sure that 'reading'
-            // is a valid buffer to read from.
-
-            // compare-and-swap FlowStatus field to make sure that only one reader
-            // returns NewData
-            FlowStatus result;
-            do {
-                result = reading->status;
-            } while((result != NoData) && !os::CAS(&reading->status, result, OldData));
+            PtrType reading = lockReadPtr();
+            FlowStatus result = markAsRead(reading);
 
             if ((result == NewData) ||
                 ((result == OldData) && copy_old_data) || copy_sample) {
@@ -253,6 +236,16 @@ namespace RTT
          * @param push The data which must be set.
          */
         virtual bool Set( param_t push )
+        {
+            value_t* item = Loan();
+            if (!item) return false;
+
+            // copy sample
+            *item = push;
+            return Commit(item);
+        }
+
+        virtual value_t* Loan()
         {
             if (!initialized) {
                 log(Error) << "You set a lock-free data object of type " << internal::DataSourceTypeInfo<T>::getType() << " without initializing it with a data sample. "
@@ -264,7 +257,7 @@ namespace RTT
             if (!oro_atomic_inc_and_test(&writing->write_lock)) {
                 // abort, another thread already successfully locked this buffer element
                 oro_atomic_dec(&writing->write_lock);
-                return false;
+                return 0;
             }
 
             // Additional check that resolves the following race condition:
@@ -277,14 +270,17 @@ namespace RTT
             if ( writing != write_ptr ) {
                 // abort, another thread already updated the write_ptr, which could imply that read_ptr == writing now
                 oro_atomic_dec(&writing->write_lock);
-                return false;
+                return 0;
             }
             // from here on we are sure that 'writing'
             // is a valid buffer to write to and we
             // have exclusive access
+            return &writing->data;
+        }
 
-            // copy sample
-            writing->data = push;
+        virtual bool Commit( value_t* item )
+        {
+            PtrType writing = toDataBuf(item);
             writing->status = NewData;
 
             // if next field is occupied (by read_ptr or counter),
@@ -302,11 +298,40 @@ namespace RTT
 
             // we will be able to move, so replace read_ptr
             read_ptr  = writing;
+            if (SampleSlot<T>::needs_release)
+                releaseStale(writing);
             write_ptr = next_write_ptr; // we checked this in the while loop
             oro_atomic_dec(&writing->write_lock);
             return true;
         }
 
+        virtual void Discard( value_t* item )
+        {
+            oro_atomic_dec(&toDataBuf(item)->write_lock);
+        }
+
+        virtual FlowStatus GetWithoutRelease( value_t*& item )
+        {
+            item = 0;
+            if (!initialized) {
+                return NoData;
+            }
+
+            PtrType reading = lockReadPtr();
+            FlowStatus result = markAsRead(reading);
+            if (result == NoData) {
+                oro_atomic_dec(&reading->read_counter);
+                return NoData;
+            }
+            item = &reading->data;
+            return result;
+        }
+
+        virtual void Release( value_t* item )
+        {
+            oro_atomic_dec(&toDataBuf(item)->read_counter);
+        }
+
         virtual bool data_sample( param_t sample, bool reset = true ) {
             if (!initialized || reset) {
                 // prepare the buffer.
@@ -337,6 +362,55 @@ namespace RTT
         virtual void clear() {
             if (!initialized) return;
 
+            PtrType reading = lockReadPtr();
+
+            // compare-and-swap FlowStatus field to avoid the race condition
+            // where a reader replaces it by OldData
+            FlowStatus result;
+            do {
+                result = reading->status;
+            } while(!os::CAS(&reading->status, result, NoData));
+
+            // XXX smp_mb
+            oro_atomic_dec(&reading->read_counter);       // release buffer
+        }
+
+    private:
+        /**
+         * Returns the buffer element that contains the given data field.
+         * The data fields of the elements of the buffer are sizeof(DataBuf)
+         * bytes apart, which gives the index of the element.
+         */
+        PtrType toDataBuf( value_t* item ) const
+        {
+            const char* first = reinterpret_cast<const char*>( &data[0].data );
+            std::size_t index = ( reinterpret_cast<const char*>(item) - first ) / sizeof(DataBuf);
+            assert( index < BUF_LEN && &data[index].data == item );
+            return &data[index];
+        }
+
+        /**
+         * Releases the samples of all elements except \a current which no
+         * reader holds. Only the writer which moves the write_ptr calls this,
+         * after the read_ptr was moved to \a current. A reader which locks one
+         * of these elements afterwards finds that it is not the read_ptr, and
+         * retries without reading it.
+         */
+        void releaseStale( PtrType current )
+        {
+            // full barrier: readers see the new read_ptr, or we see their read_counter.
+            oro_mb();
+            for (PtrType it = current->next; it != current; it = it->next)
+                if ( oro_atomic_read( &it->read_counter ) == 0 )
+                    SampleSlot<T>::release( it->data );
+        }
+
+        /**
+         * Increments the read_counter of the current read_ptr, such that
+         * no writer will touch it until the counter is decremented again.
+         */
+        PtrType lockReadPtr() const
+        {
             PtrType reading;
             // loop to combine Read/Modify of counter
             // This avoids a race condition where read_ptr
@@ -352,16 +426,20 @@ namespace RTT
             } while ( true );
             // from here on we are sure that 'reading'
             // is a valid buffer to read from.
+            return reading;
+        }
 
-            // compare-and-swap FlowStatus field to avoid the race condition
-            // where a reader replaces it by OldData
+        /**
+         * compare-and-swap FlowStatus field to make sure that only one reader
+         * returns NewData
+         */
+        static FlowStatus markAsRead( PtrType reading )
+        {
             FlowStatus result;
             do {
                 result = reading->status;
-            } while(!os::CAS(&reading->status, result, NoData));
-
-            // XXX smp_mb
-            oro_atomic_dec(&reading->read_counter);       // release buffer
+            } while((result != NoData) && !os::CAS(&reading->status, result, OldData));
+            return result;
         }
     };
 }}
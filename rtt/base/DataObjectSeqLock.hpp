@@ -0,0 +1,379 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef CORELIB_DATAOBJECT_SEQLOCK_HPP
+#define CORELIB_DATAOBJECT_SEQLOCK_HPP
+
+
+#include "../os/oro_arch.h"
+#include "../os/CAS.hpp"
+#include "DataObjectInterface.hpp"
+#include "../Logger.hpp"
+#include "../internal/DataSourceTypeInfo.hpp"
+#include <boost/type_traits/has_trivial_copy.hpp>
+#include <boost/type_traits/has_trivial_assign.hpp>
+#include <boost/type_traits/has_trivial_destructor.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <cassert>
+#include <cstddef>
+
+/**
+ * The largest sample, in bytes, for which a LOCK_FREE data connection
+ * uses a DataObjectSeqLock instead of a DataObjectLockFree.
+ */
+#ifndef ORONUM_DATAOBJECT_SEQLOCK_MAX_SIZE
+# define ORONUM_DATAOBJECT_SEQLOCK_MAX_SIZE 256
+#endif
+
+namespace RTT
+{ namespace base {
+
+    /**
+     * Is true if samples of type \a T can be stored in a DataObjectSeqLock,
+     * which requires that a sample may be copied while it is being written.
+     */
+    template<class T>
+    struct is_seqlock_copyable
+        : boost::integral_constant<bool,
+            boost::has_trivial_copy<T>::value &&
+            boost::has_trivial_assign<T>::value &&
+            boost::has_trivial_destructor<T>::value>
+    {};
+
+    /**
+     * @brief A lock-free DataObject for trivially copyable types which
+     * uses a sequence lock over two copies of the data.
+     *
+     * A writer copies the new sample into the copy that does not hold
+     * the current sample and then publishes it by incrementing a counter.
+     * A reader copies the current sample and checks afterwards that no
+     * writer started to overwrite it, or retries. Readers do not modify
+     * the data object except to mark a sample as read, so any number of
+     * threads can read it, and a reader which preempts a writer never has
+     * to retry.
+     *
+     * Compared to DataObjectLockFree, this needs two copies of the data
+     * instead of max_threads + 2, and a reader only needs an atomic
+     * read-modify-write to claim a new sample.
+     * Only use it for types for which is_seqlock_copyable is true, since
+     * a reader may copy a sample while it is being written.
+     *
+     * Concurrent writers do not block each other: the writer which finds
+     * the data object locked fails, like in DataObjectLockFree.
+     *
+     * A read loan (GetWithoutRelease()) refers to a copy of the sample owned
+     * by the data object. There is one such copy per thread given in the
+     * Options, so up to max_threads loans can be outstanding at a time.
+     * @ingroup PortBuffers
+     */
+    template<class T>
+    class DataObjectSeqLock
+        : public DataObjectInterface<T>
+    {
+    public:
+        typedef typename DataObjectInterface<T>::value_t value_t;
+        typedef typename DataObjectInterface<T>::reference_t reference_t;
+        typedef typename DataObjectInterface<T>::param_t param_t;
+
+        typedef typename DataObjectBase::Options Options;
+
+        /**
+         * @brief The maximum number of threads, which is the number of
+         * read loans that can be outstanding at a time.
+         */
+        const unsigned int MAX_THREADS;
+
+    private:
+        /**
+         * The last written sample is in data[written & 1].
+         */
+        value_t data[2];
+
+        /**
+         * The number of written samples.
+         */
+        volatile unsigned int written;
+
+        /**
+         * The number of samples of which the writing started. This is
+         * written + 1 while a writer copies into data[(written + 1) & 1],
+         * and stays so after the loan was discarded, since the copy may be
+         * half overwritten. It never decreases, or a reader could accept
+         * such a copy.
+         */
+        volatile unsigned int writing;
+
+        /**
+         * The value of written of the last sample that was returned as NewData.
+         */
+        mutable volatile unsigned int read;
+
+        /**
+         * The value of written when the data object was (re)initialized or cleared.
+         */
+        volatile unsigned int cleared;
+
+        mutable oro_atomic_t write_lock;
+
+        /**
+         * A copy of the sample which is loaned to a reader.
+         */
+        struct LoanBuf {
+            LoanBuf()
+                : data(), lock()
+            {
+                oro_atomic_set(&lock, -1);
+            }
+            value_t data;
+            mutable oro_atomic_t lock;
+        };
+
+        /**
+         * MAX_THREADS copies for read loans.
+         */
+        LoanBuf* loans;
+
+        bool initialized;
+
+    public:
+        /**
+         * Construct an uninitialized DataObjectSeqLock.
+         * @param options The maximum number of threads accessing this DataObject.
+         */
+        DataObjectSeqLock( const Options &options = Options() )
+            : MAX_THREADS(options.max_threads()),
+              data(), written(0), writing(0), read(0), cleared(0), initialized(false)
+        {
+            oro_atomic_set(&write_lock, -1);
+            loans = new LoanBuf[MAX_THREADS];
+        }
+
+        /**
+         * Construct a DataObjectSeqLock.
+         * @param initial_value The initial value of this DataObject.
+         * @param options The maximum number of threads accessing this DataObject.
+         */
+        DataObjectSeqLock( param_t initial_value, const Options &options = Options() )
+            : MAX_THREADS(options.max_threads()),
+              data(), written(0), writing(0), read(0), cleared(0), initialized(false)
+        {
+            oro_atomic_set(&write_lock, -1);
+            loans = new LoanBuf[MAX_THREADS];
+            data_sample(initial_value);
+        }
+
+        ~DataObjectSeqLock() {
+            delete[] loans;
+        }
+
+        virtual value_t Get() const {
+            value_t cache = value_t();
+            Get(cache);
+            return cache;
+        }
+
+        /**
+         * Get a copy of the Data.
+         *
+         * @param pull A copy of the data.
+         * @param copy_old_data If true, also copy the data if the data object
+         *                      has not been updated since the last call.
+         * @param copy_sample   If true, copy the data unconditionally.
+         */
+        virtual FlowStatus Get( reference_t pull, bool copy_old_data, bool copy_sample ) const
+        {
+            if (!initialized && !copy_sample) {
+                return NoData;
+            }
+
+            FlowStatus result;
+            unsigned int current;
+            bool copied = false;
+            do {
+                current = written;
+                oro_mb();
+                // claim the sample that is copied, such that after a retry
+                // NewData is returned for the sample in pull only.
+                result = markAsRead(current);
+                // once pull was overwritten, it must hold a complete sample.
+                if ((result == NoData || (result == OldData && !copy_old_data)) && !copy_sample && !copied)
+                    return result;
+                pull = data[current & 1];
+                copied = true;
+                oro_mb();
+                // retry if a writer started to overwrite the copy we read.
+            } while ( writing - current >= 2 );
+            return result;
+        }
+
+        virtual FlowStatus Get( reference_t pull, bool copy_old_data = true ) const
+        {
+            return Get( pull, copy_old_data, /* copy_sample = */ false );
+        }
+
+        virtual bool Set( param_t push )
+        {
+            value_t* item = Loan();
+            if (!item) return false;
+
+            *item = push;
+            return Commit(item);
+        }
+
+        virtual value_t* Loan()
+        {
+            if (!initialized) {
+                log(Error) << "You set a lock-free data object of type " << internal::DataSourceTypeInfo<T>::getType() << " without initializing it with a data sample. "
+                           << "This might not be real-time safe." << endlog();
+                data_sample(value_t(), true);
+            }
+
+            if (!oro_atomic_inc_and_test(&write_lock)) {
+                // abort, another thread is writing
+                oro_atomic_dec(&write_lock);
+                return 0;
+            }
+            // after a discarded loan, its copy is written again.
+            unsigned int next = (writing == written) ? writing + 1 : writing;
+            writing = next;
+            // readers must see that this copy is being written before it is modified.
+            oro_mb();
+            return &data[next & 1];
+        }
+
+        virtual bool Commit( value_t* item )
+        {
+            // the sample must be complete before it is published.
+            oro_mb();
+            written = writing;
+            oro_atomic_dec(&write_lock);
+            return true;
+        }
+
+        virtual void Discard( value_t* item )
+        {
+            oro_atomic_dec(&write_lock);
+        }
+
+        virtual FlowStatus GetWithoutRelease( value_t*& item )
+        {
+            item = 0;
+            if (!initialized) {
+                return NoData;
+            }
+            // copy into the first copy that is not loaned to another reader.
+            LoanBuf* loan = 0;
+            for (unsigned int i = 0; i < MAX_THREADS && !loan; ++i) {
+                if (oro_atomic_inc_and_test(&loans[i].lock))
+                    loan = &loans[i];
+                else
+                    oro_atomic_dec(&loans[i].lock);
+            }
+            if (!loan) {
+                // more than MAX_THREADS read loans are outstanding
+                return NoData;
+            }
+            FlowStatus result = Get(loan->data, /* copy_old_data = */ true);
+            if (result == NoData) {
+                oro_atomic_dec(&loan->lock);
+                return NoData;
+            }
+            item = &loan->data;
+            return result;
+        }
+
+        virtual void Release( value_t* item )
+        {
+            oro_atomic_dec(&toLoanBuf(item)->lock);
+        }
+
+        virtual bool data_sample( param_t sample, bool reset = true ) {
+            if (!initialized || reset) {
+                data[0] = sample;
+                data[1] = sample;
+                for (unsigned int i = 0; i < MAX_THREADS; ++i)
+                    loans[i].data = sample;
+                writing = written;
+                read = written;
+                cleared = written;
+                initialized = true;
+                return true;
+            } else {
+                return initialized;
+            }
+        }
+
+        virtual value_t data_sample() const {
+            value_t sample;
+            (void) Get(sample, /* copy_old_data = */ true, /* copy_sample = */ true);
+            return sample;
+        }
+
+        /**
+         * Subsequent reads return NoData until a new sample has been written.
+         */
+        virtual void clear() {
+            if (!initialized) return;
+            cleared = written;
+        }
+
+    private:
+        /**
+         * Returns the loan copy that contains the given data field.
+         */
+        LoanBuf* toLoanBuf( value_t* item ) const
+        {
+            const char* first = reinterpret_cast<const char*>( &loans[0].data );
+            std::size_t index = ( reinterpret_cast<const char*>(item) - first ) / sizeof(LoanBuf);
+            assert( index < MAX_THREADS && &loans[index].data == item );
+            return &loans[index];
+        }
+
+        /**
+         * Returns the status of the sample with number \a current and makes
+         * sure that only one reader returns NewData for it.
+         */
+        FlowStatus markAsRead( unsigned int current ) const
+        {
+            if (current == cleared)
+                return NoData;
+            unsigned int last;
+            do {
+                last = read;
+                // a newer sample was read already
+                if (int(current - last) <= 0)
+                    return OldData;
+            } while (!os::CAS(&read, last, current));
+            return NewData;
+        }
+    };
+}}
+
+#endif
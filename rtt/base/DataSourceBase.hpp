@@ -145,6 +145,13 @@ namespace RTT
        */
       virtual bool isAssignable() const;
 
+      /**
+       * Returns true if this object always returns the same value, such
+       * that expressions built on top of it can be evaluated once, when
+       * they are parsed, instead of during each evaluation.
+       */
+      virtual bool isConstant() const;
+
       /**
        * In case the internal::DataSource returns a 'reference' type,
        * call this method to notify it that the data was updated
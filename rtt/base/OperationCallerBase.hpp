@@ -69,6 +69,16 @@ namespace RTT
              */
             virtual OperationCallerBase<F>* cloneI(ExecutionEngine* caller) const = 0;
 
+            /**
+             * Pre-allocates the storage of \a n concurrent send() invocations,
+             * such that send() does not allocate memory. While all
+             * invocations are in use, send() fails. When \a n is zero,
+             * send() allocates the storage of each invocation, which is the default.
+             * @return false if this implementation does not support it.
+             * @nrt
+             */
+            virtual bool setMaxConcurrentSends(unsigned int n) { return false; }
+
         };
     }
 }
@@ -44,11 +44,11 @@ using namespace base;
 using namespace internal;
 
 OperationCallerInterface::OperationCallerInterface()
-    : myengine(0), caller(0), met(ClientThread)
+    : myengine(0), caller(0), met(ClientThread), mpriority(NormalPriority)
 {}
 
 OperationCallerInterface::OperationCallerInterface(OperationCallerInterface const& orig)
-    : myengine(orig.myengine), caller(orig.caller),  met(orig.met)
+    : myengine(orig.myengine), caller(orig.caller),  met(orig.met), mpriority(orig.mpriority)
 {}
 
 OperationCallerInterface::~OperationCallerInterface()
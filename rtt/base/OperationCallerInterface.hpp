@@ -42,6 +42,7 @@
 #include "../rtt-fwd.hpp"
 #include "DisposableInterface.hpp"
 #include "OperationBase.hpp"
+#include "../MessagePriority.hpp"
 
 namespace RTT
 {
@@ -104,6 +105,15 @@ namespace RTT
 
             ExecutionThread getThread() const { return met; }
 
+            /**
+             * Sets the priority class of the messages which are
+             * sent to the ExecutionEngine when this operation is
+             * sent or its results are returned to the caller.
+             */
+            void setPriority(MessagePriority p) { mpriority = p; }
+
+            MessagePriority getPriority() const { return mpriority; }
+
             /**
              * Executed when the operation execution resulted in a
              * C++ exception. Must report the error to the ExecutionEngine
@@ -122,6 +132,7 @@ namespace RTT
             ExecutionEngine* myengine;
             ExecutionEngine* caller;
             ExecutionThread met;
+            MessagePriority mpriority;
         };
     }
 }
@@ -48,7 +48,7 @@ using namespace RTT::detail;
 using namespace std;
 
 PortInterface::PortInterface(const std::string& name)
-    : name(name), fullName(name), iface(0), cmanager(this) {}
+    : name(name), fullName(name), mpriority(NormalPriority), mcallback(0), iface(0), cmanager(this) {}
 
 PortInterface::~PortInterface() {}
 
@@ -76,6 +76,11 @@ PortInterface& PortInterface::doc(const std::string& desc) {
     return *this;
 }
 
+PortInterface& PortInterface::priority(MessagePriority p) {
+    mpriority = p;
+    return *this;
+}
+
 bool PortInterface::connectedTo(PortInterface* port) {
     return cmanager.connectedTo(port);
 }
@@ -48,6 +48,7 @@
 #include "../types/rtt-types-fwd.hpp"
 #include "../os/Mutex.hpp"
 #include "../rtt-fwd.hpp"
+#include "../MessagePriority.hpp"
 
 namespace RTT
 { namespace base {
@@ -61,6 +62,14 @@ namespace RTT
         std::string name;
         std::string fullName;
         std::string mdesc;
+        MessagePriority mpriority;
+
+        /**
+         * The callback of this event port, owned by the TaskContext, or null.
+         */
+        internal::PortCallback* mcallback;
+        friend class RTT::ExecutionEngine;
+        friend class RTT::TaskContext;
 
         void updateFullName();
 
@@ -112,6 +121,20 @@ namespace RTT
          */
         PortInterface& doc(const std::string& desc);
 
+        /**
+         * Get the priority class of the callbacks of this port.
+         */
+        MessagePriority getPriority() const { return mpriority; }
+
+        /**
+         * Set the priority class with which the callbacks of this port
+         * are queued in the ExecutionEngine of its owner. Defaults to
+         * NormalPriority.
+         * @param p The priority class of the port's callbacks.
+         * @return a reference to this object.
+         */
+        PortInterface& priority(MessagePriority p);
+
 
         /** Returns true if this port is connected */
         virtual bool connected() const = 0;
@@ -0,0 +1,60 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_SAMPLE_SLOT_HPP
+#define ORO_SAMPLE_SLOT_HPP
+
+namespace RTT
+{ namespace base {
+
+    /**
+     * Tells the lock-free buffers and data objects what to do with a
+     * slot once the sample it holds has been read and the slot is free.
+     * By default, the slot keeps the sample, such that its memory can be
+     * reused by the next write. Specialize it for sample types which refer
+     * to a resource that must be given back as soon as possible, like
+     * internal::SharedSample.
+     */
+    template<class T>
+    struct SampleSlot
+    {
+        /**
+         * True if release() must be called for freed slots.
+         */
+        static const bool needs_release = false;
+
+        /**
+         * Releases what the \a sample in a free slot refers to.
+         */
+        static void release(T& sample) {}
+    };
+}}
+
+#endif
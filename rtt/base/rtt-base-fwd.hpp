@@ -46,6 +46,7 @@ namespace RTT {
         class AttributeBase;
         class BufferBase;
         class ChannelElementBase;
+        class ChannelStatistics;
         class MultipleInputsChannelElementBase;
         class MultipleOutputsChannelElementBase;
         class MultipleInputsMultipleOutputsChannelElementBase;
@@ -71,6 +72,8 @@ namespace RTT {
         class Buffer;
         template< class T>
         class BufferLockFree;
+        template< class T>
+        class BufferLockFreeSPSC;
         template<class F>
         struct OperationCallerBase;
         template<class T>
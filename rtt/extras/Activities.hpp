@@ -48,7 +48,9 @@
  */
 #include "SlaveActivity.hpp"
 #include "SequentialActivity.hpp"
+#include "DataFlowActivity.hpp"
 #include "PeriodicActivity.hpp"
+#include "PoolActivity.hpp"
 #include "../Activity.hpp"
 #include "../base/RunnableInterface.hpp"
 
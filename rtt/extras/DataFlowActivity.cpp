@@ -0,0 +1,334 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "DataFlowActivity.hpp"
+#include "SlaveActivity.hpp"
+#include "../TaskContext.hpp"
+#include "../DataFlowInterface.hpp"
+#include "../base/PortInterface.hpp"
+#include "../base/InputPortInterface.hpp"
+#include "../base/OutputPortInterface.hpp"
+#include "../os/MutexLock.hpp"
+#include "../os/TimeService.hpp"
+#include "../Logger.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace RTT
+{ namespace extras {
+
+    using namespace base;
+
+    /**
+     * Executes a part of one level of the schedule each time
+     * it is started.
+     */
+    class DataFlowActivity::Worker : public os::Thread
+    {
+    public:
+        Worker(DataFlowActivity& a, unsigned int i, int scheduler, int priority, const std::string& name)
+            : os::Thread(scheduler, priority, 0.0, 0, name), act(a), index(i)
+        {}
+
+        void loop()
+        {
+            act.execute(act.mbegin + index, act.mend, act.mstride);
+            if ( act.mpending.dec_and_test() ) {
+                os::MutexLock lock(act.mdone_lock);
+                act.mdone.broadcast();
+            }
+        }
+
+        DataFlowActivity& act;
+        /** The offset in the level, the activity itself takes offset 0. */
+        const unsigned int index;
+    };
+
+    DataFlowActivity::DataFlowActivity( int scheduler, int priority, Seconds period, unsigned int workers,
+                                        const std::string& name )
+        : Activity(scheduler, priority, period, (RunnableInterface*)0, name), mchanged(false),
+          mbegin(0), mend(0), mstride(1)
+    {
+        for (unsigned int i = 1; i < workers; ++i) {
+            std::ostringstream wname;
+            wname << name << "." << i;
+            // each start() of a worker executes its loop() once.
+            mworkers.push_back( new Worker(*this, i, scheduler, priority, wname.str()) );
+        }
+    }
+
+    DataFlowActivity::~DataFlowActivity()
+    {
+        // step() uses the workers.
+        stop();
+        for (unsigned int i = 0; i != mworkers.size(); ++i)
+            delete mworkers[i];
+    }
+
+    bool DataFlowActivity::addComponent( TaskContext* component )
+    {
+        os::MutexLock lock(mlock);
+        if ( !component || component->isRunning()
+             || std::find(mcomponents.begin(), mcomponents.end(), component) != mcomponents.end() )
+            return false;
+        if ( !component->setActivity( new SlaveActivity( getPeriod() ) ) )
+            return false;
+        mcomponents.push_back( component );
+        return true;
+    }
+
+    bool DataFlowActivity::removeComponent( TaskContext* component )
+    {
+        // A step() which executes the component must finish first, unless
+        // we are called from that step().
+        bool inside = isSelf();
+        for (unsigned int i = 0; i != mworkers.size(); ++i)
+            inside = inside || mworkers[i]->isSelf();
+        if ( !inside )
+            mexecuting.lock();
+        {
+            os::MutexLock lock(mlock);
+            std::vector<TaskContext*>::iterator it = std::find(mcomponents.begin(), mcomponents.end(), component);
+            if ( it == mcomponents.end() ) {
+                if ( !inside )
+                    mexecuting.unlock();
+                return false;
+            }
+            mcomponents.erase(it);
+            for (unsigned int i = 0; i != mschedule.size(); ++i) {
+                if ( mschedule[i].component != component )
+                    continue;
+                // keep the levels consistent with the shorter schedule.
+                mschedule.erase( mschedule.begin() + i );
+                for (unsigned int l = 0; l != mlevels.size(); ++l)
+                    if ( mlevels[l] > i )
+                        --mlevels[l];
+                mlevels.erase( std::unique(mlevels.begin(), mlevels.end()), mlevels.end() );
+                mchanged = true;
+                break;
+            }
+        }
+        // the component gets the activity of a new TaskContext, unless it is
+        // running or its SlaveActivity may still be executed by our step().
+        if ( !inside && !component->isRunning() ) {
+            // setActivity() refuses to replace an active SlaveActivity
+            // without master, which presents the calling thread as its own.
+            if ( component->getActivity() )
+                component->getActivity()->stop();
+            component->setActivity( 0 );
+        }
+        if ( !inside )
+            mexecuting.unlock();
+        return true;
+    }
+
+    /**
+     * Returns true if an output port of \a from is connected to
+     * an input port of \a to.
+     */
+    static bool feeds( TaskContext* from, TaskContext* to )
+    {
+        DataFlowInterface::Ports outputs = from->ports()->getPorts();
+        DataFlowInterface::Ports inputs = to->ports()->getPorts();
+        for (DataFlowInterface::Ports::iterator o = outputs.begin(); o != outputs.end(); ++o) {
+            if ( !dynamic_cast<OutputPortInterface*>(*o) || !(*o)->connected() )
+                continue;
+            for (DataFlowInterface::Ports::iterator i = inputs.begin(); i != inputs.end(); ++i)
+                if ( dynamic_cast<InputPortInterface*>(*i) && (*o)->getManager()->connectedTo(*i) )
+                    return true;
+        }
+        return false;
+    }
+
+    bool DataFlowActivity::updateSchedule()
+    {
+        os::MutexLock lock(mlock);
+        const unsigned int n = mcomponents.size();
+
+        // successors and number of unscheduled predecessors of each component.
+        std::vector< std::vector<unsigned int> > successors(n);
+        std::vector<unsigned int> predecessors(n, 0);
+        for (unsigned int a = 0; a != n; ++a)
+            for (unsigned int b = 0; b != n; ++b)
+                if ( a != b && feeds(mcomponents[a], mcomponents[b]) ) {
+                    successors[a].push_back(b);
+                    ++predecessors[b];
+                }
+
+        // Kahn's algorithm, one level at a time.
+        std::vector<ScheduleEntry> schedule;
+        std::vector<unsigned int> levels;
+        std::vector<unsigned int> order;
+        std::vector<unsigned int> current;
+        for (unsigned int c = 0; c != n; ++c)
+            if ( predecessors[c] == 0 )
+                current.push_back(c);
+        while ( !current.empty() ) {
+            levels.push_back( schedule.size() );
+            std::vector<unsigned int> next;
+            for (unsigned int i = 0; i != current.size(); ++i) {
+                unsigned int c = current[i];
+                schedule.push_back( ScheduleEntry( mcomponents[c] ) );
+                schedule.back().level = levels.size() - 1;
+                for (unsigned int s = 0; s != successors[c].size(); ++s)
+                    if ( --predecessors[ successors[c][s] ] == 0 )
+                        next.push_back( successors[c][s] );
+            }
+            current.swap(next);
+        }
+
+        if ( schedule.size() != n ) {
+            std::ostringstream cycle;
+            for (unsigned int c = 0; c != n; ++c)
+                if ( predecessors[c] != 0 )
+                    cycle << " " << mcomponents[c]->getName();
+            log(Error) << "DataFlowActivity " << getName() << ": the port connections between these components form a cycle:" << cycle.str() << endlog();
+            return false;
+        }
+
+        // keep the statistics of the components which remain.
+        for (unsigned int i = 0; i != schedule.size(); ++i)
+            for (unsigned int j = 0; j != mschedule.size(); ++j)
+                if ( mschedule[j].component == schedule[i].component ) {
+                    unsigned int level = schedule[i].level;
+                    schedule[i] = mschedule[j];
+                    schedule[i].level = level;
+                }
+        levels.push_back( schedule.size() );
+        mschedule.swap(schedule);
+        mlevels.swap(levels);
+        mchanged = true;
+        return true;
+    }
+
+    std::vector<DataFlowActivity::ScheduleEntry> DataFlowActivity::getSchedule() const
+    {
+        os::MutexLock lock(mlock);
+        return mschedule;
+    }
+
+    void DataFlowActivity::resetStatistics()
+    {
+        os::MutexLock lock(mlock);
+        for (unsigned int i = 0; i != mschedule.size(); ++i) {
+            ScheduleEntry& e = mschedule[i];
+            e.last = e.max = e.total = 0;
+            e.count = 0;
+        }
+    }
+
+    unsigned int DataFlowActivity::getWorkers() const
+    {
+        return mworkers.size() + 1;
+    }
+
+    bool DataFlowActivity::initialize()
+    {
+        return updateSchedule();
+    }
+
+    void DataFlowActivity::execute(unsigned int begin, unsigned int end, unsigned int stride)
+    {
+        for (unsigned int i = begin; i < end; i += stride) {
+            ScheduleEntry& e = mrun[i];
+            ActivityInterface* slave = e.component->getActivity();
+            nsecs start = os::TimeService::Instance()->getNSecs();
+            if ( !slave || !slave->execute() )
+                continue;
+            e.last = os::TimeService::Instance()->getNSecs() - start;
+            if ( e.last > e.max )
+                e.max = e.last;
+            e.total += e.last;
+            ++e.count;
+        }
+    }
+
+    void DataFlowActivity::step()
+    {
+        os::MutexLock executing(mexecuting);
+        {
+            // The components are executed from a copy of the schedule, such
+            // that their hooks may change or read the schedule. The copies
+            // keep their capacity, so this only allocates when the schedule grew.
+            os::MutexLock lock(mlock);
+            mrun.assign( mschedule.begin(), mschedule.end() );
+            mrunlevels.assign( mlevels.begin(), mlevels.end() );
+            mchanged = false;
+        }
+        for (unsigned int i = 0; i != mrun.size(); ++i) {
+            ScheduleEntry& e = mrun[i];
+            e.max = e.total = 0;
+            e.count = 0;
+        }
+
+        for (unsigned int l = 0; l + 1 < mrunlevels.size(); ++l) {
+            unsigned int begin = mrunlevels[l], end = mrunlevels[l + 1];
+            unsigned int helpers = std::min<unsigned int>( mworkers.size(), end - begin - 1 );
+            if ( helpers == 0 ) {
+                execute(begin, end, 1);
+                continue;
+            }
+            mbegin = begin;
+            mend = end;
+            mstride = helpers + 1;
+            mpending.set(helpers);
+            for (unsigned int w = 0; w != helpers; ++w)
+                mworkers[w]->start();
+            execute(begin, end, mstride);
+            os::MutexLock done(mdone_lock);
+            while ( mpending.read() != 0 )
+                mdone.wait(mdone_lock);
+        }
+
+        // add the execution times of this cycle to the schedule.
+        os::MutexLock lock(mlock);
+        for (unsigned int i = 0; i != mrun.size(); ++i) {
+            const ScheduleEntry& e = mrun[i];
+            if ( e.count == 0 )
+                continue;
+            unsigned int j = i;
+            if ( mchanged ) {
+                for (j = 0; j != mschedule.size(); ++j)
+                    if ( mschedule[j].component == e.component )
+                        break;
+            }
+            if ( j >= mschedule.size() )
+                continue;
+            ScheduleEntry& to = mschedule[j];
+            to.last = e.last;
+            if ( e.max > to.max )
+                to.max = e.max;
+            to.total += e.total;
+            to.count += e.count;
+        }
+    }
+
+}}
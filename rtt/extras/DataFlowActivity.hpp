@@ -0,0 +1,201 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_DATAFLOW_ACTIVITY_HPP
+#define ORO_DATAFLOW_ACTIVITY_HPP
+
+#include "../Activity.hpp"
+#include "../rtt-fwd.hpp"
+#include "../os/Mutex.hpp"
+#include "../os/Condition.hpp"
+#include "../os/Atomic.hpp"
+#include <vector>
+
+namespace RTT
+{ namespace extras {
+
+    /**
+     * @brief An activity which executes a set of components in the order
+     * of their data flow, in a single periodic or triggered activity.
+     *
+     * Each component added with addComponent() gets a periodic
+     * SlaveActivity, which this activity executes. The execution order is
+     * derived from the port connections between the components: when an
+     * output port of component A is connected to an input port of component
+     * B, A is executed before B, such that the data written by A is read by B
+     * in the same cycle. Components without such a dependency on each other
+     * are at the same level of the graph, which may be executed in parallel
+     * by additional worker threads.
+     *
+     * The schedule is computed when this activity starts and when
+     * updateSchedule() is called, for example after connections changed. A
+     * cycle in the connections between the components is reported and
+     * prevents the activity from starting.
+     *
+     * The components must be started and stopped by the user, as with
+     * any other SlaveActivity. Stopped components are skipped.
+     *
+     * @ingroup CoreLibActivities
+     */
+    class RTT_API DataFlowActivity
+        : public Activity
+    {
+    public:
+        /**
+         * One component in the schedule, with its execution times
+         * in the last cycles.
+         */
+        struct ScheduleEntry {
+            ScheduleEntry(TaskContext* c = 0)
+                : component(c), level(0), last(0), max(0), total(0), count(0) {}
+            TaskContext* component;
+            /** The number of components on the longest path to this component. */
+            unsigned int level;
+            /** The execution time of the last cycle. */
+            nsecs last;
+            /** The largest execution time so far. */
+            nsecs max;
+            /** The sum of all execution times. */
+            nsecs total;
+            /** The number of executions. */
+            unsigned long count;
+        };
+
+        /**
+         * Create a data flow activity with a given scheduler type, priority and
+         * period.
+         * @param scheduler ORO_SCHED_RT or ORO_SCHED_OTHER.
+         * @param priority The priority of this activity and its workers.
+         * @param period The periodicity of this activity. When zero, the
+         * components are executed once each time this activity is triggered.
+         * @param workers The number of threads which execute the components
+         * of one level, including the thread of this activity.
+         * @param name The name of this activity.
+         */
+        DataFlowActivity( int scheduler, int priority, Seconds period, unsigned int workers = 1,
+                          const std::string& name = "DataFlowActivity" );
+
+        /**
+         * Stops this activity and its workers. The components keep
+         * their SlaveActivity.
+         */
+        ~DataFlowActivity();
+
+        /**
+         * Adds a component to this activity.
+         * @param component A component which is not running. It gets
+         * a SlaveActivity which is executed by this activity.
+         * @return false if the component is running, was added already or
+         * could not be given a SlaveActivity.
+         */
+        bool addComponent( TaskContext* component );
+
+        /**
+         * Removes a component from this activity. A component which is
+         * not running gets the default activity of a new TaskContext, since
+         * the activity it had before addComponent() was deleted. A running
+         * component keeps its SlaveActivity, which is no longer executed.
+         * When called from a hook of a component executed by this activity,
+         * the component keeps its SlaveActivity, which the current step()
+         * may execute once more.
+         * @return false if the component was not added.
+         */
+        bool removeComponent( TaskContext* component );
+
+        /**
+         * Computes the execution order of the components from their
+         * port connections.
+         * @return false if the connections contain a cycle, in which case
+         * the previous schedule is kept.
+         */
+        bool updateSchedule();
+
+        /**
+         * Returns the components in their execution order, together with their
+         * level in the graph and their execution times.
+         */
+        std::vector<ScheduleEntry> getSchedule() const;
+
+        /**
+         * Clears the execution times of getSchedule().
+         */
+        void resetStatistics();
+
+        /**
+         * Returns the number of threads which execute a level.
+         */
+        unsigned int getWorkers() const;
+
+        /**
+         * Computes the schedule, fails if it contains a cycle.
+         */
+        virtual bool initialize();
+
+        /**
+         * Executes all running components in their schedule order.
+         * The schedule is copied first, such that the hooks of the components
+         * may call the other functions of this activity.
+         */
+        virtual void step();
+
+    private:
+        class Worker;
+        friend class Worker;
+
+        /**
+         * Executes the entries [begin, end) of the schedule with a
+         * stride of \a stride.
+         */
+        void execute(unsigned int begin, unsigned int end, unsigned int stride);
+
+        /** Protects the schedule. */
+        mutable os::Mutex mlock;
+        /** Held by step() while it executes the components. */
+        os::Mutex mexecuting;
+        std::vector<TaskContext*> mcomponents;
+        std::vector<ScheduleEntry> mschedule;
+        /** The index in mschedule where each level starts, terminated by its size. */
+        std::vector<unsigned int> mlevels;
+        /** True if mschedule changed since step() copied it. */
+        bool mchanged;
+        /** The copies of mschedule and mlevels which step() executes. */
+        std::vector<ScheduleEntry> mrun;
+        std::vector<unsigned int> mrunlevels;
+        std::vector<Worker*> mworkers;
+        /** The level the workers execute, and the number of busy workers. */
+        unsigned int mbegin, mend, mstride;
+        os::AtomicInt mpending;
+        os::Mutex mdone_lock;
+        os::Condition mdone;
+    };
+
+}}
+
+#endif
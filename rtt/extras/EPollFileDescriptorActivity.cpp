@@ -0,0 +1,359 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "EPollFileDescriptorActivity.hpp"
+#include "../ExecutionEngine.hpp"
+#include "../base/TaskCore.hpp"
+#include "../Logger.hpp"
+
+#include <algorithm>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <boost/cstdint.hpp>
+
+using namespace RTT;
+using namespace extras;
+using namespace base;
+
+EPollFileDescriptorActivity::EPollFileDescriptorActivity(int priority, RunnableInterface* _r, const std::string& name )
+    : Activity(priority, 0.0, _r, name)
+    , m_period(0)
+{
+    init();
+}
+
+EPollFileDescriptorActivity::EPollFileDescriptorActivity(int scheduler, int priority, RunnableInterface* _r, const std::string& name )
+    : Activity(scheduler, priority, 0.0, _r, name)
+    , m_period(0)
+{
+    init();
+}
+
+EPollFileDescriptorActivity::EPollFileDescriptorActivity(int scheduler, int priority, Seconds period, RunnableInterface* _r, const std::string& name )
+    : Activity(scheduler, priority, 0.0, _r, name)	// actual period == 0.0
+    , m_period(period >= 0.0 ? period : 0.0)        // intended period
+{
+    init();
+}
+
+EPollFileDescriptorActivity::EPollFileDescriptorActivity(int scheduler, int priority, Seconds period, unsigned cpu_affinity, RunnableInterface* _r, const std::string& name )
+    : Activity(scheduler, priority, 0.0, cpu_affinity, _r, name)	// actual period == 0.0
+    , m_period(period >= 0.0 ? period : 0.0)        // intended period
+{
+    init();
+}
+
+void EPollFileDescriptorActivity::init()
+{
+    m_running = false;
+    m_timeout_us = 0;
+    m_has_error = false;
+    m_has_timeout = false;
+    m_break_loop = false;
+    m_trigger = false;
+    m_user_timeout = false;
+
+    // Both live as long as this object, such that fds can be watched before start().
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    m_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll_fd == -1 || m_event_fd == -1)
+    {
+        log(Error) << "EPollFileDescriptorActivity: cannot create epoll instance or eventfd, errno = "
+                   << errno << endlog();
+        return;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = m_event_fd;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_event_fd, &ev) == -1)
+        log(Error) << "EPollFileDescriptorActivity: cannot watch eventfd, errno = " << errno << endlog();
+}
+
+EPollFileDescriptorActivity::~EPollFileDescriptorActivity()
+{
+    stop();
+    if (m_event_fd != -1)
+        close(m_event_fd);
+    if (m_epoll_fd != -1)
+        close(m_epoll_fd);
+}
+
+Seconds EPollFileDescriptorActivity::getPeriod() const
+{ return m_period; }
+
+bool EPollFileDescriptorActivity::setPeriod(Seconds p)
+{
+	if (p < 0)
+        return false;
+	m_period = p;
+	return true;
+}
+
+bool EPollFileDescriptorActivity::isRunning() const
+{ return Activity::isRunning() && m_running; }
+int EPollFileDescriptorActivity::getTimeout() const
+{ return m_timeout_us / 1000; }
+int EPollFileDescriptorActivity::getTimeout_us() const
+{ return m_timeout_us; }
+void EPollFileDescriptorActivity::setTimeout(int timeout)
+{
+	setTimeout_us(timeout * 1000);
+}
+void EPollFileDescriptorActivity::setTimeout_us(int timeout_us)
+{
+	if (0 <= timeout_us)
+	{
+		m_timeout_us = timeout_us;
+	}
+	else
+	{
+        log(Error) << "Ignoring invalid timeout (" << timeout_us << ")" << endlog();
+    }
+}
+void EPollFileDescriptorActivity::watch(int fd)
+{ RTT::os::MutexLock lock(m_lock);
+    if (fd < 0)
+    {
+        log(Error) << "negative file descriptor given to EPollFileDescriptorActivity::watch" << endlog();
+        return;
+    }
+    bool added = m_watched_fds.insert(fd).second;
+
+    // A running loop() picks up the new fd without being woken up.
+    // The fd is added again if it was watched already: the kernel dropped
+    // it from the epoll set if it was closed since, and its number may now
+    // refer to a newly opened file. EEXIST means it is still registered.
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1 && errno != EEXIST)
+    {
+        log(Error) << "EPollFileDescriptorActivity: cannot watch file descriptor " << fd
+                   << ", errno = " << errno << endlog();
+        if (added)
+            m_watched_fds.erase(fd);
+    }
+}
+void EPollFileDescriptorActivity::unwatch(int fd)
+{ RTT::os::MutexLock lock(m_lock);
+    if (m_watched_fds.erase(fd))
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, 0);
+}
+void EPollFileDescriptorActivity::clearAllWatches()
+{ RTT::os::MutexLock lock(m_lock);
+    for (std::set<int>::const_iterator it = m_watched_fds.begin(); it != m_watched_fds.end(); ++it)
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, *it, 0);
+    m_watched_fds.clear();
+}
+bool EPollFileDescriptorActivity::isUpdated(int fd) const
+{ return std::binary_search(m_ready_fds.begin(), m_ready_fds.end(), fd); }
+bool EPollFileDescriptorActivity::hasError() const
+{ return m_has_error; }
+bool EPollFileDescriptorActivity::hasTimeout() const
+{ return m_has_timeout; }
+bool EPollFileDescriptorActivity::isWatched(int fd) const
+{ RTT::os::MutexLock lock(m_lock);
+    return m_watched_fds.count(fd) != 0; }
+
+bool EPollFileDescriptorActivity::start()
+{
+    if ( isActive() )
+        return false;
+
+    if (m_epoll_fd == -1 || m_event_fd == -1)
+    {
+        log(Error) << "EPollFileDescriptorActivity: no epoll instance or eventfd" << endlog();
+        return false;
+    }
+
+    // reset flags and wake-ups of a previous run
+    clearEventFd();
+    m_break_loop = false;
+    m_trigger = false;
+    m_user_timeout = false;
+
+    if (!Activity::start())
+    {
+        log(Error) << "EPollFileDescriptorActivity: Activity::start() failed" << endlog();
+        return false;
+    }
+    return true;
+}
+
+bool EPollFileDescriptorActivity::trigger()
+{
+    if (isActive()) {
+        { RTT::os::MutexLock lock(m_command_mutex);
+            m_trigger = true;
+        }
+        writeEventFd();
+        return true;
+    } else
+        return false;
+}
+
+bool EPollFileDescriptorActivity::timeout()
+{
+    if (isActive()) {
+        { RTT::os::MutexLock lock(m_command_mutex);
+            m_user_timeout = true;
+        }
+        writeEventFd();
+        return true;
+    } else
+        return false;
+}
+
+void EPollFileDescriptorActivity::loop()
+{
+    static const int MAX_EVENTS = 64;
+    struct epoll_event events[MAX_EVENTS];
+
+    while(true)
+    {
+        int timeout_ms = -1;
+        if (m_timeout_us != 0)
+            timeout_ms = (m_timeout_us + 999) / 1000;
+
+        m_running = false;
+        int ret = epoll_wait(m_epoll_fd, events, MAX_EVENTS, timeout_ms);
+
+        m_has_error   = false;
+        m_has_timeout = false;
+        m_ready_fds.clear();
+        if (ret == -1)
+        {
+            log(Error) << "EPollFileDescriptorActivity: error in epoll_wait(), errno = "
+                       << errno << endlog();
+            m_has_error = true;
+        }
+        else if (ret == 0)
+        {
+            log(Error) << "EPollFileDescriptorActivity: timeout in epoll_wait()" << endlog();
+            m_has_timeout = true;
+        }
+
+        // Level-triggered: fds that did not fit in events are reported by the next epoll_wait().
+        for (int i = 0; i < ret; ++i)
+        {
+            if (events[i].data.fd == m_event_fd)
+                clearEventFd(); // breakLoop or trigger requests
+            else
+                m_ready_fds.push_back(events[i].data.fd);
+        }
+        std::sort(m_ready_fds.begin(), m_ready_fds.end());
+
+        // We check the flags after the eventfd was emptied as we could
+        // miss commands otherwise:
+        bool user_trigger = false;
+        bool user_timeout = false;
+        { RTT::os::MutexLock lock(m_command_mutex);
+            // This section should be really fast to not block threads calling
+            // trigger(), breakLoop() or timeout().
+            if (m_trigger) {
+                user_trigger = true;
+                m_trigger = false;
+            }
+            if (m_user_timeout) {
+                user_timeout = true;
+                m_user_timeout = false;
+            }
+            if (m_break_loop) {
+                m_break_loop = false;
+                break;
+            }
+        }
+
+        try
+        {
+            m_running = true;
+            step();
+            if (m_has_timeout)
+                work(RunnableInterface::TimeOut);
+            else if ( user_timeout )
+                work(RunnableInterface::TimeOut);
+            else if ( user_trigger )
+                work(RunnableInterface::Trigger);
+            else
+                work(RunnableInterface::IOReady);
+            m_running = false;
+        }
+        catch(...)
+        {
+            m_running = false;
+            throw;
+        }
+    }
+}
+
+void EPollFileDescriptorActivity::clearEventFd() {
+    // a single read resets the counter of all pending writes
+    boost::uint64_t count;
+    int unused; (void)unused;
+    unused = read(m_event_fd, &count, sizeof(count));
+}
+void EPollFileDescriptorActivity::writeEventFd() {
+    boost::uint64_t one = 1;
+    int unused; (void)unused; // avoid the "return value not used" warning
+    unused = write(m_event_fd, &one, sizeof(one));
+}
+
+bool EPollFileDescriptorActivity::breakLoop()
+{
+    { RTT::os::MutexLock lock(m_command_mutex);
+        m_break_loop = true;
+    }
+    writeEventFd();
+    return true;
+}
+
+void EPollFileDescriptorActivity::step()
+{
+    m_running = true;
+    if (runner != 0)
+        runner->step();
+    m_running = false;
+}
+
+void EPollFileDescriptorActivity::work(base::RunnableInterface::WorkReason reason) {
+    m_running = true;
+    if (runner != 0)
+        runner->work(reason);
+    m_running = false;
+}
+
+bool EPollFileDescriptorActivity::stop()
+{
+    return Activity::stop();
+}
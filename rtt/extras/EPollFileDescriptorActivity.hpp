@@ -0,0 +1,195 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef EPOLL_FILEDESCRIPTOR_ACTIVITY_HPP
+#define EPOLL_FILEDESCRIPTOR_ACTIVITY_HPP
+
+#include "FileDescriptorActivityInterface.hpp"
+#include "../Activity.hpp"
+#include <set>
+#include <vector>
+
+namespace RTT { namespace extras {
+
+    /** A FileDescriptorActivity for Linux which waits with epoll instead of
+     * select(). Waiting costs the same for any number of watched file
+     * descriptors, which is not limited to FD_SETSIZE. trigger(), timeout()
+     * and breakLoop() wake up the activity with a single write on an eventfd.
+     *
+     * It is used like FileDescriptorActivity, see
+     * FileDescriptorActivityInterface:
+     *
+     * <code>
+     *   FileDescriptorActivityInterface* fd_activity =
+     *      dynamic_cast<FileDescriptorActivityInterface*>(getActivity().get());
+     * </code>
+     *
+     * The watched file descriptors are level-triggered, so step() is called
+     * again as long as data is left on one of them. Timeouts are rounded up
+     * to whole milliseconds.
+     */
+    class RTT_API EPollFileDescriptorActivity : public extras::FileDescriptorActivityInterface,
+                                                public Activity
+    {
+        std::set<int> m_watched_fds;
+        std::vector<int> m_ready_fds; //! sorted file descriptors reported by the last wait
+        bool m_running;
+        int  m_epoll_fd;
+        int  m_event_fd;
+        int  m_timeout_us;		//! timeout in microseconds
+        Seconds m_period;		//! intended period
+        mutable RTT::os::Mutex m_lock;
+        bool m_has_error;
+        bool m_has_timeout;
+
+        RTT::os::Mutex m_command_mutex;
+        bool m_break_loop;
+        bool m_trigger;
+        bool m_user_timeout;
+
+        void init();
+
+        void writeEventFd();
+
+        void clearEventFd();
+
+    public:
+        /**
+         * Create an EPollFileDescriptorActivity with a given priority and base::RunnableInterface
+         * instance. The default scheduler for EPollFileDescriptorActivity
+         * objects is ORO_SCHED_RT.
+         *
+         * @param priority The priority of the underlying thread.
+         * @param _r The optional runner, if none, this->loop() is called.
+         * @param name The name of the underlying thread.
+         */
+        EPollFileDescriptorActivity(int priority, base::RunnableInterface* _r = 0, const std::string& name ="EPollFileDescriptorActivity" );
+
+        /**
+         * Create an EPollFileDescriptorActivity with a given scheduler type, priority and
+         * base::RunnableInterface instance.
+         * @param scheduler
+         *        The scheduler in which the activitie's thread must run. Use ORO_SCHED_OTHER or
+         *        ORO_SCHED_RT.
+         * @param priority The priority of the underlying thread.
+         * @param _r The optional runner, if none, this->loop() is called.
+         * @param name The name of the underlying thread.
+         */
+        EPollFileDescriptorActivity(int scheduler, int priority, base::RunnableInterface* _r = 0, const std::string& name ="EPollFileDescriptorActivity" );
+
+        /**
+         * As above, with the _intended_ \a period of the activity.
+         * The underlying thread is not periodic.
+         */
+        EPollFileDescriptorActivity(int scheduler, int priority, Seconds period, base::RunnableInterface* _r = 0, const std::string& name ="EPollFileDescriptorActivity" );
+
+        /**
+         * As above, with the cpu affinity of the underlying thread.
+         */
+        EPollFileDescriptorActivity(int scheduler, int priority, Seconds period, unsigned cpu_affinity,
+                                    base::RunnableInterface* _r = 0, const std::string& name ="EPollFileDescriptorActivity" );
+
+        virtual ~EPollFileDescriptorActivity();
+
+        bool isRunning() const;
+
+		/// Get the _intended_ period (not the actual running period)
+        virtual Seconds getPeriod() const;
+
+		/// Set the _intended_ period (not the actual running period)
+        virtual bool setPeriod(Seconds period);
+
+        void watch(int fd);
+
+        void unwatch(int fd);
+
+        void clearAllWatches();
+
+        bool isWatched(int fd) const;
+
+        bool isUpdated(int fd) const;
+
+        bool hasTimeout() const;
+
+        bool hasError() const;
+
+        void setTimeout(int timeout);
+
+        void setTimeout_us(int timeout_us);
+
+        int getTimeout() const;
+
+        int getTimeout_us() const;
+
+        /** Start the underlying thread and make it call \c loop
+         */
+        virtual bool start();
+
+        /** The main loop, listening to various wake-up events
+         *
+         * The loop can be broken by calling \c breakLoop. \c timeout and \c trigger
+         * will wake it up and make it call work with resp. a TimeOut and Trigger
+         * reason. Available I/O on watched file descriptors will wake it up and
+         * make it call \c work with a IOReady reason
+         */
+        virtual void loop();
+
+        /** Wake-up \c loop and make it return */
+        virtual bool breakLoop();
+        virtual bool stop();
+
+        /** @deprecated does nothing, EPollFileDescriptorActivity uses the \c work interface
+         */
+        virtual void step();
+
+        /** Called by loop() when it is woken up
+         *
+         * @see FileDescriptorActivity::work
+         */
+        virtual void work(base::RunnableInterface::WorkReason reason);
+
+        /**
+         * Wake up the main thread (in \c loop) and call \c work with Trigger as reason
+         *
+         * @return true if the activity is active, that is if it is started and
+         *   will process the trigger. false otherwise.
+         */
+        virtual bool trigger();
+
+        /**
+         * Wake up the main thread (in \c loop) and call \c work with TimeOut as reason
+         *
+         * @return true if the activity is active, that is if it is started and
+         *   will process the trigger. false otherwise.
+         */
+        virtual bool timeout();
+    };
+}}
+
+#endif
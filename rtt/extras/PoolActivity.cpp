@@ -0,0 +1,668 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PoolActivity.hpp"
+#include "../os/Thread.hpp"
+#include "../os/Mutex.hpp"
+#include "../os/MutexLock.hpp"
+#include "../os/Condition.hpp"
+#include "../os/Atomic.hpp"
+#include "../os/CAS.hpp"
+#include "../os/Wakeup.hpp"
+#include "../os/TimeService.hpp"
+#include "../Logger.hpp"
+
+#include <boost/weak_ptr.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+
+namespace RTT
+{ namespace extras {
+
+    using namespace base;
+
+    /**
+     * The workers of one scheduler and priority. Each worker owns a
+     * queue of triggered activities, which it executes in FIFO order.
+     * A worker with an empty queue steals the most recently queued activity
+     * of another worker, and sleeps when all queues are empty. Queuing
+     * an activity wakes up at most one sleeping worker.
+     */
+    class PoolActivity::Pool
+    {
+    public:
+        class Worker : public os::Thread
+        {
+        public:
+            Worker(Pool& p, unsigned int i, int scheduler, int priority, unsigned cpu_affinity, const std::string& name)
+                : os::Thread(scheduler, priority, 0.0, cpu_affinity, name),
+                  pool(p), index(i), quit(false), head(0), count(0)
+            {
+                ORO_ATOMIC_SETUP(&sleeping, 0);
+            }
+
+            void loop()
+            {
+                while ( !quit ) {
+                    PoolActivity* a = pool.take(index);
+                    if ( a ) {
+                        if ( a->run(this, index) )
+                            pool.push(a, index);
+                    } else
+                        pool.sleep(*this);
+                }
+            }
+
+            bool breakLoop()
+            {
+                quit = true;
+                wakeup.signal();
+                return true;
+            }
+
+            Pool& pool;
+            const unsigned int index;
+            volatile bool quit;
+            /** Protects the queue of this worker. */
+            os::Mutex lock;
+            /** A ring of queued activities, sized to the number of activities of the pool. */
+            std::vector<PoolActivity*> ring;
+            unsigned int head;
+            unsigned int count;
+            /** 1 from when this worker goes to sleep until it is woken up. */
+            oro_atomic_t sleeping;
+            os::Wakeup wakeup;
+        };
+
+        Pool(int scheduler, int priority, unsigned int workers, const std::vector<unsigned>& cpu_affinities)
+            : mscheduler(scheduler), mpriority(priority), activities(0), capacity(0)
+        {
+            for (unsigned int i = 0; i != workers; ++i) {
+                std::ostringstream name;
+                name << "Pool" << scheduler << "." << priority << "." << i;
+                mworkers.push_back( new Worker(*this, i, scheduler, priority,
+                                               i < cpu_affinities.size() ? cpu_affinities[i] : 0, name.str()) );
+            }
+            // the workers run loop() until they are stopped.
+            for (unsigned int i = 0; i != workers; ++i)
+                mworkers[i]->start();
+        }
+
+        ~Pool()
+        {
+            for (unsigned int i = 0; i != mworkers.size(); ++i)
+                mworkers[i]->stop();
+            for (unsigned int i = 0; i != mworkers.size(); ++i)
+                delete mworkers[i];
+        }
+
+        /**
+         * Makes room for one more activity in the queues of the workers.
+         * The queues grow by doubling, so that they are not reallocated
+         * for each new activity.
+         */
+        void add()
+        {
+            os::MutexLock lock(mlock);
+            ++activities;
+            if ( activities > capacity )
+                resize( std::max(activities, 2 * capacity) );
+        }
+
+        /**
+         * Leaves the room of \a a in the queues of the workers, which must
+         * no longer be triggered. The queues shrink when they are at most
+         * a quarter used.
+         */
+        void detach(PoolActivity* a)
+        {
+            remove(a);
+            os::MutexLock lock(mlock);
+            --activities;
+            if ( 4 * activities <= capacity && capacity > 1 )
+                resize( std::max(2 * activities, 1u) );
+        }
+
+        /**
+         * Removes \a a from the queue it is in.
+         * @return true if it was queued.
+         */
+        bool remove(PoolActivity* a)
+        {
+            for (unsigned int i = 0; i != mworkers.size(); ++i) {
+                Worker& w = *mworkers[i];
+                os::MutexLock wlock(w.lock);
+                for (unsigned int j = 0; j != w.count; ++j) {
+                    if ( w.ring[ (w.head + j) % w.ring.size() ] == a ) {
+                        for (; j + 1 < w.count; ++j)
+                            w.ring[ (w.head + j) % w.ring.size() ] = w.ring[ (w.head + j + 1) % w.ring.size() ];
+                        --w.count;
+                        queued.dec();
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Queues \a a at worker \a index and wakes up a sleeping worker.
+         */
+        void push(PoolActivity* a, unsigned int index)
+        {
+            Worker& w = *mworkers[index];
+            {
+                os::MutexLock wlock(w.lock);
+                // an activity is queued at most once and has room in each queue.
+                assert( w.count < w.ring.size() );
+                w.ring[ (w.head + w.count) % w.ring.size() ] = a;
+                ++w.count;
+            }
+            // A sleeper marks itself sleeping before it checks queued, so
+            // either it sees our activity or we see it sleeping.
+            queued.inc();
+            if ( sleepers.read() > 0 )
+                wakeOne();
+        }
+
+        /**
+         * Takes the oldest activity of worker \a index or steals the
+         * newest one of another worker.
+         */
+        PoolActivity* take(unsigned int index)
+        {
+            if ( queued.read() == 0 )
+                return 0;
+            for (unsigned int i = 0; i != mworkers.size(); ++i) {
+                Worker& w = *mworkers[ (index + i) % mworkers.size() ];
+                os::MutexLock wlock(w.lock);
+                if ( w.count == 0 )
+                    continue;
+                PoolActivity* a;
+                if ( i == 0 ) {
+                    a = w.ring[w.head];
+                    w.head = (w.head + 1) % w.ring.size();
+                } else
+                    a = w.ring[ (w.head + w.count - 1) % w.ring.size() ];
+                --w.count;
+                queued.dec();
+                return a;
+            }
+            return 0;
+        }
+
+        /**
+         * Blocks worker \a w until wakeOne() picks it or it is stopped.
+         * It may return early, after which the worker looks for work again.
+         */
+        void sleep(Worker& w)
+        {
+            sleepers.inc();
+            oro_atomic_set(&w.sleeping, 1);
+            oro_mb();
+            if ( queued.read() == 0 && !w.quit )
+                w.wakeup.wait();
+            oro_atomic_set(&w.sleeping, 0);
+            sleepers.dec();
+        }
+
+        /**
+         * Wakes up one sleeping worker, if any.
+         */
+        void wakeOne()
+        {
+            for (unsigned int i = 0; i != mworkers.size(); ++i) {
+                Worker& w = *mworkers[i];
+                if ( os::CAS(&w.sleeping, 1, 0) ) {
+                    w.wakeup.signal();
+                    return;
+                }
+            }
+        }
+
+        /**
+         * Wakes up stop() calls which wait for an activity to become idle.
+         * Must be called after an activity became idle.
+         */
+        void notifyIdle()
+        {
+            // A waiter increments idle_waiters before it checks the state, so
+            // either it sees the activity idle or we see it waiting.
+            oro_mb();
+            if ( idle_waiters.read() == 0 )
+                return;
+            os::MutexLock lock(mlock);
+            idle_cond.broadcast();
+        }
+
+        /**
+         * Waits until \a a is idle or \a timeout seconds passed.
+         */
+        bool waitIdle(PoolActivity* a, Seconds timeout)
+        {
+            nsecs deadline = os::TimeService::Instance()->getNSecs() + Seconds_to_nsecs(timeout);
+            os::MutexLock lock(mlock);
+            idle_waiters.inc();
+            bool idle = true;
+            while ( oro_atomic_read(&a->mstate) != PoolActivity::Idle ) {
+                if ( !idle_cond.wait_until(mlock, deadline) &&
+                     oro_atomic_read(&a->mstate) != PoolActivity::Idle ) {
+                    idle = false;
+                    break;
+                }
+            }
+            idle_waiters.dec();
+            return idle;
+        }
+
+        /**
+         * Returns the index of the calling worker, or \a def if the
+         * caller is not a worker of this pool.
+         */
+        unsigned int self(unsigned int def) const
+        {
+            for (unsigned int i = 0; i != mworkers.size(); ++i)
+                if ( mworkers[i]->isSelf() )
+                    return i;
+            return def;
+        }
+
+        Seconds stopTimeout() const
+        {
+            return mworkers[0]->getStopTimeout();
+        }
+
+        int getScheduler() const { return mworkers[0]->getScheduler(); }
+        int getPriority() const { return mworkers[0]->getPriority(); }
+        unsigned int size() const { return mworkers.size(); }
+
+        const int mscheduler;
+        const int mpriority;
+    private:
+        /**
+         * Sets the size of the queues of all workers to \a size, which is
+         * at least the number of activities. Call with mlock locked.
+         */
+        void resize(unsigned int size)
+        {
+            for (unsigned int i = 0; i != mworkers.size(); ++i) {
+                Worker& w = *mworkers[i];
+                os::MutexLock wlock(w.lock);
+                assert( w.count <= size );
+                std::vector<PoolActivity*> ring(size, (PoolActivity*)0);
+                for (unsigned int j = 0; j != w.count; ++j)
+                    ring[j] = w.ring[ (w.head + j) % w.ring.size() ];
+                w.ring.swap(ring);
+                w.head = 0;
+            }
+            capacity = size;
+        }
+
+        std::vector<Worker*> mworkers;
+        os::AtomicInt queued;
+        os::AtomicInt sleepers;
+        os::AtomicInt idle_waiters;
+        /** The number of activities of this pool. */
+        unsigned int activities;
+        /** The size of the queues of the workers. */
+        unsigned int capacity;
+        os::Mutex mlock;
+        os::Condition idle_cond;
+    };
+
+    namespace {
+        typedef std::pair<int,int> PoolKey;
+
+        struct PoolConfig {
+            unsigned int workers;
+            std::vector<unsigned> cpu_affinities;
+        };
+
+        os::Mutex& poolsLock() {
+            static os::Mutex lock;
+            return lock;
+        }
+
+        std::map<PoolKey, boost::weak_ptr<PoolActivity::Pool> >& pools() {
+            static std::map<PoolKey, boost::weak_ptr<PoolActivity::Pool> > p;
+            return p;
+        }
+
+        std::map<PoolKey, PoolConfig>& poolConfigs() {
+            static std::map<PoolKey, PoolConfig> c;
+            return c;
+        }
+
+        boost::shared_ptr<PoolActivity::Pool> getPool(int scheduler, int priority) {
+            os::MutexLock lock( poolsLock() );
+            PoolKey key(scheduler, priority);
+            boost::shared_ptr<PoolActivity::Pool> pool = pools()[key].lock();
+            if ( !pool ) {
+                PoolConfig config;
+                if ( poolConfigs().count(key) ) {
+                    config = poolConfigs()[key];
+                } else {
+                    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                    config.workers = cpus > 0 ? cpus : 2;
+                }
+                pool.reset( new PoolActivity::Pool(scheduler, priority, config.workers, config.cpu_affinities) );
+                pools()[key] = pool;
+            }
+            return pool;
+        }
+    }
+
+    PoolActivity::PoolActivity( RunnableInterface* run, const std::string& name )
+        : ActivityInterface(run), mpool( getPool(ORO_SCHED_OTHER, os::LowestPriority) ), mname(name),
+          active(false), mtimeout(false), mtrigger(false), minloop(false), mworker(0), mlast(0)
+    {
+        ORO_ATOMIC_SETUP(&mstate, Idle);
+        std::memset(&mtask, 0, sizeof(mtask));
+        mlast = threadNumber() % mpool->size();
+        mpool->add();
+    }
+
+    PoolActivity::PoolActivity( int scheduler, int priority, RunnableInterface* run, const std::string& name )
+        : ActivityInterface(run), mpool( getPool(scheduler, priority) ), mname(name),
+          active(false), mtimeout(false), mtrigger(false), minloop(false), mworker(0), mlast(0)
+    {
+        ORO_ATOMIC_SETUP(&mstate, Idle);
+        std::memset(&mtask, 0, sizeof(mtask));
+        mlast = threadNumber() % mpool->size();
+        mpool->add();
+    }
+
+    PoolActivity::~PoolActivity()
+    {
+        stop();
+        // a worker may still be executing us if stop() failed.
+        os::ThreadInterface* worker = mworker;
+        if ( !worker || !worker->isSelf() ) {
+            while ( !mpool->waitIdle(this, mpool->stopTimeout()) )
+                log(Warning) << "PoolActivity " << mname << " still waits for its step() to return before it can be destroyed." << endlog();
+        }
+        mpool->detach(this);
+        ORO_ATOMIC_CLEANUP(&mstate);
+    }
+
+    bool PoolActivity::configurePool( int scheduler, int priority, unsigned int workers,
+                                      const std::vector<unsigned>& cpu_affinities )
+    {
+        if ( workers == 0 )
+            return false;
+        os::MutexLock lock( poolsLock() );
+        PoolKey key(scheduler, priority);
+        if ( pools()[key].lock() )
+            return false;
+        PoolConfig& config = poolConfigs()[key];
+        config.workers = workers;
+        config.cpu_affinities = cpu_affinities;
+        return true;
+    }
+
+    unsigned int PoolActivity::getPoolSize() const
+    {
+        return mpool->size();
+    }
+
+    Seconds PoolActivity::getPeriod() const
+    {
+        return 0.0;
+    }
+
+    bool PoolActivity::setPeriod(Seconds s)
+    {
+        return s == 0.0;
+    }
+
+    nsecs PoolActivity::getPeriodNS() const
+    {
+        return 0;
+    }
+
+    unsigned PoolActivity::getCpuAffinity() const
+    {
+        return ~0;
+    }
+
+    bool PoolActivity::setCpuAffinity(unsigned cpu)
+    {
+        return false;
+    }
+
+    os::ThreadInterface* PoolActivity::thread()
+    {
+        return this;
+    }
+
+    bool PoolActivity::start()
+    {
+        if ( active )
+            return false;
+
+        if ( runner && !runner->initialize() )
+            return false;
+
+        active = true;
+        // like Activity, execute loop() once after start.
+        trigger();
+        return true;
+    }
+
+    bool PoolActivity::stop()
+    {
+        if ( !active )
+            return false;
+
+        active = false;
+        if ( mpool->remove(this) )
+            oro_atomic_set(&mstate, Idle);
+
+        os::ThreadInterface* worker = mworker;
+        if ( worker && worker->isSelf() ) {
+            // stopped from within our own step(): it returns after finalize().
+        } else if ( oro_atomic_read(&mstate) != Idle ) {
+            if ( minloop && !runner->breakLoop() ) {
+                log(Warning) << "Failed to stop PoolActivity " << mname << ": breakLoop() returned false." << endlog();
+                active = true;
+                return false;
+            }
+            if ( !mpool->waitIdle(this, mpool->stopTimeout()) ) {
+                log(Error) << "Failed to stop PoolActivity " << mname << ": step() function did not return after " << mpool->stopTimeout() << " second(s)." << endlog();
+                active = true;
+                return false;
+            }
+        }
+
+        if ( runner )
+            runner->finalize();
+        return true;
+    }
+
+    bool PoolActivity::isRunning() const
+    {
+        return active;
+    }
+
+    bool PoolActivity::isPeriodic() const
+    {
+        return false;
+    }
+
+    bool PoolActivity::isActive() const
+    {
+        return active;
+    }
+
+    bool PoolActivity::execute()
+    {
+        return false;
+    }
+
+    bool PoolActivity::trigger()
+    {
+        if ( !active )
+            return false;
+        mtrigger = true;
+        return queue();
+    }
+
+    bool PoolActivity::timeout()
+    {
+        if ( !active )
+            return false;
+        mtimeout = true;
+        return queue();
+    }
+
+    bool PoolActivity::queue()
+    {
+        while ( true ) {
+            int state = oro_atomic_read(&mstate);
+            if ( state == Idle ) {
+                if ( os::CAS(&mstate, Idle, Queued) ) {
+                    mpool->push(this, mpool->self(mlast));
+                    return true;
+                }
+            } else if ( state == Running ) {
+                if ( os::CAS(&mstate, Running, Retriggered) )
+                    return true;
+            } else
+                return true; // will be executed.
+        }
+    }
+
+    bool PoolActivity::run(os::ThreadInterface* worker, unsigned int index)
+    {
+        oro_atomic_set(&mstate, Running);
+        mworker = worker;
+        mlast = index;
+        if ( active && mtimeout ) {
+            mtimeout = false;
+            if ( runner ) {
+                runner->step();
+                runner->work(RunnableInterface::TimeOut);
+            }
+        }
+        // a trigger that was merged with a timeout is executed as well.
+        if ( active && mtrigger ) {
+            mtrigger = false;
+            if ( runner ) {
+                minloop = true;
+                runner->loop();
+                minloop = false;
+                runner->work(RunnableInterface::Trigger);
+            }
+        }
+        mworker = 0;
+
+        if ( !active ) {
+            oro_atomic_set(&mstate, Idle);
+            mpool->notifyIdle();
+            return false;
+        }
+        if ( os::CAS(&mstate, Running, Idle) ) {
+            // stop() may have been called after active was checked.
+            mpool->notifyIdle();
+            return false;
+        }
+        // triggered while running: execute again after the others.
+        oro_atomic_set(&mstate, Queued);
+        return true;
+    }
+
+    const char* PoolActivity::getName() const
+    {
+        return mname.c_str();
+    }
+
+    RTOS_TASK* PoolActivity::getTask()
+    {
+        os::ThreadInterface* worker = mworker;
+        return worker ? worker->getTask() : &mtask;
+    }
+
+    const RTOS_TASK* PoolActivity::getTask() const
+    {
+        os::ThreadInterface* worker = mworker;
+        return worker ? worker->getTask() : &mtask;
+    }
+
+    bool PoolActivity::setScheduler(int sched_type)
+    {
+        return sched_type == mpool->getScheduler();
+    }
+
+    int PoolActivity::getScheduler() const
+    {
+        return mpool->getScheduler();
+    }
+
+    bool PoolActivity::setPriority(int priority)
+    {
+        return priority == mpool->getPriority();
+    }
+
+    int PoolActivity::getPriority() const
+    {
+        return mpool->getPriority();
+    }
+
+    unsigned int PoolActivity::getPid() const
+    {
+        os::ThreadInterface* worker = mworker;
+        return worker ? worker->getPid() : 0;
+    }
+
+    void PoolActivity::setMaxOverrun(int m)
+    {
+    }
+
+    int PoolActivity::getMaxOverrun() const
+    {
+        return -1;
+    }
+
+    void PoolActivity::setWaitPeriodPolicy(int p)
+    {
+    }
+
+    void PoolActivity::yield()
+    {
+        os::ThreadInterface* worker = mworker;
+        if ( worker && worker->isSelf() )
+            worker->yield();
+    }
+
+}}
@@ -0,0 +1,222 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_POOL_ACTIVITY_HPP
+#define ORO_POOL_ACTIVITY_HPP
+
+#include "../base/ActivityInterface.hpp"
+#include "../base/RunnableInterface.hpp"
+#include "../os/ThreadInterface.hpp"
+#include "../os/oro_arch.h"
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <vector>
+
+namespace RTT
+{ namespace extras {
+
+    /**
+     * @brief An activity which executes its runner in a pool of worker
+     * threads, shared by all PoolActivity objects with the same scheduler
+     * and priority.
+     *
+     * This allows many event driven components to share a few threads.
+     * Each worker has a queue of triggered activities, and an idle worker
+     * steals activities from the queues of the other workers. An activity is
+     * executed by at most one worker at a time: triggering it while it is
+     * executed causes it to be executed once more afterwards.
+     *
+     * The number of workers and their CPU affinities are set per pool with
+     * configurePool(), before the first activity of that pool is created.
+     * Since a runner that blocks keeps its worker busy, components which wait
+     * for each other should not share a pool with fewer workers than waiting
+     * components.
+     *
+     * thread() returns this object, which presents itself as the worker that
+     * is executing it.
+     *
+     * \section ExecReact Reactions to execute():
+     * Always returns false.
+     *
+     * \section TrigReact Reactions to trigger():
+     * Queues base::RunnableInterface::loop() and work(Trigger) for execution
+     * by a worker. timeout() queues step() and work(TimeOut).
+     *
+     * @ingroup CoreLibActivities
+     */
+    class RTT_API PoolActivity
+        : public base::ActivityInterface, public os::ThreadInterface
+    {
+    public:
+        class Pool;
+
+        /**
+         * Create an activity which is executed by the pool of the
+         * ORO_SCHED_OTHER scheduler at the lowest priority.
+         * @param run Run this instance.
+         * @param name The name of this activity.
+         */
+        PoolActivity( base::RunnableInterface* run = 0, const std::string& name = "PoolActivity" );
+
+        /**
+         * Create an activity which is executed by the pool of the
+         * given scheduler and priority.
+         * @param scheduler ORO_SCHED_RT or ORO_SCHED_OTHER.
+         * @param priority The priority of the workers of the pool.
+         * @param run Run this instance.
+         * @param name The name of this activity.
+         */
+        PoolActivity( int scheduler, int priority, base::RunnableInterface* run = 0, const std::string& name = "PoolActivity" );
+
+        /**
+         * Stops this activity and leaves the pool. The workers of the
+         * pool are stopped with its last activity.
+         */
+        ~PoolActivity();
+
+        /**
+         * Sets the number of workers and their CPU affinities of the pool
+         * of the given scheduler and priority.
+         * @param workers The number of worker threads, at least one.
+         * @param cpu_affinities The CPU affinity mask of each worker. Workers
+         * without a mask in this list may run on any CPU.
+         * @return false if \a workers is zero or if an activity of this pool exists already.
+         */
+        static bool configurePool( int scheduler, int priority, unsigned int workers,
+                                   const std::vector<unsigned>& cpu_affinities = std::vector<unsigned>() );
+
+        /**
+         * Returns the number of workers of the pool of this activity.
+         */
+        unsigned int getPoolSize() const;
+
+        Seconds getPeriod() const;
+
+        bool setPeriod(Seconds s);
+
+        nsecs getPeriodNS() const;
+
+        unsigned getCpuAffinity() const;
+
+        bool setCpuAffinity(unsigned cpu);
+
+        os::ThreadInterface* thread();
+
+        bool start();
+
+        bool stop();
+
+        bool isRunning() const;
+
+        bool isPeriodic() const;
+
+        bool isActive() const;
+
+        bool execute();
+
+        bool trigger();
+
+        bool timeout();
+
+        const char* getName() const;
+
+        /**
+         * Returns the task of the worker which is executing this activity,
+         * or a task which is no thread when it is not being executed.
+         */
+        RTOS_TASK* getTask();
+
+        const RTOS_TASK* getTask() const;
+
+        /**
+         * The scheduler is the one of the pool and can not be changed.
+         */
+        bool setScheduler(int sched_type);
+
+        int getScheduler() const;
+
+        /**
+         * The priority is the one of the pool and can not be changed.
+         */
+        bool setPriority(int priority);
+
+        int getPriority() const;
+
+        unsigned int getPid() const;
+
+        void setMaxOverrun(int m);
+
+        int getMaxOverrun() const;
+
+        void setWaitPeriodPolicy(int p);
+
+        void yield();
+
+    private:
+        friend class Pool;
+
+        /**
+         * Executes the runner once in the calling \a worker with
+         * the given \a index in the pool.
+         * Returns true if the activity must be queued again.
+         */
+        bool run(os::ThreadInterface* worker, unsigned int index);
+        /**
+         * Queues this activity for execution, unless it is queued or
+         * executed already.
+         */
+        bool queue();
+
+        static const int Idle = 0;
+        static const int Queued = 1;
+        static const int Running = 2;
+        static const int Retriggered = 3;
+
+        boost::shared_ptr<Pool> mpool;
+        std::string mname;
+        /** Idle, Queued, Running or Retriggered. */
+        oro_atomic_t mstate;
+        volatile bool active;
+        volatile bool mtimeout;
+        /** True if loop() must be executed. */
+        volatile bool mtrigger;
+        /** True while the runner's loop() is executed. */
+        volatile bool minloop;
+        /** The worker which is executing this activity. */
+        os::ThreadInterface* volatile mworker;
+        /** The index of the worker which executed this activity last. */
+        volatile unsigned int mlast;
+        /** Returned by getTask() when no worker executes this activity. */
+        RTOS_TASK mtask;
+    };
+
+}}
+
+#endif
@@ -41,9 +41,12 @@
 
 namespace RTT {
     namespace extras {
+        class DataFlowActivity;
+        class EPollFileDescriptorActivity;
         class FileDescriptorActivity;
         class IRQActivity;
         class PeriodicActivity;
+        class PoolActivity;
         class SequentialActivity;
         class SimulationActivity;
         class SimulationThread;
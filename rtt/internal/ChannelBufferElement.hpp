@@ -41,7 +41,10 @@
 
 #include "../base/ChannelElement.hpp"
 #include "../base/BufferInterface.hpp"
+#include "../base/ChannelStatistics.hpp"
 #include "../ConnPolicy.hpp"
+#include "../os/oro_arch.h"
+#include "../os/CAS.hpp"
 
 namespace RTT { namespace internal {
 
@@ -62,6 +65,10 @@ namespace RTT { namespace internal {
         typename base::BufferInterface<T>::shared_ptr buffer;
         typename base::ChannelElement<T>::value_t *last_sample_p;
         const ConnPolicy policy;
+        /** The copy which is loaned when the buffer does not support loans. */
+        typename base::ChannelElement<T>::value_t loaned_copy;
+        /** 1 while loaned_copy is loaned. */
+        oro_atomic_t copy_loaned;
 
     public:
         typedef typename base::ChannelElement<T>::value_t value_t;
@@ -69,7 +76,7 @@ namespace RTT { namespace internal {
         typedef typename base::ChannelElement<T>::reference_t reference_t;
 
         ChannelBufferElement(typename base::BufferInterface<T>::shared_ptr buffer, const ConnPolicy& policy = ConnPolicy())
-            : buffer(buffer), last_sample_p(0), policy(policy) {}
+            : buffer(buffer), last_sample_p(0), policy(policy), loaned_copy() { ORO_ATOMIC_SETUP(&copy_loaned, 0); }
             
         virtual ~ChannelBufferElement()
         {
@@ -98,10 +105,35 @@ namespace RTT { namespace internal {
          */
         virtual WriteStatus write(param_t sample)
         {
-            if (!buffer->Push(sample)) return WriteFailure;
+            if (this->statistics) this->statistics->writing();
+            if (!buffer->Push(sample)) {
+                if (this->statistics) this->statistics->dropped();
+                return WriteFailure;
+            }
+            if (this->statistics) this->statistics->written();
             return this->signal() ? WriteSuccess : NotConnected;
         }
 
+        /** Appends a batch of samples at the end of the FIFO and signals
+         * the reader once.
+         *
+         * @return WriteFailure if not all samples fitted in the FIFO.
+         */
+        virtual WriteStatus writeAll(const std::vector<value_t>& samples)
+        {
+            if (samples.empty()) return WriteSuccess;
+            typedef typename base::BufferInterface<T>::size_type size_type;
+            if (this->statistics) this->statistics->writing(samples.size());
+            size_type written = buffer->Push(samples);
+            if (this->statistics) {
+                this->statistics->written(written);
+                this->statistics->dropped(samples.size() - written);
+            }
+            if (written == 0) return WriteFailure;
+            if (!this->signal()) return NotConnected;
+            return (written == size_type(samples.size())) ? WriteSuccess : WriteFailure;
+        }
+
         /** Pops and returns the first element of the FIFO
          *
          * @return false if the FIFO was empty, and true otherwise
@@ -123,16 +155,110 @@ namespace RTT { namespace internal {
                 else
                     buffer->Release(new_sample_p);
 
+                if (this->statistics) this->statistics->read(NewData);
                 return NewData;
             }
             if (last_sample_p) {
                 if(copy_old_data)
                     sample = *(last_sample_p);
+                if (this->statistics) this->statistics->read(OldData);
                 return OldData;
             }
+            if (this->statistics) this->statistics->read(NoData);
+            return NoData;
+        }
+
+        /** Pops all elements of the FIFO and appends them to \a samples.
+         * Like read loans, the popped samples are consumed and the last one
+         * will not be returned as OldData by read().
+         */
+        virtual FlowStatus readAll(std::vector<value_t>& samples)
+        {
+            if(last_sample_p)
+                buffer->Release(last_sample_p);
+            last_sample_p = 0;
+
+            typename std::vector<value_t>::size_type count = samples.size();
+            if (count == 0) {
+                buffer->Pop(samples);
+            } else {
+                value_t *sample_p;
+                while ( (sample_p = buffer->PopWithoutRelease()) ) {
+                    samples.push_back(*sample_p);
+                    buffer->Release(sample_p);
+                }
+            }
+            FlowStatus result = (samples.size() > count) ? NewData : NoData;
+            if (this->statistics) this->statistics->read(result, samples.size() - count);
+            return result;
+        }
+
+        virtual value_t* loan(typename base::ChannelElement<T>::shared_ptr& owner)
+        {
+            value_t *sample = buffer->Loan();
+            if (sample)
+                owner = this;
+            return sample;
+        }
+
+        virtual WriteStatus commit(value_t*& sample, base::ChannelElement<T>* owner)
+        {
+            if (owner != this) return WriteFailure;
+            value_t *item = sample;
+            sample = 0;
+            if (this->statistics) this->statistics->writing();
+            if (!buffer->Commit(item)) {
+                if (this->statistics) this->statistics->dropped();
+                return WriteFailure;
+            }
+            if (this->statistics) this->statistics->written();
+            return this->signal() ? WriteSuccess : NotConnected;
+        }
+
+        virtual void discard(value_t* sample)
+        {
+            buffer->Release(sample);
+        }
+
+        /** Pops the first element of the FIFO without copying it.
+         * The loaned sample is consumed and will not be returned as OldData.
+         * Only lock-free buffers support loans, as the other buffer implementations
+         * recycle the popped element on the next read. These pop the element into
+         * a copy owned by this element, which is loaned to one reader at a time.
+         * NoData is returned while another reader holds it.
+         */
+        virtual FlowStatus readLoan(value_t*& sample, typename base::ChannelElement<T>::shared_ptr& owner)
+        {
+            sample = 0;
+            if (policy.lock_policy != ConnPolicy::LOCK_FREE) {
+                if ( os::CAS(&copy_loaned, 0, 1) ) {
+                    if ( buffer->Pop(loaned_copy) == NewData )
+                        sample = &loaned_copy;
+                    else
+                        oro_atomic_set(&copy_loaned, 0);
+                }
+            } else
+                sample = buffer->PopWithoutRelease();
+            if ( sample ) {
+                if(last_sample_p)
+                    buffer->Release(last_sample_p);
+                last_sample_p = 0;
+                owner = this;
+                if (this->statistics) this->statistics->read(NewData);
+                return NewData;
+            }
+            if (this->statistics) this->statistics->read(NoData);
             return NoData;
         }
 
+        virtual void release(value_t* sample)
+        {
+            if (sample == &loaned_copy)
+                oro_atomic_set(&copy_loaned, 0);
+            else
+                buffer->Release(sample);
+        }
+
         /** Removes all elements in the FIFO. After a call to clear(), read()
          * will always return false (provided write() has not been called in the
          * meantime).
@@ -143,6 +269,7 @@ namespace RTT { namespace internal {
                 buffer->Release(last_sample_p);
             last_sample_p = 0;
             buffer->clear();
+            if (this->statistics) this->statistics->cleared();
             base::ChannelElement<T>::clear();
         }
 
@@ -168,6 +295,12 @@ namespace RTT { namespace internal {
         {
             return "ChannelBufferElement";
         }
+
+    protected:
+        virtual base::ChannelStatistics* createStatistics() const
+        {
+            return new base::ChannelStatistics(policy);
+        }
     };
 }}
 
@@ -41,7 +41,10 @@
 
 #include "../base/ChannelElement.hpp"
 #include "../base/DataObjectInterface.hpp"
+#include "../base/ChannelStatistics.hpp"
 #include "../ConnPolicy.hpp"
+#include "../os/oro_arch.h"
+#include "../os/CAS.hpp"
 
 namespace RTT { namespace internal {
 
@@ -52,6 +55,10 @@ namespace RTT { namespace internal {
     {
         typename base::DataObjectInterface<T>::shared_ptr data;
         const ConnPolicy policy;
+        /** The copy which is loaned when the data object does not support loans. */
+        typename base::ChannelElement<T>::value_t loaned_copy;
+        /** 1 while loaned_copy is loaned. */
+        oro_atomic_t copy_loaned;
 
     public:
         typedef typename base::ChannelElement<T>::value_t value_t;
@@ -59,23 +66,113 @@ namespace RTT { namespace internal {
         typedef typename base::ChannelElement<T>::reference_t reference_t;
 
         ChannelDataElement(typename base::DataObjectInterface<T>::shared_ptr sample, const ConnPolicy& policy = ConnPolicy())
-            : data(sample), policy(policy) {}
+            : data(sample), policy(policy), loaned_copy() { ORO_ATOMIC_SETUP(&copy_loaned, 0); }
 
         /** Update the data sample stored in this element.
          * It always returns true. */
         virtual WriteStatus write(param_t sample)
         {
-            if (!data->Set(sample)) return WriteFailure;
+            if (this->statistics) this->statistics->writing();
+            if (!data->Set(sample)) {
+                if (this->statistics) this->statistics->dropped();
+                return WriteFailure;
+            }
+            if (this->statistics) this->statistics->written();
             return this->signal() ? WriteSuccess : NotConnected;
         }
 
+        /** Only the last sample of a batch is kept.
+         */
+        virtual WriteStatus writeAll(const std::vector<value_t>& samples)
+        {
+            if (samples.empty()) return WriteSuccess;
+            return write(samples.back());
+        }
+
         /** Reads the last sample given to write()
          *
          * @return false if no sample has ever been written, true otherwise
          */
         virtual FlowStatus read(reference_t sample, bool copy_old_data)
         {
-            return data->Get(sample, copy_old_data);
+            FlowStatus result = data->Get(sample, copy_old_data);
+            if (this->statistics) this->statistics->read(result);
+            return result;
+        }
+
+        /** Appends the last sample given to write() if it has not been read yet.
+         */
+        virtual FlowStatus readAll(std::vector<value_t>& samples)
+        {
+            value_t sample = value_t();
+            FlowStatus result = data->Get(sample, false);
+            if (this->statistics) this->statistics->read(result);
+            if (result != NewData)
+                return NoData;
+            samples.push_back(sample);
+            return NewData;
+        }
+
+        virtual value_t* loan(typename base::ChannelElement<T>::shared_ptr& owner)
+        {
+            value_t *sample = data->Loan();
+            if (sample)
+                owner = this;
+            return sample;
+        }
+
+        virtual WriteStatus commit(value_t*& sample, base::ChannelElement<T>* owner)
+        {
+            if (owner != this) return WriteFailure;
+            value_t *item = sample;
+            sample = 0;
+            if (this->statistics) this->statistics->writing();
+            if (!data->Commit(item)) {
+                if (this->statistics) this->statistics->dropped();
+                return WriteFailure;
+            }
+            if (this->statistics) this->statistics->written();
+            return this->signal() ? WriteSuccess : NotConnected;
+        }
+
+        virtual void discard(value_t* sample)
+        {
+            data->Discard(sample);
+        }
+
+        /** Reads the last sample given to write() without copying it.
+         * Only lock-free data objects support loans. Otherwise, the sample is
+         * copied into a copy owned by this element, which is loaned to one
+         * reader at a time. NoData is returned while another reader holds it.
+         */
+        virtual FlowStatus readLoan(value_t*& sample, typename base::ChannelElement<T>::shared_ptr& owner)
+        {
+            FlowStatus result;
+            if (policy.lock_policy == ConnPolicy::LOCK_FREE) {
+                result = data->GetWithoutRelease(sample);
+            } else {
+                sample = 0;
+                result = NoData;
+                if ( os::CAS(&copy_loaned, 0, 1) ) {
+                    result = data->Get(loaned_copy, true);
+                    if (result != NoData)
+                        sample = &loaned_copy;
+                    else
+                        oro_atomic_set(&copy_loaned, 0);
+                }
+            }
+            if (sample)
+                owner = this;
+            if (this->statistics) this->statistics->read(result);
+            return result;
+        }
+
+        virtual void release(value_t* sample)
+        {
+            if (sample == &loaned_copy)
+                oro_atomic_set(&copy_loaned, 0);
+            else
+                data->Release(sample);
         }
 
         /** Resets the stored sample. After clear() has been called, read()
@@ -84,6 +181,7 @@ namespace RTT { namespace internal {
         virtual void clear()
         {
             data->clear();
+            if (this->statistics) this->statistics->cleared();
             base::ChannelElement<T>::clear();
         }
 
@@ -109,6 +207,12 @@ namespace RTT { namespace internal {
         {
             return "ChannelDataElement";
         };
+
+    protected:
+        virtual base::ChannelStatistics* createStatistics() const
+        {
+            return new base::ChannelStatistics(policy);
+        }
     };
 }}
 
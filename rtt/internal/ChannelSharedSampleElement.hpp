@@ -0,0 +1,357 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_CHANNEL_SHARED_SAMPLE_ELEMENT_HPP
+#define ORO_CHANNEL_SHARED_SAMPLE_ELEMENT_HPP
+
+#include "../base/ChannelElement.hpp"
+#include "../base/DataObjectInterface.hpp"
+#include "../base/BufferInterface.hpp"
+#include "../base/ChannelStatistics.hpp"
+#include "../ConnPolicy.hpp"
+#include "ChannelBufferElement.hpp"
+#include "SharedSample.hpp"
+
+namespace RTT { namespace internal {
+
+    /** A connection element that stores a reference to a single shared
+     * data sample. It is used instead of a ChannelDataElement for
+     * connections with ConnPolicy::shared_samples set.
+     */
+    template<typename T>
+    class ChannelSharedDataElement : public base::ChannelElement<T>
+    {
+        typename base::DataObjectInterface< SharedSample<T> >::shared_ptr data;
+        typename SharedSamplePool<T>::shared_ptr pool;
+        const ConnPolicy policy;
+
+    public:
+        typedef typename base::ChannelElement<T>::value_t value_t;
+        typedef typename base::ChannelElement<T>::param_t param_t;
+        typedef typename base::ChannelElement<T>::reference_t reference_t;
+
+        ChannelSharedDataElement(typename base::DataObjectInterface< SharedSample<T> >::shared_ptr data, const ConnPolicy& policy = ConnPolicy())
+            : data(data), pool(new SharedSamplePool<T>()), policy(policy)
+        {
+            pool->reserve( SharedSamplePool<T>::capacityFor(policy) );
+        }
+
+        /** Copies the sample into the private pool of this element
+         * and stores a reference to it.
+         */
+        virtual WriteStatus write(param_t sample)
+        {
+            SharedSample<T> shared = pool->allocate(sample);
+            if (shared.empty()) {
+                if (this->statistics) this->statistics->dropped();
+                return WriteFailure;
+            }
+            return writeShared(shared);
+        }
+
+        /** Stores a reference to \a sample without copying it.
+         */
+        virtual WriteStatus writeShared(const SharedSample<T>& sample)
+        {
+            if (this->statistics) this->statistics->writing();
+            if (!data->Set(sample)) {
+                if (this->statistics) this->statistics->dropped();
+                return WriteFailure;
+            }
+            if (this->statistics) this->statistics->written();
+            return this->signal() ? WriteSuccess : NotConnected;
+        }
+
+        /** Only the last sample of a batch is kept.
+         */
+        virtual WriteStatus writeAll(const std::vector<value_t>& samples)
+        {
+            if (samples.empty()) return WriteSuccess;
+            return write(samples.back());
+        }
+
+        virtual FlowStatus read(reference_t sample, bool copy_old_data)
+        {
+            SharedSample<T> shared;
+            FlowStatus result = data->Get(shared, copy_old_data);
+            if (result != NoData && !shared.empty())
+                sample = *shared;
+            if (this->statistics) this->statistics->read(result);
+            return result;
+        }
+
+        virtual FlowStatus readAll(std::vector<value_t>& samples)
+        {
+            SharedSample<T> shared;
+            FlowStatus result = data->Get(shared, false);
+            if (this->statistics) this->statistics->read(result);
+            if (result != NewData)
+                return NoData;
+            samples.push_back(*shared);
+            return NewData;
+        }
+
+        /** Loans the shared sample itself. The reference is kept
+         * until the sample is released.
+         */
+        virtual FlowStatus readLoan(value_t*& sample, typename base::ChannelElement<T>::shared_ptr& owner)
+        {
+            SharedSample<T> shared;
+            FlowStatus result = data->Get(shared, true);
+            sample = shared.release();
+            if (sample)
+                owner = this;
+            else
+                result = NoData;
+            if (this->statistics) this->statistics->read(result);
+            return result;
+        }
+
+        virtual void release(value_t* sample)
+        {
+            SharedSample<T>::adopt(sample);
+        }
+
+        /** Shared samples are immutable, writers can not borrow them.
+         */
+        virtual value_t* loan(typename base::ChannelElement<T>::shared_ptr& owner)
+        {
+            return 0;
+        }
+
+        virtual void clear()
+        {
+            data->clear();
+            if (this->statistics) this->statistics->cleared();
+            base::ChannelElement<T>::clear();
+        }
+
+        /** The storage only holds references, \a sample initializes the
+         * samples of the private pool used by write().
+         */
+        virtual WriteStatus data_sample(param_t sample, bool reset = true)
+        {
+            if (!data->data_sample(SharedSample<T>(), reset)) return WriteFailure;
+            pool->data_sample(sample);
+            return base::ChannelElement<T>::data_sample(sample, reset);
+        }
+
+        virtual value_t data_sample()
+        {
+            SharedSample<T> shared = data->Get();
+            return shared.empty() ? value_t() : *shared;
+        }
+
+        virtual const ConnPolicy* getConnPolicy() const
+        {
+            return &policy;
+        }
+
+        virtual std::string getElementName() const
+        {
+            return "ChannelSharedDataElement";
+        }
+
+    protected:
+        virtual base::ChannelStatistics* createStatistics() const
+        {
+            return new base::ChannelStatistics(policy);
+        }
+    };
+
+    /** A connection element that stores references to a fixed number of
+     * shared data samples. It is used instead of a ChannelBufferElement for
+     * connections with ConnPolicy::shared_samples set.
+     */
+    template<typename T>
+    class ChannelSharedBufferElement : public base::ChannelElement<T>, public ChannelBufferElementBase
+    {
+        typename base::BufferInterface< SharedSample<T> >::shared_ptr buffer;
+        typename SharedSamplePool<T>::shared_ptr pool;
+        SharedSample<T> last_sample;
+        const ConnPolicy policy;
+
+    public:
+        typedef typename base::ChannelElement<T>::value_t value_t;
+        typedef typename base::ChannelElement<T>::param_t param_t;
+        typedef typename base::ChannelElement<T>::reference_t reference_t;
+
+        ChannelSharedBufferElement(typename base::BufferInterface< SharedSample<T> >::shared_ptr buffer, const ConnPolicy& policy = ConnPolicy())
+            : buffer(buffer), pool(new SharedSamplePool<T>()), policy(policy)
+        {
+            pool->reserve( SharedSamplePool<T>::capacityFor(policy) );
+        }
+
+        virtual size_t getBufferSize() const
+        {
+            return buffer->capacity();
+        }
+
+        virtual size_t getBufferFillSize() const
+        {
+            return buffer->size();
+        }
+
+        virtual size_t getNumDroppedSamples() const
+        {
+            return buffer->dropped();
+        }
+
+        /** Copies the sample into the private pool of this element
+         * and appends a reference to it at the end of the FIFO.
+         */
+        virtual WriteStatus write(param_t sample)
+        {
+            SharedSample<T> shared = pool->allocate(sample);
+            if (shared.empty()) {
+                if (this->statistics) this->statistics->dropped();
+                return WriteFailure;
+            }
+            return writeShared(shared);
+        }
+
+        /** Appends a reference to \a sample at the end of the FIFO without copying it.
+         */
+        virtual WriteStatus writeShared(const SharedSample<T>& sample)
+        {
+            if (this->statistics) this->statistics->writing();
+            if (!buffer->Push(sample)) {
+                if (this->statistics) this->statistics->dropped();
+                return WriteFailure;
+            }
+            if (this->statistics) this->statistics->written();
+            return this->signal() ? WriteSuccess : NotConnected;
+        }
+
+        virtual FlowStatus read(reference_t sample, bool copy_old_data)
+        {
+            SharedSample<T> shared;
+            if (buffer->Pop(shared) == NewData) {
+                sample = *shared;
+                // As in ChannelBufferElement, buffers that are read by multiple readers never return OldData.
+                if (policy.buffer_policy != PerOutputPort && policy.buffer_policy != Shared)
+                    last_sample = shared;
+                if (this->statistics) this->statistics->read(NewData);
+                return NewData;
+            }
+            if (!last_sample.empty()) {
+                if (copy_old_data)
+                    sample = *last_sample;
+                if (this->statistics) this->statistics->read(OldData);
+                return OldData;
+            }
+            if (this->statistics) this->statistics->read(NoData);
+            return NoData;
+        }
+
+        virtual FlowStatus readAll(std::vector<value_t>& samples)
+        {
+            last_sample.reset();
+            typename std::vector<value_t>::size_type count = samples.size();
+            SharedSample<T> shared;
+            while (buffer->Pop(shared) == NewData)
+                samples.push_back(*shared);
+            FlowStatus result = (samples.size() > count) ? NewData : NoData;
+            if (this->statistics) this->statistics->read(result, samples.size() - count);
+            return result;
+        }
+
+        /** Pops the first reference of the FIFO and loans the shared sample itself.
+         * The loaned sample is consumed and will not be returned as OldData.
+         */
+        virtual FlowStatus readLoan(value_t*& sample, typename base::ChannelElement<T>::shared_ptr& owner)
+        {
+            SharedSample<T> shared;
+            sample = 0;
+            if (buffer->Pop(shared) == NewData) {
+                last_sample.reset();
+                sample = shared.release();
+                owner = this;
+                if (this->statistics) this->statistics->read(NewData);
+                return NewData;
+            }
+            if (this->statistics) this->statistics->read(NoData);
+            return NoData;
+        }
+
+        virtual void release(value_t* sample)
+        {
+            SharedSample<T>::adopt(sample);
+        }
+
+        /** Shared samples are immutable, writers can not borrow them.
+         */
+        virtual value_t* loan(typename base::ChannelElement<T>::shared_ptr& owner)
+        {
+            return 0;
+        }
+
+        virtual void clear()
+        {
+            last_sample.reset();
+            buffer->clear();
+            if (this->statistics) this->statistics->cleared();
+            base::ChannelElement<T>::clear();
+        }
+
+        /** The storage only holds references, \a sample initializes the
+         * samples of the private pool used by write().
+         */
+        virtual WriteStatus data_sample(param_t sample, bool reset = true)
+        {
+            if (!buffer->data_sample(SharedSample<T>(), reset)) return WriteFailure;
+            pool->data_sample(sample);
+            return base::ChannelElement<T>::data_sample(sample, reset);
+        }
+
+        virtual value_t data_sample()
+        {
+            return last_sample.empty() ? value_t() : *last_sample;
+        }
+
+        virtual const ConnPolicy* getConnPolicy() const
+        {
+            return &policy;
+        }
+
+        virtual std::string getElementName() const
+        {
+            return "ChannelSharedBufferElement";
+        }
+
+    protected:
+        virtual base::ChannelStatistics* createStatistics() const
+        {
+            return new base::ChannelStatistics(policy);
+        }
+    };
+}}
+
+#endif
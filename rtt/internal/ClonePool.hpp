@@ -0,0 +1,133 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_CLONE_POOL_HPP
+#define ORO_CLONE_POOL_HPP
+
+#include "../os/oro_arch.h"
+#include "../os/CAS.hpp"
+#include "../os/oro_allocator.hpp"
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <vector>
+
+namespace RTT
+{
+    namespace internal
+    {
+        /**
+         * A fixed number of pre-allocated copies of an object of type \a T,
+         * which are handed out as shared pointers and reused once all
+         * references to them are gone. Used by LocalOperationCaller to send
+         * without allocating memory.
+         *
+         * A copy of a pool is empty, such that the objects in the pool, which
+         * may contain a pool themselves, do not refer back to it.
+         */
+        template<class T>
+        class ClonePool
+        {
+            struct Slot
+            {
+                Slot(const T& prototype) : object(prototype) { ORO_ATOMIC_SETUP(&claiming, 0); }
+                T object;
+                /** 1 while allocate() hands out object. */
+                oro_atomic_t claiming;
+            };
+            typedef boost::shared_ptr<Slot> SlotPtr;
+
+            /**
+             * One pointer per slot, which is created with its control block in
+             * reserve(). A slot is unused when the pool holds its only reference.
+             */
+            std::vector<SlotPtr> slots;
+        public:
+            typedef boost::shared_ptr<T> shared_ptr;
+
+            ClonePool() {}
+            ClonePool(const ClonePool&) {}
+            ClonePool& operator=(const ClonePool&) { return *this; }
+
+            /**
+             * Replaces the objects of the pool by \a size copies of \a prototype.
+             * Objects that are still in use are released when their last reference is gone.
+             * Must not be called concurrently with allocate().
+             * @nrt
+             */
+            void reserve(const T& prototype, unsigned int size)
+            {
+                std::vector<SlotPtr> next;
+                next.reserve(size);
+                for (unsigned int i = 0; i != size; ++i)
+                    next.push_back( boost::allocate_shared<Slot>(os::rt_allocator<Slot>(), prototype) );
+                slots.swap(next);
+            }
+
+            /**
+             * Returns the number of objects in the pool, or zero if the pool is not used.
+             */
+            unsigned int capacity() const { return slots.size(); }
+
+            /**
+             * Returns an unused object of the pool, after \a prototype has been assigned to it.
+             * The returned pointer shares the control block of the slot, so no memory is allocated.
+             * If the assignment throws, the object is returned to the pool.
+             * @return a null pointer if all objects are in use.
+             * @rt
+             */
+            shared_ptr allocate(const T& prototype)
+            {
+                for (typename std::vector<SlotPtr>::iterator it = slots.begin(); it != slots.end(); ++it) {
+                    if ( it->use_count() != 1 || !os::CAS(&(*it)->claiming, 0, 1) )
+                        continue;
+                    // another allocate() may have handed out the slot before we claimed it.
+                    if ( it->use_count() != 1 ) {
+                        oro_atomic_set(&(*it)->claiming, 0);
+                        continue;
+                    }
+                    // orders the accesses to object after those of its last user.
+                    oro_mb();
+                    try {
+                        (*it)->object = prototype;
+                    } catch (...) {
+                        oro_atomic_set(&(*it)->claiming, 0);
+                        throw;
+                    }
+                    shared_ptr result( *it, &(*it)->object );
+                    oro_atomic_set(&(*it)->claiming, 0);
+                    return result;
+                }
+                return shared_ptr();
+            }
+        };
+    }
+}
+
+#endif
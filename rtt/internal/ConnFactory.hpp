@@ -52,6 +52,7 @@
 
 #include "../base/DataObject.hpp"
 #include "../base/DataObjectUnSync.hpp"
+#include "../base/DataObjectSeqLock.hpp"
 #include "../base/Buffer.hpp"
 #include "../base/BufferUnSync.hpp"
 #include "../Logger.hpp"
@@ -157,51 +158,121 @@ namespace RTT
         template<typename T>
         static base::ChannelElement<T>* buildDataStorage(ConnPolicy const& policy, const T& initial_value = T())
         {
-            if (policy.type == ConnPolicy::DATA)
+            // Connections that share samples store references to a copy owned by a SharedSamplePool
+            if (policy.shared_samples && policy.buffer_policy == PerConnection)
             {
-                typename base::DataObjectInterface<T>::shared_ptr data_object;
-                switch (policy.lock_policy)
+                if (policy.type == ConnPolicy::DATA)
                 {
-#ifndef OROBLD_OS_NO_ASM
-                case ConnPolicy::LOCK_FREE:
-                    data_object.reset( new base::DataObjectLockFree<T>(initial_value, policy) );
-                    break;
-#else
-                case ConnPolicy::LOCK_FREE:
-                    RTT::log(Warning) << "lock free connection policy is unavailable on this system, defaulting to LOCKED" << RTT::endlog();
-#endif
-                case ConnPolicy::LOCKED:
-                    data_object.reset( new base::DataObjectLocked<T>(initial_value) );
-                    break;
-                case ConnPolicy::UNSYNC:
-                    data_object.reset( new base::DataObjectUnSync<T>(initial_value) );
-                    break;
+                    typename base::DataObjectInterface< SharedSample<T> >::shared_ptr data_object = buildDataObject< SharedSample<T> >(policy, SharedSample<T>());
+                    if (!data_object) return NULL;
+                    return new ChannelSharedDataElement<T>(data_object, policy);
                 }
+                else if (policy.type == ConnPolicy::BUFFER || policy.type == ConnPolicy::CIRCULAR_BUFFER)
+                {
+                    typename base::BufferInterface< SharedSample<T> >::shared_ptr buffer_object = buildBufferObject< SharedSample<T> >(policy, SharedSample<T>());
+                    if (!buffer_object) return NULL;
+                    return new ChannelSharedBufferElement<T>(buffer_object, policy);
+                }
+                return NULL;
+            }
+
+            if (policy.type == ConnPolicy::DATA)
+            {
+                typename base::DataObjectInterface<T>::shared_ptr data_object = buildDataObject<T>(policy, initial_value);
+                if (!data_object) return NULL;
                 return new ChannelDataElement<T>(data_object, policy);
             }
             else if (policy.type == ConnPolicy::BUFFER || policy.type == ConnPolicy::CIRCULAR_BUFFER)
             {
-                typename base::BufferInterface<T>::shared_ptr buffer_object;
-                switch (policy.lock_policy)
-                {
+                typename base::BufferInterface<T>::shared_ptr buffer_object = buildBufferObject<T>(policy, initial_value);
+                if (!buffer_object) return NULL;
+                return new ChannelBufferElement<T>(buffer_object, policy);
+            }
+            return NULL;
+        }
+
+        /** Creates the data object of a DATA connection for samples of type \a T,
+         * based on the lock policy of \a policy.
+         */
+        template<typename T>
+        static typename base::DataObjectInterface<T>::shared_ptr buildDataObject(ConnPolicy const& policy, const T& initial_value)
+        {
+            typename base::DataObjectInterface<T>::shared_ptr data_object;
+            switch (policy.lock_policy)
+            {
 #ifndef OROBLD_OS_NO_ASM
-                case ConnPolicy::LOCK_FREE:
-                    buffer_object.reset(new base::BufferLockFree<T>(policy.size, initial_value, policy));
-                    break;
+            case ConnPolicy::LOCK_FREE:
+                data_object.reset( buildSeqLockDataObject<T>(policy, initial_value, base::is_seqlock_copyable<T>()) );
+                if (!data_object)
+                    data_object.reset( new base::DataObjectLockFree<T>(initial_value, policy) );
+                break;
 #else
-                case ConnPolicy::LOCK_FREE:
-                    RTT::log(Warning) << "lock free connection policy is unavailable on this system, defaulting to LOCKED" << RTT::endlog();
+            case ConnPolicy::LOCK_FREE:
+                RTT::log(Warning) << "lock free connection policy is unavailable on this system, defaulting to LOCKED" << RTT::endlog();
 #endif
-                case ConnPolicy::LOCKED:
-                    buffer_object.reset(new base::BufferLocked<T>(policy.size, initial_value, policy));
-                    break;
-                case ConnPolicy::UNSYNC:
-                    buffer_object.reset(new base::BufferUnSync<T>(policy.size, initial_value, policy));
-                    break;
+            case ConnPolicy::LOCKED:
+                data_object.reset( new base::DataObjectLocked<T>(initial_value) );
+                break;
+            case ConnPolicy::UNSYNC:
+                data_object.reset( new base::DataObjectUnSync<T>(initial_value) );
+                break;
+            }
+            return data_object;
+        }
+
+        /** Creates a sequence lock data object if \a policy selects it for samples of type \a T,
+         * or returns null.
+         */
+        template<typename T>
+        static base::DataObjectInterface<T>* buildSeqLockDataObject(ConnPolicy const& policy, const T& initial_value, boost::true_type)
+        {
+            if (policy.seqlock == ConnPolicy::SEQLOCK_NEVER ||
+                (policy.seqlock == ConnPolicy::SEQLOCK_AUTO && sizeof(T) > ORONUM_DATAOBJECT_SEQLOCK_MAX_SIZE))
+                return 0;
+            return new base::DataObjectSeqLock<T>(initial_value, policy);
+        }
+
+        template<typename T>
+        static base::DataObjectInterface<T>* buildSeqLockDataObject(ConnPolicy const& policy, const T&, boost::false_type)
+        {
+            if (policy.seqlock == ConnPolicy::SEQLOCK_ALWAYS)
+                RTT::log(Warning) << "seqlock connection policy is unavailable for type " << internal::DataSourceTypeInfo<T>::getType() << ", which is not trivially copyable" << RTT::endlog();
+            return 0;
+        }
+
+        /** Creates the buffer object of a BUFFER or CIRCULAR_BUFFER connection for
+         * samples of type \a T, based on the lock policy of \a policy.
+         */
+        template<typename T>
+        static typename base::BufferInterface<T>::shared_ptr buildBufferObject(ConnPolicy const& policy, const T& initial_value)
+        {
+            typename base::BufferInterface<T>::shared_ptr buffer_object;
+            switch (policy.lock_policy)
+            {
+#ifndef OROBLD_OS_NO_ASM
+            case ConnPolicy::LOCK_FREE:
+                {
+                    // A non-circular buffer with one writer and one reader does not need the
+                    // multi-writer pool and queue of BufferLockFree.
+                    base::BufferBase::Options options(policy);
+                    if (!options.circular() && !options.multiple_writers() && !options.multiple_readers() && options.max_threads() <= 2)
+                        buffer_object.reset(new base::BufferLockFreeSPSC<T>(policy.size, initial_value, options));
+                    else
+                        buffer_object.reset(new base::BufferLockFree<T>(policy.size, initial_value, options));
                 }
-                return new ChannelBufferElement<T>(buffer_object, policy);
+                break;
+#else
+            case ConnPolicy::LOCK_FREE:
+                RTT::log(Warning) << "lock free connection policy is unavailable on this system, defaulting to LOCKED" << RTT::endlog();
+#endif
+            case ConnPolicy::LOCKED:
+                buffer_object.reset(new base::BufferLocked<T>(policy.size, initial_value, policy));
+                break;
+            case ConnPolicy::UNSYNC:
+                buffer_object.reset(new base::BufferUnSync<T>(policy.size, initial_value, policy));
+                break;
             }
-            return NULL;
+            return buffer_object;
         }
 
         /** During the process of building a connection between two ports, this
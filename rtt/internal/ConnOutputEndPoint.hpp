@@ -125,6 +125,40 @@ namespace RTT
             return result;
         }
 
+        /** Writes a batch of samples on this connection.
+         * Same as write(), the port is signalled once if this endpoint has a buffer output.
+         */
+        virtual WriteStatus writeAll(const std::vector<typename Base::value_t>& samples)
+        {
+            typename base::ChannelElement<T>::shared_ptr output = this->getOutput();
+            WriteStatus result = output ? output->writeAll(samples) : NotConnected;
+            if (result == WriteSuccess) {
+                if (!signal()) {
+                    return WriteFailure;
+                }
+            } else if (result == NotConnected) {
+                // see write()
+                result = WriteFailure;
+            }
+            return result;
+        }
+
+        /** Writes a sample obtained by loan() on this connection.
+         * Same as write(), the port is signalled if this endpoint has a buffer output.
+         */
+        virtual WriteStatus commit(typename Base::value_t*& sample, base::ChannelElement<T>* owner)
+        {
+            WriteStatus result = Base::commit(sample, owner);
+            if (result == WriteSuccess) {
+                if (!signal()) {
+                    return WriteFailure;
+                }
+            } else if (result == NotConnected) {
+                result = WriteFailure;
+            }
+            return result;
+        }
+
         using Base::disconnect;
 
         virtual bool disconnect(const base::ChannelElementBase::shared_ptr& channel, bool forward)
@@ -171,6 +171,63 @@ namespace RTT
             return found;
         }
 
+        namespace {
+            /**
+             * Calls \a f on \a channel and then on the elements before and after it,
+             * until \a f returns true. The element storing the samples of a connection
+             * may be on either side of the element that was registered to the port.
+             */
+            template<class F>
+            bool visitConnection(ChannelElementBase::shared_ptr channel, F f)
+            {
+                if ( f(channel) )
+                    return true;
+                for (ChannelElementBase::shared_ptr next = channel->getOutput(); next; next = next->getOutput())
+                    if ( f(next) )
+                        return true;
+                for (ChannelElementBase::shared_ptr previous = channel->getInput(); previous; previous = previous->getInput())
+                    if ( f(previous) )
+                        return true;
+                return false;
+            }
+
+            bool enableElementStatistics(ChannelElementBase::shared_ptr const& element)
+            {
+                return element->enableStatistics();
+            }
+
+            struct FindElementStatistics
+            {
+                boost::shared_ptr<ChannelStatistics>* result;
+                bool operator()(ChannelElementBase::shared_ptr const& element) const
+                {
+                    *result = element->getStatistics();
+                    return result->get() != 0;
+                }
+            };
+        }
+
+        int ConnectionManager::enableStatistics()
+        {
+            PortConnectionLock lock(mport);
+            int count = 0;
+            for(Connections::iterator conn_it = connections.begin(); conn_it != connections.end(); ++conn_it) {
+                if ( conn_it->get<1>() && visitConnection(conn_it->get<1>(), &enableElementStatistics) )
+                    ++count;
+            }
+            return count;
+        }
+
+        boost::shared_ptr<ChannelStatistics> ConnectionManager::getStatistics(const ChannelDescriptor& descriptor)
+        {
+            boost::shared_ptr<ChannelStatistics> result;
+            if ( descriptor.get<1>() ) {
+                FindElementStatistics find = { &result };
+                visitConnection(descriptor.get<1>(), find);
+            }
+            return result;
+        }
+
     }
 
 }
@@ -137,6 +137,20 @@ namespace RTT
                 return connections;
             }
 
+            /**
+             * Starts collecting statistics in the element which stores the
+             * samples of each connection.
+             * @return the number of connections which collect statistics.
+             * @see base::ChannelElementBase::enableStatistics()
+             */
+            int enableStatistics();
+
+            /**
+             * Returns the statistics of the connection described by \a descriptor.
+             * @return null if the connection does not collect statistics.
+             */
+            static boost::shared_ptr<base::ChannelStatistics> getStatistics(const ChannelDescriptor& descriptor);
+
             /**
              * Returns a pointer to the shared connection element this port may be connected to.
              */
@@ -0,0 +1,183 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "ConnectionStatisticsService.hpp"
+#include "ConnectionManager.hpp"
+#include "../TaskContext.hpp"
+#include "../base/PortInterface.hpp"
+#include "../base/ChannelStatistics.hpp"
+#include <sstream>
+
+namespace RTT
+{ namespace internal {
+
+    using namespace std;
+    using base::ChannelStatistics;
+
+    namespace {
+        /**
+         * Returns the ports named \a port, or all ports of \a tc if \a port is empty.
+         */
+        DataFlowInterface::Ports selectPorts(TaskContext* tc, const string& port)
+        {
+            if ( port.empty() )
+                return tc->ports()->getPorts();
+            DataFlowInterface::Ports result;
+            if ( tc->ports()->getPort(port) )
+                result.push_back( tc->ports()->getPort(port) );
+            return result;
+        }
+
+        ChannelStatistics::shared_ptr connectionStatistics(TaskContext* tc, const string& port, int connection)
+        {
+            base::PortInterface* p = tc->ports()->getPort(port);
+            if ( !p || connection < 0 )
+                return ChannelStatistics::shared_ptr();
+            ConnectionManager::Connections connections = p->getManager()->getConnections();
+            ConnectionManager::Connections::const_iterator it = connections.begin();
+            for (int i = 0; i != connection && it != connections.end(); ++i)
+                ++it;
+            if ( it == connections.end() )
+                return ChannelStatistics::shared_ptr();
+            return ConnectionManager::getStatistics(*it);
+        }
+    }
+
+    ConnectionStatisticsService::shared_ptr ConnectionStatisticsService::Create(TaskContext* parent)
+    {
+        shared_ptr sp(new ConnectionStatisticsService(parent));
+        parent->provides()->addService( sp );
+        return sp;
+    }
+
+    ConnectionStatisticsService::ConnectionStatisticsService(TaskContext* parent)
+        : Service("connectionStatistics", parent)
+    {
+        this->doc("Statistics of the connections of the ports of this component.");
+        addOperation("enable", &ConnectionStatisticsService::enable, this)
+            .doc("Starts collecting statistics on the connections of a port. Returns the number of connections which collect statistics.")
+            .arg("port", "The name of the port, or an empty string for all ports.");
+        addOperation("reset", &ConnectionStatisticsService::reset, this)
+            .doc("Sets the statistics of the connections of a port to zero.")
+            .arg("port", "The name of the port, or an empty string for all ports.");
+        addOperation("getConnectionCount", &ConnectionStatisticsService::getConnectionCount, this)
+            .doc("Returns the number of connections of a port.")
+            .arg("port", "The name of the port.");
+        addOperation("getCounters", &ConnectionStatisticsService::getCounters, this)
+            .doc("Returns the writes, overwrites, drops, reads, NewData reads and OldData reads of a connection, or an empty array if it does not collect statistics.")
+            .arg("port", "The name of the port.")
+            .arg("connection", "The index of the connection of the port.");
+        addOperation("getLatencyHistogram", &ConnectionStatisticsService::getLatencyHistogram, this)
+            .doc("Returns the latency histogram of a connection. Element i counts the samples which waited less than 2^i microseconds, the last element counts all others.")
+            .arg("port", "The name of the port.")
+            .arg("connection", "The index of the connection of the port.");
+        addOperation("report", &ConnectionStatisticsService::report, this)
+            .doc("Returns one line for each connection which collects statistics.");
+    }
+
+    int ConnectionStatisticsService::enable(const string& port)
+    {
+        int count = 0;
+        DataFlowInterface::Ports ports = selectPorts(getOwner(), port);
+        for (DataFlowInterface::Ports::iterator it = ports.begin(); it != ports.end(); ++it)
+            count += (*it)->getManager()->enableStatistics();
+        return count;
+    }
+
+    void ConnectionStatisticsService::reset(const string& port)
+    {
+        DataFlowInterface::Ports ports = selectPorts(getOwner(), port);
+        for (DataFlowInterface::Ports::iterator it = ports.begin(); it != ports.end(); ++it) {
+            ConnectionManager::Connections connections = (*it)->getManager()->getConnections();
+            for (ConnectionManager::Connections::iterator conn_it = connections.begin(); conn_it != connections.end(); ++conn_it) {
+                ChannelStatistics::shared_ptr statistics = ConnectionManager::getStatistics(*conn_it);
+                if ( statistics )
+                    statistics->reset();
+            }
+        }
+    }
+
+    int ConnectionStatisticsService::getConnectionCount(const string& port)
+    {
+        base::PortInterface* p = getOwner()->ports()->getPort(port);
+        return p ? p->getManager()->getConnections().size() : 0;
+    }
+
+    vector<double> ConnectionStatisticsService::getCounters(const string& port, int connection)
+    {
+        vector<double> result;
+        ChannelStatistics::shared_ptr statistics = connectionStatistics(getOwner(), port, connection);
+        if ( !statistics )
+            return result;
+        result.push_back( statistics->getWrites() );
+        result.push_back( statistics->getOverwrites() );
+        result.push_back( statistics->getDrops() );
+        result.push_back( statistics->getReads() );
+        result.push_back( statistics->getNewData() );
+        result.push_back( statistics->getOldData() );
+        return result;
+    }
+
+    vector<double> ConnectionStatisticsService::getLatencyHistogram(const string& port, int connection)
+    {
+        ChannelStatistics::shared_ptr statistics = connectionStatistics(getOwner(), port, connection);
+        if ( !statistics )
+            return vector<double>();
+        vector<int> histogram = statistics->getLatencyHistogram();
+        return vector<double>( histogram.begin(), histogram.end() );
+    }
+
+    string ConnectionStatisticsService::report()
+    {
+        stringstream result;
+        DataFlowInterface::Ports ports = getOwner()->ports()->getPorts();
+        for (DataFlowInterface::Ports::iterator it = ports.begin(); it != ports.end(); ++it) {
+            ConnectionManager::Connections connections = (*it)->getManager()->getConnections();
+            int index = 0;
+            for (ConnectionManager::Connections::iterator conn_it = connections.begin(); conn_it != connections.end(); ++conn_it, ++index) {
+                ChannelStatistics::shared_ptr statistics = ConnectionManager::getStatistics(*conn_it);
+                if ( !statistics )
+                    continue;
+                result << (*it)->getName() << "[" << index << "]:"
+                       << " writes " << statistics->getWrites()
+                       << ", overwrites " << statistics->getOverwrites()
+                       << ", drops " << statistics->getDrops()
+                       << ", reads " << statistics->getReads()
+                       << " (new " << statistics->getNewData()
+                       << ", old " << statistics->getOldData() << "), latency";
+                vector<int> histogram = statistics->getLatencyHistogram();
+                for (unsigned int i = 0; i != histogram.size(); ++i)
+                    result << " " << histogram[i];
+                result << endl;
+            }
+        }
+        return result.str();
+    }
+}}
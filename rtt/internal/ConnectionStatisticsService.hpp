@@ -0,0 +1,103 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_CONNECTION_STATISTICS_SERVICE_HPP
+#define ORO_CONNECTION_STATISTICS_SERVICE_HPP
+
+#include "../Service.hpp"
+#include <string>
+#include <vector>
+
+namespace RTT
+{ namespace internal {
+
+    /**
+     * Exposes the statistics of the connections of the ports of a
+     * TaskContext, such that scripts and deployers can find overloaded
+     * connections. It is not loaded by default: TaskContext::loadService("connectionStatistics")
+     * creates it as the \a connectionStatistics service of a TaskContext.
+     *
+     * A connection is identified by the name of a port and its index in
+     * the connections of the ConnectionManager of that port.
+     * @see base::ChannelStatistics
+     */
+    class RTT_API ConnectionStatisticsService
+        : public Service
+    {
+    public:
+        typedef boost::shared_ptr<ConnectionStatisticsService> shared_ptr;
+
+        /**
+         * Creates a ConnectionStatisticsService object and registers
+         * the service to \a parent.
+         */
+        static shared_ptr Create(TaskContext* parent);
+
+        ConnectionStatisticsService(TaskContext* parent);
+
+        /**
+         * Starts collecting statistics on the connections of \a port,
+         * or of all ports if \a port is empty.
+         * @return the number of connections which collect statistics.
+         */
+        int enable(const std::string& port);
+
+        /**
+         * Sets the statistics of the connections of \a port, or of
+         * all ports if \a port is empty, to zero.
+         */
+        void reset(const std::string& port);
+
+        /**
+         * Returns the number of connections of \a port.
+         */
+        int getConnectionCount(const std::string& port);
+
+        /**
+         * Returns the counters of a connection of \a port: writes, overwrites,
+         * drops, reads, NewData reads and OldData reads.
+         * @return an empty array if that connection does not collect statistics.
+         */
+        std::vector<double> getCounters(const std::string& port, int connection);
+
+        /**
+         * Returns the latency histogram of a connection of \a port.
+         * @return an empty array if that connection does not collect statistics.
+         * @see base::ChannelStatistics::getLatencyHistogram()
+         */
+        std::vector<double> getLatencyHistogram(const std::string& port, int connection);
+
+        /**
+         * Returns one line for each connection which collects statistics.
+         */
+        std::string report();
+    };
+}}
+
+#endif
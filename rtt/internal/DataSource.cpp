@@ -105,6 +105,10 @@ namespace RTT {
         return false;
     }
 
+    bool DataSourceBase::isConstant() const {
+        return false;
+    }
+
     bool DataSourceBase::update( DataSourceBase* ) {
         return false;
     }
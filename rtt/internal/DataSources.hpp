@@ -142,6 +142,11 @@ namespace RTT
             return mdata;
         }
 
+        virtual bool isConstant() const
+        {
+            return true;
+        }
+
         virtual ConstantDataSource<T>* clone() const;
 
         virtual ConstantDataSource<T>* copy( std::map<const base::DataSourceBase*, base::DataSourceBase*>& alreadyCloned ) const;
@@ -719,6 +724,11 @@ namespace RTT
         mdsb->reset();
       }
 
+    virtual bool isConstant() const
+      {
+        return mdsa->isConstant() && mdsb->isConstant();
+      }
+
       virtual BinaryDataSource<function>* clone() const
       {
           return new BinaryDataSource<function>(mdsa.get(), mdsb.get(), fun);
@@ -776,6 +786,11 @@ namespace RTT
         mdsa->reset();
       }
 
+    virtual bool isConstant() const
+      {
+        return mdsa->isConstant();
+      }
+
     virtual UnaryDataSource<function>* clone() const
       {
           return new UnaryDataSource<function>(mdsa.get(), fun);
@@ -853,6 +868,14 @@ namespace RTT
               mdsargs[i]->reset();
       }
 
+      virtual bool isConstant() const
+      {
+          for( unsigned int i=0; i !=mdsargs.size(); ++i)
+              if ( !mdsargs[i]->isConstant() )
+                  return false;
+          return true;
+      }
+
       virtual NArityDataSource<function>* clone() const
       {
           return new NArityDataSource<function>(fun, mdsargs);
@@ -51,6 +51,7 @@
 #include "../SendHandle.hpp"
 #include "../ExecutionEngine.hpp"
 #include "OperationCallerBinder.hpp"
+#include "ClonePool.hpp"
 #include <boost/fusion/include/vector_tie.hpp>
 #include "../os/oro_allocator.hpp"
 
@@ -104,7 +105,7 @@ namespace RTT
                         this->reportError();
                     bool result = false;
                     if ( this->caller){
-                        result = this->caller->process(this);
+                        result = this->caller->process(this, this->getPriority());
                     }
                     if (!result)
                         dispose();
@@ -129,9 +130,11 @@ namespace RTT
 
             SendHandle<Signature> do_send(shared_ptr cl) {
                 //std::cout << "Sending clone..."<<std::endl;
+                if ( !cl )
+                    return SendHandle<Signature>(); // all pre-allocated clones are in use
                 ExecutionEngine* receiver = this->getMessageProcessor();
                 cl->self = cl;
-                if ( receiver && receiver->process( cl.get() ) ) {
+                if ( receiver && receiver->process( cl.get(), cl->getPriority() ) ) {
                     return SendHandle<Signature>( cl );
                 } else {
                     cl->dispose();
@@ -148,6 +151,8 @@ namespace RTT
             SendHandle<Signature> send_impl( T1 a1 ) {
                 // bind types from Storage<Function>
                 shared_ptr cl = this->cloneRT();
+                if ( !cl )
+                    return SendHandle<Signature>();
                 cl->store( a1 );
                 return do_send(cl);
             }
@@ -156,6 +161,8 @@ namespace RTT
             SendHandle<Signature> send_impl( T1 a1, T2 a2 ) {
                 // bind types from Storage<Function>
                 shared_ptr cl = this->cloneRT();
+                if ( !cl )
+                    return SendHandle<Signature>();
                 cl->store( a1,a2 );
                 return do_send(cl);
             }
@@ -164,6 +171,8 @@ namespace RTT
             SendHandle<Signature> send_impl( T1 a1, T2 a2, T3 a3 ) {
                 // bind types from Storage<Function>
                 shared_ptr cl = this->cloneRT();
+                if ( !cl )
+                    return SendHandle<Signature>();
                 cl->store( a1,a2,a3 );
                 return do_send(cl);
             }
@@ -172,6 +181,8 @@ namespace RTT
             SendHandle<Signature> send_impl( T1 a1, T2 a2, T3 a3, T4 a4 ) {
                 // bind types from Storage<Function>
                 shared_ptr cl = this->cloneRT();
+                if ( !cl )
+                    return SendHandle<Signature>();
                 cl->store( a1,a2,a3,a4 );
                 return do_send(cl);
             }
@@ -180,6 +191,8 @@ namespace RTT
             SendHandle<Signature> send_impl( T1 a1, T2 a2, T3 a3, T4 a4, T5 a5 ) {
                 // bind types from Storage<Function>
                 shared_ptr cl = this->cloneRT();
+                if ( !cl )
+                    return SendHandle<Signature>();
                 cl->store( a1,a2,a3,a4,a5 );
                 return do_send(cl);
             }
@@ -188,6 +201,8 @@ namespace RTT
             SendHandle<Signature> send_impl( T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6 ) {
                 // bind types from Storage<Function>
                 shared_ptr cl = this->cloneRT();
+                if ( !cl )
+                    return SendHandle<Signature>();
                 cl->store( a1,a2,a3,a4,a5,a6 );
                 return do_send(cl);
             }
@@ -196,6 +211,8 @@ namespace RTT
             SendHandle<Signature> send_impl( T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7 ) {
                 // bind types from Storage<Function>
                 shared_ptr cl = this->cloneRT();
+                if ( !cl )
+                    return SendHandle<Signature>();
                 cl->store( a1,a2,a3,a4,a5,a6,a7 );
                 return do_send(cl);
             }
@@ -615,6 +632,10 @@ namespace RTT
                 return this->retv.result(); // may return void.
             }
 
+            /**
+             * Returns a copy of this object for a send().
+             * @return a null pointer if no copy is available.
+             */
             virtual shared_ptr cloneRT() const = 0;
         protected:
             typedef BindStorage<FunctionT> Store;
@@ -705,8 +726,22 @@ namespace RTT
             typename LocalOperationCallerImpl<Signature>::shared_ptr cloneRT() const
             {
                 // returns identical copy of this;
+                if ( mclones.capacity() )
+                    return mclones.allocate(*this);
                 return boost::allocate_shared<LocalOperationCaller<Signature> >(os::rt_allocator<LocalOperationCaller<Signature> >(), *this);
             }
+
+            virtual bool setMaxConcurrentSends(unsigned int n)
+            {
+                mclones.reserve(*this, n);
+                return true;
+            }
+
+        private:
+            /**
+             * Pre-allocated copies of this object for send(), if setMaxConcurrentSends() was called.
+             */
+            mutable ClonePool< LocalOperationCaller<Signature> > mclones;
         };
     }
 }
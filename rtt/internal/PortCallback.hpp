@@ -0,0 +1,77 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_PORT_CALLBACK_HPP
+#define ORO_PORT_CALLBACK_HPP
+
+#include "../os/oro_arch.h"
+#include "../rtt-fwd.hpp"
+#include <boost/function.hpp>
+
+namespace RTT
+{ namespace internal {
+
+    /**
+     * The callback of an event port of a TaskContext, which queues it in
+     * its ExecutionEngine when data arrives on the port.
+     *
+     * The TaskContext owns these entries and only deletes them when it is
+     * destroyed, so a queued entry stays valid after its port was removed.
+     * Removing the port sets \a port to null, such that the engine skips
+     * the entry instead of touching the port. The entry is reused for the
+     * next event port.
+     */
+    struct PortCallback
+    {
+        PortCallback()
+            : port(0)
+        {
+            oro_atomic_set(&queued, 0);
+        }
+
+        /**
+         * The event port, or null when the entry is not in use.
+         */
+        base::PortInterface* port;
+
+        /**
+         * Is 1 while this entry is queued in the ExecutionEngine, such
+         * that the port is queued only once.
+         */
+        oro_atomic_t queued;
+
+        /**
+         * The callback of the port, invoked in the thread of the TaskContext.
+         */
+        boost::function<void(base::PortInterface*)> callback;
+    };
+}}
+
+#endif
@@ -182,6 +182,43 @@ namespace internal {
             return mstorage->read(sample, copy_old_data);
         }
 
+        virtual WriteStatus writeAll(const std::vector<value_t>& samples)
+        {
+            WriteStatus result = mstorage->writeAll(samples);
+            if (result == WriteSuccess) {
+                if (!this->signal()) {
+                    return WriteFailure;
+                }
+            }
+            return result;
+        }
+
+        virtual FlowStatus readAll(std::vector<value_t>& samples)
+        {
+            return mstorage->readAll(samples);
+        }
+
+        virtual value_t* loan(typename base::ChannelElement<T>::shared_ptr& owner)
+        {
+            return mstorage->loan(owner);
+        }
+
+        virtual WriteStatus commit(value_t*& sample, base::ChannelElement<T>* owner)
+        {
+            WriteStatus result = mstorage->commit(sample, owner);
+            if (result == WriteSuccess) {
+                if (!this->signal()) {
+                    return WriteFailure;
+                }
+            }
+            return result;
+        }
+
+        virtual FlowStatus readLoan(value_t*& sample, typename base::ChannelElement<T>::shared_ptr& owner)
+        {
+            return mstorage->readLoan(sample, owner);
+        }
+
         /**
          * Resets the stored sample. After clear() has been called, read()
          * returns false
@@ -214,6 +251,19 @@ namespace internal {
         {
             return mstorage->data_sample();
         }
+
+        /**
+         * The statistics of a shared connection are those of its storage.
+         */
+        virtual bool enableStatistics()
+        {
+            return mstorage->enableStatistics();
+        }
+
+        virtual boost::shared_ptr<base::ChannelStatistics> getStatistics() const
+        {
+            return mstorage->getStatistics();
+        }
     };
 
     template <typename T>
@@ -0,0 +1,342 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_SHARED_SAMPLE_HPP
+#define ORO_SHARED_SAMPLE_HPP
+
+#include "TsPool.hpp"
+#include "../ConnPolicy.hpp"
+#include "../base/BufferLockFreeSPSC.hpp"
+#include "../base/SampleSlot.hpp"
+#include "../base/DataObjectBase.hpp"
+#include "../os/oro_arch.h"
+#include "../os/Mutex.hpp"
+#include "../os/MutexLock.hpp"
+#include <boost/intrusive_ptr.hpp>
+#include <boost/aligned_storage.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace RTT
+{ namespace internal {
+
+    template<class T> class SharedSamplePool;
+
+    /**
+     * A counted reference to an immutable sample in a SharedSamplePool.
+     * Connections that store shared samples keep these references instead
+     * of copies, such that a sample written to many connections is only
+     * copied once. The sample returns to its pool when the last
+     * reference is gone.
+     */
+    template<class T>
+    class SharedSample
+    {
+    public:
+        /**
+         * The pool element.
+         */
+        struct Node
+        {
+            T value;
+            oro_atomic_t refcount;
+            TsPool<Node>* segment;
+            SharedSamplePool<T>* owner;
+
+            Node() : value(), segment(0), owner(0) { ORO_ATOMIC_SETUP(&refcount, 0); }
+        };
+
+        SharedSample() : node(0) {}
+
+        SharedSample(const SharedSample& other)
+            : node(other.node)
+        {
+            if (node) oro_atomic_inc(&node->refcount);
+        }
+
+        ~SharedSample() { deref(node); }
+
+        SharedSample& operator=(const SharedSample& other)
+        {
+            if (other.node) oro_atomic_inc(&other.node->refcount);
+            Node* old = node;
+            node = other.node;
+            deref(old);
+            return *this;
+        }
+
+        const T& operator*() const { return node->value; }
+        const T* operator->() const { return &node->value; }
+        const T* get() const { return node ? &node->value : 0; }
+        bool empty() const { return node == 0; }
+
+        /**
+         * Drops the reference held by this object.
+         */
+        void reset()
+        {
+            Node* old = node;
+            node = 0;
+            deref(old);
+        }
+
+        /**
+         * Hands the reference held by this object over to the caller,
+         * who must give it back with adopt(). This allows to loan the sample
+         * as a plain pointer.
+         */
+        T* release()
+        {
+            Node* n = node;
+            node = 0;
+            return n ? &n->value : 0;
+        }
+
+        /**
+         * Takes over a reference that was given out by release().
+         */
+        static SharedSample adopt(T* value)
+        {
+            if (!value)
+                return SharedSample();
+            return SharedSample( reinterpret_cast<Node*>( reinterpret_cast<char*>(value) - valueOffset() ) );
+        }
+
+    private:
+        friend class SharedSamplePool<T>;
+
+        explicit SharedSample(Node* node) : node(node) {}
+
+        /**
+         * The offset of value in a Node, like offsetof(), which
+         * is not defined for types that are not plain old data.
+         */
+        static std::ptrdiff_t valueOffset()
+        {
+            typename boost::aligned_storage<sizeof(Node), boost::alignment_of<Node>::value>::type storage;
+            const Node* node = reinterpret_cast<const Node*>(&storage);
+            return reinterpret_cast<const char*>(&node->value) - reinterpret_cast<const char*>(node);
+        }
+
+        static void deref(Node* node)
+        {
+            if (node && oro_atomic_dec_and_test(&node->refcount))
+                SharedSamplePool<T>::deallocate(node);
+        }
+
+        Node* node;
+    };
+}
+
+namespace base {
+
+    /**
+     * A freed slot of a buffer or data object drops its reference, such
+     * that the sample can return to its pool.
+     */
+    template<class T>
+    struct SampleSlot< internal::SharedSample<T> >
+    {
+        static const bool needs_release = true;
+        static void release(internal::SharedSample<T>& sample) { sample.reset(); }
+    };
+}
+
+namespace internal {
+
+    /**
+     * A real-time pool of samples that are shared by reference. The pool
+     * only grows, by adding fixed-size segments with reserve(). It is
+     * reference counted and stays alive as long as one of its samples is
+     * referenced, such that the connections of a port may outlive the pool
+     * owner.
+     */
+    template<class T>
+    class SharedSamplePool
+    {
+        typedef typename SharedSample<T>::Node Node;
+
+        struct Segment
+        {
+            Segment(unsigned int size, const Node& sample) : pool(size, sample), next(0) {}
+            TsPool<Node> pool;
+            Segment* volatile next;
+        };
+
+    public:
+        typedef boost::intrusive_ptr< SharedSamplePool<T> > shared_ptr;
+
+        SharedSamplePool()
+            : segments(0), pool_capacity(0)
+        {
+            ORO_ATOMIC_SETUP(&refcount, 0);
+        }
+
+        ~SharedSamplePool()
+        {
+            while (segments) {
+                Segment* next = segments->next;
+                delete segments;
+                segments = next;
+            }
+        }
+
+        /**
+         * Returns the number of samples a connection with \a policy may
+         * hold at the same time. These are the samples in the slots of its
+         * data object or buffer, a sample loaned or being copied by each
+         * reader, the sample being written and the last sample read.
+         */
+        static unsigned int capacityFor(const ConnPolicy& policy)
+        {
+            if (policy.type == ConnPolicy::DATA) {
+                // a DataObjectLockFree has the most slots
+                unsigned int threads = base::DataObjectBase::Options(policy).max_threads();
+                return (threads + 2) + threads + 1;
+            }
+            // a BufferLockFreeSPSC has the most slots, a power of two
+            base::BufferBase::Options options(policy);
+            return base::BufferLockFreeSPSC<T>::slotCount(policy.size, options) + options.max_threads() + 2;
+        }
+
+        /**
+         * Grows the pool such that it holds at least \a size samples.
+         * @nrt
+         */
+        void reserve(unsigned int size)
+        {
+            os::MutexLock lock(mutex);
+            if (size <= pool_capacity)
+                return;
+            Segment* segment = new Segment(size - pool_capacity, prototype);
+            oro_mb(); // the segment must be complete before allocate() can see it
+            Segment* volatile* tail = &segments;
+            while (*tail)
+                tail = &(*tail)->next;
+            *tail = segment;
+            pool_capacity = size;
+        }
+
+        unsigned int capacity() const { return pool_capacity; }
+
+        /**
+         * Returns the number of free samples in the pool.
+         * @nrt
+         */
+        unsigned int size() const
+        {
+            unsigned int free = 0;
+            for (Segment* segment = segments; segment; segment = segment->next)
+                free += segment->pool.size();
+            return free;
+        }
+
+        /**
+         * Initializes all free samples of the pool with \a sample, such that
+         * allocate() does not need to allocate memory for dynamically sized types.
+         * This takes all free samples out of the pool for a moment. A writer
+         * that calls allocate() meanwhile finds the pool exhausted and copies
+         * its sample for each connection instead, so this is best called before
+         * the pool is used, when the first connection is set up.
+         * @nrt
+         */
+        void data_sample(const T& sample)
+        {
+            os::MutexLock lock(mutex);
+            prototype.value = sample;
+            std::vector<Node*> nodes;
+            nodes.reserve(pool_capacity);
+            for (Segment* segment = segments; segment; segment = segment->next) {
+                Node* node;
+                while ( (node = segment->pool.allocate()) ) {
+                    node->value = sample;
+                    nodes.push_back(node);
+                }
+                for (typename std::vector<Node*>::iterator it = nodes.begin(); it != nodes.end(); ++it)
+                    segment->pool.deallocate(*it);
+                nodes.clear();
+            }
+        }
+
+        /**
+         * Copies \a value into a free sample of the pool.
+         * @return a reference to the sample, or an empty reference if the pool is exhausted.
+         * @rt
+         */
+        SharedSample<T> allocate(const T& value)
+        {
+            for (Segment* segment = segments; segment; segment = segment->next) {
+                Node* node = segment->pool.allocate();
+                if (node) {
+                    node->value = value;
+                    node->segment = &segment->pool;
+                    node->owner = this;
+                    oro_atomic_set(&node->refcount, 1);
+                    intrusive_ptr_add_ref(this);
+                    return SharedSample<T>(node);
+                }
+            }
+            return SharedSample<T>();
+        }
+
+        friend void intrusive_ptr_add_ref(SharedSamplePool<T>* p)
+        {
+            oro_atomic_inc(&p->refcount);
+        }
+
+        friend void intrusive_ptr_release(SharedSamplePool<T>* p)
+        {
+            if (oro_atomic_dec_and_test(&p->refcount))
+                delete p;
+        }
+
+    private:
+        friend class SharedSample<T>;
+
+        SharedSamplePool(const SharedSamplePool&);
+        SharedSamplePool& operator=(const SharedSamplePool&);
+
+        static void deallocate(Node* node)
+        {
+            SharedSamplePool<T>* owner = node->owner;
+            node->segment->deallocate(node);
+            intrusive_ptr_release(owner);
+        }
+
+        oro_atomic_t refcount;
+        Segment* volatile segments;
+        unsigned int pool_capacity;
+        Node prototype;
+        os::Mutex mutex;
+    };
+}}
+
+#endif
@@ -0,0 +1,116 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "ThreadStatisticsService.hpp"
+#include "../TaskContext.hpp"
+#include "../base/ActivityInterface.hpp"
+#include "../os/ThreadStatistics.hpp"
+
+namespace RTT
+{ namespace internal {
+
+    using namespace std;
+    using os::ThreadStatistics;
+
+    namespace {
+        /**
+         * Returns the statistics of the thread which executes \a tc, if any.
+         */
+        ThreadStatistics* threadStatistics(TaskContext* tc)
+        {
+            base::ActivityInterface* activity = tc ? tc->getActivity() : 0;
+            return activity ? activity->getThreadStatistics() : 0;
+        }
+    }
+
+    ThreadStatisticsService::shared_ptr ThreadStatisticsService::Create(TaskContext* parent)
+    {
+        shared_ptr sp(new ThreadStatisticsService(parent));
+        parent->provides()->addService( sp );
+        return sp;
+    }
+
+    ThreadStatisticsService::ThreadStatisticsService(TaskContext* parent)
+        : Service("threadStatistics", parent)
+    {
+        this->doc("Timing statistics of the thread which executes this component.");
+        addOperation("reset", &ThreadStatisticsService::reset, this)
+            .doc("Sets the statistics of the thread to zero.");
+        addOperation("getPeriods", &ThreadStatisticsService::getPeriods, this)
+            .doc("Returns the number of periods that were recorded.");
+        addOperation("getOverruns", &ThreadStatisticsService::getOverruns, this)
+            .doc("Returns the number of periods in which the thread did not finish in time.");
+        addOperation("getLatency", &ThreadStatisticsService::getLatency, this)
+            .doc("Returns a percentile of the time between the start of a period and the moment the thread woke up, in seconds.")
+            .arg("percentile", "The percentile, for example 50, 99 or 99.9.");
+        addOperation("getDuration", &ThreadStatisticsService::getDuration, this)
+            .doc("Returns a percentile of the time the thread spent executing each period, in seconds.")
+            .arg("percentile", "The percentile, for example 50, 99 or 99.9.");
+        addOperation("report", &ThreadStatisticsService::report, this)
+            .doc("Returns a one-line summary of the statistics.");
+    }
+
+    void ThreadStatisticsService::reset()
+    {
+        ThreadStatistics* statistics = threadStatistics(getOwner());
+        if ( statistics )
+            statistics->reset();
+    }
+
+    int ThreadStatisticsService::getPeriods()
+    {
+        ThreadStatistics* statistics = threadStatistics(getOwner());
+        return statistics ? statistics->duration.count() : 0;
+    }
+
+    int ThreadStatisticsService::getOverruns()
+    {
+        ThreadStatistics* statistics = threadStatistics(getOwner());
+        return statistics ? statistics->overruns.read() : 0;
+    }
+
+    double ThreadStatisticsService::getLatency(double percentile)
+    {
+        ThreadStatistics* statistics = threadStatistics(getOwner());
+        return statistics ? nsecs_to_Seconds( statistics->latency.percentile(percentile) ) : 0.0;
+    }
+
+    double ThreadStatisticsService::getDuration(double percentile)
+    {
+        ThreadStatistics* statistics = threadStatistics(getOwner());
+        return statistics ? nsecs_to_Seconds( statistics->duration.percentile(percentile) ) : 0.0;
+    }
+
+    string ThreadStatisticsService::report()
+    {
+        ThreadStatistics* statistics = threadStatistics(getOwner());
+        return statistics ? statistics->report() : string("no statistics");
+    }
+}}
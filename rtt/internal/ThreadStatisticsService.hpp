@@ -0,0 +1,98 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_THREAD_STATISTICS_SERVICE_HPP
+#define ORO_THREAD_STATISTICS_SERVICE_HPP
+
+#include "../Service.hpp"
+#include <string>
+
+namespace RTT
+{ namespace internal {
+
+    /**
+     * Exposes the timing statistics of the thread which executes a
+     * TaskContext, such that supervisors can check its wake-up latency,
+     * the duration of its periods and its overruns. It is not loaded by
+     * default: use TaskContext::loadService("threadStatistics") to add it
+     * as the \a threadStatistics service of a TaskContext.
+     *
+     * The statistics belong to the thread, so they are shared with all
+     * other components which are executed by the same thread.
+     * @see os::ThreadStatistics
+     */
+    class RTT_API ThreadStatisticsService
+        : public Service
+    {
+    public:
+        typedef boost::shared_ptr<ThreadStatisticsService> shared_ptr;
+
+        /**
+         * Creates a ThreadStatisticsService object and registers
+         * the service to \a parent.
+         */
+        static shared_ptr Create(TaskContext* parent);
+
+        ThreadStatisticsService(TaskContext* parent);
+
+        /**
+         * Sets the statistics of the thread to zero.
+         */
+        void reset();
+
+        /**
+         * Returns the number of periods that were recorded.
+         */
+        int getPeriods();
+
+        /**
+         * Returns the number of periods in which the thread did not finish in time.
+         */
+        int getOverruns();
+
+        /**
+         * Returns the given percentile of the wake-up latency, in seconds.
+         */
+        double getLatency(double percentile);
+
+        /**
+         * Returns the given percentile of the time spent in each period, in seconds.
+         */
+        double getDuration(double percentile);
+
+        /**
+         * Returns a one-line summary of the statistics.
+         * @see os::ThreadStatistics::report()
+         */
+        std::string report();
+    };
+}}
+
+#endif
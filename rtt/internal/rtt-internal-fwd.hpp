@@ -54,6 +54,7 @@ namespace RTT {
         class SignalBase;
         class SimpleConnID;
         class PortConnectionLock;
+        struct PortCallback;
         struct GenerateDataSource;
         struct IntrusiveStorage;
         struct LocalConnID;
@@ -0,0 +1,184 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "Epoch.hpp"
+#include "CAS.hpp"
+#include "oro_arch.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+# include <windows.h>
+# include <malloc.h>
+# define ORO_EPOCH_THREAD_LOCAL __declspec(thread)
+# define ORO_EPOCH_CACHE_ALIGNED __declspec(align(64))
+#else
+# define ORO_EPOCH_THREAD_LOCAL __thread
+# define ORO_EPOCH_CACHE_ALIGNED __attribute__((aligned(64)))
+# include <pthread.h>
+#endif
+
+namespace RTT
+{ namespace os {
+
+    namespace {
+        /**
+         * The epoch state of one thread. Records are aligned to a cache line,
+         * such that a reader only ever writes to a line of its own. They are
+         * never freed, but the record of a thread that exited is reused by
+         * the next thread that enters a guard.
+         */
+        struct ORO_EPOCH_CACHE_ALIGNED Record
+        {
+            /** The epoch in which the thread entered its outer guard, 0 if quiescent. */
+            volatile Epoch::Stamp epoch;
+            unsigned int nesting;
+            /** 1 while a thread uses this record. */
+            volatile int owned;
+            Record* next;
+
+            Record() : epoch(0), nesting(0), owned(1), next(0) {}
+        };
+
+        /** The current epoch. Starts at 1 and always odd, such that 0 marks quiescent threads. */
+        volatile Epoch::Stamp global_epoch = 1;
+
+        /** The records of all threads that ever entered a guard. Records are only prepended. */
+        Record* volatile records = 0;
+
+        ORO_EPOCH_THREAD_LOCAL Record* current = 0;
+
+        /** Allocates a record on a cache line of its own, since new does not respect its alignment. */
+        Record* newRecord()
+        {
+            void* mem = 0;
+#ifdef _MSC_VER
+            mem = _aligned_malloc(sizeof(Record), sizeof(Record));
+#else
+            if ( posix_memalign(&mem, sizeof(Record), sizeof(Record)) != 0 )
+                mem = 0;
+#endif
+            if (!mem)
+                throw std::bad_alloc();
+            return new (mem) Record();
+        }
+
+#ifndef _MSC_VER
+        /** Called when a thread exits: hands its record to the next thread. */
+        void releaseRecord(void* record)
+        {
+            Record* rec = static_cast<Record*>(record);
+            rec->nesting = 0;
+            rec->epoch = 0;
+            current = 0;
+            oro_mb();
+            rec->owned = 0;
+        }
+
+        struct RecordKey
+        {
+            pthread_key_t key;
+            RecordKey() { pthread_key_create(&key, &releaseRecord); }
+        };
+
+        pthread_key_t recordKey()
+        {
+            static RecordKey key;
+            return key.key;
+        }
+#endif
+
+        Record* self()
+        {
+            Record* rec = current;
+            if (rec)
+                return rec;
+            for (rec = records; rec; rec = rec->next)
+                if ( rec->owned == 0 && CAS(&rec->owned, 0, 1) )
+                    break;
+            if (!rec) {
+                rec = newRecord();
+                Record* head;
+                do {
+                    head = records;
+                    rec->next = head;
+                } while ( !CAS(&records, head, rec) );
+            }
+            current = rec;
+#ifndef _MSC_VER
+            pthread_setspecific(recordKey(), rec);
+#endif
+            return rec;
+        }
+    }
+
+    Epoch::Guard::Guard()
+        : record( self() )
+    {
+        Record* rec = static_cast<Record*>(record);
+        if (rec->nesting++ == 0) {
+            rec->epoch = global_epoch;
+            // the epoch must be visible before any protected pointer is read.
+            oro_mb();
+        }
+    }
+
+    Epoch::Guard::~Guard()
+    {
+        Record* rec = static_cast<Record*>(record);
+        if (--rec->nesting == 0) {
+            // all protected reads must be done before the thread is seen as quiescent.
+            oro_mb();
+            rec->epoch = 0;
+        }
+    }
+
+    Epoch::Stamp Epoch::advance()
+    {
+        Stamp stamp;
+        do {
+            stamp = global_epoch;
+        } while ( !CAS(&global_epoch, stamp, stamp + 2) );
+        return stamp + 2;
+    }
+
+    bool Epoch::passed(Stamp stamp)
+    {
+        oro_mb();
+        for (Record* rec = records; rec; rec = rec->next) {
+            Stamp epoch = rec->epoch;
+            // the difference handles the wrap around of the epoch counter.
+            if (epoch != 0 && static_cast<long>(epoch - stamp) < 0)
+                return false;
+        }
+        return true;
+    }
+}}
@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_OS_EPOCH_HPP
+#define ORO_OS_EPOCH_HPP
+
+#include "../rtt-config.h"
+#include "oro_arch.h"
+#include <vector>
+
+/**
+ * The number of times EpochPointer::publish() checks if the readers of
+ * a replaced object are gone before it postpones its reclamation.
+ */
+#ifndef ORONUM_EPOCH_RECLAIM_SPINS
+# define ORONUM_EPOCH_RECLAIM_SPINS 1000
+#endif
+
+namespace RTT
+{ namespace os {
+
+    /**
+     * Epoch based reclamation for data that is read very often and
+     * replaced rarely, such as the connection lists of a port.
+     *
+     * Readers enclose their accesses in an Epoch::Guard. Entering and
+     * leaving a guard only writes to a record owned by the calling thread,
+     * so concurrent readers never bounce a shared cache line and never
+     * execute an atomic read-modify-write. A writer that replaced a pointer
+     * calls advance() and may free the old data as soon as passed() returns
+     * true for the returned stamp.
+     *
+     * Guards may be nested. A writer may replace data while it is inside
+     * a guard itself, but that data is then only reclaimed after the writer
+     * left its guard, since it may still be reading it.
+     *
+     * @see EpochPointer
+     */
+    class RTT_API Epoch
+    {
+    public:
+        typedef unsigned long Stamp;
+
+        /**
+         * Marks a read-side critical section of the calling thread.
+         */
+        class RTT_API Guard
+        {
+        public:
+            Guard();
+            ~Guard();
+        private:
+            Guard(const Guard&);
+            Guard& operator=(const Guard&);
+            void* record;
+        };
+
+        /**
+         * Starts a new epoch.
+         * @return the stamp to pass to passed() for data that was
+         * unlinked before this call.
+         */
+        static Stamp advance();
+
+        /**
+         * Checks if all threads, including the calling one, left the read-side
+         * critical sections they were in when \a stamp was returned by advance().
+         * This function never blocks.
+         */
+        static bool passed(Stamp stamp);
+    };
+
+    /**
+     * A pointer to an immutable object which is replaced as a whole
+     * by publish() and read inside an Epoch::Guard.
+     *
+     * Writers must be serialised by the owner of the EpochPointer.
+     * Replaced objects are deleted as soon as no reader can access them
+     * anymore. If a reader is still busy after a short spin, the old object
+     * is kept until the next publish() or the destruction of this pointer,
+     * such that a writer never blocks on a reader.
+     */
+    template<class T>
+    class EpochPointer
+    {
+    public:
+        /**
+         * Takes ownership of \a initial.
+         */
+        explicit EpochPointer(T* initial = new T())
+            : current(initial)
+        {}
+
+        ~EpochPointer()
+        {
+            delete current;
+            for (typename Retired::iterator it = retired.begin(); it != retired.end(); ++it)
+                delete it->first;
+        }
+
+        /**
+         * Returns the current object. The result may only be used
+         * inside an Epoch::Guard, or by a writer.
+         */
+        const T& get() const { return *current; }
+
+        /**
+         * Replaces the current object by \a next, which must have been
+         * allocated with new. The previous object is reclaimed when all
+         * readers left it.
+         */
+        void publish(T* next)
+        {
+            T* old = current;
+            oro_mb();
+            current = next;
+            retired.push_back( std::make_pair(old, Epoch::advance()) );
+            reclaim();
+        }
+
+    private:
+        EpochPointer(const EpochPointer&);
+        EpochPointer& operator=(const EpochPointer&);
+
+        void reclaim()
+        {
+            typename Retired::iterator it = retired.begin();
+            for (unsigned int spins = 0; it != retired.end(); ) {
+                if (Epoch::passed(it->second)) {
+                    delete it->first;
+                    it = retired.erase(it);
+                } else if (++spins >= ORONUM_EPOCH_RECLAIM_SPINS) {
+                    break;
+                }
+            }
+        }
+
+        typedef std::vector< std::pair<T*, Epoch::Stamp> > Retired;
+        T* volatile current;
+        Retired retired;
+    };
+}}
+
+#endif
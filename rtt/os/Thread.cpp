@@ -135,8 +135,15 @@ namespace RTT {
                             if (task->period != 0) // periodic
                             {
                                 MutexLock lock(task->breaker);
+                                // the time at which the current period started.
+                                NANO_TIME period_start = rtos_get_time_ns();
+                                // after an overrun, period_start is only an estimate.
+                                bool overran = false;
                                 while(task->running && !task->prepareForExit )
                                 {
+                                    NANO_TIME step_start = rtos_get_time_ns();
+                                    if ( !overran )
+                                        task->mstatistics.latency.record( step_start - period_start );
                                     TRY
                                     (
                                         SCOPE_ON
@@ -148,6 +155,7 @@ namespace RTT {
                                         SCOPE_OFF
                                         throw;
                                     )
+                                    task->mstatistics.duration.record( rtos_get_time_ns() - step_start );
 
                                     // Check changes in period
                                     if ( cur_period != task->period) {
@@ -156,7 +164,13 @@ namespace RTT {
                                         cur_period = task->period;
                                         if (cur_period == 0)
                                             break; // break while(task->running) if no longer periodic
+                                        period_start = rtos_get_time_ns();
                                     }
+                                    else if (task->mwait_policy == ORO_WAIT_REL)
+                                        period_start = step_start;
+
+                                    // follow rtos_task_wait_period() to the start of the next period.
+                                    period_start += cur_period;
 
                                     // Check changes in scheduler
                                     if ( cur_sched != task->msched_type) {
@@ -166,8 +180,10 @@ namespace RTT {
                                     // rtos_task_wait_period will return immediately if
                                     // the task is not periodic (ie period == 0)
                                     // return non-zero to indicate overrun.
-                                    if (rtos_task_wait_period(task->getTask()) != 0)
+                                    overran = rtos_task_wait_period(task->getTask()) != 0;
+                                    if (overran)
                                     {
+                                        task->mstatistics.overruns.inc();
                                         ++overruns;
                                         if (overruns == task->maxOverRun)
                                             break; // break while(task->running)
@@ -251,7 +267,7 @@ namespace RTT {
 #ifdef OROPKG_OS_THREAD_SCOPE
         ,d(NULL)
 #endif
-                    , stopTimeout(0)
+                    , stopTimeout(0), mwait_policy(ORO_WAIT_ABS)
         {
             this->setup(_priority, cpu_affinity, name);
         }
@@ -660,6 +676,12 @@ namespace RTT {
         void Thread::setWaitPeriodPolicy(int p)
         {
             rtos_task_set_wait_period_policy(&rtos_task, p);  
+            mwait_policy = p;
+        }
+
+        ThreadStatistics* Thread::getStatistics()
+        {
+            return &mstatistics;
         }
 
     }
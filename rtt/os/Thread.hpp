@@ -44,6 +44,7 @@
 
 #include "ThreadInterface.hpp"
 #include "Mutex.hpp"
+#include "ThreadStatistics.hpp"
 
 #include <string>
 
@@ -242,6 +243,8 @@ namespace RTT
 
             virtual void setWaitPeriodPolicy(int p);
 
+            virtual ThreadStatistics* getStatistics();
+
         protected:
             /**
              * Exit and destroy the thread
@@ -356,6 +359,16 @@ namespace RTT
              */
             double stopTimeout;
 
+            /**
+             * The wait policy of the periodic loop, ORO_WAIT_ABS or ORO_WAIT_REL.
+             */
+            int mwait_policy;
+
+            /**
+             * The timing of the periodic loop.
+             */
+            ThreadStatistics mstatistics;
+
 #ifdef OROPKG_OS_THREAD_SCOPE
             // Pointer to Threadscope device
             dev::DigitalOutInterface * d;
@@ -55,6 +55,11 @@ ThreadInterface::~ThreadInterface()
     //threads.dec();
 }
 
+ThreadStatistics* ThreadInterface::getStatistics()
+{
+    return 0;
+}
+
 bool ThreadInterface::isSelf() const
 {
     return rtos_task_is_self( this->getTask() ) == 1;
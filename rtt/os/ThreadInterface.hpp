@@ -48,6 +48,8 @@ namespace RTT
 {
     namespace os
     {
+        class ThreadStatistics;
+
         /**
          * A thread which is being run.
          * The periodicity is the time between the starting
@@ -206,6 +208,13 @@ namespace RTT
              */
             virtual void setWaitPeriodPolicy(int p) = 0;
 
+            /**
+             * Returns the timing statistics of the periodic execution
+             * of this thread, which are recorded in each period.
+             * @return null if this thread does not record statistics.
+             */
+            virtual ThreadStatistics* getStatistics();
+
             /**
              * Yields (put to the back of the scheduler queue) the calling thread.
              */
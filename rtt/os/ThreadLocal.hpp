@@ -0,0 +1,116 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef RTT_OS_THREADLOCAL_HPP
+#define RTT_OS_THREADLOCAL_HPP
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace RTT
+{ namespace os {
+    /**
+     * A pointer which has a value per thread, initially null. When a thread
+     * exits which set a value that is not null, \a Release is called with it.
+     *
+     * On Windows this uses fiber local storage, which calls \a Release for
+     * exiting threads as well. Other targets use POSIX thread-specific data.
+     */
+    template<void (*Release)(void*)>
+    class ThreadLocal
+    {
+    public:
+        ThreadLocal()
+        {
+#ifdef _WIN32
+            key = FlsAlloc(&release);
+#else
+            pthread_key_create(&key, Release);
+#endif
+        }
+
+        /**
+         * Frees the key. \a Release is not called for threads which are still
+         * alive, except on Windows.
+         */
+        ~ThreadLocal()
+        {
+#ifdef _WIN32
+            FlsFree(key);
+#else
+            pthread_key_delete(key);
+#endif
+        }
+
+        /**
+         * Returns the value of the calling thread.
+         */
+        void* get() const
+        {
+#ifdef _WIN32
+            return FlsGetValue(key);
+#else
+            return pthread_getspecific(key);
+#endif
+        }
+
+        /**
+         * Sets the value of the calling thread.
+         */
+        void set(void* value)
+        {
+#ifdef _WIN32
+            FlsSetValue(key, value);
+#else
+            pthread_setspecific(key, value);
+#endif
+        }
+
+    private:
+        ThreadLocal(const ThreadLocal&);
+        ThreadLocal& operator=(const ThreadLocal&);
+
+#ifdef _WIN32
+        static void WINAPI release(PVOID value)
+        {
+            if ( value )
+                Release(value);
+        }
+        DWORD key;
+#else
+        pthread_key_t key;
+#endif
+    };
+}}
+
+#endif
@@ -0,0 +1,118 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "ThreadStatistics.hpp"
+#include <sstream>
+#include <cmath>
+
+using namespace RTT;
+using namespace RTT::os;
+
+const unsigned int TimingHistogram::Bins;
+
+unsigned int TimingHistogram::bin(nsecs duration)
+{
+    if ( duration < 8 )
+        return duration < 0 ? 0 : (unsigned int)duration;
+    // find the most significant bit of duration, which selects the
+    // group of 8 bins, and use the next 3 bits to select the bin in it.
+    unsigned long long value = duration;
+#ifdef __GNUC__
+    unsigned int msb = 63 - __builtin_clzll(value);
+#else
+    unsigned int msb = 3;
+    while ( value >> (msb + 1) )
+        ++msb;
+#endif
+    unsigned int result = (msb - 2) * 8 + ((value >> (msb - 3)) & 7);
+    return result < Bins ? result : Bins - 1;
+}
+
+nsecs TimingHistogram::lowerBound(unsigned int i)
+{
+    if ( i < 8 )
+        return i;
+    return nsecs(8 + i % 8) << (i / 8 - 1);
+}
+
+void TimingHistogram::record(nsecs duration)
+{
+    bins[ bin(duration) ].inc();
+}
+
+void TimingHistogram::reset()
+{
+    for (unsigned int i = 0; i != Bins; ++i)
+        bins[i].set(0);
+}
+
+int TimingHistogram::count() const
+{
+    int total = 0;
+    for (unsigned int i = 0; i != Bins; ++i)
+        total += bins[i].read();
+    return total;
+}
+
+nsecs TimingHistogram::percentile(double percent) const
+{
+    int total = count();
+    if ( total == 0 )
+        return 0;
+    double target = std::ceil( percent / 100.0 * total );
+    int cumulative = 0;
+    for (unsigned int i = 0; i != Bins - 1; ++i) {
+        cumulative += bins[i].read();
+        if ( cumulative >= target && cumulative != 0 )
+            return lowerBound(i + 1);
+    }
+    return lowerBound(Bins - 1);
+}
+
+void ThreadStatistics::reset()
+{
+    latency.reset();
+    duration.reset();
+    overruns.set(0);
+}
+
+std::string ThreadStatistics::report() const
+{
+    std::ostringstream result;
+    result << "periods: " << duration.count()
+           << " overruns: " << overruns.read()
+           << " latency p50/p99/p99.9: " << latency.percentile(50) / 1000.0
+           << "/" << latency.percentile(99) / 1000.0
+           << "/" << latency.percentile(99.9) / 1000.0 << "us"
+           << " duration p50/p99/p99.9: " << duration.percentile(50) / 1000.0
+           << "/" << duration.percentile(99) / 1000.0
+           << "/" << duration.percentile(99.9) / 1000.0 << "us";
+    return result.str();
+}
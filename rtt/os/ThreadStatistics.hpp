@@ -0,0 +1,142 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef ORO_OS_THREAD_STATISTICS_HPP
+#define ORO_OS_THREAD_STATISTICS_HPP
+
+#include "../rtt-config.h"
+#include "Atomic.hpp"
+#include "Time.hpp"
+#include <string>
+
+namespace RTT
+{ namespace os {
+
+    /**
+     * A histogram of durations, in nanoseconds, with a fixed number of
+     * bins. The width of the bins grows with the duration, such that each
+     * recorded value is known up to 1/8th (12.5%) of its value, from
+     * nanoseconds up to about half an hour.
+     *
+     * record() is lock-free, does not allocate memory and takes a few
+     * tens of nanoseconds. The statistics may be read from any thread
+     * while values are recorded.
+     */
+    class RTT_API TimingHistogram
+    {
+    public:
+        /**
+         * The number of bins of the histogram.
+         */
+        static const unsigned int Bins = 312;
+
+        /**
+         * Adds \a duration to the histogram. Negative durations count as zero.
+         * @rt
+         */
+        void record(nsecs duration);
+
+        /**
+         * Sets all bins to zero.
+         */
+        void reset();
+
+        /**
+         * Returns the number of recorded durations.
+         */
+        int count() const;
+
+        /**
+         * Returns the duration below which \a percent percent of the
+         * recorded durations are, for example 99.9 for the 99.9th percentile.
+         * The result is rounded up to the upper bound of its bin.
+         * @return zero if no durations were recorded.
+         */
+        nsecs percentile(double percent) const;
+
+        /**
+         * Returns the number of recorded durations in bin \a i.
+         */
+        int getBin(unsigned int i) const { return i < Bins ? bins[i].read() : 0; }
+
+        /**
+         * Returns the smallest duration which is counted in bin \a i.
+         */
+        static nsecs lowerBound(unsigned int i);
+
+        /**
+         * Returns the bin in which \a duration is counted.
+         */
+        static unsigned int bin(nsecs duration);
+    private:
+        AtomicInt bins[Bins];
+    };
+
+    /**
+     * The timing of the periodic loop of a Thread: how late it woke up
+     * with respect to its period, how long step() took and how many
+     * periods were overrun. These are recorded for each period
+     * while the thread runs periodically.
+     * @see ThreadInterface::getStatistics()
+     */
+    class RTT_API ThreadStatistics
+    {
+    public:
+        /**
+         * The time between the start of a period and the start of step().
+         * A Thread only knows the start of a period which follows an
+         * overrun approximately, so it records no latency for that period.
+         */
+        TimingHistogram latency;
+
+        /**
+         * The time it took to execute step().
+         */
+        TimingHistogram duration;
+
+        /**
+         * The number of periods in which step() did not finish in time.
+         */
+        AtomicInt overruns;
+
+        /**
+         * Sets all statistics to zero.
+         */
+        void reset();
+
+        /**
+         * Returns a one-line summary of the statistics, with the median,
+         * 99th and 99.9th percentiles of the latency and duration, in microseconds.
+         */
+        std::string report() const;
+    };
+}}
+
+#endif
@@ -62,67 +62,138 @@ namespace RTT {
     {
         // This code is executed from mThread's thread
         while (!mdo_quit) {
-            Time wake_up_time;
-            TimerId next_timer_id = 0;
-
             // Select next timer.
             int ret = 0;
             {// This scope is for MutexLock.
-                // find wake_up_time
-                // check timers queue.
+                // the next timer to expire is at the front of the queue.
                 MutexLock locker(mmutex);
-                wake_up_time = std::numeric_limits<Time>::max();
-                for (TimerIds::iterator it = mtimers.begin(); it != mtimers.end(); ++it) {
-                    if ( it->expires != 0 && it->expires < wake_up_time  ) {
-                        wake_up_time = it->expires;
-                        next_timer_id = it - mtimers.begin();
-                    }
-                }
 
                 // Wait
-                if ( wake_up_time == std::numeric_limits<Time>::max() )
+                if ( mqueue.empty() )
                     ret = mcond.wait( mmutex ); // case of no timers
-                else if ( wake_up_time > rtos_get_time_ns() )
-                    ret = mcond.wait_until( mmutex, wake_up_time ); // case of running timers
+                else if ( mtimers[ mqueue.front() ].expires > rtos_get_time_ns() )
+                    ret = mcond.wait_until( mmutex, mtimers[ mqueue.front() ].expires ); // case of running timers
                 else
                     ret = -1; // case of timer overrun.
-            }// MutexLock
 
-            // Timeout handling
-            if (ret == -1) {
-                // a timer expired
-                // expires: reset/reprogram the timer that expired:
-                {
-                    MutexLock locker(mmutex);
-                    // detect corner case for resize:
-                    if ( next_timer_id < int(mtimers.size()) ) {
-                        // now clear or reprogram it.
-                        TimerIds::iterator tim = mtimers.begin() + next_timer_id;
-                        if ( tim->period ) {
+                // Timeout handling
+                if (ret == -1) {
+                    // collect all timers that expired and reset/reprogram
+                    // them. A single batch never fires more timeouts than
+                    // there are timers, such that a late periodic timer
+                    // can not starve the others.
+                    if ( mexpired.capacity() < mtimers.size() )
+                        mexpired.reserve( mtimers.size() );
+                    mexpired.clear();
+                    Time now = rtos_get_time_ns();
+                    while ( !mqueue.empty() && mexpired.size() < mtimers.size()
+                            && mtimers[ mqueue.front() ].expires <= now ) {
+                        TimerId timer_id = mqueue.front();
+                        TimerInfo& tim = mtimers[timer_id];
+                        if ( tim.period ) {
                             // periodic timer
-                            tim->expires += tim->period;
+                            schedule( timer_id, tim.expires + tim.period );
                         } else {
                             // aperiodic timer
-                            tim->expires = 0;
+                            unschedule( timer_id );
                         }
+                        // notify waiting threads
+                        tim.expired.broadcast();
+                        mexpired.push_back( std::make_pair(timer_id, tim.sequence) );
                     }
                 }
+            }// MutexLock
 
-                // Second: notify waiting threads
-                {// This scope is for MutexLock.
-                    MutexLock locker(mmutex);
-                    mtimers[next_timer_id].expired.broadcast();
-                }// MutexLock
-
-                // Third: send the timeout signal and allow (within the callback)
-                // to reprogram the timer.
-                // If we would expires call timeout(), the code above would overwrite
-                // user settings.
-                timeout( next_timer_id );
+            // Send the timeout signals and allow (within the callback)
+            // to reprogram the timer.
+            // If we would expires call timeout(), the code above would overwrite
+            // user settings.
+            if (ret == -1) {
+                for (std::vector< std::pair<TimerId, unsigned int> >::const_iterator it = mexpired.begin(); it != mexpired.end(); ++it) {
+                    {
+                        // skip timers which an earlier timeout() of this batch armed again or killed.
+                        MutexLock locker(mmutex);
+                        if ( it->first >= (int) mtimers.size() || mtimers[it->first].sequence != it->second )
+                            continue;
+                    }
+                    timeout( it->first );
+                }
             }
         }
     }
 
+    void Timer::schedule(TimerId timer_id, Time expires)
+    {
+        TimerInfo& tim = mtimers[timer_id];
+        if ( tim.position < 0 ) {
+            tim.expires = expires;
+            tim.position = mqueue.size();
+            mqueue.push_back( timer_id );
+            siftUp( tim.position );
+        } else {
+            bool earlier = expires < tim.expires;
+            tim.expires = expires;
+            if ( earlier )
+                siftUp( tim.position );
+            else
+                siftDown( tim.position );
+        }
+    }
+
+    void Timer::unschedule(TimerId timer_id)
+    {
+        TimerInfo& tim = mtimers[timer_id];
+        tim.expires = 0;
+        if ( tim.position < 0 )
+            return;
+        std::size_t pos = tim.position;
+        tim.position = -1;
+        TimerId last = mqueue.back();
+        mqueue.pop_back();
+        if ( pos < mqueue.size() ) {
+            // move the last timer into the hole and restore the heap.
+            mqueue[pos] = last;
+            mtimers[last].position = pos;
+            siftDown( pos );
+            siftUp( mtimers[last].position );
+        }
+    }
+
+    void Timer::siftUp(std::size_t pos)
+    {
+        TimerId timer_id = mqueue[pos];
+        while ( pos > 0 ) {
+            std::size_t parent = (pos - 1) / 2;
+            if ( mtimers[ mqueue[parent] ].expires <= mtimers[timer_id].expires )
+                break;
+            mqueue[pos] = mqueue[parent];
+            mtimers[ mqueue[pos] ].position = pos;
+            pos = parent;
+        }
+        mqueue[pos] = timer_id;
+        mtimers[timer_id].position = pos;
+    }
+
+    void Timer::siftDown(std::size_t pos)
+    {
+        TimerId timer_id = mqueue[pos];
+        std::size_t size = mqueue.size();
+        for (;;) {
+            std::size_t child = 2 * pos + 1;
+            if ( child >= size )
+                break;
+            if ( child + 1 < size && mtimers[ mqueue[child + 1] ].expires < mtimers[ mqueue[child] ].expires )
+                ++child;
+            if ( mtimers[timer_id].expires <= mtimers[ mqueue[child] ].expires )
+                break;
+            mqueue[pos] = mqueue[child];
+            mtimers[ mqueue[pos] ].position = pos;
+            pos = child;
+        }
+        mqueue[pos] = timer_id;
+        mtimers[timer_id].position = pos;
+    }
+
     bool Timer::breakLoop()
     {
         mdo_quit = true;
@@ -138,6 +209,8 @@ namespace RTT {
         : mThread(0), mdo_quit(false)
     {
         mtimers.resize(max_timers);
+        mqueue.reserve(max_timers);
+        mexpired.reserve(max_timers);
         if (scheduler != -1) {
             mThread = new Activity(scheduler, priority, 0.0, this, name);
             mThread->start();
@@ -158,7 +231,11 @@ namespace RTT {
     void Timer::setMaxTimers(TimerId max)
     {
         MutexLock locker(mmutex);
+        // drop the timers that are removed from the queue.
+        for (TimerId i = max; i < (int) mtimers.size(); ++i)
+            unschedule(i);
         mtimers.resize(max, TimerInfo() );
+        mqueue.reserve(max);
     }
 
     bool Timer::startTimer(TimerId timer_id, double period)
@@ -173,8 +250,9 @@ namespace RTT {
 
         {
             MutexLock locker(mmutex);
-            mtimers[timer_id].expires = due_time;
+            schedule( timer_id, due_time );
             mtimers[timer_id].period = Seconds_to_nsecs( period );
+            ++mtimers[timer_id].sequence;
         }
         mcond.broadcast();
         return true;
@@ -193,8 +271,9 @@ namespace RTT {
 
         {
             MutexLock locker(mmutex);
-            mtimers[timer_id].expires  = due_time;
+            schedule( timer_id, due_time );
             mtimers[timer_id].period = 0;
+            ++mtimers[timer_id].sequence;
         }
         mcond.broadcast();
         return true;
@@ -235,8 +314,9 @@ namespace RTT {
             log(Error) << "Invalid timer id" << endlog();
             return false;
         }
-        mtimers[timer_id].expires = 0;
+        unschedule( timer_id );
         mtimers[timer_id].period = 0;
+        ++mtimers[timer_id].sequence;
         mtimers[timer_id].expired.broadcast();
         return true;
     }
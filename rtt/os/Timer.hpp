@@ -81,11 +81,13 @@ namespace RTT
 
         struct TimerInfo
         {
-            TimerInfo() : expires(0), period(0) {}
+            TimerInfo() : expires(0), period(0), position(-1), sequence(0) {}
             TimerInfo(const TimerInfo& other) { *this = other; }
-            TimerInfo& operator=(const TimerInfo& other) { this->expires = other.expires; this->period = other.period; return *this; }
+            TimerInfo& operator=(const TimerInfo& other) { this->expires = other.expires; this->period = other.period; this->position = other.position; this->sequence = other.sequence; return *this; }
             Time expires; // was .first
             Time period;  // was .second
+            int position; // index in mqueue, -1 if not armed
+            unsigned int sequence; // incremented each time the timer is armed or killed
             Condition expired;
         };
 
@@ -96,8 +98,40 @@ namespace RTT
          */
         typedef std::vector<TimerInfo> TimerIds;
         TimerIds mtimers;
+
+        /**
+         * A binary min-heap of the ids of all armed timers, ordered
+         * on their expiry time. Each armed timer keeps its index in
+         * this heap in TimerInfo::position, such that arming, re-arming
+         * and killing a timer costs O(log n) and the next timer to
+         * expire is always found at the front.
+         */
+        std::vector<TimerId> mqueue;
+
+        /**
+         * The timers which expired in the current loop iteration, with
+         * their TimerInfo::sequence at that moment. A timer whose sequence
+         * changed before its timeout() is called was armed again or killed
+         * meanwhile, and is skipped. Only accessed from within loop().
+         */
+        std::vector< std::pair<TimerId, unsigned int> > mexpired;
         bool mdo_quit;
 
+        /**
+         * (Re-)inserts \a timer_id in mqueue with expiry time \a expires.
+         * mmutex must be locked.
+         */
+        void schedule(TimerId timer_id, Time expires);
+
+        /**
+         * Removes \a timer_id from mqueue and clears its expiry time.
+         * mmutex must be locked.
+         */
+        void unschedule(TimerId timer_id);
+
+        void siftUp(std::size_t pos);
+        void siftDown(std::size_t pos);
+
         bool initialize();
         void finalize();
         void step();
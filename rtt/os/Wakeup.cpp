@@ -0,0 +1,141 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "Wakeup.hpp"
+#include "CAS.hpp"
+#include "oro_arch.h"
+
+#ifdef OROPKG_OS_GNULINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <ctime>
+#else
+#include "MutexLock.hpp"
+#endif
+
+namespace RTT
+{ namespace os {
+
+#ifdef OROPKG_OS_GNULINUX
+    static inline void futex_wait(volatile int* addr, int value, const struct timespec* timeout)
+    {
+        syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, timeout, 0, 0);
+    }
+
+    static inline void futex_wake(volatile int* addr)
+    {
+        syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, 0, 0, 0);
+    }
+#endif
+
+    Wakeup::Wakeup()
+        : mstate(Clear)
+    {
+    }
+
+    Wakeup::~Wakeup()
+    {
+    }
+
+    bool Wakeup::signal()
+    {
+        // The caller's writes must be visible before the flag is found set,
+        // or the waiter may clear it and miss them without being woken up.
+        oro_mb();
+        if ( mstate == Set )
+            return false;
+        int old;
+        do {
+            old = mstate;
+        } while ( !CAS(&mstate, old, Set) );
+        if ( old == Waiting ) {
+#ifdef OROPKG_OS_GNULINUX
+            futex_wake(&mstate);
+#else
+            // the waiter holds the lock until it blocks.
+            MutexLock lock(mlock);
+            mcond.broadcast();
+#endif
+        }
+        return old != Set;
+    }
+
+    void Wakeup::wait()
+    {
+        wait_until(0);
+    }
+
+    bool Wakeup::trywait()
+    {
+        return CAS(&mstate, Set, Clear);
+    }
+
+    bool Wakeup::wait_until(nsecs abs_time)
+    {
+        while ( true ) {
+            int state = mstate;
+            if ( state == Set ) {
+                if ( CAS(&mstate, Set, Clear) )
+                    return true;
+                continue;
+            }
+            if ( state == Clear && !CAS(&mstate, Clear, Waiting) )
+                continue;
+
+            // mstate is Waiting until signal() sets it.
+#ifdef OROPKG_OS_GNULINUX
+            if ( abs_time == 0 ) {
+                futex_wait(&mstate, Waiting, 0);
+                continue;
+            }
+            nsecs timeout = abs_time - rtos_get_time_ns();
+            if ( timeout <= 0 ) {
+                if ( CAS(&mstate, Waiting, Clear) )
+                    return false;
+                continue;
+            }
+            struct timespec ts;
+            ts.tv_sec = timeout / 1000000000LL;
+            ts.tv_nsec = timeout % 1000000000LL;
+            futex_wait(&mstate, Waiting, &ts);
+#else
+            MutexLock lock(mlock);
+            if ( mstate != Waiting )
+                continue;
+            if ( abs_time == 0 )
+                mcond.wait(mlock);
+            else if ( !mcond.wait_until(mlock, abs_time) && CAS(&mstate, Waiting, Clear) )
+                return false;
+#endif
+        }
+    }
+}}
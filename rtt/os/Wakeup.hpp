@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef RTT_OS_WAKEUP_HPP
+#define RTT_OS_WAKEUP_HPP
+
+#include "fosi.h"
+#include "../rtt-config.h"
+#include "../Time.hpp"
+#ifndef OROPKG_OS_GNULINUX
+#include "Mutex.hpp"
+#include "Condition.hpp"
+#endif
+
+namespace RTT
+{ namespace os {
+    /**
+     * A flag which one thread waits for and other threads set.
+     * Setting a flag which is set already has no effect, such that many
+     * signal() calls before a wait() wake up the waiting thread only once.
+     *
+     * The flag is a single atomic word. signal() always issues a full memory
+     * barrier, sets the flag with a compare-and-swap when it is not set yet,
+     * and only enters the kernel when a thread is blocked in wait(). On
+     * GNU/Linux, the waiting thread blocks on a futex of this word. Other
+     * targets use a Mutex and Condition for blocking.
+     */
+    class RTT_API Wakeup
+    {
+    public:
+        Wakeup();
+
+        ~Wakeup();
+
+        /**
+         * Sets the flag and wakes up the waiting thread, if any.
+         * @return false if the flag was set already.
+         */
+        bool signal();
+
+        /**
+         * Waits until the flag is set, and clears it.
+         */
+        void wait();
+
+        /**
+         * Waits until the flag is set, but not longer than
+         * the absolute time \a abs_time, and clears it.
+         * @return true if the flag was set, false if the time passed.
+         */
+        bool wait_until(nsecs abs_time);
+
+        /**
+         * Clears the flag without waiting.
+         * @return true if the flag was set.
+         */
+        bool trywait();
+
+    private:
+        Wakeup(const Wakeup&);
+
+        static const int Clear = 0;
+        static const int Set = 1;
+        static const int Waiting = 2;
+
+        /** Clear, Set or Waiting. */
+        volatile int mstate;
+#ifndef OROPKG_OS_GNULINUX
+        Mutex mlock;
+        Condition mcond;
+#endif
+    };
+}}
+
+#endif
@@ -154,4 +154,10 @@ int oro_atomic_inc_and_test(oro_atomic_t *a);
 int oro_cmpxchg(void volatile* ptr, unsigned long o, unsigned long n);
 
 
+/**
+ * A full memory barrier: no load or store is moved across it,
+ * neither by the compiler nor by the processor.
+ */
+void oro_mb(void);
+
 #endif // __ORO_ARCH_INTERFACE__
@@ -151,5 +151,10 @@ static __inline__ int oro_atomic_inc_and_test(oro_atomic_t *a_int)
 #define oro_cmpxchg(ptr,o,n)\
     (__sync_val_compare_and_swap((ptr),(o),(n)))
 
+/**
+ * A full memory barrier.
+ */
+#define oro_mb() __sync_synchronize()
+
 
 #endif // __GCC_ORO_ARCH__
@@ -174,6 +174,8 @@ static inline unsigned long __oro_cmpxchg(volatile void *ptr, unsigned long old,
     ((__typeof__(*(ptr)))__oro_cmpxchg((ptr),(unsigned long)(o),\
                     (unsigned long)(n),sizeof(*(ptr))))
 
+#define oro_mb() __asm__ __volatile__("lock; addl $0,0(%%esp)":::"memory")
+
 #undef ORO_LOCK
 #undef ORO_LOCK_PREFIX
 #endif
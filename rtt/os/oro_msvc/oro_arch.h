@@ -124,6 +124,8 @@ static __forceinline int oro_atomic_set_mask(oro_atomic_t *a_int, int mask)
 	return _InterlockedOr((long *)a_int, mask);
 }
 
+#define oro_mb() MemoryBarrier()
+
 #pragma warning(push)
 #pragma warning(disable : 4715) // Disable warning on "specified function can potentially not return a value"
 
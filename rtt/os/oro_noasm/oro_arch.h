@@ -144,4 +144,14 @@ static __inline__ int oro_atomic_inc_and_test(oro_atomic_t *a_int)
   return ret;
 }
 
+/**
+ * A full memory barrier, which is not available without assembly
+ * on compilers other than GCC.
+ */
+#ifdef __GNUC__
+#define oro_mb() __sync_synchronize()
+#else
+#define oro_mb()
+#endif
+
 #endif
@@ -56,8 +56,11 @@ namespace RTT {
         class StartStopManager;
         class Thread;
         class ThreadInterface;
+        class ThreadStatistics;
         class TimeService;
         class Timer;
+        class TimingHistogram;
+        class Wakeup;
         struct CleanupFunction;
         struct InitFunction;
     }
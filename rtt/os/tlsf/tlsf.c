@@ -76,6 +76,11 @@
 #define	USE_SBRK 	(0)
 #endif
 
+/* USE_ARENAS gives each thread its own memory pool, see tlsf_malloc() */
+#ifndef USE_ARENAS
+#define	USE_ARENAS 	(0)
+#endif
+
 
 #if TLSF_USE_LOCKS
 #include "target.h"
@@ -105,6 +110,11 @@
 #include <unistd.h>
 #endif
 
+#if USE_ARENAS
+#include <pthread.h>
+static void arena_destroy_all(void);
+#endif
+
 #if USE_MMAP
 #include <sys/mman.h>
 
@@ -426,7 +436,24 @@ static __inline__ void corrupt(const char *msg) {
 	} while(0)
 
 #if USE_SBRK || USE_MMAP
+#if USE_ARENAS
+/* The pools of several threads may grow at the same time. */
+static pthread_mutex_t area_lock = PTHREAD_MUTEX_INITIALIZER;
+static __inline__ void *get_system_area(size_t * size);
+
+static __inline__ void *get_new_area(size_t * size)
+{
+    void *area;
+    pthread_mutex_lock(&area_lock);
+    area = get_system_area(size);
+    pthread_mutex_unlock(&area_lock);
+    return area;
+}
+
+static __inline__ void *get_system_area(size_t * size)
+#else
 static __inline__ void *get_new_area(size_t * size)
+#endif
 {
     void *area;
 
@@ -474,12 +501,14 @@ static __inline__ bhdr_t *process_area(void *area, size_t size)
 
 static char *mp = NULL;         /* Default memory pool. */
 
+static size_t init_pool(size_t mem_pool_size, void *mem_pool);
+
 /******************************************************************/
 size_t init_memory_pool(size_t mem_pool_size, void *mem_pool)
 {
 /******************************************************************/
     tlsf_t *tlsf;
-    bhdr_t *b, *ib;
+    bhdr_t *b;
 
     if (!mem_pool || !mem_pool_size || mem_pool_size < sizeof(tlsf_t) + BHDR_OVERHEAD * 8) {
         ERROR_MSG("init_memory_pool (): memory_pool invalid\n");
@@ -500,6 +529,16 @@ size_t init_memory_pool(size_t mem_pool_size, void *mem_pool)
     if(mp == 0)
         mp = mem_pool;
 
+    return init_pool(mem_pool_size, mem_pool);
+}
+
+/******************************************************************/
+static size_t init_pool(size_t mem_pool_size, void *mem_pool)
+{
+/******************************************************************/
+    tlsf_t *tlsf = (tlsf_t *) mem_pool;
+    bhdr_t *b, *ib;
+
     /* Zeroing the memory pool */
     memset(mem_pool, 0, sizeof(tlsf_t));
 
@@ -651,6 +690,9 @@ void destroy_memory_pool(void *mem_pool)
 {
 /******************************************************************/
     if((void*)mp == (void*)mem_pool){
+#if USE_ARENAS
+        arena_destroy_all();
+#endif
         mp = 0;
     }
 
@@ -662,7 +704,11 @@ void destroy_memory_pool(void *mem_pool)
 
 
 /******************************************************************/
+#if USE_ARENAS
+static void *pool_malloc(size_t size)
+#else
 void *tlsf_malloc(size_t size)
+#endif
 {
 /******************************************************************/
     void *ret;
@@ -691,7 +737,11 @@ void *tlsf_malloc(size_t size)
 }
 
 /******************************************************************/
+#if USE_ARENAS
+static void pool_free(void *ptr)
+#else
 void tlsf_free(void *ptr)
+#endif
 {
 /******************************************************************/
 
@@ -703,6 +753,7 @@ void tlsf_free(void *ptr)
 
 }
 
+#if !USE_ARENAS
 /******************************************************************/
 void *tlsf_realloc(void *ptr, size_t size)
 {
@@ -739,6 +790,305 @@ void *tlsf_calloc(size_t nelem, size_t elem_size)
     return ret;
 }
 
+#endif /* !USE_ARENAS */
+
+#if USE_ARENAS
+/*
+ * Each thread allocates from an arena, a memory pool of its own, such
+ * that real-time threads do not contend on the lock of the default pool.
+ * Each block starts with a header which records its arena. A block freed
+ * by another thread is pushed on the lock-free 'remote' list of its
+ * arena and only returned to the pool by the thread which owns it, the
+ * next time that thread allocates or frees. The arena of a thread which
+ * exits is adopted by the next thread which needs one; blocks freed into
+ * it meanwhile are only reclaimed once it is adopted. Arenas are carved
+ * from the default pool and returned to it by destroy_memory_pool().
+ * When an arena can not be created or is exhausted, the block is
+ * allocated from the default pool instead.
+ *
+ * The statistics of the default pool, such as get_used_size_mp(), count
+ * each arena as one block of ARENA_AREA_SIZE, not the blocks allocated
+ * from it; see get_arena_statistics() for these.
+ */
+
+#ifndef ARENA_AREA_SIZE
+#define ARENA_AREA_SIZE (1024*64)
+#endif
+
+typedef struct arena_struct arena_t;
+
+typedef struct arena_hdr_struct {
+    /* the arena of the block, NULL for the default pool */
+    arena_t *arena;
+    /* the next block in the remote list of the arena */
+    struct arena_hdr_struct *next;
+} arena_hdr_t;
+
+struct arena_struct {
+    void *pool;
+    arena_hdr_t *volatile remote;
+    /* 0 if the thread which owned this arena exited */
+    volatile int owned;
+    arena_t *next;
+};
+
+#define ARENA_HDR_SIZE (ROUNDUP_SIZE(sizeof(arena_hdr_t)))
+
+/* All arenas, only prepended to until the default pool is destroyed. */
+static arena_t *volatile arenas = NULL;
+/* Incremented when the arenas are returned to the default pool. */
+static volatile unsigned int arena_generation = 0;
+static __thread arena_t *current_arena = NULL;
+static __thread unsigned int current_generation = 0;
+static pthread_key_t arena_key;
+static pthread_once_t arena_once = PTHREAD_ONCE_INIT;
+
+/* Returns the arena of the calling thread, or NULL if it has none. */
+static __inline__ arena_t *arena_current(void)
+{
+    arena_t *arena = current_arena;
+
+    if (arena && current_generation == arena_generation && arena->owned)
+        return arena;
+    return NULL;
+}
+
+static void arena_release(void *arena)
+{
+    /* later destructors of this thread must not use the arena anymore. */
+    current_arena = NULL;
+    if (current_generation != arena_generation)
+        return;
+    __sync_synchronize();
+    ((arena_t *) arena)->owned = 0;
+}
+
+/* Returns all arenas to the default pool, which is about to be destroyed. */
+static void arena_destroy_all(void)
+{
+    arena_t *arena, *next;
+
+    arena = __sync_lock_test_and_set(&arenas, NULL);
+    __sync_fetch_and_add(&arena_generation, 1);
+    while (arena) {
+        next = arena->next;
+        pool_free(arena);
+        arena = next;
+    }
+}
+
+static void arena_key_create(void)
+{
+    pthread_key_create(&arena_key, arena_release);
+}
+
+/* Returns the blocks freed by other threads to the pool of arena. */
+static __inline__ void arena_collect(arena_t * arena)
+{
+    arena_hdr_t *h, *next;
+
+    if (!arena->remote)
+        return;
+    h = __sync_lock_test_and_set(&arena->remote, NULL);
+    while (h) {
+        next = h->next;
+        free_ex(h, arena->pool);
+        h = next;
+    }
+}
+
+static arena_t *arena_create(void)
+{
+    arena_t *arena;
+    void *area;
+    size_t area_size = ARENA_AREA_SIZE;
+
+    pthread_once(&arena_once, arena_key_create);
+
+    /* Adopt the arena of a thread which exited. */
+    for (arena = arenas; arena; arena = arena->next)
+        if (!arena->owned && __sync_bool_compare_and_swap(&arena->owned, 0, 1))
+            break;
+
+    if (!arena) {
+#if !(USE_MMAP || USE_SBRK)
+        if (!mp)
+            return NULL;
+#endif
+        area = pool_malloc(area_size);
+        if (!area)
+            return NULL;
+        arena = (arena_t *) area;
+        arena->pool = (char *) area + ROUNDUP_SIZE(sizeof(arena_t));
+        init_pool(ROUNDDOWN_SIZE(area_size - ROUNDUP_SIZE(sizeof(arena_t))), arena->pool);
+        arena->remote = NULL;
+        arena->owned = 1;
+        do {
+            arena->next = arenas;
+        } while (!__sync_bool_compare_and_swap(&arenas, arena->next, arena));
+    }
+
+    pthread_setspecific(arena_key, arena);
+    current_arena = arena;
+    current_generation = arena_generation;
+    return arena;
+}
+
+/******************************************************************/
+void *tlsf_malloc(size_t size)
+{
+/******************************************************************/
+    arena_t *arena = arena_current();
+    arena_hdr_t *h = NULL;
+
+    if (!arena)
+        arena = arena_create();
+    if (arena) {
+        arena_collect(arena);
+        h = (arena_hdr_t *) malloc_ex(size + ARENA_HDR_SIZE, arena->pool);
+    }
+    if (!h) {
+        arena = NULL;
+        h = (arena_hdr_t *) pool_malloc(size + ARENA_HDR_SIZE);
+        if (!h)
+            return NULL;
+    }
+    h->arena = arena;
+    return (char *) h + ARENA_HDR_SIZE;
+}
+
+/******************************************************************/
+void tlsf_free(void *ptr)
+{
+/******************************************************************/
+    arena_hdr_t *h, *head;
+    arena_t *arena;
+    bhdr_t *b;
+
+    if (!ptr)
+        return;
+
+    h = (arena_hdr_t *) ((char *) ptr - ARENA_HDR_SIZE);
+    b = (bhdr_t *) ((char *) h - BHDR_OVERHEAD);
+    if ((b->size & BLOCK_STATE) != USED_BLOCK)
+        corrupt("tlsf_free(): Freeing unused block\n");
+
+    arena = h->arena;
+    if (!arena) {
+        pool_free(h);
+    } else if (arena == arena_current()) {
+        free_ex(h, arena->pool);
+        arena_collect(arena);
+    } else {
+        do {
+            head = arena->remote;
+            h->next = head;
+        } while (!__sync_bool_compare_and_swap(&arena->remote, head, h));
+    }
+}
+
+/******************************************************************/
+void *tlsf_realloc(void *ptr, size_t size)
+{
+/******************************************************************/
+    bhdr_t *b;
+    size_t old_size;
+    void *ret;
+
+    if (!ptr)
+        return tlsf_malloc(size);
+    if (!size) {
+        tlsf_free(ptr);
+        return NULL;
+    }
+
+    b = (bhdr_t *) ((char *) ptr - ARENA_HDR_SIZE - BHDR_OVERHEAD);
+    old_size = (b->size & BLOCK_SIZE) - ARENA_HDR_SIZE;
+    if (size <= old_size)
+        return ptr;
+
+    ret = tlsf_malloc(size);
+    if (ret) {
+        memcpy(ret, ptr, old_size);
+        tlsf_free(ptr);
+    }
+    return ret;
+}
+
+/******************************************************************/
+void *tlsf_calloc(size_t nelem, size_t elem_size)
+{
+/******************************************************************/
+    void *ret;
+
+    if (elem_size && nelem > ((size_t) -1) / elem_size)
+        return NULL;
+
+    ret = tlsf_malloc(nelem * elem_size);
+    if (ret)
+        memset(ret, 0, nelem * elem_size);
+    return ret;
+}
+
+/******************************************************************/
+size_t get_used_size_arena()
+{
+/******************************************************************/
+    arena_t *arena = arena_current();
+
+    return arena ? get_used_size(arena->pool) : 0;
+}
+
+/******************************************************************/
+size_t get_max_size_arena()
+{
+/******************************************************************/
+    arena_t *arena = arena_current();
+
+    return arena ? get_max_size(arena->pool) : 0;
+}
+
+/******************************************************************/
+int get_arena_statistics(size_t *used_size, size_t *max_size, int n)
+{
+/******************************************************************/
+    arena_t *arena;
+    int i = 0;
+
+    for (arena = arenas; arena; arena = arena->next, ++i) {
+        if (i < n) {
+            used_size[i] = get_used_size(arena->pool);
+            max_size[i] = get_max_size(arena->pool);
+        }
+    }
+    return i;
+}
+
+#else
+
+/******************************************************************/
+size_t get_used_size_arena()
+{
+/******************************************************************/
+    return 0;
+}
+
+/******************************************************************/
+size_t get_max_size_arena()
+{
+/******************************************************************/
+    return 0;
+}
+
+/******************************************************************/
+int get_arena_statistics(size_t *used_size, size_t *max_size, int n)
+{
+/******************************************************************/
+    return 0;
+}
+
+#endif /* USE_ARENAS */
+
 /******************************************************************/
 void *malloc_ex(size_t size, void *mem_pool)
 {
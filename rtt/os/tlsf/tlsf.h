@@ -44,6 +44,13 @@ extern void *malloc_ex(size_t, void *);
 extern void free_ex(void *, void *);
 extern void *realloc_ex(void *, size_t, void *);
 extern void *calloc_ex(size_t, size_t, void *);
+/* The current and maximum used size of the arena of the calling thread.
+ * get_used_size_mp() counts each arena as a whole, not the blocks in it. */
+extern size_t get_used_size_arena();
+extern size_t get_max_size_arena();
+/* Fills in the current and maximum used size of up to n arenas
+ * and returns the number of arenas. */
+extern int get_arena_statistics(size_t *used_size, size_t *max_size, int n);
 #endif
 
 extern void *tlsf_malloc(size_t size);
@@ -51,6 +51,8 @@
 #include "../os/StartStopManager.hpp"
 #include "../os/MutexLock.hpp"
 #include "../internal/GlobalService.hpp"
+#include "../internal/ConnectionStatisticsService.hpp"
+#include "../internal/ThreadStatisticsService.hpp"
 
 #include <cstdlib>
 #include <dlfcn.h>
@@ -309,7 +311,24 @@ namespace {
 
 static boost::shared_ptr<PluginLoader> instance2;
 
-PluginLoader::PluginLoader() {}
+namespace {
+    bool loadConnectionStatistics(TaskContext* tc)
+    {
+        return internal::ConnectionStatisticsService::Create(tc).get() != 0;
+    }
+
+    bool loadThreadStatistics(TaskContext* tc)
+    {
+        return internal::ThreadStatisticsService::Create(tc).get() != 0;
+    }
+}
+
+PluginLoader::PluginLoader()
+{
+    // the statistics services of RTT are only created on demand.
+    addService("connectionStatistics", &loadConnectionStatistics);
+    addService("threadStatistics", &loadThreadStatistics);
+}
 PluginLoader::~PluginLoader(){}
 
 
@@ -362,7 +381,7 @@ bool PluginLoader::loadService(string const& servicename, TaskContext* tc) {
                 }
             } else {
                 // loadPlugin( 0 ) was already called. So drop the service in the global service.
-                if (it->is_service) {
+                if (it->is_service && it->createService) {
                     try {
                         Service::shared_ptr service = it->createService();
                         if (service) {
@@ -391,6 +410,19 @@ bool PluginLoader::loadService(string const& servicename, TaskContext* tc) {
     return false;
 }
 
+bool PluginLoader::addService(string const& servicename, bool (*loadService)(TaskContext*)) {
+    MutexLock lock( listlock );
+    if ( isLoadedInternal(servicename) )
+        return false;
+    LoadedLib builtin(servicename, servicename, 0);
+    builtin.plugname = servicename;
+    builtin.loadPlugin = loadService;
+    builtin.createService = 0;
+    builtin.is_service = true;
+    loadedLibs.push_back(builtin);
+    return true;
+}
+
 // This is a DUMB function and does not scan subdirs, possible filenames etc.
 bool PluginLoader::loadPluginsInternal( std::string const& path_list, std::string const& subdir, std::string const& kind )
 {
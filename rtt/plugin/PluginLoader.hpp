@@ -232,6 +232,17 @@ namespace RTT {
              */
             bool loadService(std::string const& servicename, TaskContext* tc);
 
+            /**
+             * Registers a service which is linked into the process instead of
+             * being loaded from a plugin library, such that loadService() and
+             * listServices() find it like the services of loaded plugins.
+             * The PluginLoader registers the services built into RTT itself.
+             * @param servicename The name of the service.
+             * @param loadService Creates the service in the given TaskContext.
+             * @return false if a plugin or service with that name was loaded already.
+             */
+            bool addService(std::string const& servicename, bool (*loadService)(RTT::TaskContext*));
+
             /**
              * Lists all services discovered by the PluginLoader.
              * @return A list of service names
@@ -60,6 +60,7 @@
 
 #include <boost/bind.hpp>
 #include <boost/ref.hpp>
+#include <boost/scoped_ptr.hpp>
 #include "rtt-scripting-config.h"
 #include <iostream>
 
@@ -82,6 +83,29 @@ namespace RTT
         boost::spirit::classic::assertion<std::string> expect_timespec("Expected a time specification (e.g. > 10s or > varname ) after 'time' .");
 
         guard<std::string> my_guard;
+
+        /**
+         * Replaces the operation \a ret on the arguments \a arg1 and
+         * \a arg2 by a constant holding its result if all arguments
+         * are constant, such that the operation is not evaluated again
+         * each time the expression is. Operations which fail to evaluate
+         * are left as-is, such that the error shows up at run-time.
+         */
+        DataSourceBase::shared_ptr foldConstant( DataSourceBase::shared_ptr ret, DataSourceBase* arg1, DataSourceBase* arg2 = 0 )
+        {
+            if ( !arg1->isConstant() || ( arg2 && !arg2->isConstant() ) )
+                return ret;
+            const types::TypeInfo* ti = ret->getTypeInfo();
+            if ( !ti || ti->getTypeName() == "unknown_t" )
+                return ret;
+            try {
+                boost::scoped_ptr<AttributeBase> result( ti->buildConstant( "", ret ) );
+                if ( result && result->getDataSource() )
+                    return result->getDataSource();
+            } catch(...) {
+            }
+            return ret;
+        }
     }
 
 
@@ -612,7 +636,7 @@ namespace RTT
     if ( ! ret )
         throw parse_exception_fatal_semantic_error( "Cannot apply unary operator \"" + op +
                                                     "\" to " + arg->getType() +"." );
-    parsestack.push( ret );
+    parsestack.push( foldConstant( ret, arg.get() ) );
   }
 
   void ExpressionParser::seen_dotmember( iter_t s, iter_t f )
@@ -625,7 +649,7 @@ namespace RTT
     if ( ! ret )
       throw parse_exception_fatal_semantic_error( arg->getType() + " does not have member \"" + member +
                                             "\"." );
-    parsestack.push( ret );
+    parsestack.push( foldConstant( ret, arg.get() ) );
   }
 
   void ExpressionParser::seen_binary( const std::string& op )
@@ -642,7 +666,7 @@ namespace RTT
     if ( ! ret )
       throw parse_exception_fatal_semantic_error( "Cannot apply binary operation "+ arg2->getType() +" " + op +
                                             " "+arg1->getType() +"." );
-    parsestack.push( ret );
+    parsestack.push( foldConstant( ret, arg2.get(), arg1.get() ) );
   }
 
   void ExpressionParser::seen_assign()
@@ -703,7 +727,7 @@ namespace RTT
     if ( ! ret )
       throw parse_exception_fatal_semantic_error( "Illegal use of []: "+ arg2->getType() +"[ "
                                                 +arg1->getType() +" ]." );
-    parsestack.push( ret );
+    parsestack.push( foldConstant( ret, arg2.get(), arg1.get() ) );
   }
 
   void ExpressionParser::dropResult()
@@ -57,7 +57,8 @@ namespace RTT {
 
 
     FunctionGraph::FunctionGraph(const std::string& _name, bool unload_on_stop)
-        : myName(_name), retn(0), pausing(false), mstep(false), munload_on_stop(unload_on_stop)
+        : myName(_name), retn(0), pausing(false), mstep(false), munload_on_stop(unload_on_stop),
+          pc(0), previous_pc(0), exit_pc(0)
     {
         // the start vertex of our function graph
         startv = add_vertex( program );
@@ -108,6 +109,7 @@ namespace RTT {
         graph_traits<Graph>::vertices_size_type cnt = 0;
         for(tie(vi,vend) = vertices(program); vi != vend; ++vi)
             put(index, *vi, cnt++);
+        this->compile();
         this->reset();
     }
 
@@ -225,110 +227,76 @@ namespace RTT {
     }
 
 
-    bool FunctionGraph::executeUntil()
+    void FunctionGraph::compile()
     {
-        graph_traits<Graph>::out_edge_iterator ei, ei_end;
-        // the map contains _references_ to all vertex_command properties
         boost::property_map<Graph, vertex_command_t>::type
             cmap = get(vertex_command, program);
         boost::property_map<Graph, edge_condition_t>::type
             emap = get(edge_condition, program);
+        property_map<Graph, vertex_index_t>::type
+            index = get(vertex_index, program);
 
-        do {
-            // Check this always on entry of executeUntil :
-            // initialise current node if needed and reset all its out_edges
-            // if previous == current, we DO NOT RESET, because we want to check
-            // if previous command has completed !
-            if ( previous != current )
-                {
-                    for ( tie(ei, ei_end) = boost::out_edges( current, program ); ei != ei_end; ++ei)
-                        emap[*ei].reset();
-                    try {
-                        cmap[current].startExecution();
-                    } catch(...) {
-                        pStatus = Status::error;
-                        return false;
-                    }
-                }
-
-            // initial conditions :
-            previous = current;
-            // execute the current command.
-            try {
-                cmap[current].execute();
-            } catch(...) {
-                pStatus = Status::error;
-                return false;
-            }
-
-            // Branch selecting Logic :
-            if ( cmap[current].isValid() ) {
-                for ( tie(ei, ei_end) = boost::out_edges( current, program ); ei != ei_end; ++ei) {
-                    try {
-                        if ( emap[*ei].evaluate() ) {
-                            current = boost::target(*ei, program);
-                            // a new node has been found ...
-                            // so continue
-                            break; // exit from for loop.
-                        }
-                    } catch(...) {
-                        pStatus = Status::error;
-                        return false;
-                    }
-                }
+        // instructions are stored in the order of the vertex index, which finish() has assigned.
+        code.resize( num_vertices(program) );
+        branches.clear();
+        branches.reserve( num_edges(program) );
+        graph_traits<Graph>::vertex_iterator vi, vend;
+        for(tie(vi,vend) = vertices(program); vi != vend; ++vi) {
+            Instruction& instr = code[ get(index, *vi) ];
+            instr.command = cmap[*vi].getCommand();
+            instr.vertex = *vi;
+            instr.first_branch = branches.size();
+            graph_traits<Graph>::out_edge_iterator ei, ei_end;
+            for ( tie(ei, ei_end) = boost::out_edges( *vi, program ); ei != ei_end; ++ei) {
+                Branch branch;
+                branch.condition = emap[*ei].getCondition();
+                branch.target = get(index, boost::target(*ei, program));
+                branches.push_back(branch);
             }
-        } while ( previous != current && pStatus == Status::running && !pausing); // keep going if we found a new node
-
-        // check finished state
-        if (current == exitv) {
-            this->stop();
-            return !munload_on_stop;
+            instr.end_branch = branches.size();
         }
-        return true; // we need to wait.
+        exit_pc = get(index, exitv);
     }
 
-    bool FunctionGraph::executeStep()
+    bool FunctionGraph::enter()
     {
-        graph_traits<Graph>::out_edge_iterator ei, ei_end;
-        // the map contains _references_ to all vertex_command properties
-        boost::property_map<Graph, vertex_command_t>::type
-            cmap = get(vertex_command, program);
-        boost::property_map<Graph, edge_condition_t>::type
-            emap = get(edge_condition, program);
-
-        // initialise current node if needed and reset all its out_edges
-        if ( previous != current )
-        {
-            for ( tie(ei, ei_end) = boost::out_edges( current, program ); ei != ei_end; ++ei)
-                emap[*ei].reset();
+        // initialise the current instruction if needed and reset all its branches
+        // if previous == current, we DO NOT RESET, because we want to check
+        // if the previous command has completed !
+        if ( previous_pc != pc ) {
+            const Instruction& instr = code[pc];
+            for ( std::size_t b = instr.first_branch; b != instr.end_branch; ++b )
+                branches[b].condition->reset();
             try {
-                cmap[current].startExecution();
+                instr.command->reset();
+                instr.command->readArguments();
             } catch(...) {
                 pStatus = Status::error;
                 return false;
             }
-            previous = current;
         }
+        return true;
+    }
 
+    bool FunctionGraph::executeInstruction()
+    {
+        const Instruction& instr = code[pc];
         // execute the current command.
         try {
-            cmap[current].execute();
+            instr.command->execute();
         } catch(...) {
             pStatus = Status::error;
             return false;
         }
 
         // Branch selecting Logic :
-        if ( cmap[current].isValid() ) {
-            for ( tie(ei, ei_end) = boost::out_edges( current, program ); ei != ei_end; ++ei) {
+        if ( instr.command->valid() ) {
+            for ( std::size_t b = instr.first_branch; b != instr.end_branch; ++b ) {
                 try {
-                    if ( emap[*ei].evaluate() ) {
-                        current = boost::target(*ei, program);
-                        if (current == exitv)
-                            this->stop();
-                        // a new node has been found ...
-                        // it will be executed in the next step.
-                        return true;
+                    if ( branches[b].condition->evaluate() ) {
+                        pc = branches[b].target;
+                        // a new instruction has been found ...
+                        break;
                     }
                 } catch(...) {
                     pStatus = Status::error;
@@ -336,15 +304,59 @@ namespace RTT {
                 }
             }
         }
+        return true;
+    }
+
+    bool FunctionGraph::executeUntil()
+    {
+        bool ok = true;
+        do {
+            // Check this always on entry of executeUntil :
+            ok = this->enter();
+            if (!ok)
+                break;
+            // initial conditions :
+            previous_pc = pc;
+            ok = this->executeInstruction();
+        } while ( ok && previous_pc != pc && pStatus == Status::running && !pausing); // keep going if we found a new instruction
+
+        current = code[pc].vertex;
+        previous = code[previous_pc].vertex;
+        if (!ok)
+            return false;
+
+        // check finished state
+        if (pc == exit_pc) {
+            this->stop();
+            return !munload_on_stop;
+        }
+        return true; // we need to wait.
+    }
+
+    bool FunctionGraph::executeStep()
+    {
+        bool ok = this->enter();
+        if (ok) {
+            previous_pc = pc;
+            ok = this->executeInstruction();
+        }
+
+        current = code[pc].vertex;
+        previous = code[previous_pc].vertex;
+        if (!ok)
+            return false;
+
         // check finished state
-        if (current == exitv)
+        if (pc == exit_pc)
             this->stop();
-        return true; // no new branch found yet !
+        return true; // a new instruction will be executed in the next step
     }
 
     void FunctionGraph::reset() {
         current = startv;
         previous = exitv;
+        pc = get(vertex_index, program, startv);
+        previous_pc = exit_pc;
         this->stop();
     }
 
@@ -44,6 +44,7 @@
 #include "rtt-scripting-config.h"
 #include "../base/AttributeBase.hpp"
 #include "ProgramInterface.hpp"
+#include <vector>
 
 namespace RTT
 { namespace scripting {
@@ -112,6 +113,54 @@ namespace RTT
         bool mstep;
         bool munload_on_stop;
 
+        /**
+         * A vertex of the graph, as it is executed.
+         * Its out-edges are the branches [first_branch, end_branch).
+         */
+        struct Instruction
+        {
+            base::ActionInterface* command;
+            std::size_t first_branch;
+            std::size_t end_branch;
+            Vertex vertex;
+        };
+
+        /**
+         * An out-edge of the graph, as it is evaluated.
+         */
+        struct Branch
+        {
+            ConditionInterface* condition;
+            std::size_t target;
+        };
+
+        /**
+         * The graph flattened by compile() into contiguous arrays,
+         * such that execution does not need to walk the graph.
+         */
+        std::vector<Instruction> code;
+        std::vector<Branch> branches;
+        std::size_t pc;
+        std::size_t previous_pc;
+        std::size_t exit_pc;
+
+        /**
+         * Flattens the graph into \a code and \a branches.
+         * Must be called again when the graph is modified.
+         */
+        void compile();
+
+        /**
+         * Starts the instruction at \a pc, if it was not started yet.
+         */
+        bool enter();
+
+        /**
+         * Executes the instruction at \a pc and follows the first branch which evaluates to true.
+         * @return false if an exception was thrown.
+         */
+        bool executeInstruction();
+
         bool executeUntil();
         bool executeStep();
 
@@ -64,10 +64,10 @@ namespace RTT {
     std::string StateMachine::emptyString;
 
     StateMachine::StateMachine(StateMachinePtr parent, const string& name )
-        : smpStatus(nill), _parent (parent) , _name(name), smStatus(Status::unloaded),
+        : smpStatus(nill), _parent (parent) , _name(name), smStatus(Status::unloaded), frozen(false),
           initstate(0), finistate(0), current( 0 ), next(0), initc(0),
           currentProg(0), currentExit(0), currentHandle(0), currentEntry(0), currentRun(0), currentTrans(0),
-          checking_precond(false), mstep(false), mtrace(false), evaluating(0)
+          currentTable(0), checking_precond(false), mstep(false), mtrace(false), evaluating(0)
     {
         this->addState(0); // allows global state transitions
     }
@@ -417,7 +417,7 @@ namespace RTT {
                         smStatus = Status::error;
                     currentTrans = transProg;
                     // manually reset reqstep, or the next iteration would skip transition checks.
-                    reqstep = stateMap.find( current )->second.begin();
+                    reqstep = currentTable->transitions->begin();
                     // from now on, we are in transition to self !
                     // currentRun is _not_ set to zero or reset.
                     // it is/may be interrupted by trans, then continued.
@@ -473,9 +473,11 @@ namespace RTT {
 //            TRACE("Enabling events for state '"+s->getName()+"'.");
 //        } else
 //            TRACE("Enabling global events.");
-        EventMap::mapped_type& hlist = eventMap[s];
-        for (EventList::iterator eit = hlist.begin();
-             eit != hlist.end();
+        StateTable* t = stateTable(s);
+        if ( t == 0 || t->events == 0 )
+            return;
+        for (EventList::iterator eit = t->events->begin();
+             eit != t->events->end();
              ++eit) {
             assert( get<6>(*eit).connected() == false );
             get<6>(*eit).connect();
@@ -487,9 +489,11 @@ namespace RTT {
 //            TRACE("Disabling events for state '"+s->getName()+"'.");
 //        } else
 //            TRACE("Disabling global events.");
-        EventMap::mapped_type& hlist = eventMap[s];
-                for (EventList::iterator eit = hlist.begin();
-                     eit != hlist.end();
+        StateTable* t = stateTable(s);
+        if ( t == 0 || t->events == 0 )
+            return;
+                for (EventList::iterator eit = t->events->begin();
+                     eit != t->events->end();
                      ++eit) {
                     assert( get<6>(*eit).connected() == true );
                     get<6>(*eit).disconnect();
@@ -555,6 +559,7 @@ namespace RTT {
         // add the states to the statemap.
         stateMap[from];
         stateMap[to];
+        frozen = false;
         return true;
     }
 
@@ -624,20 +629,25 @@ namespace RTT {
             return current; // can not accept request, still in transition.
         }
 
+        if ( !frozen )
+            this->freeze();
+
         // Reset global conditions.
         TransList::const_iterator it, it1, it2;
-        it1 = stateMap.find( 0 )->second.begin();
-        it2 = stateMap.find( 0 )->second.end();
+        it1 = tables[0].transitions->begin();
+        it2 = tables[0].transitions->end();
+        // the table of the target of *it1 :
+        std::vector<StateTable*>::const_iterator gt = tables[0].targets.begin();
 
-        if ( reqstep == stateMap.find( current )->second.begin() ) // avoid reseting too much in stepping mode.
+        if ( reqstep == currentTable->transitions->begin() ) // avoid reseting too much in stepping mode.
             for ( it= it1; it != it2; ++it)
                 get<0>(*it)->reset();
 
         if ( reqstep == reqend ) { // if nothing to evaluate, eval globals, then just handle()
 
-            for ( ; it1 != it2; ++it1 )
+            for ( ; it1 != it2; ++it1, ++gt )
                 if ( get<0>(*it1)->evaluate()
-                     && checkConditions( get<1>(*it1) ) == 1 ) {
+                     && checkConditions( *gt ) == 1 ) {
                     StateInterface* next = get<1>(*it1);
                     if ( next == 0 ) // handle current if no next
                         changeState( current, get<4>(*it1).get(), stepping );
@@ -658,7 +668,7 @@ namespace RTT {
                 if (reqstep == reqend )
                     return current;
                 // check preconds of target state :
-                int cres = checkConditions( get<1>(*reqstep), stepping );
+                int cres = checkConditions( currentTable->targets[ reqstep - currentTable->transitions->begin() ], stepping );
                 if (cres == 0) {
                     break; // only returned in stepping
                 }
@@ -670,8 +680,8 @@ namespace RTT {
             }
              if ( reqstep + 1 == reqend ) {
                 // to a state specified by the user (global)
-                for ( ; it1 != it2; ++it1 ) {
-                    if ( get<0>(*it1)->evaluate() && checkConditions( get<1>(*it1) ) == 1 ) {
+                for ( ; it1 != it2; ++it1, ++gt ) {
+                    if ( get<0>(*it1)->evaluate() && checkConditions( *gt ) == 1 ) {
                              StateInterface* next = get<1>(*it1);
                              if ( next == 0) // handle current if no next
                                  changeState( current, get<4>(*it1).get(), stepping );
@@ -682,7 +692,7 @@ namespace RTT {
                          }
                     }
                 // no transition was found, reset and 'schedule' a handle :
-                reqstep = stateMap.find( current )->second.begin();
+                reqstep = currentTable->transitions->begin();
                 evaluating = get<3>(*reqstep);
                 changeState( current, 0, stepping );
                 break;
@@ -697,10 +707,20 @@ namespace RTT {
     }
 
     int StateMachine::checkConditions( StateInterface* state, bool stepping ) {
+        return this->checkConditions( stateTable(state), stepping );
+    }
+
+    int StateMachine::checkConditions( const StateTable* target, bool stepping ) {
+
+        // a state which is not in this state machine has no preconditions.
+        if ( target == 0 ) {
+            checking_precond = false;
+            return 1;
+        }
 
-        // if the preconditions of \a state are checked the first time in stepping mode, reset the iterators.
+        // if the preconditions of \a target are checked the first time in stepping mode, reset the iterators.
         if ( !checking_precond || !stepping ) {
-            prec_it = precondMap.equal_range(state); // state is the _target_ state
+            prec_it = make_pair( target->preconds.begin(), target->preconds.end() );
         }
 
         // will be set to true if stepping below.
@@ -708,18 +728,18 @@ namespace RTT {
 
         while ( prec_it.first != prec_it.second ) {
             if (checking_precond == false && stepping ) {
-                evaluating = prec_it.first->second.second; // indicate we will evaluate this line (if any).
+                evaluating = prec_it.first->second; // indicate we will evaluate this line (if any).
                 checking_precond = true;
                 return 0;
             }
-            if ( prec_it.first->second.first->evaluate() == false ) {
+            if ( prec_it.first->first->evaluate() == false ) {
                 checking_precond = false;
                 return -1; // precondition failed
             }
             ++( prec_it.first );
             if (stepping) {
                 if ( prec_it.first != prec_it.second )
-                    evaluating = prec_it.first->second.second; // indicate we will evaluate the next line (if any).
+                    evaluating = prec_it.first->second; // indicate we will evaluate the next line (if any).
                 checking_precond = true;
                 return 0; // not done yet.
             }
@@ -735,21 +755,26 @@ namespace RTT {
         // bad idea, user, don't run this if we're not active...
         if ( current == 0 )
             return 0;
+        if ( !frozen )
+            this->freeze();
         TransList::const_iterator it1, it2;
-        it1 = stateMap.find( current )->second.begin();
-        it2 = stateMap.find( current )->second.end();
+        std::vector<StateTable*>::const_iterator tt;
+        it1 = currentTable->transitions->begin();
+        it2 = currentTable->transitions->end();
+        tt = currentTable->targets.begin();
 
-        for ( ; it1 != it2; ++it1 )
-            if ( get<0>(*it1)->evaluate() && checkConditions( get<1>(*it1)) == 1 ) {
+        for ( ; it1 != it2; ++it1, ++tt )
+            if ( get<0>(*it1)->evaluate() && checkConditions( *tt ) == 1 ) {
                 return get<1>(*it1);
             }
 
         // also check the global transitions.
-        it1 = stateMap.find( 0 )->second.begin();
-        it2 = stateMap.find( 0 )->second.end();
+        it1 = tables[0].transitions->begin();
+        it2 = tables[0].transitions->end();
+        tt = tables[0].targets.begin();
 
-        for ( ; it1 != it2; ++it1 )
-            if ( get<0>(*it1)->evaluate() && checkConditions( get<1>(*it1)) == 1 ) {
+        for ( ; it1 != it2; ++it1, ++tt )
+            if ( get<0>(*it1)->evaluate() && checkConditions( *tt ) == 1 ) {
                 return get<1>(*it1);
             }
 
@@ -769,6 +794,45 @@ namespace RTT {
     void StateMachine::addState( StateInterface* s )
     {
         stateMap[s];
+        frozen = false;
+    }
+
+    void StateMachine::freeze()
+    {
+        tables.clear();
+        tableIds.clear();
+        // size the tables first, such that the targets may point into it.
+        tables.resize( stateMap.size() );
+        std::size_t id = 1;
+        for ( TransitionMap::iterator it = stateMap.begin(); it != stateMap.end(); ++it )
+            tableIds[ it->first ] = it->first ? id++ : 0; // global transitions get id 0.
+
+        for ( TransitionMap::iterator it = stateMap.begin(); it != stateMap.end(); ++it ) {
+            StateTable& t = tables[ tableIds[ it->first ] ];
+            t.state = it->first;
+            t.transitions = &it->second;
+            for ( TransList::iterator tit = it->second.begin(); tit != it->second.end(); ++tit )
+                t.targets.push_back( &tables[ tableIds[ get<1>(*tit) ] ] );
+            std::pair<PreConditionMap::iterator,PreConditionMap::iterator> pre = precondMap.equal_range( it->first );
+            for ( ; pre.first != pre.second; ++pre.first )
+                t.preconds.push_back( pre.first->second );
+            EventMap::iterator eit = eventMap.find( it->first );
+            t.events = eit == eventMap.end() ? 0 : &eit->second;
+        }
+
+        currentTable = current ? &tables[ tableIds[current] ] : 0;
+        checking_precond = false;
+        frozen = true;
+    }
+
+    StateMachine::StateTable* StateMachine::stateTable( StateInterface* s )
+    {
+        if ( !frozen )
+            this->freeze();
+        std::map<StateInterface*, std::size_t>::const_iterator it = tableIds.find( s );
+        if ( it == tableIds.end() )
+            return 0;
+        return &tables[ it->second ];
     }
 
 
@@ -804,10 +868,13 @@ namespace RTT {
             return true;
         }
 
+        if ( !frozen )
+            this->freeze();
+
         // between 2 states specified by the user.
         TransList::iterator it, it1, it2;
-        it1 = stateMap.find( current )->second.begin();
-        it2 = stateMap.find( current )->second.end();
+        it1 = currentTable->transitions->begin();
+        it2 = currentTable->transitions->end();
 
         for ( ; it1 != it2; ++it1 )
             if ( get<1>(*it1) == s_n
@@ -820,8 +887,8 @@ namespace RTT {
             }
 
         // to a state specified by the user (global)
-        it1 = stateMap.find( 0 )->second.begin();
-        it2 = stateMap.find( 0 )->second.end();
+        it1 = tables[0].transitions->begin();
+        it2 = tables[0].transitions->end();
 
         // reset all conditions
         for ( it= it1; it != it2; ++it)
@@ -886,6 +953,7 @@ namespace RTT {
             return;
         precondMap.insert( make_pair(state, make_pair( cnd, line)) );
         stateMap[state]; // add to state map.
+        frozen = false;
     }
 
     void StateMachine::transitionSet( StateInterface* from, StateInterface* to, ConditionInterface* cnd, int priority, int line )
@@ -912,6 +980,7 @@ namespace RTT {
             ; // this ';' is intentional
         stateMap[from].insert(it, boost::make_tuple( cnd, to, priority, line, transprog ) );
         stateMap[to]; // insert empty vector for 'to' state.
+        frozen = false;
     }
 
     StateInterface* StateMachine::currentState() const
@@ -964,8 +1033,8 @@ namespace RTT {
 //        TRACE( "Planning to enter state " + s->getName() );
 
         // Before a state is entered, all transitions are reset !
-        TransList::iterator it;
-        for ( it= stateMap.find(s)->second.begin(); it != stateMap.find(s)->second.end(); ++it)
+        TransList* tl = stateTable(s)->transitions;
+        for ( TransList::iterator it = tl->begin(); it != tl->end(); ++it)
             get<0>(*it)->reset();
 
         currentEntry = s->getEntryProgram();
@@ -1040,8 +1109,9 @@ namespace RTT {
         // if we did not change state, it will be reset in requestNextState().
         if ( current != next ) {
             if ( next ) {
-                reqstep = stateMap.find( next )->second.begin();
-                reqend  = stateMap.find( next )->second.end();
+                currentTable = stateTable( next );
+                reqstep = currentTable->transitions->begin();
+                reqend  = currentTable->transitions->end();
                 // init for getLineNumber() :
                 if ( reqstep == reqend )
                     evaluating = 0;
@@ -1049,6 +1119,7 @@ namespace RTT {
                     evaluating = get<3>(*reqstep);
             } else {
                 current = 0;
+                currentTable = 0;
                 return true;  // done if current == 0 !
             }
             // make change transition after exit of previous state:
@@ -1145,12 +1216,14 @@ namespace RTT {
     {
         initstate = s;
         stateMap[initstate];
+        frozen = false;
     }
 
     void StateMachine::setFinalState( StateInterface* s )
     {
         finistate = s;
         stateMap[finistate];
+        frozen = false;
     }
 
     void StateMachine::trace(bool t) {
@@ -1168,6 +1241,10 @@ namespace RTT {
 
         smpStatus = nill;
 
+        // flatten the maps before the first transition is evaluated.
+        if ( !frozen )
+            this->freeze();
+
         if ( this->checkConditions( getInitialState() ) != 1 ) {
             TRACE("Won't activate: preconditions failed.");
             return false; //preconditions not met.
@@ -1184,9 +1261,10 @@ namespace RTT {
 
         current = getInitialState();
         next = current;
+        currentTable = stateTable( current );
         enterState( getInitialState() );
-        reqstep = stateMap.find( next )->second.begin();
-        reqend = stateMap.find( next )->second.end();
+        reqstep = currentTable->transitions->begin();
+        reqend = currentTable->transitions->end();
 
         // Enable all event handlers
         enableGlobalEvents();
@@ -90,6 +90,7 @@ namespace RTT
         typedef std::vector< boost::tuple<ConditionInterface*, StateInterface*, int, int, boost::shared_ptr<ProgramInterface> > > TransList;
         typedef std::map< StateInterface*, TransList > TransitionMap;
         typedef std::multimap< StateInterface*, std::pair<ConditionInterface*, int> > PreConditionMap;
+        typedef std::vector< std::pair<ConditionInterface*, int> > PreConditionList;
         typedef std::vector< boost::tuple<ServicePtr,
                                                  std::string, std::vector<base::DataSourceBase::shared_ptr>,
                                                  StateInterface*,
@@ -619,6 +620,63 @@ namespace RTT
          */
         EventMap eventMap;
 
+        /**
+         * The transitions, preconditions and events of one state,
+         * flattened out of stateMap, precondMap and eventMap by freeze().
+         */
+        struct StateTable {
+            StateTable() : state(0), transitions(0), events(0) {}
+            StateInterface* state;
+            /**
+             * The transitions leaving this state, in order of priority.
+             */
+            TransList* transitions;
+            /**
+             * The table of the target state of each element of transitions.
+             */
+            std::vector<StateTable*> targets;
+            /**
+             * The preconditions of this state and their line numbers.
+             */
+            PreConditionList preconds;
+            /**
+             * The event handlers of this state, or null if it has none.
+             */
+            EventList* events;
+        };
+        typedef std::vector<StateTable> StateTables;
+
+        /**
+         * The tables of all states, indexed by a dense state id.
+         * The global transitions have id 0.
+         */
+        StateTables tables;
+
+        /**
+         * The id of each state in tables. Only looked up when
+         * the state machine changes state.
+         */
+        std::map<StateInterface*, std::size_t> tableIds;
+
+        /**
+         * False if stateMap, precondMap or eventMap were modified
+         * since the last freeze().
+         */
+        bool frozen;
+
+        /**
+         * Builds tables from stateMap, precondMap and eventMap, such that
+         * evaluating the transitions of a state does not need any map lookup.
+         * Called by activate() and lazily after the state machine was modified.
+         */
+        void freeze();
+
+        /**
+         * Returns the table of state \a s, or null if \a s is not a state of
+         * this state machine.
+         */
+        StateTable* stateTable( StateInterface* s );
+
         void changeState( StateInterface* s, ProgramInterface* tprog, bool stepping = false );
 
         void leaveState( StateInterface* s );
@@ -633,6 +691,8 @@ namespace RTT
 
         int checkConditions( StateInterface* state, bool stepping = false );
 
+        int checkConditions( const StateTable* target, bool stepping = false );
+
         void enableGlobalEvents();
         void disableGlobalEvents();
         void enableEvents( StateInterface* s );
@@ -680,7 +740,12 @@ namespace RTT
         TransList::iterator reqstep;
         TransList::iterator reqend;
 
-        std::pair<PreConditionMap::const_iterator,PreConditionMap::const_iterator> prec_it;
+        /**
+         * The table of the current state.
+         */
+        StateTable* currentTable;
+
+        std::pair<PreConditionList::const_iterator,PreConditionList::const_iterator> prec_it;
         bool checking_precond;
         bool mstep, mtrace;
 
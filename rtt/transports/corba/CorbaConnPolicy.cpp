@@ -56,6 +56,8 @@ RTT::corba::CConnPolicy toCORBA(RTT::ConnPolicy const& policy)
     corba_policy.buffer_policy = RTT::corba::CBufferPolicy(policy.buffer_policy);
     corba_policy.max_threads   = policy.max_threads;
     corba_policy.mandatory     = policy.mandatory;
+    corba_policy.shared_samples = policy.shared_samples;
+    corba_policy.seqlock       = policy.seqlock;
     corba_policy.data_size     = policy.data_size;
     corba_policy.transport     = policy.transport;
     corba_policy.name_id       = CORBA::string_dup( policy.name_id.c_str() );
@@ -73,6 +75,8 @@ RTT::ConnPolicy toRTT(RTT::corba::CConnPolicy const& corba_policy)
     policy.buffer_policy = RTT::BufferPolicy(corba_policy.buffer_policy);
     policy.max_threads   = corba_policy.max_threads;
     policy.mandatory     = corba_policy.mandatory;
+    policy.shared_samples = corba_policy.shared_samples;
+    policy.seqlock       = corba_policy.seqlock;
     policy.data_size     = corba_policy.data_size;
     policy.transport     = corba_policy.transport;
     policy.name_id       = corba_policy.name_id;
@@ -42,9 +42,17 @@
 #include "../../base/ChannelElementBase.hpp"
 #include "../../Logger.hpp"
 #include <map>
-#include <sys/select.h>
 #include <mqueue.h>
 
+// Xenomai message queues are not Linux file descriptors and can only be select()'ed.
+#if defined(__linux__) && !defined(OROPKG_OS_XENOMAI)
+#define ORO_MQUEUE_DISPATCHER_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#else
+#include <sys/select.h>
+#endif
+
 namespace RTT { namespace mqueue { class Dispatcher; } }
 
 namespace RTT {
@@ -58,6 +66,11 @@ namespace RTT {
          * received new data.
          * Reasonably, there should be one dispatcher for each
          * peer component sending us data.
+         *
+         * On Linux, the queues are registered level-triggered with
+         * an epoll instance, such that each wake-up only visits the
+         * queues that hold data, independent of the number of
+         * queues monitored. Other targets fall back to select().
          */
         class Dispatcher : public Activity
         {
@@ -69,9 +82,17 @@ namespace RTT {
             typedef std::map<mqd_t,base::ChannelElementBase*> MQMap;
             MQMap mqmap;
 
+#ifdef ORO_MQUEUE_DISPATCHER_EPOLL
+            int epfd;            /* The epoll instance all queues are registered with */
+
+            static const int max_events = 64; /* Maximum number of ready queues returned per wake-up */
+
+            struct epoll_event events[max_events];
+#else
             fd_set socks;        /* Socket file descriptors we want to wake up for, using select() */
 
             int highsock;        /* Highest #'d file descriptor, needed for select() */
+#endif
 
             bool do_exit;
 
@@ -79,16 +100,50 @@ namespace RTT {
 
             Dispatcher( const std::string& name)
             : Activity(ORO_SCHED_RT, os::HighestPriority, 0.0, 0, name),
-              highsock(0), do_exit(false)
-              {}
+#ifdef ORO_MQUEUE_DISPATCHER_EPOLL
+              epfd( epoll_create1(EPOLL_CLOEXEC) ),
+#else
+              highsock(0),
+#endif
+              do_exit(false)
+            {
+#ifdef ORO_MQUEUE_DISPATCHER_EPOLL
+                if (epfd < 0) {
+                    Logger::In in("Dispatcher");
+                    log(Error) << "Dispatcher failed to create an epoll instance: " << strerror(errno) << endlog();
+                }
+#endif
+            }
 
             ~Dispatcher() {
                 Logger::In in("Dispatcher");
                 log(Info) << "Dispacher cleans up: no more work."<<endlog();
                 stop();
+#ifdef ORO_MQUEUE_DISPATCHER_EPOLL
+                if (epfd >= 0)
+                    close(epfd);
+#endif
                 DispatchI = 0;
             }
 
+#ifdef ORO_MQUEUE_DISPATCHER_EPOLL
+            void read_queue(mqd_t mqdes) {
+                os::MutexLock lock(maplock);
+                MQMap::iterator it = mqmap.find(mqdes);
+                if (it == mqmap.end())
+                    return;
+                /* Forward the messages that are in the queue now. The queue is
+                   level-triggered: if a message is left because signal() failed,
+                   or if one arrived in the mean time, the next wake-up returns it. */
+                struct mq_attr attr;
+                if (mq_getattr(mqdes, &attr) != 0)
+                    return;
+                for (long i = 0; i < attr.mq_curmsgs; ++i)
+                    if ( !it->second->signal() )
+                        break;
+            }
+#else
+
             void build_select_list() {
 
                 /* First put together fd_set for select(), which will
@@ -127,6 +182,7 @@ namespace RTT {
                     }
                 }
             }
+#endif
 
         public:
             typedef boost::intrusive_ptr<Dispatcher> shared_ptr;
@@ -148,8 +204,18 @@ namespace RTT {
                 log(Debug) <<"Dispatcher is monitoring mqdes "<< mqdes <<endlog();
                 os::MutexLock lock(maplock);
                 // we add a refcount per channel we monitor.
-                if (mqmap.count(mqdes) == 0)
+                if (mqmap.count(mqdes) == 0) {
+#ifdef ORO_MQUEUE_DISPATCHER_EPOLL
+                    struct epoll_event ev;
+                    ev.events = EPOLLIN;
+                    ev.data.fd = mqdes;
+                    if ( epoll_ctl(epfd, EPOLL_CTL_ADD, mqdes, &ev) != 0 ) {
+                        log(Error) <<"Dispatcher failed to monitor mqdes "<< mqdes <<": "<< strerror(errno) <<endlog();
+                        return;
+                    }
+#endif
                     refcount.inc();
+                }
                 mqmap[mqdes] = chan;
             }
 
@@ -158,6 +224,9 @@ namespace RTT {
                 log(Debug) <<"Dispatcher drops mqdes "<< mqdes <<endlog();
                 os::MutexLock lock(maplock);
                 if (mqmap.count(mqdes)) {
+#ifdef ORO_MQUEUE_DISPATCHER_EPOLL
+                    epoll_ctl(epfd, EPOLL_CTL_DEL, mqdes, 0);
+#endif
                     mqmap.erase( mqmap.find(mqdes) );
                     refcount.dec();
                 }
@@ -168,6 +237,28 @@ namespace RTT {
                 return true;
             }
 
+#ifdef ORO_MQUEUE_DISPATCHER_EPOLL
+            void loop() {
+                int ready;           /* Number of queues ready for reading */
+                while (1) { /* epoll loop */
+                    /* Time out after 50ms to check do_exit. */
+                    ready = epoll_wait(epfd, events, max_events, 50);
+
+                    if (ready < 0) {
+                        if (errno != EINTR)
+                        {
+                            log(Error) <<"Dispatcher failed to wait on message queues. Stopped thread. error: "<<strerror(errno)<<endlog();
+                            return;
+                        }
+                    }
+                    for (int i = 0; i < ready; ++i)
+                        read_queue( events[i].data.fd );
+
+                    if ( do_exit )
+                        return;
+                } /* while(1) */
+            }
+#else
             void loop() {
                 struct timeval timeout;  /* Timeout for select */
                 int readsocks;       /* Number of sockets ready for reading */
@@ -207,6 +298,7 @@ namespace RTT {
                         return;
                 } /* while(1) */
             }
+#endif
 
             bool breakLoop() {
                 do_exit = true;
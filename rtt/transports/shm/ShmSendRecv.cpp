@@ -0,0 +1,415 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <unistd.h>
+#include <sstream>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <errno.h>
+#include <boost/algorithm/string.hpp>
+
+#include "ShmSendRecv.hpp"
+#include "../../types/TypeMarshaller.hpp"
+#include "../../Logger.hpp"
+#include "../../Activity.hpp"
+#include "../../os/oro_arch.h"
+#include "../../base/ChannelElementBase.hpp"
+#include "../../base/PortInterface.hpp"
+#include "../../DataFlowInterface.hpp"
+#include "../../TaskContext.hpp"
+
+using namespace RTT;
+using namespace RTT::detail;
+using namespace RTT::shm;
+
+namespace RTT {
+    namespace shm {
+        /**
+         * The layout of the start of the shared memory object. The
+         * counters of the writer and of the reader are kept in separate
+         * cache lines, the slots follow the header.
+         */
+        struct ShmHeader
+        {
+            enum { Magic = 0x4f524f53 /* "OROS" */, CacheLine = 64, MaxSlots = 1 << 20 };
+            /** Set to Magic by the creator once the header is initialized. */
+            oro_atomic_t magic;
+            unsigned int slot_count;
+            /** The maximum size of a marshalled sample. */
+            unsigned int slot_size;
+            /** The distance between two slots. */
+            unsigned int slot_stride;
+            char pad0[CacheLine - sizeof(oro_atomic_t) - 3 * sizeof(unsigned int)];
+            /** The number of slots written. Wraps around. */
+            oro_atomic_t head;
+            /** Set by the reader before it sleeps on wake. */
+            oro_atomic_t waiting;
+            /** The futex word of the reader, incremented to wake it up. */
+            oro_atomic_t wake;
+            char pad1[CacheLine - 3 * sizeof(oro_atomic_t)];
+            /** The number of slots read. Wraps around. */
+            oro_atomic_t tail;
+            char pad2[CacheLine - sizeof(oro_atomic_t)];
+        };
+
+        /**
+         * Every slot starts with the length of the marshalled sample,
+         * padded such that the sample is suitably aligned.
+         */
+        struct ShmSlotHeader
+        {
+            unsigned int length;
+            char pad[16 - sizeof(unsigned int)];
+        };
+
+        namespace {
+            // futex operations on a word shared between processes, so not FUTEX_PRIVATE.
+            // A zero timeout waits without a time limit.
+            int futex_wait(oro_atomic_t* word, int value, Seconds timeout) {
+                struct timespec ts;
+                ts.tv_sec = (time_t) timeout;
+                ts.tv_nsec = (long) Seconds_to_nsecs(timeout - ts.tv_sec);
+                return syscall(SYS_futex, (int*) word, FUTEX_WAIT, value, timeout > 0 ? &ts : 0, 0, 0);
+            }
+
+            /**
+             * The number of samples between \a tail and \a head, which
+             * is correct after either counter wrapped around.
+             */
+            unsigned int distance(int head, int tail) {
+                return (unsigned int) head - (unsigned int) tail;
+            }
+
+            int futex_wake(oro_atomic_t* word) {
+                return syscall(SYS_futex, (int*) word, FUTEX_WAKE, 1, 0, 0, 0);
+            }
+        }
+
+        /**
+         * Waits on the ring of one receiving channel element and
+         * signals it for each sample that arrives.
+         */
+        class ShmSendRecv::Receiver : public Activity
+        {
+            ShmSendRecv* msr;
+            base::ChannelElementBase* mchan;
+            bool do_exit;
+        public:
+            Receiver(ShmSendRecv* sr, base::ChannelElementBase* chan, const std::string& name)
+                : Activity(ORO_SCHED_RT, os::HighestPriority, 0.0, 0, name),
+                  msr(sr), mchan(chan), do_exit(false)
+            {}
+
+            ~Receiver() {
+                stop();
+            }
+
+            bool initialize() {
+                do_exit = false;
+                return true;
+            }
+
+            void loop() {
+                while ( !do_exit ) {
+                    // blocks until a sample arrives or breakLoop() interrupts it.
+                    // A sample which does not fit in the next channel element
+                    // is dropped there.
+                    if ( msr->shmWait(0.0) )
+                        while ( !do_exit && msr->shmPending() )
+                            mchan->signal();
+                }
+            }
+
+            bool breakLoop() {
+                do_exit = true;
+                msr->shmInterrupt();
+                return true;
+            }
+        };
+    }
+}
+
+ShmSendRecv::ShmSendRecv(types::TypeMarshaller const& transport) :
+    mtransport(transport), marshaller_cookie(0), mheader(0), mmap_size(0), mis_sender(false), minit_done(false),
+    minterrupted(false), mdropped(0), mreceiver(0)
+{
+}
+
+void ShmSendRecv::setupStream(base::DataSourceBase::shared_ptr ds, base::PortInterface* port, ConnPolicy const& policy,
+                              bool is_sender)
+{
+    Logger::In in("ShmSendRecv");
+
+    marshaller_cookie = mtransport.createCookie();
+    mis_sender = is_sender;
+
+    if (policy.name_id.empty())
+    {
+        if (!port->getInterface() || !port->getInterface()->getOwner() || port->getInterface()->getOwner()->getName().empty())
+            throw std::runtime_error("Shm name_id not set, and the port is either not attached to a task, or said task has no name. Cannot create a reasonably unique shared memory name automatically");
+
+        std::stringstream name_stream;
+        name_stream << port->getInterface()->getOwner()->getName() << '.' << port->getName() << '.' << this << '@' << getpid();
+        std::string name = name_stream.str();
+        boost::algorithm::replace_all(name, "/", "_");
+        policy.name_id = "/" + name;
+    }
+    if (policy.name_id[0] != '/' || policy.name_id.find('/', 1) != std::string::npos)
+        throw std::runtime_error("Could not open shared memory object with wrong name. Names must start with '/' and contain no more '/' after the first one.");
+
+    if (policy.size < 0 || policy.size > ShmHeader::MaxSlots)
+        throw std::runtime_error("Could not open shared memory object with a negative or too large buffer size.");
+    unsigned int size = policy.size ? (unsigned int) policy.size : 10;
+    // a power of two, such that the wrapping counters map onto the slots continuously.
+    unsigned int slot_count = 1;
+    while ( slot_count < size )
+        slot_count <<= 1;
+    unsigned int slot_size = policy.data_size ? policy.data_size : mtransport.getSampleSize(ds, marshaller_cookie);
+    if (slot_size == 0)
+        throw std::runtime_error("Could not open shared memory object with zero sample size.");
+    unsigned int slot_stride = (sizeof(ShmSlotHeader) + slot_size + ShmHeader::CacheLine - 1) & ~(ShmHeader::CacheLine - 1);
+
+    // the first side to arrive creates and initializes the object, the other one attaches to it.
+    bool creator = true;
+    int fd = shm_open(policy.name_id.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IREAD | S_IWRITE);
+    if (fd < 0 && errno == EEXIST) {
+        creator = false;
+        fd = shm_open(policy.name_id.c_str(), O_RDWR, S_IREAD | S_IWRITE);
+    }
+    if (fd < 0) {
+        log(Error) << "FAILED opening '" << policy.name_id << "' for " << (is_sender ? "writing: " : "reading: ") << strerror(errno) << endlog();
+        throw std::runtime_error("Could not open shared memory object: shm_open returned -1.");
+    }
+
+    if (creator) {
+        mmap_size = sizeof(ShmHeader) + size_t(slot_count) * slot_stride;
+        if (ftruncate(fd, mmap_size) != 0) {
+            close(fd);
+            shm_unlink(policy.name_id.c_str());
+            throw std::runtime_error("Could not size shared memory object: ftruncate returned -1.");
+        }
+    } else {
+        // wait for the creator to size the object, the layout is then read from its header.
+        struct stat st;
+        st.st_size = 0;
+        int wait = 500;
+        while ( fstat(fd, &st) == 0 && st.st_size < (off_t) sizeof(ShmHeader) && wait-- )
+            usleep(1000);
+        mmap_size = st.st_size;
+        if (mmap_size < sizeof(ShmHeader)) {
+            close(fd);
+            throw std::runtime_error("Could not attach to shared memory object: it was not initialized by its creator.");
+        }
+    }
+
+    void* addr = mmap(0, mmap_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        if (creator)
+            shm_unlink(policy.name_id.c_str());
+        throw std::runtime_error("Could not map shared memory object: mmap failed.");
+    }
+    mheader = static_cast<ShmHeader*>(addr);
+    mshmname = policy.name_id;
+
+    if (creator) {
+        mheader->slot_count = slot_count;
+        mheader->slot_size = slot_size;
+        mheader->slot_stride = slot_stride;
+        oro_atomic_set(&mheader->head, 0);
+        oro_atomic_set(&mheader->waiting, 0);
+        oro_atomic_set(&mheader->wake, 0);
+        oro_atomic_set(&mheader->tail, 0);
+        // full barrier: the layout is visible before the magic.
+        oro_atomic_add(&mheader->magic, ShmHeader::Magic);
+    } else {
+        int wait = 500;
+        while ( oro_atomic_read(&mheader->magic) != ShmHeader::Magic && wait-- )
+            usleep(1000);
+        if ( oro_atomic_read(&mheader->magic) != ShmHeader::Magic
+             || mheader->slot_count == 0 || (mheader->slot_count & (mheader->slot_count - 1)) != 0
+             || sizeof(ShmHeader) + size_t(mheader->slot_count) * mheader->slot_stride > mmap_size ) {
+            cleanupStream();
+            throw std::runtime_error("Could not attach to shared memory object: it has an invalid header.");
+        }
+        if (mheader->slot_size < slot_size)
+            log(Warning) << "Shared memory object '" << mshmname << "' has slots of " << mheader->slot_size
+                         << " bytes, while samples of " << slot_size << " bytes are expected." << endlog();
+    }
+
+    log(Debug) << "Opened '" << mshmname << "' with " << mheader->slot_count << " slots of " << mheader->slot_size
+               << " bytes for " << (is_sender ? "writing." : "reading.") << endlog();
+}
+
+ShmSendRecv::~ShmSendRecv()
+{
+    if (mheader)
+        munmap(mheader, mmap_size);
+}
+
+void ShmSendRecv::cleanupStream()
+{
+    if (mreceiver)
+    {
+        delete mreceiver; // stops the thread.
+        mreceiver = 0;
+    }
+    minit_done = false;
+    if (mheader)
+    {
+        // both sides unlink, such that the name can be reused for a new connection.
+        // The mapping of the other side remains valid.
+        shm_unlink(mshmname.c_str());
+        munmap(mheader, mmap_size);
+        mheader = 0;
+    }
+
+    if (marshaller_cookie)
+    {
+        mtransport.deleteCookie(marshaller_cookie);
+        marshaller_cookie = 0;
+    }
+}
+
+char* ShmSendRecv::slot(int counter) const
+{
+    unsigned int index = (unsigned int) counter & (mheader->slot_count - 1);
+    return reinterpret_cast<char*>(mheader + 1) + size_t(index) * mheader->slot_stride;
+}
+
+bool ShmSendRecv::shmReady(base::DataSourceBase::shared_ptr ds, base::ChannelElementBase* chan)
+{
+    if (minit_done)
+        return true;
+
+    assert( !mis_sender ); // we can only receive inputReady when we're on the input port side of the ring.
+    if (mis_sender)
+        return false;
+
+    // Try to get the initial sample
+    //
+    // The output port implementation guarantees that there will be one
+    // after the connection is ready
+    if ( shmWait(0.5) && shmRead(ds) )
+    {
+        minit_done = true;
+        minterrupted = false;
+        // ok, now we can start forwarding.
+        mreceiver = new Receiver(this, chan, "ShmReceive" + mshmname);
+        mreceiver->start();
+        return true;
+    }
+    log(Error) << "Failed to receive initial data sample for Shm Channel Element." << endlog();
+    return false;
+}
+
+bool ShmSendRecv::shmPending() const
+{
+    return distance(oro_atomic_read(&mheader->head), oro_atomic_read(&mheader->tail)) != 0;
+}
+
+bool ShmSendRecv::shmWait(Seconds timeout)
+{
+    if ( shmPending() )
+        return true;
+    // full barrier: the writer sees that we wait, or we see its new head.
+    oro_atomic_inc(&mheader->waiting);
+    int wake = oro_atomic_read(&mheader->wake);
+    // shmInterrupt() sets minterrupted before it changes wake.
+    oro_mb();
+    if ( !shmPending() && !minterrupted )
+        futex_wait(&mheader->wake, wake, timeout);
+    oro_atomic_dec(&mheader->waiting);
+    return shmPending();
+}
+
+void ShmSendRecv::shmInterrupt()
+{
+    minterrupted = true;
+    // full barrier: shmWait() sees minterrupted, or it sees a new wake.
+    oro_atomic_inc(&mheader->wake);
+    futex_wake(&mheader->wake);
+}
+
+size_t ShmSendRecv::shmDropped() const
+{
+    return mdropped;
+}
+
+bool ShmSendRecv::shmRead(RTT::base::DataSourceBase::shared_ptr ds)
+{
+    int tail = oro_atomic_read(&mheader->tail);
+    if ( tail == oro_atomic_read(&mheader->head) )
+        return false;
+    char* s = slot(tail);
+    ShmSlotHeader* sh = reinterpret_cast<ShmSlotHeader*>(s);
+    bool result = mtransport.updateFromBlob((void*) (sh + 1), sh->length, ds, marshaller_cookie);
+    // full barrier: the slot is released after we're done with it.
+    oro_atomic_inc(&mheader->tail);
+    return result;
+}
+
+bool ShmSendRecv::shmWrite(RTT::base::DataSourceBase::shared_ptr ds)
+{
+    int head = oro_atomic_read(&mheader->head);
+    if ( distance(head, oro_atomic_read(&mheader->tail)) >= mheader->slot_count ) {
+        ++mdropped; // full: drop the sample, like a full message queue does.
+        return false;
+    }
+
+    char* s = slot(head);
+    ShmSlotHeader* sh = reinterpret_cast<ShmSlotHeader*>(s);
+    void* payload = sh + 1;
+    // the marshaller writes into the slot, or returns the sample's own memory for plain types.
+    std::pair<void const*, int> blob = mtransport.fillBlob(ds, payload, mheader->slot_size, marshaller_cookie);
+    if (blob.first == 0 || blob.second > (int) mheader->slot_size)
+    {
+        log(Error) << "ShmChannel: failed to marshal sample into a slot of " << mheader->slot_size << " bytes" << endlog();
+        return false;
+    }
+    if (blob.first != payload)
+        memcpy(payload, blob.first, blob.second);
+    sh->length = blob.second;
+
+    // full barrier: the contents of the slot are visible before the new head,
+    // and the new head before we look for a waiting reader.
+    oro_atomic_inc(&mheader->head);
+    if ( oro_atomic_read(&mheader->waiting) ) {
+        oro_atomic_inc(&mheader->wake);
+        futex_wake(&mheader->wake);
+    }
+    return true;
+}
@@ -0,0 +1,179 @@
+/***************************************************************************
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU General Public                   *
+ *   License as published by the Free Software Foundation;                 *
+ *   version 2 of the License.                                             *
+ *                                                                         *
+ *   As a special exception, you may use this file as part of a free       *
+ *   software library without restriction.  Specifically, if other files   *
+ *   instantiate templates or use macros or inline functions from this     *
+ *   file, or you compile this file and link it with other files to        *
+ *   produce an executable, this file does not by itself cause the         *
+ *   resulting executable to be covered by the GNU General Public          *
+ *   License.  This exception does not however invalidate any other        *
+ *   reasons why the executable file might be covered by the GNU General   *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   This library is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU     *
+ *   Lesser General Public License for more details.                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public             *
+ *   License along with this library; if not, write to the Free Software   *
+ *   Foundation, Inc., 59 Temple Place,                                    *
+ *   Suite 330, Boston, MA  02111-1307  USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef ORO_SHMSENDRECV_HPP_
+#define ORO_SHMSENDRECV_HPP_
+
+#include "../../rtt-fwd.hpp"
+#include "../../base/DataSourceBase.hpp"
+#include "../../os/Time.hpp"
+#include <string>
+
+namespace RTT
+{
+    namespace shm
+    {
+        struct ShmHeader;
+
+        /**
+         * Implements the sending/receiving of samples through a ring of
+         * fixed-size slots in a POSIX shared memory object. The writer
+         * marshals each sample directly into a free slot and the reader
+         * unmarshals it directly from that slot, such that no sample
+         * passes through the kernel. A reader waiting for data sleeps
+         * on a futex in the shared memory, which the writer only wakes
+         * up when the reader is actually waiting.
+         *
+         * It can only be OR sender OR receiver (logical XOR). The ring
+         * has one writer and one reader: if it is full, new samples are
+         * dropped, like with a full message queue. The number of slots is
+         * the buffer size of the ConnPolicy rounded up to a power of two.
+         */
+        class ShmSendRecv
+        {
+            class Receiver;
+        protected:
+            /**
+             * Transport marshaller used for size calculations
+             * and data updates.
+             */
+            types::TypeMarshaller const& mtransport;
+            /**
+             * A private blob that is returned by mtransport.getCookie(). It is
+             * used by the marshallers if they need private internal data to do
+             * the marshalling
+             */
+            void* marshaller_cookie;
+            /**
+             * The mapped shared memory object, null if not mapped.
+             */
+            ShmHeader* mheader;
+            /**
+             * The size of the mapping.
+             */
+            size_t mmap_size;
+            /**
+             * True if this object is a sender.
+             */
+            bool mis_sender;
+            /**
+             * True if the initial sample was received, false after cleanupStream().
+             */
+            bool minit_done;
+            /**
+             * The name of the shared memory object, as specified in the ConnPolicy when
+             * creating the stream, or self-calculated when that name was empty.
+             */
+            std::string mshmname;
+            /**
+             * Set by shmInterrupt() to end shmWait().
+             */
+            volatile bool minterrupted;
+            /**
+             * The number of samples dropped by shmWrite() because the ring was full.
+             */
+            size_t mdropped;
+            /**
+             * The thread which forwards the received samples, receiver only.
+             */
+            Receiver* mreceiver;
+
+            /**
+             * Returns the slot of the head or tail \a counter.
+             */
+            char* slot(int counter) const;
+
+        public:
+            /**
+             * Create a channel element for remote data exchange.
+             * @param transport The type specific object that will be used to marshal the data.
+             */
+            ShmSendRecv(types::TypeMarshaller const& transport);
+
+            /**
+             * Creates or opens the shared memory object. The side that
+             * creates it determines the number and the size of the slots,
+             * from the ConnPolicy or, if the policy has a zero data size,
+             * from the sample given in \a ds.
+             * @throw std::runtime_error if the object can not be opened.
+             */
+            void setupStream(base::DataSourceBase::shared_ptr ds, base::PortInterface* port, ConnPolicy const& policy, bool is_sender);
+
+            ~ShmSendRecv();
+
+            void cleanupStream();
+
+            /**
+             * Works only in receive mode, waits for the initial sample
+             * and starts forwarding new samples to \a chan.
+             */
+            bool shmReady(base::DataSourceBase::shared_ptr ds, base::ChannelElementBase* chan);
+
+            /**
+             * Read the oldest sample from the ring.
+             * @param ds stores the resulting data sample.
+             * @return true if an item could be read.
+             */
+            bool shmRead(base::DataSourceBase::shared_ptr ds);
+
+            /**
+             * Returns true if the ring holds samples that were not read yet.
+             */
+            bool shmPending() const;
+
+            /**
+             * Waits at most \a timeout for a sample to arrive, or without
+             * a time limit if \a timeout is zero, until shmInterrupt().
+             * @return true if there is a sample to read.
+             */
+            bool shmWait(Seconds timeout);
+
+            /**
+             * Wakes up shmWait(), and makes it return immediately from now on.
+             */
+            void shmInterrupt();
+
+            /**
+             * Write to the ring
+             * @param ds the data sample to write
+             * @return true if it could be written, false if it could not be
+             * marshalled or was dropped because the ring is full.
+             */
+            bool shmWrite(base::DataSourceBase::shared_ptr ds);
+
+            /**
+             * Returns the number of samples that shmWrite() dropped
+             * because the ring was full.
+             */
+            size_t shmDropped() const;
+        };
+    }
+}
+
+#endif /* ORO_SHMSENDRECV_HPP_ */
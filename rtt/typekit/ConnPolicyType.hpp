@@ -58,6 +58,8 @@ namespace boost {
             a & boost::serialization::make_nvp("pull", c.pull );
             a & boost::serialization::make_nvp("buffer_policy", c.buffer_policy );
             a & boost::serialization::make_nvp("mandatory", c.mandatory );
+            a & boost::serialization::make_nvp("shared_samples", c.shared_samples );
+            a & boost::serialization::make_nvp("seqlock", c.seqlock );
             a & boost::serialization::make_nvp("transport", c.transport );
             a & boost::serialization::make_nvp("data_size", c.data_size );
             a & boost::serialization::make_nvp("name_id", c.name_id );
@@ -69,7 +69,7 @@ namespace RTT
     public:
         typedef const std::type_info * TypeId;
 
-        TypeInfo(const std::string& name) : mtypenames(1,name) {}
+        TypeInfo(const std::string& name) : mtypenames(1,name), mtid_name(0), mtid(0) {}
 
         ~TypeInfo();
         /**
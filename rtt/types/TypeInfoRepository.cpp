@@ -46,6 +46,9 @@
 #include "../internal/mystd.hpp"
 #include "../internal/DataSourceTypeInfo.hpp"
 #include <boost/algorithm/string.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
+#include <cstring>
 
 namespace RTT
 {
@@ -54,12 +57,65 @@ namespace RTT
 
     namespace {
         boost::shared_ptr<TypeInfoRepository> typerepos;
+
+        /**
+         * Hashes and compares the names of std::type_info objects.
+         */
+        struct TypeIdNameHash
+        {
+            std::size_t operator()(const char* name) const {
+                return boost::hash_range(name, name + std::strlen(name));
+            }
+        };
+        struct TypeIdNameEqual
+        {
+            bool operator()(const char* a, const char* b) const {
+                return a == b || std::strcmp(a, b) == 0;
+            }
+        };
     }
 
+    struct TypeInfoRepository::Index
+    {
+        typedef boost::unordered_map<std::string, TypeInfo*> Names;
+        /** The names under which the types were added. */
+        Names names;
+        /** The other names of the types. */
+        Names aliases;
+        typedef boost::unordered_map<const char*, TypeInfo*, TypeIdNameHash, TypeIdNameEqual> Ids;
+        /** The types by the name of their type id. */
+        Ids ids;
+
+        /**
+         * Adds type \a t under \a name. Its aliases and type id keep
+         * referring to the types which were inserted before.
+         */
+        void insert(const std::string& name, TypeInfo* t)
+        {
+            names[name] = t;
+            std::vector< std::string > tnames = t->getTypeNames();
+            for (vector<std::string>::iterator j = tnames.begin(); j != tnames.end(); ++j)
+                aliases.insert( std::make_pair(*j, t) );
+            if ( t->getTypeId() )
+                ids.insert( std::make_pair(t->getTypeId()->name(), t) );
+        }
+    };
+
     TypeInfoRepository::TypeInfoRepository()
+        : index( new Index() )
     {
     }
 
+    void TypeInfoRepository::rebuildIndex() const
+    {
+        Index* next = new Index();
+        // in the order of data, such that the first type with
+        // a given alias or type id is found, as before.
+        for (map_t::const_iterator i = data.begin(); i != data.end(); ++i)
+            next->insert( i->first, i->second );
+        index.publish( next );
+    }
+
     boost::shared_ptr<TypeInfoRepository> TypeInfoRepository::Instance()
     {
         if ( typerepos )
@@ -80,29 +136,40 @@ namespace RTT
     
     TypeInfo* TypeInfoRepository::typeInternal( const std::string& name ) const
     {
-        MutexLock lock(type_lock);
-        map_t::const_iterator i = data.find( name );
-        if ( i != data.end() ) {
-            // found
-            return i->second;
-        }
-
-        // try alternate name replace / with dots:
+        // alternate name, replace / with dots:
         string tkname = "/" + boost::replace_all_copy(boost::replace_all_copy(name, string("."), "/"), "<","</");
-        i = data.find( tkname );
-        if ( i != data.end() ) {
-            // found
-            return i->second;
+        {
+            os::Epoch::Guard guard;
+            const Index& idx = index.get();
+            Index::Names::const_iterator i = idx.names.find( name );
+            if ( i != idx.names.end() ) {
+                // found
+                return i->second;
+            }
+
+            // try alternate name
+            i = idx.names.find( tkname );
+            if ( i != idx.names.end() ) {
+                // found
+                return i->second;
+            }
+
+            // try alias name
+            i = idx.aliases.find( name );
+            if ( i != idx.aliases.end() )
+                return i->second;
+            i = idx.aliases.find( tkname );
+            if ( i != idx.aliases.end() )
+                return i->second;
         }
 
-        // try alias name
-        for (i = data.begin(); i != data.end(); ++i) {
-            std::vector< std::string > names = i->second->getTypeNames();
-            vector<std::string>::iterator j = names.begin();
-            for (; j != names.end(); ++j) {
-                if(((*j) == name) || ((*j) == tkname)) {
-                    return i->second;
-                }
+        // TypeInfo::addAlias() may have added an alias after the index
+        // was built, so scan the types as well:
+        MutexLock lock(type_lock);
+        for (map_t::const_iterator t = data.begin(); t != data.end(); ++t) {
+            if ( t->second->isType(name) || t->second->isType(tkname) ) {
+                rebuildIndex();
+                return t->second;
             }
         }
 
@@ -139,23 +206,47 @@ namespace RTT
     TypeInfo* TypeInfoRepository::getTypeById(TypeInfo::TypeId type_id) const {
       if (!type_id)
           return 0;
+      bool indexed;
+      {
+          os::Epoch::Guard guard;
+          const Index& idx = index.get();
+          Index::Ids::const_iterator i = idx.ids.find( type_id->name() );
+          indexed = ( i != idx.ids.end() );
+          if ( indexed && *(i->second->getTypeId()) == *type_id )
+              return i->second;
+      }
+      // A type id may have been set after the index was built, or distinct
+      // types have equal type id names, ask each type for its type id.
       MutexLock lock(type_lock);
-      // Ask each type for its type id name.
       map_t::const_iterator i = data.begin();
       for (; i != data.end(); ++i){
-        if (i->second->getTypeId() && *(i->second->getTypeId()) == *type_id)
+        if (i->second->getTypeId() && *(i->second->getTypeId()) == *type_id) {
+          if (!indexed)
+              rebuildIndex();
           return i->second;
+        }
       }
       return 0;
     }
 
     TypeInfo* TypeInfoRepository::getTypeById(const char * type_id_name) const {
-      // Ask each type for its type id name.
+      if (!type_id_name)
+          return 0;
+      {
+          os::Epoch::Guard guard;
+          const Index& idx = index.get();
+          Index::Ids::const_iterator i = idx.ids.find( type_id_name );
+          if ( i != idx.ids.end() )
+              return i->second;
+      }
+      // A type id may have been set after the index was built, ask each type.
       MutexLock lock(type_lock);
       map_t::const_iterator i = data.begin();
       for (; i != data.end(); ++i){
-        if (i->second->getTypeId() && i->second->getTypeId()->name() == type_id_name)
+        if (i->second->getTypeId() && strcmp(i->second->getTypeId()->name(), type_id_name) == 0) {
+          rebuildIndex();
           return i->second;
+        }
       }
       return 0;
     }
@@ -171,6 +262,9 @@ namespace RTT
         }
 
         data[t->getTypeName()] = t;
+        Index* next = new Index( index.get() );
+        next->insert( t->getTypeName(), t );
+        index.publish( next );
         return true;
     }
 
@@ -200,6 +294,9 @@ namespace RTT
         MutexLock lock(type_lock);
         // keep track of this type:
         data[ tname ] = ti;
+        Index* next = new Index( index.get() );
+        next->insert( tname, ti );
+        index.publish( next );
 
         log(Debug) << "Registered Type '"<<tname <<"' to the Orocos Type System."<<Logger::endl;
         for(Transports::iterator it = transports.begin(); it != transports.end(); ++it)
@@ -45,6 +45,7 @@
 #include <boost/function.hpp>
 #include "TypeInfo.hpp"
 #include "TypeInfoGenerator.hpp"
+#include "../os/Epoch.hpp"
 
 namespace RTT
 { namespace types {
@@ -62,6 +63,22 @@ namespace RTT
         typedef std::vector<TransportPlugin*> Transports;
         Transports transports;
         mutable os::Mutex type_lock;
+
+        /**
+         * Hash indexes of the types by name, alias and type id, which are
+         * read inside an os::Epoch::Guard without taking type_lock. Adding
+         * a type publishes a copy of the index which includes it. A new
+         * index is built from data when a lookup finds a type under an
+         * alias or type id that was set later.
+         */
+        struct Index;
+        mutable os::EpochPointer<Index> index;
+
+        /**
+         * Builds a new index from data and publishes it.
+         * type_lock must be held by the caller.
+         */
+        void rebuildIndex() const;
         
         boost::function<bool (const std::string &)> loadTypeKitForName;
         
@@ -30,7 +30,10 @@
 #include <base/Buffer.hpp>
 #include <internal/ListLockFree.hpp>
 #include <base/DataObject.hpp>
+#include <base/DataObjectSeqLock.hpp>
 #include <internal/TsPool.hpp>
+#include <internal/SharedSample.hpp>
+#include <os/Epoch.hpp>
 //#include <internal/SortedList.hpp>
 
 #include <os/Thread.hpp>
@@ -43,6 +46,18 @@ using namespace std;
 using namespace RTT;
 using namespace RTT::detail;
 
+namespace {
+    /** Counts the objects that an EpochPointer did not reclaim yet. */
+    struct EpochCounted
+    {
+        static int alive;
+        int value;
+        EpochCounted() : value(1) { ++alive; }
+        ~EpochCounted() { value = 0; --alive; }
+    };
+    int EpochCounted::alive = 0;
+}
+
 class Dummy {
 public:
     Dummy(double a = 0.0, double b =1.0, double c=2.0)
@@ -181,6 +196,7 @@ public:
     DataObjectLocked<Dummy>* dlocked;
     DataObjectLockFree<Dummy>* dlockfree;
     DataObjectUnSync<Dummy>* dunsync;
+    DataObjectSeqLock<Dummy>* dseqlock;
 
     void testBuf();
     void testCirc();
@@ -206,6 +222,7 @@ public:
         dlockfree = new DataObjectLockFree<Dummy>(Dummy());
         dlocked   = new DataObjectLocked<Dummy>(Dummy());
         dunsync   = new DataObjectUnSync<Dummy>(Dummy());
+        dseqlock  = new DataObjectSeqLock<Dummy>(Dummy());
 
         // defaults
         buffer = lockfree;
@@ -222,6 +239,7 @@ public:
         delete dlockfree;
         delete dlocked;
         delete dunsync;
+        delete dseqlock;
     }
 
     class DataObjectWriter : public RunnableInterface {
@@ -290,6 +308,96 @@ public:
         }
     };
 
+    /**
+     * A sample which takes long to copy, such that a reader is likely
+     * to be preempted while copying it.
+     */
+    struct LargeSample {
+        double values[1024];
+    };
+
+    /**
+     * Writes samples of which all values are equal through loans, and
+     * discards every other loan after overwriting it.
+     */
+    class DataObjectLoanWriter : public RunnableInterface {
+    private:
+        DataObjectInterface<LargeSample> *dataobj;
+        bool stop;
+
+    public:
+        int writes;
+        int discards;
+
+    public:
+        DataObjectLoanWriter(DataObjectInterface<LargeSample> *dataobj) : dataobj(dataobj), stop(false), writes(0), discards(0) {}
+        bool initialize() {
+            stop = false;
+            return true;
+        }
+        void step() {
+            double value = 0.0;
+            while (stop == false) {
+                LargeSample* item = dataobj->Loan();
+                if (!item)
+                    continue;
+                value += 1.0;
+                std::fill(item->values, item->values + 1024, value);
+                if (writes == discards) {
+                    dataobj->Commit(item);
+                    ++writes;
+                } else {
+                    dataobj->Discard(item);
+                    ++discards;
+                }
+            }
+        }
+
+        void finalize() {}
+
+        bool breakLoop() {
+            stop = true;
+            return true;
+        }
+    };
+
+    /**
+     * Reads samples and counts those of which not all values are equal.
+     */
+    class DataObjectConsistencyReader : public RunnableInterface {
+    private:
+        DataObjectInterface<LargeSample> *dataobj;
+        bool stop;
+        LargeSample sample;
+
+    public:
+        int reads;
+        int torn;
+
+    public:
+        DataObjectConsistencyReader(DataObjectInterface<LargeSample> *dataobj) : dataobj(dataobj), stop(false), reads(0), torn(0) {}
+        bool initialize() {
+            stop = false;
+            return true;
+        }
+        void step() {
+            while (stop == false) {
+                if (dataobj->Get(sample, false) != NewData)
+                    continue;
+                ++reads;
+                if (std::count(sample.values, sample.values + 1024, sample.values[0]) != 1024)
+                    ++torn;
+            }
+        }
+
+        void finalize() {}
+
+        bool breakLoop() {
+            stop = true;
+            return true;
+        }
+    };
+
     class BufferWriter : public RunnableInterface {
     private:
         BufferInterface<Dummy> *buffer;
@@ -1094,6 +1202,74 @@ BOOST_AUTO_TEST_CASE( testBufLockFree )
     circular = clockfree;
     testBuf();
     testCirc();
+
+    // a full circular buffer only drops its oldest sample when a loan is committed
+    circular->clear();
+    for (int i = 0; i != QS; ++i)
+        BOOST_CHECK( circular->Push( Dummy(i, i, i) ) );
+    std::vector<Dummy*> loans;
+    while ( Dummy* loan = circular->Loan() )
+        loans.push_back( loan );
+    BOOST_CHECK( !loans.empty() );
+    BOOST_CHECK_EQUAL( circular->size(), QS );
+    for (unsigned int i = 0; i != loans.size(); ++i)
+        circular->Release( loans[i] );
+    Dummy r;
+    BOOST_CHECK_EQUAL( circular->Pop(r), NewData );
+    BOOST_CHECK_EQUAL( r, Dummy(0, 0, 0) );
+    BOOST_CHECK( circular->Push( Dummy(QS, QS, QS) ) );
+    Dummy* loan = circular->Loan();
+    BOOST_REQUIRE( loan );
+    *loan = Dummy(QS + 1, QS + 1, QS + 1);
+    BOOST_CHECK( circular->Commit( loan ) );
+    BOOST_CHECK_EQUAL( circular->Pop(r), NewData );
+    BOOST_CHECK_EQUAL( r, Dummy(2, 2, 2) );
+    circular->clear();
+}
+
+BOOST_AUTO_TEST_CASE( testBufLockFreeSPSC )
+{
+    buffer = new BufferLockFreeSPSC<Dummy>(QS, Dummy());
+    testBuf();
+
+    // elements popped without release block the writer until released, in any order
+    Dummy* c = new Dummy(2.0, 1.0, 0.0);
+    Dummy r;
+    std::vector<Dummy*> popped;
+    for(int i = 0; i != QS; ++i)
+        BOOST_CHECK( buffer->Push( *c ) );
+    while( Dummy *item = buffer->PopWithoutRelease() )
+        popped.push_back(item);
+    BOOST_REQUIRE_EQUAL( popped.size(), (size_t)QS );
+    int written = 0;
+    while( buffer->Push( *c ) )
+        ++written;
+    BOOST_CHECK( written >= 2 );
+    BOOST_CHECK( written < QS );
+    buffer->Release(popped[1]);
+    BOOST_CHECK( buffer->Push( *c ) == false );
+    buffer->Release(popped[0]);
+    BOOST_CHECK( buffer->Push( *c ) );
+    for(int i = 2; i != QS; ++i)
+        buffer->Release(popped[i]);
+    BOOST_CHECK_EQUAL( buffer->size(), written + 1 );
+
+    // a discarded loan is handed out again
+    buffer->clear();
+    Dummy* loan = buffer->Loan();
+    BOOST_REQUIRE( loan );
+    buffer->Release(loan);
+    BOOST_CHECK( buffer->Loan() == loan );
+    *loan = *c;
+    BOOST_CHECK( buffer->Commit(loan) );
+    BOOST_CHECK( buffer->Pop(r) );
+    BOOST_CHECK( r == *c );
+    delete buffer;
+    delete c;
+
+    buffer = new BufferLockFreeSPSC<Dummy>(QS, Dummy());
+    testBufMultiThreaded(1, 1);
+    delete buffer;
 }
 
 BOOST_AUTO_TEST_CASE( testBufLocked )
@@ -1130,6 +1306,52 @@ BOOST_AUTO_TEST_CASE( testDObjUnSync )
     testDObj();
 }
 
+BOOST_AUTO_TEST_CASE( testDObjSeqLock )
+{
+    BOOST_CHECK( is_seqlock_copyable<Dummy>::value );
+    BOOST_CHECK( !is_seqlock_copyable<std::vector<double> >::value );
+
+    dataobj = dseqlock;
+    testDObj();
+
+    // NewData is returned once per sample, also with loans
+    Dummy d;
+    dataobj->Set( Dummy(1.0, 2.0, 3.0) );
+    Dummy* item = 0;
+    BOOST_CHECK_EQUAL( NewData, dataobj->GetWithoutRelease(item) );
+    BOOST_REQUIRE( item );
+    BOOST_CHECK_EQUAL( *item, Dummy(1.0, 2.0, 3.0) );
+    // the loaned sample is not overwritten
+    dataobj->Set( Dummy(4.0, 5.0, 6.0) );
+    BOOST_CHECK_EQUAL( *item, Dummy(1.0, 2.0, 3.0) );
+    dataobj->Release(item);
+    BOOST_CHECK_EQUAL( NewData, dataobj->Get(d) );
+    BOOST_CHECK_EQUAL( d, Dummy(4.0, 5.0, 6.0) );
+    BOOST_CHECK_EQUAL( OldData, dataobj->Get(d) );
+
+    // a second reader gets its own copy while the first loan is outstanding
+    Dummy* other = 0;
+    BOOST_CHECK_EQUAL( OldData, dataobj->GetWithoutRelease(item) );
+    BOOST_CHECK_EQUAL( OldData, dataobj->GetWithoutRelease(other) );
+    BOOST_REQUIRE( item && other );
+    BOOST_CHECK( item != other );
+    BOOST_CHECK_EQUAL( *other, Dummy(4.0, 5.0, 6.0) );
+    dataobj->Release(other);
+    dataobj->Release(item);
+
+    // a discarded loan is not published
+    item = dataobj->Loan();
+    BOOST_REQUIRE( item );
+    BOOST_CHECK( dataobj->Loan() == 0 );
+    *item = Dummy(7.0, 8.0, 9.0);
+    dataobj->Discard(item);
+    BOOST_CHECK_EQUAL( OldData, dataobj->Get(d) );
+    BOOST_CHECK_EQUAL( d, Dummy(4.0, 5.0, 6.0) );
+
+    dataobj->clear();
+    BOOST_CHECK_EQUAL( NoData, dataobj->Get(d) );
+}
+
 BOOST_AUTO_TEST_CASE( testBufLockFree4Writers1Reader )
 {
     buffer
@@ -1212,6 +1434,41 @@ BOOST_AUTO_TEST_CASE( testDObjLockFree4Writers4Readers )
     delete dataobj;
 }
 
+BOOST_AUTO_TEST_CASE( testDObjSeqLockSingleWriter4Readers )
+{
+    dataobj = dseqlock;
+    testDObjMultiThreaded(1, 4);
+}
+
+BOOST_AUTO_TEST_CASE( testDObjSeqLock4Writers4Readers )
+{
+    dataobj = dseqlock;
+    testDObjMultiThreaded(4, 4);
+}
+
+BOOST_AUTO_TEST_CASE( testDObjSeqLockDiscardWhileReading )
+{
+    // a discarded loan may have overwritten the copy a reader is copying,
+    // which the reader must notice.
+    LargeSample initial;
+    std::fill(initial.values, initial.values + 1024, 0.0);
+    DataObjectSeqLock<LargeSample> seqlock( initial, DataObjectBase::Options().max_threads(5) );
+    ThreadPool<DataObjectLoanWriter> writers(1, ORO_SCHED_OTHER, 0, 0, "DataObjectLoanWriter", (DataObjectInterface<LargeSample>*) &seqlock);
+    ThreadPool<DataObjectConsistencyReader> readers(4, ORO_SCHED_OTHER, 0, 0, "DataObjectConsistencyReader", (DataObjectInterface<LargeSample>*) &seqlock);
+
+    BOOST_REQUIRE( readers.start() );
+    BOOST_REQUIRE( writers.start() );
+    sleep(2);
+    BOOST_REQUIRE( writers.stop() );
+    BOOST_REQUIRE( readers.stop() );
+
+    BOOST_CHECK_GT( writers[0].first->discards, 0 );
+    BOOST_FOREACH(ThreadPool<DataObjectConsistencyReader>::value_type &reader, readers) {
+        BOOST_CHECK_GT( reader.first->reads, 0 );
+        BOOST_CHECK_EQUAL( reader.first->torn, 0 );
+    }
+}
+
 BOOST_AUTO_TEST_CASE( testDObjLockedSingleWriter4Readers )
 {
     dataobj = dlocked;
@@ -1303,6 +1560,62 @@ BOOST_AUTO_TEST_CASE( testMemoryPoolMultiThreaded )
     }
 }
 
+BOOST_AUTO_TEST_CASE( testSharedSampleSlotsAreReleased )
+{
+    typedef internal::SharedSample<int> Sample;
+    ConnPolicy policy = ConnPolicy::buffer(4);
+    unsigned int capacity = internal::SharedSamplePool<int>::capacityFor(policy);
+    internal::SharedSamplePool<int>::shared_ptr pool( new internal::SharedSamplePool<int>() );
+    pool->reserve( capacity );
+
+    Sample sample;
+    BufferLockFreeSPSC<Sample> spsc( 4, sample, BufferBase::Options(policy) );
+    BufferLockFree<Sample> circular( 4, sample, BufferBase::Options(policy).circular(true) );
+    DataObjectLockFree<Sample> data( sample, DataObjectBase::Options(policy) );
+
+    // all three store references to the same samples, which must return to
+    // the pool once they were read, or the pool runs out.
+    for (int i = 0; i != 3 * int(capacity); ++i) {
+        sample = pool->allocate( i );
+        BOOST_REQUIRE( !sample.empty() );
+        BOOST_CHECK( spsc.Push(sample) );
+        BOOST_CHECK( circular.Push(sample) );
+        BOOST_CHECK( data.Set(sample) );
+        if (i % 3 != 2)
+            continue;
+        for (int j = i - 2; j <= i; ++j) {
+            BOOST_CHECK_EQUAL( spsc.Pop(sample), NewData );
+            BOOST_CHECK_EQUAL( *sample, j );
+            BOOST_CHECK_EQUAL( circular.Pop(sample), NewData );
+            BOOST_CHECK_EQUAL( *sample, j );
+        }
+        BOOST_CHECK_EQUAL( data.Get(sample), NewData );
+        BOOST_CHECK_EQUAL( *sample, i );
+    }
+    sample.reset();
+    // only the current sample of the data object is left
+    BOOST_CHECK_EQUAL( pool->size(), capacity - 1 );
+}
+
+BOOST_AUTO_TEST_CASE( testEpochPublishInGuard )
+{
+    {
+        os::EpochPointer<EpochCounted> ptr;
+        {
+            os::Epoch::Guard guard;
+            const EpochCounted& old = ptr.get();
+            ptr.publish( new EpochCounted() );
+            // we may still read the object we replaced inside our own guard.
+            BOOST_CHECK_EQUAL( EpochCounted::alive, 2 );
+            BOOST_CHECK_EQUAL( old.value, 1 );
+        }
+        // it is reclaimed by the next publish() outside the guard.
+        ptr.publish( new EpochCounted() );
+        BOOST_CHECK_EQUAL( EpochCounted::alive, 1 );
+    }
+    BOOST_CHECK_EQUAL( EpochCounted::alive, 0 );
+}
+
 #if 0
 BOOST_AUTO_TEST_CASE( testSortedList )
 {
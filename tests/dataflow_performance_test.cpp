@@ -1505,6 +1505,28 @@ BOOST_AUTO_TEST_CASE( DataFlowPerformanceTest_Data_Shared_4Writers4Readers )
 }
 #endif
 
+#if RTT_VERSION_GTE(2,8,99)
+// 8 writers, 1 reader, PerInputPort (all writers traverse the inputs list of the same buffer)
+BOOST_AUTO_TEST_CASE( DataFlowPerformanceTest_Data_PerInputPort_8Writers1Reader )
+{
+    options.NumberOfWriters = 8;
+    options.NumberOfReaders = 1;
+    options.policy.buffer_policy = PerInputPort;
+    runner.reset(new RunnerType(options));
+    run();
+}
+
+// 8 writers, 8 readers, Shared (all writers and readers traverse the lists of the same connection)
+BOOST_AUTO_TEST_CASE( DataFlowPerformanceTest_Data_Shared_8Writers8Readers )
+{
+    options.NumberOfWriters = 8;
+    options.NumberOfReaders = 8;
+    options.policy.buffer_policy = Shared;
+    runner.reset(new RunnerType(options));
+    run();
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
 
 // Registers the fixture into the 'registry'
@@ -1541,6 +1563,31 @@ BOOST_AUTO_TEST_CASE( DataFlowPerformanceTest_Buffer_PerInputPort_7Writers1Reade
 }
 #endif
 
+#if RTT_VERSION_GTE(2,8,99)
+// 1 writer, 1 reader, PerConnection (single-writer single-reader lock-free buffer)
+BOOST_AUTO_TEST_CASE( DataFlowPerformanceTest_Buffer_PerConnection_1Writer1Reader_SPSC )
+{
+    options.NumberOfWriters = 1;
+    options.NumberOfReaders = 1;
+    options.policy.buffer_policy = PerConnection;
+    options.policy.lock_policy = ConnPolicy::LOCK_FREE;
+    runner.reset(new RunnerType(options));
+    run();
+}
+
+// 1 writer, 1 reader, PerConnection (multi-writer single-reader lock-free buffer for comparison)
+BOOST_AUTO_TEST_CASE( DataFlowPerformanceTest_Buffer_PerConnection_1Writer1Reader_MWSR )
+{
+    options.NumberOfWriters = 1;
+    options.NumberOfReaders = 1;
+    options.policy.buffer_policy = PerConnection;
+    options.policy.lock_policy = ConnPolicy::LOCK_FREE;
+    options.policy.max_threads = 3;
+    runner.reset(new RunnerType(options));
+    run();
+}
+#endif
+
 #if (RTT_VERSION_MAJOR >= 2)
 // 1 writer, 7 readers, PerConnection
 BOOST_AUTO_TEST_CASE( DataFlowPerformanceTest_Buffer_PerInputPort_1Writer7Readers )
@@ -1611,6 +1658,18 @@ BOOST_AUTO_TEST_CASE( DataFlowPerformanceTest_Buffer_Shared_4Writers4Readers )
 }
 #endif
 
+#if RTT_VERSION_GTE(2,8,99)
+// 8 writers, 1 reader, PerInputPort
+BOOST_AUTO_TEST_CASE( DataFlowPerformanceTest_Buffer_PerInputPort_8Writers1Reader )
+{
+    options.NumberOfWriters = 8;
+    options.NumberOfReaders = 1;
+    options.policy.buffer_policy = PerInputPort;
+    runner.reset(new RunnerType(options));
+    run();
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
 
 // Registers the fixture into the 'registry'
@@ -1641,4 +1700,16 @@ BOOST_AUTO_TEST_CASE( DataFlowPerformanceTest_EmptyReads_Shared_7Writers1Reader
 }
 #endif
 
+#if RTT_VERSION_GTE(2,8,99)
+// 64 writers, 1 reader, PerConnection
+BOOST_AUTO_TEST_CASE( DataFlowPerformanceTest_EmptyReads_PerConnection_64Writers1Reader )
+{
+    options.NumberOfWriters = 64;
+    options.NumberOfReaders = 1;
+    options.policy.buffer_policy = PerConnection;
+    runner.reset(new RunnerType(options));
+    run();
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -63,6 +63,31 @@ struct TestLog
   }
 };
 
+struct TestAsyncLog
+  : public RunnableInterface
+{
+  int lines;
+  bool initialize() { lines = 0; return true; }
+
+  void step() {
+      Logger::In in("TALOG");
+      log(Info) << "Asynchronous line " << lines++ << " of a thread." << endlog();
+  }
+
+  void finalize() {
+  }
+};
+
+static int countAsyncLines(Logger* logger)
+{
+    int count = 0;
+    std::string line;
+    while ( !(line = logger->getLogLine()).empty() )
+        if ( line.find("Asynchronous line") != std::string::npos )
+            ++count;
+    return count;
+}
+
 
 BOOST_FIXTURE_TEST_SUITE( LoggerTestSuite, LoggerTest )
 
@@ -118,4 +143,62 @@ BOOST_AUTO_TEST_CASE( testThreadLog )
 
 }
 
+BOOST_AUTO_TEST_CASE( testAsyncLog )
+{
+  countAsyncLines(logger);
+  logger->allowAsync();
+  BOOST_REQUIRE( logger->isAsync() );
+  unsigned int dropped = logger->getDroppedRecords();
+
+  boost::scoped_ptr<TestAsyncLog> run( new TestAsyncLog() );
+  boost::scoped_ptr<ActivityInterface> t( new Activity(25, 0.001, 0, "ORActivity1") );
+  boost::scoped_ptr<TestAsyncLog> run2( new TestAsyncLog() );
+  boost::scoped_ptr<ActivityInterface> t2( new Activity(25, 0.001, 0, "ORActivity2") );
+
+  t->run( run.get() );
+  t2->run( run2.get() );
+
+  int received = 0;
+  t->start();
+  t2->start();
+  for (int i = 0; i != 50; ++i) {
+      usleep(10000);
+      received += countAsyncLines(logger);
+  }
+  t->stop();
+  t2->stop();
+
+  // more threads than ThreadLogs, which are reused when their threads exit.
+  int exited = 0;
+  for (int i = 0; i != 100; ++i) {
+      TestAsyncLog once;
+      Activity* a = new Activity( &once, "ORActivityOnce" );
+      BOOST_REQUIRE( a->start() );
+      for (int w = 0; w != 1000 && once.lines == 0; ++w)
+          usleep(1000);
+      BOOST_REQUIRE( a->stop() );
+      delete a;
+      exited += once.lines;
+      if ( i % 10 == 0 )
+          usleep(100000);
+  }
+
+  // a burst which may overflow the ring of this thread.
+  for (int i = 0; i != 300; ++i)
+      log(Info) << "Asynchronous line " << i << " of the main thread." << endlog();
+
+  logger->disallowAsync();
+  BOOST_CHECK( !logger->isAsync() );
+  received += countAsyncLines(logger);
+
+  BOOST_CHECK( run->lines > 0 );
+  BOOST_CHECK( run2->lines > 0 );
+  BOOST_CHECK_EQUAL( exited, 100 );
+#ifdef OROSEM_REMOTE_LOGGING
+  BOOST_CHECK_EQUAL( received + int(logger->getDroppedRecords() - dropped), run->lines + run2->lines + exited + 300 );
+#else
+  (void)dropped;
+#endif
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -20,6 +20,13 @@
 
 #define ORO_TEST_OPERATION_CALLER
 
+#include <rtt-config.h>
+#ifdef OS_RT_MALLOC
+// need access to the TLSF statistics embedded in RTT
+#define ORO_MEMORY_POOL
+#include <rtt/os/tlsf/tlsf.h>
+#endif
+
 #include <TaskContext.hpp>
 #include <OperationCaller.hpp>
 #include <Operation.hpp>
@@ -270,6 +277,55 @@ BOOST_AUTO_TEST_CASE(testOwnThreadOperationCallerSend)
     BOOST_CHECK_EQUAL( -8.0, h7.ret() );
 }
 
+BOOST_AUTO_TEST_CASE(testOwnThreadOperationCallerSendPool)
+{
+    OperationCaller<double(int)> m1("m1", &OperationsFixture::m1, this, tc->engine(), caller->engine(), OwnThread);
+    BOOST_REQUIRE( m1.setMaxConcurrentSends(2) );
+    BOOST_REQUIRE( tc->isRunning() );
+    BOOST_REQUIRE( caller->isRunning() );
+
+#ifdef OS_RT_MALLOC
+    size_t used = get_used_size_mp();
+#endif
+    SendHandle<double(int)> h1 = m1.send(1);
+    SendHandle<double(int)> h2 = m1.send(2);
+    SendHandle<double(int)> h3 = m1.send(3);
+#ifdef OS_RT_MALLOC
+    // sending from the pool does not allocate real-time memory
+    BOOST_CHECK_EQUAL( used, get_used_size_mp() );
+#endif
+    BOOST_CHECK( h1.ready() );
+    BOOST_CHECK( h2.ready() );
+    // all pre-allocated invocations are in use
+    BOOST_CHECK( !h3.ready() );
+    BOOST_CHECK_EQUAL( SendFailure, h3.collect() );
+
+    double retn = 0;
+    BOOST_CHECK_EQUAL( SendSuccess, h1.collect(retn) );
+    BOOST_CHECK_EQUAL( retn, -2.0 );
+    BOOST_CHECK_EQUAL( SendSuccess, h2.collect(retn) );
+    BOOST_CHECK_EQUAL( retn, 2.0 );
+
+    // the invocations are reused once their handles are gone and they have been disposed,
+    // which the engine did before it executes the next message.
+    h1 = SendHandle<double(int)>();
+    h2 = SendHandle<double(int)>();
+    OperationCaller<double(void)> m0("m0", &OperationsFixture::m0, this, tc->engine(), caller->engine(), OwnThread);
+    BOOST_CHECK_EQUAL( -1.0, m0.call() );
+    h3 = m1.send(3);
+    BOOST_REQUIRE( h3.ready() );
+    BOOST_CHECK_EQUAL( SendSuccess, h3.collect(retn) );
+    BOOST_CHECK_EQUAL( retn, 2.0 );
+
+    // back to allocating invocations
+    BOOST_REQUIRE( m1.setMaxConcurrentSends(0) );
+    h1 = m1.send(1);
+    h2 = m1.send(2);
+    SendHandle<double(int)> h4 = m1.send(4);
+    BOOST_CHECK( h1.ready() && h2.ready() && h4.ready() );
+    BOOST_CHECK_EQUAL( SendSuccess, h4.collect(retn) );
+}
+
 BOOST_AUTO_TEST_CASE(testLocalOperationCallerFactory)
 {
     // Test the addition of 'simple' operationCallers to the operation interface,
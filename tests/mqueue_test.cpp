@@ -34,6 +34,7 @@ using namespace RTT::detail;
 #include <OutputPort.hpp>
 #include <TaskContext.hpp>
 #include <string>
+#include <sstream>
 
 using namespace RTT;
 using namespace RTT::detail;
@@ -382,5 +383,63 @@ BOOST_AUTO_TEST_CASE( testVectorTransport )
     rtos_disable_rt_warning();
 }
 
+/**
+ * Measures the time between writing a sample and its arrival in the
+ * input port, while the Dispatcher monitors an increasing number of
+ * message queues of which only one receives data.
+ */
+BOOST_AUTO_TEST_CASE( testDispatcherScaling )
+{
+    const unsigned int counts[] = { 1, 16, 64, 128 };
+    const int samples = 100;
+    std::vector< OutputPort<double>* > writers;
+    std::vector< InputPort<double>* > readers;
+
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 10;
+
+    for (unsigned int c = 0; c != sizeof(counts) / sizeof(counts[0]); ++c) {
+        while ( writers.size() < counts[c] ) {
+            writers.push_back( new OutputPort<double>("w") );
+            readers.push_back( new InputPort<double>("r") );
+            std::stringstream name;
+            name << "/dispatch" << writers.size();
+            policy.name_id = name.str();
+            if ( !writers.back()->createConnection( *readers.back(), policy ) )
+                break;
+        }
+        if ( !writers.back()->connected() ) {
+            // most likely the system limit of message queues (/proc/sys/fs/mqueue/queues_max).
+            std::cout << "Could not create " << counts[c] << " message queues, stopping." << std::endl;
+            break;
+        }
+
+        double total = 0, worst = 0;
+        for (int i = 0; i != samples; ++i) {
+            unsigned int target = (i * 7) % writers.size();
+            double value = 0;
+            os::TimeService::ticks start = os::TimeService::Instance()->getTicks();
+            writers[target]->write( i );
+            while ( readers[target]->read( value ) != NewData
+                    && os::TimeService::Instance()->secondsSince( start ) < 1.0 )
+                ;
+            double latency = os::TimeService::Instance()->secondsSince( start );
+            BOOST_CHECK_EQUAL( value, double(i) );
+            total += latency;
+            worst = std::max( worst, latency );
+        }
+        std::cout << "Dispatcher wake-up latency with " << writers.size() << " queues: mean "
+                  << total / samples * 1e6 << "us, worst " << worst * 1e6 << "us." << std::endl;
+    }
+
+    for (unsigned int i = 0; i != writers.size(); ++i) {
+        writers[i]->disconnect();
+        readers[i]->disconnect();
+        delete writers[i];
+        delete readers[i];
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
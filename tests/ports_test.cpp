@@ -28,10 +28,12 @@
 
 #include <boost/function_types/function_type.hpp>
 #include <OperationCaller.hpp>
+#include <base/ChannelStatistics.hpp>
 
 #include <rtt-config.h>
 
 #include <memory>
+#include <numeric>
 
 using namespace std;
 using namespace RTT;
@@ -302,6 +304,331 @@ BOOST_AUTO_TEST_CASE(testPortSimpleConnections)
     BOOST_CHECK( !wp.connected() );
 }
 
+BOOST_AUTO_TEST_CASE(testPortLoanedSamples)
+{
+    OutputPort<int> wp("WriterName", false);
+    InputPort<int> rp("ReaderName");
+
+    {
+        LoanedSample<int> loaned;
+        BOOST_CHECK( !wp.loan(loaned) );
+        BOOST_CHECK( !loaned.valid() );
+    }
+
+    // data connection
+    BOOST_REQUIRE( wp.createConnection(rp, ConnPolicy::data(ConnPolicy::LOCK_FREE, false)) );
+    {
+        ConstLoanedSample<int> sample;
+        BOOST_CHECK_EQUAL( rp.read(sample), NoData );
+        BOOST_CHECK( !sample.valid() );
+
+        LoanedSample<int> loaned;
+        BOOST_REQUIRE( wp.loan(loaned) );
+        *loaned = 1;
+        BOOST_CHECK_EQUAL( wp.write(loaned), WriteSuccess );
+        BOOST_CHECK( !loaned.valid() );
+
+        BOOST_CHECK_EQUAL( rp.read(sample), NewData );
+        BOOST_REQUIRE( sample.valid() );
+        BOOST_CHECK_EQUAL( *sample, 1 );
+
+        // the writer does not overwrite a sample that is still loaned by the reader
+        BOOST_REQUIRE( wp.loan(loaned) );
+        *loaned = 2;
+        loaned.reset();
+        BOOST_CHECK_EQUAL( wp.write(3), WriteSuccess );
+        BOOST_CHECK_EQUAL( *sample, 1 );
+        BOOST_CHECK_EQUAL( rp.read(sample), NewData );
+        BOOST_CHECK_EQUAL( *sample, 3 );
+        BOOST_CHECK_EQUAL( rp.read(sample), OldData );
+        BOOST_CHECK_EQUAL( *sample, 3 );
+    }
+    wp.disconnect();
+
+    // buffer connection
+    BOOST_REQUIRE( wp.createConnection(rp, ConnPolicy::buffer(2)) );
+    {
+        LoanedSample<int> loaned;
+        for(int i = 1; i <= 2; ++i) {
+            BOOST_REQUIRE( wp.loan(loaned) );
+            *loaned = i;
+            BOOST_CHECK_EQUAL( wp.write(loaned), WriteSuccess );
+        }
+        BOOST_CHECK( !wp.loan(loaned) ); // buffer full
+        BOOST_CHECK_EQUAL( wp.write(3), WriteFailure );
+
+        ConstLoanedSample<int> sample;
+        BOOST_CHECK_EQUAL( rp.read(sample), NewData );
+        BOOST_CHECK_EQUAL( *sample, 1 );
+        BOOST_CHECK_EQUAL( rp.read(sample), NewData );
+        BOOST_CHECK_EQUAL( *sample, 2 );
+        BOOST_CHECK_EQUAL( rp.read(sample), NoData );
+        BOOST_CHECK( !sample.valid() );
+
+        // copying reads and loaned reads can be mixed
+        BOOST_CHECK_EQUAL( wp.write(4), WriteSuccess );
+        int value = 0;
+        BOOST_CHECK_EQUAL( rp.read(value), NewData );
+        BOOST_CHECK_EQUAL( value, 4 );
+    }
+    wp.disconnect();
+
+    // circular buffer connection
+    BOOST_REQUIRE( wp.createConnection(rp, ConnPolicy::circularBuffer(2)) );
+    {
+        LoanedSample<int> loaned;
+        for(int i = 1; i <= 3; ++i) {
+            BOOST_REQUIRE( wp.loan(loaned) );
+            *loaned = i;
+            BOOST_CHECK_EQUAL( wp.write(loaned), WriteSuccess );
+        }
+
+        ConstLoanedSample<int> sample;
+        BOOST_CHECK_EQUAL( rp.read(sample), NewData );
+        BOOST_CHECK_EQUAL( *sample, 2 );
+        BOOST_CHECK_EQUAL( rp.read(sample), NewData );
+        BOOST_CHECK_EQUAL( *sample, 3 );
+    }
+
+    // no loans if the sample has to be copied to multiple connections anyway
+    InputPort<int> rp2("ReaderName2");
+    BOOST_REQUIRE( wp.createConnection(rp2, ConnPolicy::buffer(2)) );
+    {
+        LoanedSample<int> loaned;
+        BOOST_CHECK( !wp.loan(loaned) );
+    }
+    wp.disconnect();
+
+    // locked connections loan a copy of the sample
+    BOOST_REQUIRE( wp.createConnection(rp, ConnPolicy::data(ConnPolicy::LOCKED)) );
+    {
+        ConstLoanedSample<int> sample;
+        BOOST_CHECK_EQUAL( rp.read(sample), NoData );
+        BOOST_CHECK( !sample.valid() );
+        BOOST_CHECK_EQUAL( wp.write(5), WriteSuccess );
+        BOOST_CHECK_EQUAL( rp.read(sample), NewData );
+        BOOST_REQUIRE( sample.valid() );
+        BOOST_CHECK_EQUAL( *sample, 5 );
+        BOOST_CHECK_EQUAL( wp.write(6), WriteSuccess );
+        BOOST_CHECK_EQUAL( *sample, 5 );
+        BOOST_CHECK_EQUAL( rp.read(sample), NewData );
+        BOOST_CHECK_EQUAL( *sample, 6 );
+        BOOST_CHECK_EQUAL( rp.read(sample), OldData );
+        BOOST_CHECK_EQUAL( *sample, 6 );
+    }
+    wp.disconnect();
+
+    BOOST_REQUIRE( wp.createConnection(rp, ConnPolicy::buffer(2, ConnPolicy::LOCKED)) );
+    {
+        BOOST_CHECK_EQUAL( wp.write(7), WriteSuccess );
+        BOOST_CHECK_EQUAL( wp.write(8), WriteSuccess );
+
+        ConstLoanedSample<int> sample;
+        BOOST_CHECK_EQUAL( rp.read(sample), NewData );
+        BOOST_REQUIRE( sample.valid() );
+        BOOST_CHECK_EQUAL( *sample, 7 );
+        BOOST_CHECK_EQUAL( rp.read(sample), NewData );
+        BOOST_CHECK_EQUAL( *sample, 8 );
+        BOOST_CHECK_EQUAL( rp.read(sample), NoData );
+        BOOST_CHECK( !sample.valid() );
+    }
+    wp.disconnect();
+}
+
+BOOST_AUTO_TEST_CASE(testPortBatchWriteRead)
+{
+    OutputPort<int> wp("WriterName");
+    InputPort<int> rp("ReaderName");
+    tce->ports()->addEventPort( rp );
+    BOOST_REQUIRE( tce->start() );
+
+    std::vector<int> batch, result;
+    for(int i = 1; i <= 5; ++i)
+        batch.push_back(i);
+    BOOST_CHECK_EQUAL( wp.write(batch), NotConnected );
+
+    // buffer connection: one wake-up per batch
+    BOOST_REQUIRE( wp.createConnection(rp, ConnPolicy::buffer(8)) );
+    tce->resetStats();
+    BOOST_CHECK_EQUAL( wp.write(batch), WriteSuccess );
+    BOOST_CHECK_EQUAL( tce->nb_events, 1 );
+    BOOST_CHECK_EQUAL( wp.getLastWrittenValue(), 5 );
+
+    BOOST_CHECK_EQUAL( rp.readAll(result), NewData );
+    BOOST_CHECK( result == batch );
+    BOOST_CHECK_EQUAL( rp.readAll(result), NoData );
+    BOOST_CHECK( result.empty() );
+    int value = 0;
+    BOOST_CHECK_EQUAL( rp.read(value), NoData );
+
+    // the batch is truncated if it does not fit
+    BOOST_CHECK_EQUAL( wp.write(batch), WriteSuccess );
+    BOOST_CHECK_EQUAL( wp.write(batch), WriteFailure );
+    BOOST_CHECK_EQUAL( rp.readAll(result), NewData );
+    BOOST_CHECK_EQUAL( result.size(), 8 );
+
+    // range overload
+    int samples[] = { 6, 7, 8 };
+    BOOST_CHECK_EQUAL( wp.write(samples, samples + 3), WriteSuccess );
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 6 );
+    BOOST_CHECK_EQUAL( rp.readAll(result), NewData );
+    BOOST_REQUIRE_EQUAL( result.size(), 2 );
+    BOOST_CHECK_EQUAL( result[0], 7 );
+    BOOST_CHECK_EQUAL( result[1], 8 );
+    wp.disconnect();
+
+    // data connection: only the last sample is kept
+    BOOST_REQUIRE( wp.createConnection(rp, ConnPolicy::data()) );
+    tce->resetStats();
+    BOOST_CHECK_EQUAL( wp.write(batch), WriteSuccess );
+    BOOST_CHECK_EQUAL( tce->nb_events, 1 );
+    BOOST_CHECK_EQUAL( rp.readAll(result), NewData );
+    BOOST_REQUIRE_EQUAL( result.size(), 1 );
+    BOOST_CHECK_EQUAL( result[0], 5 );
+    BOOST_CHECK_EQUAL( rp.readAll(result), NoData );
+    BOOST_CHECK_EQUAL( rp.read(value), OldData );
+    BOOST_CHECK_EQUAL( value, 5 );
+    wp.disconnect();
+
+    // shared input buffer
+    ConnPolicy policy = ConnPolicy::buffer(8);
+    policy.buffer_policy = PerInputPort;
+    BOOST_REQUIRE( wp.createConnection(rp, policy) );
+    tce->resetStats();
+    BOOST_CHECK_EQUAL( wp.write(batch), WriteSuccess );
+    BOOST_CHECK_EQUAL( tce->nb_events, 1 );
+    BOOST_CHECK_EQUAL( rp.readAll(result), NewData );
+    BOOST_CHECK( result == batch );
+    wp.disconnect();
+
+    tce->stop();
+}
+
+BOOST_AUTO_TEST_CASE(testPortConnectionStatistics)
+{
+    OutputPort<int> wp("Write");
+    InputPort<int> rp("Read");
+    tc->ports()->addPort( wp );
+    tc->ports()->addPort( rp );
+
+    BOOST_CHECK( !tc->provides()->hasService("connectionStatistics") );
+    BOOST_REQUIRE( tc->loadService("connectionStatistics") );
+    BOOST_REQUIRE( tc->provides()->hasService("connectionStatistics") );
+    Service::shared_ptr statistics = tc->provides("connectionStatistics");
+    OperationCaller<int(std::string const&)> enable = statistics->getOperation("enable");
+    OperationCaller<std::vector<double>(std::string const&, int)> counters = statistics->getOperation("getCounters");
+    OperationCaller<std::vector<double>(std::string const&, int)> latency = statistics->getOperation("getLatencyHistogram");
+    OperationCaller<std::string()> report = statistics->getOperation("report");
+    BOOST_REQUIRE( enable.ready() && counters.ready() && latency.ready() && report.ready() );
+
+    // buffer connection: the third write is dropped
+    BOOST_REQUIRE( wp.createConnection(rp, ConnPolicy::buffer(2)) );
+    BOOST_CHECK( counters("Write", 0).empty() );
+    BOOST_CHECK_EQUAL( enable("Write"), 1 );
+    BOOST_CHECK_EQUAL( enable("Read"), 1 );
+    BOOST_CHECK_EQUAL( enable("Unknown"), 0 );
+    int value = 0;
+    BOOST_CHECK_EQUAL( wp.write(1), WriteSuccess );
+    BOOST_CHECK_EQUAL( wp.write(2), WriteSuccess );
+    BOOST_CHECK_EQUAL( wp.write(3), WriteFailure );
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    BOOST_CHECK_EQUAL( rp.read(value), OldData );
+
+    std::vector<double> c = counters("Read", 0);
+    BOOST_REQUIRE_EQUAL( c.size(), 6 );
+    BOOST_CHECK_EQUAL( c[0], 2 ); // writes
+    BOOST_CHECK_EQUAL( c[1], 0 ); // overwrites
+    BOOST_CHECK_EQUAL( c[2], 1 ); // drops
+    BOOST_CHECK_EQUAL( c[3], 3 ); // reads
+    BOOST_CHECK_EQUAL( c[4], 2 ); // NewData
+    BOOST_CHECK_EQUAL( c[5], 1 ); // OldData
+    BOOST_CHECK( counters("Write", 0) == c );
+    std::vector<double> h = latency("Write", 0);
+    BOOST_REQUIRE_EQUAL( h.size(), base::ChannelStatistics::LatencyBins );
+    BOOST_CHECK_EQUAL( std::accumulate(h.begin(), h.end(), 0.0), 2 );
+    BOOST_CHECK( report().find("Write[0]: writes 2, overwrites 0, drops 1") != std::string::npos );
+    wp.disconnect();
+
+    // circular buffer: the oldest sample is overwritten
+    BOOST_REQUIRE( wp.createConnection(rp, ConnPolicy::circularBuffer(2)) );
+    BOOST_CHECK_EQUAL( enable(""), 2 );
+    BOOST_CHECK_EQUAL( wp.write(1), WriteSuccess );
+    BOOST_CHECK_EQUAL( wp.write(2), WriteSuccess );
+    BOOST_CHECK_EQUAL( wp.write(3), WriteSuccess );
+    std::vector<int> samples;
+    BOOST_CHECK_EQUAL( rp.readAll(samples), NewData );
+    BOOST_CHECK_EQUAL( samples.size(), 2 );
+    c = counters("Write", 0);
+    BOOST_REQUIRE_EQUAL( c.size(), 6 );
+    BOOST_CHECK_EQUAL( c[0], 3 );
+    BOOST_CHECK_EQUAL( c[1], 1 );
+    BOOST_CHECK_EQUAL( c[2], 0 );
+    BOOST_CHECK_EQUAL( c[3], 1 );
+    BOOST_CHECK_EQUAL( c[4], 1 );
+    h = latency("Read", 0);
+    BOOST_CHECK_EQUAL( std::accumulate(h.begin(), h.end(), 0.0), 2 );
+    wp.disconnect();
+
+    // data connection: an unread sample is overwritten
+    BOOST_REQUIRE( wp.createConnection(rp, ConnPolicy::data()) );
+    BOOST_CHECK_EQUAL( enable("Write"), 1 );
+    BOOST_CHECK_EQUAL( wp.write(1), WriteSuccess );
+    BOOST_CHECK_EQUAL( wp.write(2), WriteSuccess );
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    BOOST_CHECK_EQUAL( rp.read(value), OldData );
+    c = counters("Write", 0);
+    BOOST_REQUIRE_EQUAL( c.size(), 6 );
+    BOOST_CHECK_EQUAL( c[0], 2 );
+    BOOST_CHECK_EQUAL( c[1], 1 );
+    BOOST_CHECK_EQUAL( c[3], 2 );
+    BOOST_CHECK_EQUAL( c[4], 1 );
+    BOOST_CHECK_EQUAL( c[5], 1 );
+    h = latency("Write", 0);
+    BOOST_CHECK_EQUAL( std::accumulate(h.begin(), h.end(), 0.0), 1 );
+    wp.disconnect();
+
+    // shared samples: the same counters as for a copying connection
+    ConnPolicy shared_data = ConnPolicy::data();
+    shared_data.shared_samples = true;
+    BOOST_REQUIRE( wp.createConnection(rp, shared_data) );
+    BOOST_CHECK_EQUAL( enable("Write"), 1 );
+    BOOST_CHECK_EQUAL( wp.write(1), WriteSuccess );
+    BOOST_CHECK_EQUAL( wp.write(2), WriteSuccess );
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 2 );
+    c = counters("Write", 0);
+    BOOST_REQUIRE_EQUAL( c.size(), 6 );
+    BOOST_CHECK_EQUAL( c[0], 2 );
+    BOOST_CHECK_EQUAL( c[1], 1 );
+    BOOST_CHECK_EQUAL( c[4], 1 );
+    h = latency("Write", 0);
+    BOOST_CHECK_EQUAL( std::accumulate(h.begin(), h.end(), 0.0), 1 );
+    wp.disconnect();
+
+    ConnPolicy shared_buffer = ConnPolicy::buffer(2);
+    shared_buffer.shared_samples = true;
+    BOOST_REQUIRE( wp.createConnection(rp, shared_buffer) );
+    BOOST_CHECK_EQUAL( enable("Write"), 1 );
+    BOOST_CHECK_EQUAL( wp.write(1), WriteSuccess );
+    BOOST_CHECK_EQUAL( wp.write(2), WriteSuccess );
+    BOOST_CHECK_EQUAL( wp.write(3), WriteFailure );
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    c = counters("Write", 0);
+    BOOST_REQUIRE_EQUAL( c.size(), 6 );
+    BOOST_CHECK_EQUAL( c[0], 2 );
+    BOOST_CHECK_EQUAL( c[2], 1 );
+    BOOST_CHECK_EQUAL( c[4], 2 );
+    h = latency("Write", 0);
+    BOOST_CHECK_EQUAL( std::accumulate(h.begin(), h.end(), 0.0), 2 );
+    wp.disconnect();
+
+    tc->ports()->removePort("Read");
+    tc->ports()->removePort("Write");
+}
+
 BOOST_AUTO_TEST_CASE(testPortOneWriterThreeReaders)
 {
     OutputPort<int> wp("W");
@@ -375,6 +702,67 @@ BOOST_AUTO_TEST_CASE(testPortOneWriterThreeReaders)
     BOOST_CHECK_EQUAL( rp3.read(value), NoData );
 }
 
+BOOST_AUTO_TEST_CASE(testPortOneWriterThreeReadersWithSharedSamples)
+{
+    OutputPort< std::vector<double> > wp("W");
+    InputPort< std::vector<double> > rp1("R1");
+    InputPort< std::vector<double> > rp2("R2");
+    InputPort< std::vector<double> > rp3("R3");
+
+    ConnPolicy data_policy = ConnPolicy::data();
+    data_policy.shared_samples = true;
+    ConnPolicy buffer_policy = ConnPolicy::buffer(4);
+    buffer_policy.shared_samples = true;
+
+    BOOST_REQUIRE( wp.createConnection(rp1, data_policy) );
+    BOOST_REQUIRE( wp.createConnection(rp2, buffer_policy) );
+    BOOST_REQUIRE( wp.createConnection(rp3, ConnPolicy::data()) ); // copies, as usual
+    wp.setDataSample( std::vector<double>(10, 0.0) );
+
+    for(int i = 1; i <= 5; ++i)
+        BOOST_CHECK_EQUAL( wp.write(std::vector<double>(10, i)), i <= 4 ? WriteSuccess : WriteFailure ); // R2 is full after 4 samples
+
+    std::vector<double> value;
+    BOOST_CHECK_EQUAL( rp1.read(value), NewData );
+    BOOST_CHECK( value == std::vector<double>(10, 5) );
+    BOOST_CHECK_EQUAL( rp3.read(value), NewData );
+    BOOST_CHECK( value == std::vector<double>(10, 5) );
+    for(int i = 1; i <= 4; ++i) {
+        BOOST_CHECK_EQUAL( rp2.read(value), NewData );
+        BOOST_CHECK( value == std::vector<double>(10, i) );
+    }
+    BOOST_CHECK_EQUAL( rp2.read(value), OldData );
+    BOOST_CHECK( value == std::vector<double>(10, 4) );
+
+    // connections that share samples hand out the same copy
+    BOOST_CHECK_EQUAL( wp.write(std::vector<double>(10, 6)), WriteSuccess );
+    {
+        ConstLoanedSample< std::vector<double> > sample1, sample2, sample3;
+        BOOST_CHECK_EQUAL( rp1.read(sample1), NewData );
+        BOOST_CHECK_EQUAL( rp2.read(sample2), NewData );
+        BOOST_CHECK_EQUAL( rp3.read(sample3), NewData );
+        BOOST_REQUIRE( sample1.valid() && sample2.valid() && sample3.valid() );
+        BOOST_CHECK( *sample1 == std::vector<double>(10, 6) );
+        BOOST_CHECK_EQUAL( &*sample1, &*sample2 );
+        BOOST_CHECK( &*sample1 != &*sample3 );
+
+        // a loaned sample is not overwritten by later writes
+        BOOST_CHECK_EQUAL( wp.write(std::vector<double>(10, 7)), WriteSuccess );
+        BOOST_CHECK( *sample1 == std::vector<double>(10, 6) );
+        BOOST_CHECK_EQUAL( rp1.read(sample1), NewData );
+        BOOST_CHECK( *sample1 == std::vector<double>(10, 7) );
+        BOOST_CHECK( *sample2 == std::vector<double>(10, 6) );
+    }
+
+    // removing a connection keeps the others working
+    wp.disconnect(&rp2);
+    BOOST_CHECK_EQUAL( wp.write(std::vector<double>(10, 8)), WriteSuccess );
+    BOOST_CHECK_EQUAL( rp1.read(value), NewData );
+    BOOST_CHECK( value == std::vector<double>(10, 8) );
+    wp.disconnect();
+    BOOST_CHECK_EQUAL( rp1.read(value), NoData );
+}
+
 BOOST_AUTO_TEST_CASE(testPortOneWriterThreeReadersWithSharedOutputBuffer)
 {
     ConnPolicy cp = ConnPolicy::buffer(4);
@@ -631,6 +1019,46 @@ BOOST_AUTO_TEST_CASE(testPortThreeWritersOneReader)
     BOOST_CHECK_EQUAL( rp.read(value), NoData );
 }
 
+BOOST_AUTO_TEST_CASE(testPortManyWritersOneReaderArrivalOrder)
+{
+    const int writers = 8;
+    std::vector< boost::shared_ptr< OutputPort<int> > > wps;
+    InputPort<int> rp("R", ConnPolicy::data());
+    for(int i = 0; i < writers; ++i) {
+        wps.push_back( boost::shared_ptr< OutputPort<int> >(new OutputPort<int>(std::string("W") + char('0' + i))) );
+        BOOST_REQUIRE( wps.back()->createConnection(rp) );
+    }
+
+    int value = 0;
+    BOOST_CHECK_EQUAL( rp.read(value), NoData );
+
+    // inputs are served in the order in which they received data, not in the order of connection
+    BOOST_CHECK_EQUAL( wps[5]->write(5), WriteSuccess );
+    BOOST_CHECK_EQUAL( wps[2]->write(2), WriteSuccess );
+    BOOST_CHECK_EQUAL( wps[7]->write(7), WriteSuccess );
+    BOOST_CHECK_EQUAL( wps[5]->write(15), WriteSuccess );
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 15 );
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 2 );
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 7 );
+    BOOST_CHECK_EQUAL( rp.read(value), OldData );
+    BOOST_CHECK_EQUAL( value, 7 );
+
+    // an input that receives data again is queued again
+    BOOST_CHECK_EQUAL( wps[2]->write(12), WriteSuccess );
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 12 );
+
+    // data written before the inputs list changed is not lost
+    BOOST_CHECK_EQUAL( wps[3]->write(3), WriteSuccess );
+    wps[0]->disconnect(&rp);
+    BOOST_CHECK_EQUAL( rp.read(value), NewData );
+    BOOST_CHECK_EQUAL( value, 3 );
+    BOOST_CHECK_EQUAL( rp.read(value), OldData );
+}
+
 BOOST_AUTO_TEST_CASE(testSharedBufferConnection)
 {
     ConnPolicy cp = ConnPolicy::buffer(10);
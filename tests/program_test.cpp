@@ -383,6 +383,48 @@ BOOST_AUTO_TEST_CASE(testProgramLoops)
     this->finishProgram( tc, "x");
 }
 
+BOOST_AUTO_TEST_CASE(testProgramStep)
+{
+    // pause a program and step through it
+    string prog = string("program x { \n")
+        + "tvar_i = 1\n"
+        + "tvar_i = 2\n"
+        + "tvar_i = 3\n"
+        + "}";
+    Parser::ParsedPrograms pg_list;
+    try {
+        pg_list = parser.parseProgram( prog, tc );
+    }
+    catch( const file_parse_exception& exc )
+        {
+            BOOST_REQUIRE_MESSAGE( false, exc.what() );
+        }
+    BOOST_REQUIRE( !pg_list.empty() );
+    ProgramInterfacePtr pi = pg_list.front();
+    BOOST_REQUIRE( sa->loadProgram( pi ) );
+
+    var_i = 0;
+    BOOST_REQUIRE( pi->pause() );
+    BOOST_CHECK( SimulationThread::Instance()->run(1) );
+    BOOST_REQUIRE( pi->isPaused() );
+    BOOST_CHECK_EQUAL( var_i, 0 );
+
+    int steps = 0;
+    while ( !pi->isStopped() && steps < 20 ) {
+        int before = var_i;
+        BOOST_REQUIRE( pi->step() );
+        BOOST_CHECK( SimulationThread::Instance()->run(1) );
+        BOOST_CHECK( pi->stepDone() );
+        // a step executes at most one statement
+        BOOST_CHECK( var_i == before || var_i == before + 1 );
+        ++steps;
+    }
+    BOOST_CHECK( pi->isStopped() );
+    BOOST_CHECK_EQUAL( var_i, 3 );
+    BOOST_CHECK( steps >= 3 );
+    this->finishProgram( tc, "x");
+}
+
 BOOST_AUTO_TEST_CASE(testProgramAnd)
 {
     // see if checking a remote condition works
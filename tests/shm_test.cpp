@@ -0,0 +1,329 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "unit.hpp"
+
+#include <iostream>
+
+#include <Service.hpp>
+#include <transports/shm/ShmLib.hpp>
+#include <os/fosi.h>
+#include <os/TimeService.hpp>
+
+#include <InputPort.hpp>
+#include <OutputPort.hpp>
+#include <TaskContext.hpp>
+#include <string>
+#include <sstream>
+
+using namespace std;
+using namespace RTT;
+using namespace RTT::detail;
+
+class ShmTest
+{
+public:
+    ShmTest()
+    {
+        mr1 = new InputPort<double>("mr");
+        mw1 = new OutputPort<double>("mw");
+
+        mr2 = new InputPort<double>("mr");
+        mw2 = new OutputPort<double>("mw");
+
+        // both tc's are non periodic
+        tc =  new TaskContext( "root" );
+        tc->ports()->addEventPort( *mr1 );
+        tc->ports()->addPort( *mw1 );
+
+        t2 = new TaskContext("other");
+        t2->ports()->addEventPort( *mr2, boost::bind(&ShmTest::new_data_listener, this, _1) );
+        t2->ports()->addPort( *mw2 );
+
+        tc->start();
+        t2->start();
+
+        policy.type = ConnPolicy::DATA;
+        policy.init = false;
+        policy.lock_policy = ConnPolicy::LOCK_FREE;
+        policy.size = 0;
+        policy.pull = true;
+        policy.transport = ORO_SHM_PROTOCOL_ID;
+    }
+
+    ~ShmTest()
+    {
+        delete tc;
+        delete t2;
+
+        delete mr1;
+        delete mw1;
+        delete mr2;
+        delete mw2;
+    }
+
+    TaskContext* tc;
+    TaskContext* t2;
+
+    PortInterface* signalled_port;
+    void new_data_listener(PortInterface* port)
+    {
+        signalled_port = port;
+    }
+
+    // Ports
+    InputPort<double>*  mr1;
+    OutputPort<double>* mw1;
+    InputPort<double>*  mr2;
+    OutputPort<double>* mw2;
+
+    ConnPolicy policy;
+
+    // helper test functions
+    void testPortDataConnection();
+    void testPortBufferConnection();
+    void testPortDisconnected();
+};
+
+#define ASSERT_PORT_SIGNALLING(code, read_port) do { \
+    signalled_port = 0; \
+    code; \
+    rtos_disable_rt_warning(); \
+    usleep(100000); \
+    rtos_enable_rt_warning(); \
+    BOOST_CHECK( read_port == signalled_port ); \
+} while(0)
+
+void ShmTest::testPortDataConnection()
+{
+    rtos_enable_rt_warning();
+    // This test assumes that there is a data connection mw1 => mr2
+    BOOST_CHECK( mw1->connected() );
+    BOOST_CHECK( mr2->connected() );
+
+    double value = 0;
+
+    // Check if no-data works
+    BOOST_CHECK( NoData == mr2->read(value) );
+
+    // Check if writing works (including signalling)
+    ASSERT_PORT_SIGNALLING(mw1->write(1.0), mr2);
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 1.0, value );
+    ASSERT_PORT_SIGNALLING(mw1->write(2.0), mr2);
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 2.0, value );
+    BOOST_CHECK( OldData == mr2->read(value) );
+
+    rtos_disable_rt_warning();
+}
+
+void ShmTest::testPortBufferConnection()
+{
+    rtos_enable_rt_warning();
+    // This test assumes that there is a buffer connection mw1 => mr2 of size 3
+    BOOST_CHECK( mw1->connected() );
+    BOOST_CHECK( mr2->connected() );
+
+    double value = 0;
+
+    // Check if no-data works
+    BOOST_CHECK( NoData == mr2->read(value) );
+
+    // Check if writing works
+    ASSERT_PORT_SIGNALLING(mw1->write(1.0), mr2);
+    ASSERT_PORT_SIGNALLING(mw1->write(2.0), mr2);
+    ASSERT_PORT_SIGNALLING(mw1->write(3.0), mr2);
+    ASSERT_PORT_SIGNALLING(mw1->write(4.0), 0);  // because size == 3
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 1.0, value );
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 2.0, value );
+    BOOST_CHECK( mr2->read(value) );
+    BOOST_CHECK_EQUAL( 3.0, value );
+    BOOST_CHECK( OldData == mr2->read(value) );
+
+    rtos_disable_rt_warning();
+}
+
+void ShmTest::testPortDisconnected()
+{
+    BOOST_CHECK( !mw1->connected() );
+    BOOST_CHECK( !mr2->connected() );
+}
+
+BOOST_FIXTURE_TEST_SUITE(  ShmTestSuite,  ShmTest )
+
+BOOST_AUTO_TEST_CASE( testPortConnections )
+{
+    policy.type = ConnPolicy::DATA;
+    policy.pull = true;
+    policy.name_id = "/shmdata1";
+    BOOST_REQUIRE( mw1->createConnection(*mr2, policy) );
+    BOOST_CHECK( policy.name_id == "/shmdata1" );
+    testPortDataConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+
+    policy.type = ConnPolicy::DATA;
+    policy.pull = true;
+    policy.name_id = "";
+    BOOST_REQUIRE( mw1->createConnection(*mr2, policy) );
+    testPortDataConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 3;
+    policy.name_id = "";
+    BOOST_REQUIRE( mw1->createConnection(*mr2, policy) );
+    testPortBufferConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+}
+
+BOOST_AUTO_TEST_CASE( testPortStreams )
+{
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/shmdata1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    testPortDataConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = true;
+    policy.size = 3;
+    policy.name_id = "/shmbuffer1";
+    BOOST_REQUIRE( mw1->createStream( policy ) );
+    BOOST_REQUIRE( mr2->createStream( policy ) );
+    testPortBufferConnection();
+    mw1->disconnect();
+    mr2->disconnect();
+    testPortDisconnected();
+}
+
+BOOST_AUTO_TEST_CASE( testPortStreamsTimeout )
+{
+    // Test creating an input stream without an output stream available.
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "/shmdata1";
+    BOOST_REQUIRE( mr2->createStream( policy ) == false );
+    BOOST_CHECK( mr2->connected() == false );
+    mr2->disconnect();
+}
+
+BOOST_AUTO_TEST_CASE( testPortStreamsWrongName )
+{
+    policy.type = ConnPolicy::DATA;
+    policy.pull = false;
+    policy.name_id = "shmdata1"; // name must start with '/'
+    BOOST_REQUIRE( mr2->createStream( policy ) == false );
+    BOOST_CHECK( mr2->connected() == false );
+    mr2->disconnect();
+
+    policy.name_id = "/shm/data1"; // and contain no other '/'
+    BOOST_REQUIRE( mw2->createStream( policy ) == false );
+    BOOST_CHECK( mw2->connected() == false );
+    mw2->disconnect();
+}
+
+BOOST_AUTO_TEST_CASE( testVectorTransport )
+{
+    DataFlowInterface* ports  = tc->ports();
+    DataFlowInterface* ports2 = t2->ports();
+
+    std::vector<double> data(20, 3.33);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    ports->addPort(vin).doc("input port");
+    ports2->addPort(vout).doc("output port");
+
+    // init the output port with a vector of size 20, values 3.33,
+    // which determines the size of the slots.
+    vout.setDataSample( data );
+
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 4;
+    policy.name_id = "/shmvdata1";
+    BOOST_REQUIRE( vout.createStream( policy ) );
+    BOOST_REQUIRE( vin.createStream( policy ) );
+
+    BOOST_CHECK_EQUAL( vin.read(data), NoData);
+
+    data.clear();
+    data.resize(10, 6.66);
+    rtos_enable_rt_warning();
+    vout.write( data );
+    rtos_disable_rt_warning();
+
+    data.clear();
+    data.resize(20, 0.0);
+    usleep(200000);
+
+    rtos_enable_rt_warning();
+    BOOST_CHECK_EQUAL( vin.read(data), NewData);
+    rtos_disable_rt_warning();
+
+    BOOST_CHECK_EQUAL( data.size(), 10);
+    for(unsigned int i=0; i != data.size(); ++i)
+        BOOST_CHECK_CLOSE( data[i], 6.66, 0.01);
+
+    rtos_enable_rt_warning();
+    BOOST_CHECK_EQUAL( vin.read(data), OldData);
+    rtos_disable_rt_warning();
+}
+
+/**
+ * Measures the time between writing a sample and its arrival in the
+ * input port, for a large sample.
+ */
+BOOST_AUTO_TEST_CASE( testVectorLatency )
+{
+    const int samples = 100;
+    std::vector<double> data(100000, 1.0);
+    InputPort< std::vector<double> > vin("VIn");
+    OutputPort< std::vector<double> > vout("Vout");
+    tc->ports()->addPort(vin);
+    t2->ports()->addPort(vout);
+    vout.setDataSample( data );
+
+    policy.type = ConnPolicy::BUFFER;
+    policy.pull = false;
+    policy.size = 4;
+    policy.name_id = "/shmvlatency";
+    BOOST_REQUIRE( vout.createConnection( vin, policy ) );
+
+    double total = 0, worst = 0;
+    std::vector<double> result(data.size());
+    for (int i = 0; i != samples; ++i) {
+        data[0] = i;
+        os::TimeService::ticks start = os::TimeService::Instance()->getTicks();
+        vout.write( data );
+        int wait = 1000;
+        while ( vin.read( result, false ) != NewData && wait-- )
+            usleep(100);
+        double elapsed = os::TimeService::Instance()->secondsSince( start );
+        BOOST_REQUIRE_EQUAL( result[0], i );
+        total += elapsed;
+        worst = std::max( worst, elapsed );
+    }
+    std::cout << "Shm latency of a " << data.size() * sizeof(double) / 1024 << " kB sample: mean "
+              << total / samples * 1e6 << " us, worst " << worst * 1e6 << " us" << std::endl;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -24,11 +24,15 @@
 #include <rtt/TaskContext.hpp>
 #include <rtt/Operation.hpp>
 #include <rtt/OperationCaller.hpp>
+#include <rtt/InputPort.hpp>
+#include <rtt/OutputPort.hpp>
 #include <rtt/extras/SlaveActivity.hpp>
+#include <rtt/extras/DataFlowActivity.hpp>
 
 #include <rtt/os/Mutex.hpp>
 #include <rtt/os/Condition.hpp>
 #include <rtt/os/fosi.h>
+#include <boost/bind.hpp>
 
 using namespace std;
 using namespace RTT::detail;
@@ -115,6 +119,79 @@ public:
     RTT::OperationCaller<void()> slave_operation_caller;
 };
 
+class PriorityComponent : public TaskContext
+{
+public:
+    PriorityComponent() : TaskContext("priority"), callbacks(0)
+    {
+        this->addOperation("high", &PriorityComponent::record, this, RTT::OwnThread).priority(RTT::HighPriority);
+        this->addOperation("normal", &PriorityComponent::record, this, RTT::OwnThread);
+        this->addOperation("low", &PriorityComponent::record, this, RTT::OwnThread).priority(RTT::LowPriority);
+        this->addEventPort("in", in, boost::bind(&PriorityComponent::onData, this, _1)).priority(RTT::HighPriority);
+    }
+
+    void record(int i)
+    {
+        order.push_back(i);
+    }
+
+    void onData(RTT::base::PortInterface*)
+    {
+        ++callbacks;
+        int i;
+        while (in.read(i) == RTT::NewData)
+            record(i);
+    }
+
+public:
+    std::vector<int> order;
+    int callbacks;
+    RTT::InputPort<int> in;
+};
+
+/**
+ * Writes one more than the largest value it read.
+ */
+struct CallbackCounter
+{
+    CallbackCounter() : calls(0) {}
+    void onData(RTT::base::PortInterface*) { ++calls; }
+    int calls;
+};
+
+class FlowComponent : public TaskContext
+{
+public:
+    FlowComponent(const std::string& name) : TaskContext(name), value(0), cycles(0), flow(0), scheduled(0)
+    {
+        this->ports()->addPort("in1", in1);
+        this->ports()->addPort("in2", in2);
+        this->ports()->addPort("out", out);
+    }
+
+    void updateHook()
+    {
+        int v1 = 0, v2 = 0;
+        in1.read(v1);
+        in2.read(v2);
+        value = (v1 > v2 ? v1 : v2) + 1;
+        out.write(value);
+        ++cycles;
+        // the schedule can be read while it is executed.
+        if ( flow )
+            scheduled = flow->getSchedule().size();
+    }
+
+public:
+    int value;
+    volatile int cycles;
+    RTT::extras::DataFlowActivity* flow;
+    unsigned int scheduled;
+    RTT::InputPort<int> in1;
+    RTT::InputPort<int> in2;
+    RTT::OutputPort<int> out;
+};
+
 /**
  * Tests operation calls and functions of components running in a SlaveActivity
  */
@@ -180,4 +257,185 @@ BOOST_AUTO_TEST_CASE( testSlaveOperationCallWithCallback )
     BOOST_CHECK_EQUAL( client.callback_operation_called_counter, 1 );
 }
 
+// Test that messages and port callbacks are served by priority and within the processing budget
+BOOST_AUTO_TEST_CASE( testSlaveMessagePriorities )
+{
+    PriorityComponent tc;
+    RTT::extras::SlaveActivity* activity = new RTT::extras::SlaveActivity();
+    tc.setActivity(activity);
+    RTT::OutputPort<int> out("out");
+    BOOST_REQUIRE( out.connectTo(&tc.in) );
+    BOOST_REQUIRE( tc.start() );
+
+    RTT::OperationCaller<void(int)> high = tc.getOperation("high");
+    RTT::OperationCaller<void(int)> normal = tc.getOperation("normal");
+    RTT::OperationCaller<void(int)> low = tc.getOperation("low");
+    BOOST_REQUIRE( high.ready() && normal.ready() && low.ready() );
+
+    low.send(1);
+    normal.send(2);
+    high.send(3);
+    low.send(4);
+    out.write(5);
+
+    BOOST_CHECK( activity->execute() );
+    int expected[] = { 3, 5, 2, 1, 4 };
+    BOOST_CHECK_EQUAL_COLLECTIONS( tc.order.begin(), tc.order.end(), expected, expected + 5 );
+    BOOST_CHECK_EQUAL( tc.engine()->getMessageStatistics(RTT::HighPriority).processed, 2u );
+    BOOST_CHECK_EQUAL( tc.engine()->getMessageStatistics(RTT::NormalPriority).processed, 1u );
+    BOOST_CHECK_EQUAL( tc.engine()->getMessageStatistics(RTT::LowPriority).processed, 2u );
+
+    // with a budget of two items, the remaining low priority messages are carried over.
+    tc.order.clear();
+    tc.engine()->resetMessageStatistics();
+    tc.engine()->setProcessingBudget(2);
+    low.send(1);
+    low.send(2);
+    low.send(3);
+    high.send(4);
+
+    activity->execute();
+    int first[] = { 4, 1 };
+    BOOST_CHECK_EQUAL_COLLECTIONS( tc.order.begin(), tc.order.end(), first, first + 2 );
+    BOOST_CHECK_EQUAL( tc.engine()->getMessageStatistics(RTT::LowPriority).deferred, 1u );
+
+    activity->execute();
+    int second[] = { 4, 1, 2, 3 };
+    BOOST_CHECK_EQUAL_COLLECTIONS( tc.order.begin(), tc.order.end(), second, second + 4 );
+    BOOST_CHECK_EQUAL( tc.engine()->getMessageStatistics(RTT::LowPriority).processed, 3u );
+    BOOST_CHECK_EQUAL( tc.engine()->getMessageStatistics(RTT::LowPriority).deferred, 1u );
+    BOOST_CHECK_EQUAL( tc.engine()->getMessageStatistics(RTT::HighPriority).processed, 1u );
+
+    tc.stop();
+}
+
+// Test that the samples which arrive on an event port before its callback ran are served by one callback
+BOOST_AUTO_TEST_CASE( testSlavePortCoalescing )
+{
+    PriorityComponent tc;
+    RTT::extras::SlaveActivity* activity = new RTT::extras::SlaveActivity();
+    tc.setActivity(activity);
+    RTT::OutputPort<int> out("out");
+    BOOST_REQUIRE( out.createConnection(tc.in, RTT::ConnPolicy::buffer(20)) );
+    BOOST_REQUIRE( tc.start() );
+
+    for (int i = 0; i != 10; ++i)
+        BOOST_CHECK_EQUAL( out.write(i), RTT::WriteSuccess );
+    BOOST_CHECK( activity->execute() );
+    BOOST_CHECK_EQUAL( tc.callbacks, 1 );
+    BOOST_CHECK_EQUAL( tc.order.size(), 10u );
+    BOOST_CHECK_EQUAL( tc.engine()->getMessageStatistics(RTT::HighPriority).processed, 1u );
+    BOOST_CHECK_EQUAL( tc.engine()->getMessageStatistics(RTT::HighPriority).coalesced, 9u );
+
+    // once the callback ran, new data queues the port again
+    BOOST_CHECK_EQUAL( out.write(10), RTT::WriteSuccess );
+    BOOST_CHECK( activity->execute() );
+    BOOST_CHECK_EQUAL( tc.callbacks, 2 );
+    BOOST_REQUIRE_EQUAL( tc.order.size(), 11u );
+    BOOST_CHECK_EQUAL( tc.order.back(), 10 );
+    BOOST_CHECK_EQUAL( tc.engine()->getMessageStatistics(RTT::HighPriority).coalesced, 9u );
+
+    tc.engine()->resetMessageStatistics();
+    BOOST_CHECK_EQUAL( tc.engine()->getMessageStatistics(RTT::HighPriority).coalesced, 0u );
+
+    tc.stop();
+}
+
+// Test that a queued event port can be removed and deleted before its callback ran
+BOOST_AUTO_TEST_CASE( testSlaveRemoveQueuedPort )
+{
+    TaskContext tc("removed");
+    RTT::extras::SlaveActivity* activity = new RTT::extras::SlaveActivity();
+    tc.setActivity(activity);
+    CallbackCounter counter;
+    RTT::OutputPort<int> out("out");
+    RTT::InputPort<int>* in = new RTT::InputPort<int>("in");
+    tc.ports()->addEventPort(*in, boost::bind(&CallbackCounter::onData, &counter, _1));
+    BOOST_REQUIRE( out.createConnection(*in, RTT::ConnPolicy::data()) );
+    BOOST_REQUIRE( tc.start() );
+
+    BOOST_CHECK_EQUAL( out.write(1), RTT::WriteSuccess );
+    tc.ports()->removePort("in");
+    delete in;
+    BOOST_CHECK( activity->execute() );
+    BOOST_CHECK_EQUAL( counter.calls, 0 );
+
+    // a new event port reuses the entry, which may still be queued
+    RTT::InputPort<int> other("other");
+    tc.ports()->addEventPort(other, boost::bind(&CallbackCounter::onData, &counter, _1));
+    BOOST_REQUIRE( out.createConnection(other, RTT::ConnPolicy::data()) );
+    BOOST_CHECK_EQUAL( out.write(2), RTT::WriteSuccess );
+    BOOST_CHECK( activity->execute() );
+    BOOST_CHECK_EQUAL( counter.calls, 1 );
+    BOOST_CHECK_EQUAL( out.write(3), RTT::WriteSuccess );
+    BOOST_CHECK( activity->execute() );
+    BOOST_CHECK_EQUAL( counter.calls, 2 );
+
+    tc.stop();
+}
+
+BOOST_AUTO_TEST_CASE( testDataFlowActivity )
+{
+    // a feeds b and d, which both feed c.
+    FlowComponent a("a"), b("b"), c("c"), d("d");
+    BOOST_CHECK( a.out.connectTo(&b.in1) );
+    BOOST_CHECK( a.out.connectTo(&d.in1) );
+    BOOST_CHECK( b.out.connectTo(&c.in1) );
+    BOOST_CHECK( d.out.connectTo(&c.in2) );
+
+    RTT::extras::DataFlowActivity flow(ORO_SCHED_OTHER, RTT::os::LowestPriority, 0.0, 2);
+    BOOST_CHECK_EQUAL( flow.getWorkers(), 2u );
+    BOOST_CHECK( flow.addComponent(&c) );
+    BOOST_CHECK( flow.addComponent(&d) );
+    BOOST_CHECK( flow.addComponent(&b) );
+    BOOST_CHECK( flow.addComponent(&a) );
+    BOOST_CHECK( !flow.addComponent(&a) );
+
+    BOOST_CHECK( flow.updateSchedule() );
+    std::vector<RTT::extras::DataFlowActivity::ScheduleEntry> schedule = flow.getSchedule();
+    BOOST_REQUIRE_EQUAL( schedule.size(), 4u );
+    BOOST_CHECK( schedule[0].component == &a );
+    BOOST_CHECK_EQUAL( schedule[0].level, 0u );
+    BOOST_CHECK( schedule[1].component == &d || schedule[1].component == &b );
+    BOOST_CHECK_EQUAL( schedule[1].level, 1u );
+    BOOST_CHECK_EQUAL( schedule[2].level, 1u );
+    BOOST_CHECK( schedule[3].component == &c );
+    BOOST_CHECK_EQUAL( schedule[3].level, 2u );
+
+    BOOST_CHECK( a.start() && b.start() && c.start() && d.start() );
+    c.flow = &flow;
+    // a non periodic activity executes the components once when started.
+    BOOST_CHECK( flow.start() );
+    for (int i = 0; i != 100 && c.cycles == 0; ++i)
+        usleep(10000);
+    BOOST_CHECK( flow.stop() );
+    // c read the values of this cycle.
+    BOOST_CHECK_EQUAL( c.value, 3 );
+    BOOST_CHECK_EQUAL( c.scheduled, 4u );
+    schedule = flow.getSchedule();
+    for (unsigned int i = 0; i != schedule.size(); ++i)
+        BOOST_CHECK_EQUAL( schedule[i].count, 1u );
+
+    // a cycle keeps the previous schedule and prevents a start.
+    BOOST_CHECK( c.out.connectTo(&a.in1) );
+    BOOST_CHECK( !flow.updateSchedule() );
+    BOOST_CHECK_EQUAL( flow.getSchedule().size(), 4u );
+    BOOST_CHECK( !flow.start() );
+    c.out.disconnect();
+    BOOST_CHECK( flow.updateSchedule() );
+
+    BOOST_CHECK( flow.removeComponent(&d) );
+    BOOST_CHECK( !flow.removeComponent(&d) );
+    BOOST_CHECK_EQUAL( flow.getSchedule().size(), 3u );
+    flow.resetStatistics();
+    BOOST_CHECK_EQUAL( flow.getSchedule()[0].count, 0u );
+
+    // a stopped component gets the activity of a new TaskContext back.
+    BOOST_CHECK( b.stop() );
+    BOOST_CHECK( flow.removeComponent(&b) );
+    BOOST_CHECK( !dynamic_cast<RTT::extras::SlaveActivity*>( b.getActivity() ) );
+
+    a.stop(); c.stop(); d.stop();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -10,6 +10,9 @@
 
 #include "specialized_activities.hpp"
 #include <extras/FileDescriptorActivity.hpp>
+#ifdef __linux__
+#include <extras/EPollFileDescriptorActivity.hpp>
+#endif
 #include <iostream>
 #include <memory>
 
@@ -19,7 +22,8 @@ using namespace RTT::detail;
 using namespace std;
 using namespace RTT;
 
-struct TestFDActivity : public FileDescriptorActivity
+template<class FDActivity>
+struct TestFDActivity : public FDActivity
 {
     int step_count, count, other_count;
     int fd, other_fd, result;
@@ -30,7 +34,7 @@ struct TestFDActivity : public FileDescriptorActivity
     RTT::os::Mutex mutex;
 
     TestFDActivity()
-        : FileDescriptorActivity(0), step_count(0), count(0), other_count(0), do_read(false) {}
+        : FDActivity(0), step_count(0), count(0), other_count(0), do_read(false) {}
 
     void work(base::RunnableInterface::WorkReason reason)
     {
@@ -41,13 +45,13 @@ struct TestFDActivity : public FileDescriptorActivity
         RTT::os::MutexLock lock(mutex);
 
         char buffer;
-        if (isUpdated(fd))
+        if (this->isUpdated(fd))
         {
             ++count;
             if (do_read)
                 result = read(fd, &buffer, 1);
         }
-        if (isUpdated(other_fd))
+        if (this->isUpdated(other_fd))
         {
             ++other_count;
             if (do_read)
@@ -57,16 +61,15 @@ struct TestFDActivity : public FileDescriptorActivity
     }
 };
 
-BOOST_FIXTURE_TEST_SUITE(SecializedActivitiesSuite,SpecializedActivities)
-
-BOOST_AUTO_TEST_CASE( testFileDescriptorActivity )
+template<class FDActivity>
+void testFDActivity()
 {
 #if __cplusplus > 199711L
-    unique_ptr<TestFDActivity>
+    unique_ptr< TestFDActivity<FDActivity> >
 #else
-    auto_ptr<TestFDActivity>
+    auto_ptr< TestFDActivity<FDActivity> >
 #endif
-            activity(new TestFDActivity);
+            activity(new TestFDActivity<FDActivity>);
     static const int USLEEP = 250000;
 
     int pipe_fds[2];
@@ -167,6 +170,59 @@ BOOST_AUTO_TEST_CASE( testFileDescriptorActivity )
     BOOST_CHECK( activity->stop() );
 }
 
+BOOST_FIXTURE_TEST_SUITE(SecializedActivitiesSuite,SpecializedActivities)
+
+BOOST_AUTO_TEST_CASE( testFileDescriptorActivity )
+{
+    testFDActivity<FileDescriptorActivity>();
+}
+
+#ifdef __linux__
+BOOST_AUTO_TEST_CASE( testEPollFileDescriptorActivity )
+{
+    testFDActivity<EPollFileDescriptorActivity>();
+}
+
+BOOST_AUTO_TEST_CASE( testEPollFileDescriptorReuse )
+{
+    static const int USLEEP = 250000;
+    TestFDActivity<EPollFileDescriptorActivity> activity;
+    activity.do_read = true;
+    activity.other_fd = -1;
+
+    int pipe_fds[2];
+    BOOST_REQUIRE(pipe(pipe_fds) == 0);
+    activity.fd = pipe_fds[0];
+    activity.watch(pipe_fds[0]);
+    BOOST_CHECK( activity.start() );
+
+    // Closing the pipe drops the fd from the epoll set, but not from
+    // the watched fds. A new pipe is likely to get the same number.
+    int old_reader = pipe_fds[0];
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    BOOST_REQUIRE(pipe(pipe_fds) == 0);
+    BOOST_REQUIRE(activity.isWatched(old_reader));
+
+    {
+        RTT::os::MutexLock lock(activity.mutex);
+        activity.fd = pipe_fds[0];
+    }
+    activity.watch(pipe_fds[0]);
+    BOOST_CHECK( activity.isWatched(pipe_fds[0]) );
+
+    char buffer = 0;
+    BOOST_CHECK_EQUAL( 1, write(pipe_fds[1], &buffer, 1) );
+    usleep(USLEEP);
+    BOOST_CHECK_EQUAL(1, activity.count);
+    BOOST_CHECK_EQUAL(base::RunnableInterface::IOReady, activity.work_reason);
+
+    BOOST_CHECK( activity.stop() );
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+}
+#endif
+
 
 BOOST_AUTO_TEST_SUITE_END()
 
@@ -8,6 +8,7 @@ class SpecializedActivities
 public:
 
     void testFileDescriptorActivity();
+    void testEPollFileDescriptorActivity();
 };
 
 #endif
@@ -24,6 +24,7 @@
 #include <scripting/StateMachine.hpp>
 #include <scripting/ParsedStateMachine.hpp>
 #include <scripting/DumpObject.hpp>
+#include <scripting/ConditionTrue.hpp>
 #include <scripting/parse_exception.hpp>
 #include <rtt/internal/GlobalEngine.hpp>
 
@@ -1796,6 +1797,57 @@ BOOST_AUTO_TEST_CASE( testSelfDeactivatingStateMachineinTransition )
     BOOST_CHECK( !sm->isActive() );
 }
 
+BOOST_AUTO_TEST_CASE( testStateTablesRebuild )
+{
+    // test that the transition tables follow modifications of the state machine.
+    string prog = string("StateMachine X {\n")
+        + " initial state INIT {\n"
+        + " transitions {\n"
+        + "  if true then select A\n"
+        + " }\n"
+        + " }\n"
+        + " state A {\n"
+        + " }\n"
+        + " state B {\n"
+        + " }\n"
+        + " final state FINI {\n"
+        + " }\n"
+        + " }\n"
+        + " RootMachine X x\n" // instantiate a non hierarchical SC
+        ;
+    this->parseState( prog, tc );
+    StateMachinePtr sm = sa->getStateMachine( "x" );
+    BOOST_REQUIRE( sm );
+    BOOST_CHECK( sm->activate() );
+    BOOST_CHECK( SimulationThread::Instance()->run(1) );
+    BOOST_CHECK( sm->inState("INIT") );
+
+    // modify the frozen state machine while it is in INIT:
+    // the tables are rebuilt on the next request.
+    sm->setFinalState( sm->getState("FINI") );
+    BOOST_CHECK( sm->requestState("A") );
+    BOOST_CHECK( SimulationThread::Instance()->run(1) );
+    BOOST_CHECK( sm->inState("A") );
+    BOOST_CHECK( !sm->requestState("B") );
+    BOOST_CHECK( sm->inState("A") );
+
+    // add a transition to the inactive state machine and look it up
+    // after the next activation.
+    BOOST_CHECK( sm->deactivate() );
+    BOOST_CHECK( SimulationThread::Instance()->run(10) );
+    BOOST_REQUIRE( sm->isActive() == false );
+    sm->transitionSet( sm->getState("A"), sm->getState("B"), new ConditionTrue, 0, 0 );
+    BOOST_CHECK( sm->activate() );
+    BOOST_CHECK( SimulationThread::Instance()->run(1) );
+    BOOST_CHECK( sm->requestState("A") );
+    BOOST_CHECK( SimulationThread::Instance()->run(1) );
+    BOOST_CHECK( sm->requestState("B") );
+    BOOST_CHECK( SimulationThread::Instance()->run(1) );
+    BOOST_CHECK( sm->inState("B") );
+
+    this->finishState( "x", tc );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 void StateTest::doState(  const std::string& name, const std::string& prog, TaskContext* tc, bool test, int runs )
@@ -27,6 +27,8 @@
 #include <vector>
 
 #include <extras/PeriodicActivity.hpp>
+#include <extras/PoolActivity.hpp>
+#include <os/Atomic.hpp>
 #include <os/TimeService.hpp>
 #include <Logger.hpp>
 
@@ -248,6 +250,39 @@ struct TestSelfRemove
     }
 };
 
+/**
+ * Counts its executions and detects concurrent ones.
+ */
+struct TestPoolRunner
+    : public RunnableInterface
+{
+    os::AtomicInt executing, loops, steps, overlaps, notself;
+    bool init, fini;
+
+    TestPoolRunner() : init(false), fini(false) {}
+
+    bool initialize() {
+        init = true;
+        return true;
+    }
+    void step() {
+        steps.inc();
+    }
+    void loop() {
+        executing.inc();
+        if ( executing.read() != 1 )
+            overlaps.inc();
+        if ( !this->getActivity()->thread()->isSelf() )
+            notself.inc();
+        usleep(100);
+        loops.inc();
+        executing.dec();
+    }
+    void finalize() {
+        fini = true;
+    }
+};
+
 void
 ActivitiesTest::setUp()
 {
@@ -543,6 +578,65 @@ BOOST_AUTO_TEST_CASE( testActivityBreakLoop )
     }
 }
 
+BOOST_AUTO_TEST_CASE( testPoolActivity )
+{
+    BOOST_CHECK( !PoolActivity::configurePool(ORO_SCHED_OTHER, os::LowestPriority, 0) );
+    BOOST_CHECK( PoolActivity::configurePool(ORO_SCHED_OTHER, os::LowestPriority, 2) );
+
+    // ten activities share two workers.
+    std::vector<TestPoolRunner*> runners;
+    std::vector<PoolActivity*> acts;
+    for (int i = 0; i != 10; ++i) {
+        runners.push_back( new TestPoolRunner() );
+        acts.push_back( new PoolActivity( runners[i] ) );
+    }
+    BOOST_CHECK_EQUAL( acts[0]->getPoolSize(), 2u );
+    BOOST_CHECK( !PoolActivity::configurePool(ORO_SCHED_OTHER, os::LowestPriority, 4) );
+    BOOST_CHECK( !acts[0]->trigger() );
+
+    for (int i = 0; i != 10; ++i) {
+        BOOST_CHECK( acts[i]->start() );
+        BOOST_CHECK( runners[i]->init );
+    }
+    for (int j = 0; j != 100; ++j)
+        for (int i = 0; i != 10; ++i)
+            BOOST_CHECK( acts[i]->trigger() );
+    BOOST_CHECK( acts[0]->timeout() );
+    testPause();
+
+    BOOST_CHECK( !acts[0]->thread()->isSelf() );
+    BOOST_CHECK_EQUAL( runners[0]->steps.read(), 1 );
+    for (int i = 0; i != 10; ++i) {
+        // triggers of a queued or executing activity are merged.
+        BOOST_CHECK( runners[i]->loops.read() >= 1 );
+        BOOST_CHECK( runners[i]->loops.read() <= 101 );
+        BOOST_CHECK_EQUAL( runners[i]->overlaps.read(), 0 );
+        BOOST_CHECK_EQUAL( runners[i]->notself.read(), 0 );
+        BOOST_CHECK( acts[i]->stop() );
+        BOOST_CHECK( runners[i]->fini );
+        BOOST_CHECK( !acts[i]->isActive() );
+        BOOST_CHECK( !acts[i]->trigger() );
+    }
+
+    // the pool shrinks when activities leave it and keeps executing the others.
+    for (int i = 2; i != 10; ++i)
+        delete acts[i];
+    for (int i = 0; i != 2; ++i) {
+        int loops = runners[i]->loops.read();
+        BOOST_CHECK( acts[i]->start() );
+        for (int j = 0; j != 10; ++j)
+            BOOST_CHECK( acts[i]->trigger() );
+        testPause();
+        BOOST_CHECK( runners[i]->loops.read() > loops );
+        BOOST_CHECK( acts[i]->stop() );
+    }
+
+    for (int i = 0; i != 2; ++i)
+        delete acts[i];
+    for (int i = 0; i != 10; ++i)
+        delete runners[i];
+}
+
 BOOST_AUTO_TEST_CASE( testSelfRemove )
 {
     scoped_ptr<TestSelfRemove> t_run_int_nonper
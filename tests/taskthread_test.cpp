@@ -22,11 +22,14 @@
 #include "taskthread_test.hpp"
 
 #include <iostream>
+#include <sched.h>
 
 #include <extras/Activities.hpp>
 #include <extras/TimerThread.hpp>
 #include <extras/SimulationThread.hpp>
 #include <os/MainThread.hpp>
+#include <os/Atomic.hpp>
+#include <os/TimeService.hpp>
 #include <Logger.hpp>
 #include <rtt-config.h>
 
@@ -155,6 +158,75 @@ struct TestRunner
     }
 };
 
+/**
+ * Counts its executions.
+ */
+struct CountingRunner
+    : public RunnableInterface
+{
+    os::AtomicInt executions;
+
+    bool initialize() {
+        return true;
+    }
+
+    void step() {
+        executions.inc();
+    }
+
+    void loop() {
+        executions.inc();
+    }
+
+    void finalize() {
+    }
+};
+
+/**
+ * A CountingRunner of which loop() returns after each execution,
+ * so it can always be broken.
+ */
+struct BreakableRunner
+    : public CountingRunner
+{
+    bool breakLoop() {
+        return true;
+    }
+};
+
+/**
+ * Triggers another activity in a loop until breakLoop().
+ */
+struct TriggerRunner
+    : public RunnableInterface
+{
+    ActivityInterface* target;
+    os::AtomicInt triggers;
+    volatile bool done;
+
+    TriggerRunner(ActivityInterface* t) : target(t), done(false) {}
+
+    bool initialize() {
+        done = false;
+        return true;
+    }
+
+    void step() {}
+
+    void loop() {
+        while ( !done ) {
+            target->trigger();
+            triggers.inc();
+        }
+    }
+
+    bool breakLoop() {
+        done = true;
+        return true;
+    }
+
+    void finalize() {}
+};
 
 void
 ActivitiesThreadTest::setUp()
@@ -293,6 +365,116 @@ BOOST_AUTO_TEST_CASE( testActivityNonPeriodic )
     BOOST_CHECK( m2task.stepped == true );
 }
 
+/**
+ * Starts \a act, then triggers it \a rounds times, each time after it
+ * executed \a runner, and returns the mean trigger to execution latency.
+ */
+static Seconds triggerLatency(ActivityInterface& act, CountingRunner& runner, int rounds)
+{
+    BOOST_CHECK( act.start() );
+    for (int i = 0; i != 1000 && runner.executions.read() == 0; ++i)
+        usleep(1000);
+    BOOST_REQUIRE( runner.executions.read() == 1 );
+
+    os::TimeService::ticks start = os::TimeService::Instance()->getTicks();
+    for (int i = 0; i != rounds; ++i) {
+        int executions = runner.executions.read();
+        BOOST_CHECK( act.trigger() );
+        while ( runner.executions.read() == executions )
+            sched_yield();
+    }
+    Seconds latency = os::TimeService::Instance()->secondsSince(start) / rounds;
+    BOOST_CHECK_EQUAL( runner.executions.read(), 1 + rounds );
+    return latency;
+}
+
+BOOST_AUTO_TEST_CASE( testActivityTriggerBenchmark )
+{
+    CountingRunner runner;
+    Activity act(ORO_SCHED_OTHER, os::LowestPriority, 0.0, &runner, "TriggerBenchmark");
+
+    // latency: trigger a waiting activity and wait until it executed.
+    const int rounds = 1000;
+    Seconds latency = triggerLatency(act, runner, rounds);
+
+    // throughput: trigger an activity which is executing or triggered already.
+    const int triggers = 100000;
+    os::TimeService::ticks start = os::TimeService::Instance()->getTicks();
+    for (int i = 0; i != triggers; ++i)
+        act.trigger();
+    Seconds trigger_time = os::TimeService::Instance()->secondsSince(start) / triggers;
+
+    BOOST_CHECK( act.stop() );
+    // triggers are merged while the activity is triggered already.
+    BOOST_CHECK( runner.executions.read() >= 1 + rounds );
+    BOOST_CHECK( runner.executions.read() <= 1 + rounds + triggers );
+    BOOST_TEST_MESSAGE( "Activity trigger to execution latency " << latency * 1e6 << " us, "
+                        << "trigger() of a triggered activity " << trigger_time * 1e9 << " ns, "
+                        << runner.executions.read() - 1 - rounds << " executions for " << triggers << " triggers" );
+}
+
+BOOST_AUTO_TEST_CASE( testPoolActivityTriggerBenchmark )
+{
+    // the same latency for an activity with its own thread and one in the pool.
+    const int rounds = 1000;
+    CountingRunner runner;
+    Activity act(ORO_SCHED_OTHER, os::LowestPriority, 0.0, &runner, "TriggerBenchmark");
+    Seconds latency = triggerLatency(act, runner, rounds);
+    BOOST_CHECK( act.stop() );
+
+    CountingRunner pool_runner;
+    PoolActivity pool_act(&pool_runner, "PoolTriggerBenchmark");
+    Seconds pool_latency = triggerLatency(pool_act, pool_runner, rounds);
+    BOOST_CHECK( pool_act.stop() );
+
+    BOOST_TEST_MESSAGE( "Trigger to execution latency of an Activity " << latency * 1e6 << " us, "
+                        << "of a PoolActivity " << pool_latency * 1e6 << " us" );
+}
+
+BOOST_AUTO_TEST_CASE( testActivityStopWhileTriggered )
+{
+    BreakableRunner runner;
+    Activity act(ORO_SCHED_OTHER, os::LowestPriority, 0.0, &runner, "Triggered");
+    TriggerRunner trigger(&act);
+    Activity trigger_act(ORO_SCHED_OTHER, os::LowestPriority, 0.0, &trigger, "Trigger");
+    BOOST_REQUIRE( trigger_act.start() );
+
+    // stop() must end loop() even if a trigger arrives while it stops.
+    for (int i = 0; i != 100; ++i) {
+        BOOST_CHECK( act.start() );
+        usleep(500);
+        BOOST_CHECK( act.stop() );
+        BOOST_CHECK( !act.isActive() );
+        int executions = runner.executions.read();
+        usleep(500);
+        BOOST_CHECK_EQUAL( runner.executions.read(), executions );
+    }
+    BOOST_CHECK( trigger_act.stop() );
+    BOOST_CHECK( trigger.triggers.read() > 0 );
+    BOOST_CHECK( runner.executions.read() >= 100 );
+}
+
+BOOST_AUTO_TEST_CASE( testActivityStartWhileActive )
+{
+    CountingRunner runner;
+    Activity act(ORO_SCHED_OTHER, os::LowestPriority, 0.0, &runner, "Restarted");
+    BOOST_CHECK( act.start() );
+    for (int i = 0; i != 1000 && runner.executions.read() == 0; ++i)
+        usleep(1000);
+    BOOST_REQUIRE_EQUAL( runner.executions.read(), 1 );
+
+    // a start() of an active activity triggers it.
+    BOOST_CHECK( act.start() );
+    BOOST_CHECK( act.isActive() );
+    for (int i = 0; i != 1000 && runner.executions.read() == 1; ++i)
+        usleep(1000);
+    BOOST_CHECK_EQUAL( runner.executions.read(), 2 );
+
+    BOOST_CHECK( act.stop() );
+    BOOST_CHECK( !act.isActive() );
+    BOOST_CHECK( !act.stop() );
+}
+
 BOOST_AUTO_TEST_CASE( testActivityPeriodic )
 {
     // Test periodic task sequencing...
@@ -337,6 +519,48 @@ BOOST_AUTO_TEST_CASE( testActivityPeriodic )
     BOOST_CHECK( m2task.stepped == true );
 }
 
+BOOST_AUTO_TEST_CASE( testThreadStatistics )
+{
+    // Test the bins of the histograms
+    os::TimingHistogram histogram;
+    nsecs values[] = { 0, 7, 8, 9, 17, 1000, 123456789 };
+    for (unsigned int i = 0; i != sizeof(values) / sizeof(nsecs); ++i) {
+        unsigned int bin = os::TimingHistogram::bin( values[i] );
+        BOOST_CHECK( os::TimingHistogram::lowerBound( bin ) <= values[i] );
+        BOOST_CHECK( values[i] < os::TimingHistogram::lowerBound( bin + 1 ) );
+    }
+    for (int i = 1; i <= 1000; ++i)
+        histogram.record( i * 1000 );
+    BOOST_CHECK_EQUAL( histogram.count(), 1000 );
+    BOOST_CHECK_CLOSE( double( histogram.percentile(50) ), 500000.0, 12.5 );
+    BOOST_CHECK_CLOSE( double( histogram.percentile(99) ), 990000.0, 12.5 );
+    histogram.reset();
+    BOOST_CHECK_EQUAL( histogram.count(), 0 );
+    BOOST_CHECK_EQUAL( histogram.percentile(50), 0 );
+
+    // Test the statistics of a periodic activity
+    TestActivity<Activity> mtask( 15, 0.01, true );
+    os::ThreadStatistics* statistics = mtask.getThreadStatistics();
+    BOOST_REQUIRE( statistics );
+    BOOST_CHECK_EQUAL( statistics->duration.count(), 0 );
+
+    BOOST_CHECK( mtask.start() );
+    usleep(200000);
+    BOOST_CHECK( mtask.stop() );
+
+    int periods = statistics->duration.count();
+    BOOST_CHECK( periods >= 10 );
+    BOOST_CHECK_EQUAL( statistics->latency.count(), periods );
+    BOOST_CHECK( statistics->latency.percentile(50) < Seconds_to_nsecs(0.01) );
+    BOOST_CHECK( statistics->latency.percentile(50) <= statistics->latency.percentile(99.9) );
+    BOOST_CHECK( statistics->duration.percentile(50) < Seconds_to_nsecs(0.01) );
+    BOOST_TEST_MESSAGE( statistics->report() );
+
+    statistics->reset();
+    BOOST_CHECK_EQUAL( statistics->duration.count(), 0 );
+    BOOST_CHECK_EQUAL( statistics->overruns.read(), 0 );
+}
+
 BOOST_AUTO_TEST_CASE( testSlave )
 {
     // Test slave activities
@@ -86,6 +86,34 @@ struct TestTimer
     }
 };
 
+/**
+ * Blocks in the timeout of timer 2, such that the timers which expire
+ * meanwhile are served in one batch. The timeout of timer 0 kills timer 1.
+ */
+struct BatchTimer
+    : public Timer
+{
+    std::vector<Timer::TimerId> occured;
+    Semaphore entered, block, done;
+    BatchTimer()
+        : Timer(4, ORO_SCHED_OTHER, 0), entered(0), block(0), done(0)
+    {
+        occured.reserve(10);
+    }
+    void timeout(Timer::TimerId id)
+    {
+        occured.push_back( id );
+        if (id == 2) {
+            entered.signal();
+            block.wait();
+        }
+        if (id == 0)
+            killTimer(1);
+        if (id == 3)
+            done.signal();
+    }
+};
+
 BOOST_FIXTURE_TEST_SUITE( TimeTestSuite, TimeTest )
 
 BOOST_AUTO_TEST_CASE( testSecondsConversion )
@@ -297,6 +325,67 @@ BOOST_AUTO_TEST_CASE( testTimerPeriod )
     BOOST_CHECK( timer.occured.size() == 0 );
 }
 
+BOOST_AUTO_TEST_CASE( testTimerScaling )
+{
+    // Arm and kill a few thousand timers, as watchdog components do,
+    // and let them expire in bursts.
+    const int max_timers = 3000;
+    TestTimer timer;
+    timer.setMaxTimers( max_timers );
+    timer.occured.reserve( max_timers );
+
+    nsecs start = hbg->getNSecs();
+    for (int i = 0; i < max_timers; ++i)
+        BOOST_CHECK( timer.arm(i, 10.0 + 0.001 * ((i * 7919) % max_timers)) );
+    nsecs arm_time = hbg->getNSecs() - start;
+
+    start = hbg->getNSecs();
+    for (int i = 0; i < max_timers; i += 2)
+        BOOST_CHECK( timer.killTimer(i) );
+    nsecs kill_time = hbg->getNSecs() - start;
+
+    start = hbg->getNSecs();
+    for (int i = 1; i < max_timers; i += 2)
+        BOOST_CHECK( timer.arm(i, 20.0 - 0.001 * (i % 1000)) );
+    nsecs rearm_time = hbg->getNSecs() - start;
+
+    BOOST_TEST_MESSAGE( "Timer with " << max_timers << " timers: arm " << arm_time / max_timers
+                        << "ns, kill " << kill_time / (max_timers / 2)
+                        << "ns, re-arm " << rearm_time / (max_timers / 2) << "ns per timer." );
+    BOOST_CHECK( timer.isArmed( 1 ) );
+    BOOST_CHECK( !timer.isArmed( 0 ) );
+    BOOST_CHECK( timer.occured.empty() );
+
+    // Let all timers expire within about 0.1s of each other.
+    Seconds burst = hbg->secondsSince( 0 );
+    for (int i = 0; i < max_timers; ++i)
+        BOOST_CHECK( timer.arm(i, 0.2 + 0.001 * (i % 100)) );
+    sleep(1);
+    BOOST_CHECK_EQUAL( int(timer.occured.size()), max_timers );
+    for (int i = 0; i < max_timers; ++i)
+        BOOST_CHECK( !timer.isArmed( i ) );
+    if ( !timer.occured.empty() )
+        BOOST_TEST_MESSAGE( "Timer fired " << timer.occured.size() << " timeouts in "
+                            << timer.occured.back().second - burst << "s." );
+}
+
+BOOST_AUTO_TEST_CASE( testTimerBatchKill )
+{
+    BatchTimer timer;
+    BOOST_CHECK( timer.arm(2, 0.0) );
+    timer.entered.wait();
+    // these expire while the timer thread is blocked in timeout(2).
+    BOOST_CHECK( timer.arm(0, 0.0) );
+    BOOST_CHECK( timer.arm(1, 0.0) );
+    BOOST_CHECK( timer.arm(3, 0.0) );
+    timer.block.signal();
+    timer.done.wait();
+    // timer 1 was killed by timeout(0) in the same batch.
+    Timer::TimerId expected[] = { 2, 0, 3 };
+    BOOST_CHECK_EQUAL_COLLECTIONS( timer.occured.begin(), timer.occured.end(), expected, expected + 3 );
+    BOOST_CHECK( !timer.isArmed( 1 ) );
+}
+
 BOOST_AUTO_TEST_CASE( testTimerWaitFor )
 {
     TestTimer timer;
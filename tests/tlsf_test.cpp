@@ -20,7 +20,11 @@
 
 #include "unit.hpp"
 #include <rtt/os/tlsf/tlsf.h>
+#include <rtt/os/TimeService.hpp>
+#include <rtt-config.h>
 #include <signal.h>
+#include <pthread.h>
+#include <algorithm>
 
 void signal_handler(int sig_num){
     if(sig_num == SIGABRT){
@@ -92,6 +96,89 @@ BOOST_AUTO_TEST_CASE(testUseSecondaryMemPool){
     oro_rt_free(a);
 }
 
+#ifdef OS_RT_MALLOC_ARENAS
+namespace {
+    const int ContendingThreads = 8;
+    const int Allocations = 20000;
+    const int KeptBlocks = 64;
+
+    /**
+     * Allocates and frees blocks of varying size and measures how long
+     * each allocation takes. The last blocks are kept, such that they
+     * are freed by another thread.
+     */
+    struct Contender
+    {
+        void* kept[KeptBlocks];
+        RTT::os::TimeService::nsecs total, worst;
+
+        static void* run(void* arg)
+        {
+            Contender* c = static_cast<Contender*>(arg);
+            RTT::os::TimeService* ts = RTT::os::TimeService::Instance();
+            c->total = c->worst = 0;
+            for (int i = 0; i < KeptBlocks; ++i)
+                c->kept[i] = 0;
+            for (int i = 0; i < Allocations; ++i) {
+                RTT::os::TimeService::nsecs start = ts->getNSecs();
+                void* block = oro_rt_malloc( 16 + (i * 37) % 512 );
+                RTT::os::TimeService::nsecs latency = ts->getNSecs() - start;
+                c->total += latency;
+                if (latency > c->worst)
+                    c->worst = latency;
+                oro_rt_free( c->kept[i % KeptBlocks] );
+                c->kept[i % KeptBlocks] = block;
+            }
+            return 0;
+        }
+    };
+
+    void contend(Contender* contenders)
+    {
+        pthread_t threads[ContendingThreads];
+        for (int i = 0; i < ContendingThreads; ++i)
+            BOOST_REQUIRE_EQUAL( 0, pthread_create(&threads[i], 0, &Contender::run, &contenders[i]) );
+        for (int i = 0; i < ContendingThreads; ++i)
+            pthread_join(threads[i], 0);
+        RTT::os::TimeService::nsecs total = 0, worst = 0;
+        for (int i = 0; i < ContendingThreads; ++i) {
+            total += contenders[i].total;
+            worst = std::max(worst, contenders[i].worst);
+            // these are returned to the arenas of the exited threads.
+            for (int j = 0; j < KeptBlocks; ++j) {
+                BOOST_CHECK( contenders[i].kept[j] );
+                oro_rt_free( contenders[i].kept[j] );
+            }
+        }
+        BOOST_TEST_MESSAGE( "oro_rt_malloc() from " << ContendingThreads << " threads: average "
+                            << total / (ContendingThreads * Allocations) << "ns, worst " << worst << "ns." );
+    }
+}
+
+BOOST_AUTO_TEST_CASE(testArenaContention)
+{
+    Contender contenders[ContendingThreads];
+    contend(contenders);
+
+    const int max_arenas = 32;
+    size_t used[max_arenas], max[max_arenas];
+    int arenas = get_arena_statistics(used, max, max_arenas);
+    BOOST_CHECK_GE( arenas, ContendingThreads );
+    for (int i = 0; i < std::min(arenas, max_arenas); ++i)
+        BOOST_CHECK_GE( max[i], used[i] );
+
+    // The arenas of the exited threads are reused.
+    contend(contenders);
+    BOOST_CHECK_EQUAL( get_arena_statistics(used, max, 0), arenas );
+
+    void* a = oro_rt_malloc(1000);
+    BOOST_CHECK( a );
+    BOOST_CHECK_GE( get_max_size_arena(), get_used_size_arena() );
+    BOOST_CHECK_GE( get_used_size_arena(), 1000u );
+    oro_rt_free(a);
+}
+#endif
+
 BOOST_AUTO_TEST_CASE(testDoubleFree)
 {
     signal(SIGABRT,&signal_handler);
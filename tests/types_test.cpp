@@ -40,6 +40,10 @@ using namespace std;
 using namespace RTT;
 using namespace RTT::detail;
 
+/** A type which is only registered by testTypeIndex. */
+struct TypeIndexTest { int value; };
+struct TypeIdLateTest { int value; };
+
 class TypesTest : public OperationsFixture
 {
 public:
@@ -558,6 +562,78 @@ BOOST_AUTO_TEST_CASE( testOperatorOrder )
     executePrograms(prog);
 }
 
+/**
+ * Tests that operations on constants are evaluated once, when parsed.
+ */
+BOOST_AUTO_TEST_CASE( testConstantFolding )
+{
+    int v = 2;
+    tc->addAttribute("v", v);
+
+    DataSourceBase::shared_ptr ds = parser.parseExpression("3*(2+1) + 4", tc);
+    BOOST_REQUIRE( ds );
+    BOOST_CHECK( ds->isConstant() );
+    BOOST_CHECK_EQUAL( DataSource<int>::narrow( ds.get() )->get(), 13 );
+
+    ds = parser.parseExpression("!(1.0 < 2.0) || 6/0 == 0", tc);
+    BOOST_REQUIRE( ds );
+    BOOST_CHECK( ds->isConstant() );
+    BOOST_CHECK( DataSource<bool>::narrow( ds.get() )->get() );
+
+    ds = parser.parseExpression("\"con\" + \"stant\"", tc);
+    BOOST_REQUIRE( ds );
+    BOOST_CHECK( ds->isConstant() );
+    BOOST_CHECK_EQUAL( DataSource<string>::narrow( ds.get() )->get(), "constant" );
+
+    // expressions on variables are evaluated each time.
+    ds = parser.parseExpression("2*3 + v", tc);
+    BOOST_REQUIRE( ds );
+    BOOST_CHECK( !ds->isConstant() );
+    BOOST_CHECK_EQUAL( DataSource<int>::narrow( ds.get() )->get(), 8 );
+    v = 4;
+    BOOST_CHECK_EQUAL( DataSource<int>::narrow( ds.get() )->get(), 10 );
+
+    // operator data sources are constant if all their arguments are.
+    typedef BinaryDataSource< std::plus<int> > Plus;
+    typedef UnaryDataSource< std::negate<int> > Negate;
+    DataSource<int>::shared_ptr two = new ConstantDataSource<int>(2);
+    DataSource<int>::shared_ptr var = new ValueDataSource<int>(2);
+    BOOST_CHECK( Plus::shared_ptr( new Plus( two, two, std::plus<int>() ) )->isConstant() );
+    BOOST_CHECK( !Plus::shared_ptr( new Plus( two, var, std::plus<int>() ) )->isConstant() );
+    BOOST_CHECK( Negate::shared_ptr( new Negate( two, std::negate<int>() ) )->isConstant() );
+    BOOST_CHECK( !Negate::shared_ptr( new Negate( var, std::negate<int>() ) )->isConstant() );
+}
+
+BOOST_AUTO_TEST_CASE( testTypeIndex )
+{
+    TypeInfoRepository::shared_ptr ti = TypeInfoRepository::Instance();
+
+    // lookups by id, name and type id name find the same type.
+    TypeInfo* t = ti->getTypeInfo<int>();
+    BOOST_REQUIRE( t );
+    BOOST_CHECK_EQUAL( ti->getTypeById( &typeid(int) ), t );
+    BOOST_CHECK_EQUAL( ti->type("int"), t );
+    BOOST_CHECK_EQUAL( ti->getTypeById( typeid(int).name() ), t );
+    BOOST_CHECK( ti->type("no_such_type_name") == 0 );
+
+    // a type added after a failed lookup is found by the next one.
+    BOOST_CHECK( ti->getTypeInfo<TypeIndexTest>() == 0 );
+    BOOST_CHECK( ti->type("TypeIndexTest") == 0 );
+    t = new TypeInfo("TypeIndexTest");
+    t->setTypeId( &typeid(TypeIndexTest) );
+    BOOST_REQUIRE( ti->addType( t ) );
+    BOOST_CHECK_EQUAL( ti->type("TypeIndexTest"), t );
+    BOOST_CHECK_EQUAL( ti->getTypeInfo<TypeIndexTest>(), t );
+    BOOST_CHECK_EQUAL( ti->getTypeById( typeid(TypeIndexTest).name() ), t );
+
+    // a type id set after the type was added is found by both lookups.
+    t = new TypeInfo("TypeIdLateTest");
+    BOOST_REQUIRE( ti->addType( t ) );
+    t->setTypeId( &typeid(TypeIdLateTest) );
+    BOOST_CHECK_EQUAL( ti->getTypeById( &typeid(TypeIdLateTest) ), t );
+    BOOST_CHECK_EQUAL( ti->getTypeById( typeid(TypeIdLateTest).name() ), t );
+}
+
 BOOST_AUTO_TEST_CASE( testGlobals )
 {
     GlobalsRepository::Instance()->setValue( new Constant<double>("cd_num", 3.33));